@@ -25,19 +25,82 @@ limitations under the License.
  */
 #include "cJSON.h"
 #include "civetweb.h"
+#include "metrics.h"
 #include "modules/brightness/brightness_scheduler.h"
 #include "modules/wifi/wifi_scheduler.h"
+#include "qos.h"
+#include "reactor.h"
+#include "state_store.h"
 #include "ws_utils.h"
+#include <limits.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 // ------------------------ 配置 ------------------------
 #define SERVER_PORT 8080
+
+// 同板运行的Flutter面板经UNIX域套接字连接，绕过TCP协议栈并以文件权限控制访问；
+// 可用同名环境变量覆盖路径，空串表示只监听TCP
+#ifndef SERVER_UNIX_SOCKET
+#define SERVER_UNIX_SOCKET "/run/flutter_panel.sock" ///< UNIX域套接字路径
+#endif
+#define SERVER_UNIX_SOCKET_ENV "SERVER_UNIX_SOCKET" ///< 覆盖套接字路径的环境变量
+
+#ifndef SERVER_UNIX_SOCKET_MODE
+#define SERVER_UNIX_SOCKET_MODE 0660 ///< 套接字文件权限（属组内的面板进程可连接）
+#endif
+
+// civetweb的每个WebSocket连接在其生命周期内占用一个工作线程，线程数即连接数上限；
+// 线程栈大小由CMake的SERVER_THREAD_STACK_SIZE（civetweb的USE_STACK_SIZE）限定，
+// 空闲连接的内存开销以栈的实际驻留页为主。可用同名环境变量覆盖线程数
+#ifndef SERVER_NUM_THREADS
+#define SERVER_NUM_THREADS 256 ///< civetweb工作线程数
+#endif
+#define SERVER_NUM_THREADS_ENV "SERVER_NUM_THREADS" ///< 覆盖工作线程数的环境变量
+
+#ifndef SERVER_RESERVED_THREADS
+#define SERVER_RESERVED_THREADS 4 ///< 为/metrics与新握手保留、不被WebSocket长期占用的线程数
+#endif
+
+// 连接数上限：全局上限不超过工作线程数减保留线程数，各路径另有上限，0表示不额外限制
+#ifndef WS_MAX_CONNECTIONS
+#define WS_MAX_CONNECTIONS 0 ///< 全局WebSocket连接数上限
+#endif
+#define WS_MAX_CONNECTIONS_ENV "WS_MAX_CONNECTIONS" ///< 覆盖全局连接数上限的环境变量
+
+#ifndef WS_WIFI_MAX_CONNECTIONS
+#define WS_WIFI_MAX_CONNECTIONS 32 ///< /wifi路径连接数上限
+#endif
+
+#ifndef WS_BRIGHTNESS_MAX_CONNECTIONS
+#define WS_BRIGHTNESS_MAX_CONNECTIONS 128 ///< /brightness路径连接数上限
+#endif
+
+// 保活：civetweb在连接静默WS_PING_INTERVAL_MS后发送PING，连续多次无应答时关闭连接并释放
+// 工作线程；超过应答期限或空闲超时的连接由ws_utils的回收检查停止推送，空闲连接在下一帧到达时
+// 由数据处理器关闭。可用同名环境变量覆盖，0表示关闭
+#ifndef WS_PING_INTERVAL_MS
+#define WS_PING_INTERVAL_MS 3000 ///< PING间隔(毫秒)
+#endif
+#define WS_PING_INTERVAL_MS_ENV "WS_PING_INTERVAL_MS" ///< 覆盖PING间隔的环境变量
+
+#ifndef WS_PONG_TIMEOUT_MS
+#define WS_PONG_TIMEOUT_MS 3000 ///< PING应答期限(毫秒)
+#endif
+#define WS_PONG_TIMEOUT_MS_ENV "WS_PONG_TIMEOUT_MS" ///< 覆盖PING应答期限的环境变量
+
+#ifndef WS_IDLE_TIMEOUT_MS
+#define WS_IDLE_TIMEOUT_MS 0 ///< 未收到业务消息的空闲超时(毫秒)，面板常驻订阅推送，默认不启用
+#endif
+#define WS_IDLE_TIMEOUT_MS_ENV "WS_IDLE_TIMEOUT_MS" ///< 覆盖空闲超时的环境变量
 // ----------------------------------------------------
 
 /**
@@ -45,7 +108,10 @@ limitations under the License.
  */
 struct per_session_data
 {
-    char path[256]; ///< 存储WebSocket连接的路径
+    char path[256];           ///< 存储WebSocket连接的路径
+    const char *metrics_path; ///< 已计入连接数的路径（指向路由表中的常量字符串），NULL表示未计入
+    int route;                ///< 路由表下标（已计入该路径的连接数），-1表示未匹配
+    ws_subscriber *sub;       ///< 推送登记与存活跟踪句柄，登记失败时为NULL
 };
 
 /**
@@ -55,11 +121,15 @@ typedef struct
 {
     char *patch;                                                ///< WebSocket路径
     void (*scheduler)(struct mg_connection *conn, cJSON *root); ///< 该路径对应的调度器函数
+    void (*on_close)(const struct mg_connection *conn);         ///< 连接关闭通知（可为NULL）
+    int max_connections;                                        ///< 该路径连接数上限，0表示不限
+    int connections;                                            ///< 该路径已接受的连接数（__atomic访问）
 } websocket_path_scheduling;
 
 static websocket_path_scheduling websocket_path_scheduling_table[] = {
-    {"/wifi", wifi_scheduler},
-    {"/brightness", brightness_scheduler},
+    {"/wifi", wifi_scheduler, wifi_scheduler_close, WS_WIFI_MAX_CONNECTIONS, 0},
+    {"/brightness", brightness_scheduler, brightness_scheduler_close,
+     WS_BRIGHTNESS_MAX_CONNECTIONS, 0},
 };
 #define WEBSOCKET_PATH_SCHEDULING_TABLE_SIZE                                                       \
     (sizeof(websocket_path_scheduling_table) / sizeof(websocket_path_scheduling))
@@ -67,11 +137,100 @@ static websocket_path_scheduling websocket_path_scheduling_table[] = {
 // 全局服务器上下文
 static struct mg_context *g_ctx = NULL;
 static volatile sig_atomic_t g_exit = 0;
+static int g_ws_limit = 0;       ///< WebSocket连接数上限
+static int g_ws_connections = 0; ///< 已接受的WebSocket连接数（__atomic访问）
+
+/**
+ * @brief 查找路径在路由表中的下标
+ *
+ * @param path WebSocket路径
+ * @return int 下标，未找到返回-1
+ */
+static int ws_route_find(const char *path)
+{
+    for (size_t i = 0; i < WEBSOCKET_PATH_SCHEDULING_TABLE_SIZE; i++)
+    {
+        if (strcmp(path, websocket_path_scheduling_table[i].patch) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 以503拒绝WebSocket握手
+ *
+ * @param conn 连接指针
+ * @param reason 拒绝原因（计入指标）
+ * @param message 响应正文
+ */
+static void ws_reject(const struct mg_connection *conn, metrics_reject_reason_t reason,
+                      const char *message)
+{
+    metrics_connection_rejected(reason);
+    mg_send_http_error((struct mg_connection *)conn, 503, "%s", message);
+    printf("拒绝连接: %s\n", message);
+}
+
+/**
+ * @brief 占用全局与路径的连接名额
+ *
+ * @param route 路由表下标，-1表示未匹配（只占用全局名额）
+ * @param conn 连接指针（达到上限时用于发送拒绝响应）
+ * @return int 成功返回0，达到上限返回-1（已发送拒绝响应）
+ */
+static int ws_admit(int route, const struct mg_connection *conn)
+{
+    char message[96];
+
+    // 连接数达到上限时明确拒绝，避免新连接在civetweb队列中无限等待空闲线程，
+    // 同时保证/metrics等短请求始终有可用线程
+    if (__atomic_add_fetch(&g_ws_connections, 1, __ATOMIC_RELAXED) > g_ws_limit)
+    {
+        __atomic_sub_fetch(&g_ws_connections, 1, __ATOMIC_RELAXED);
+        snprintf(message, sizeof(message), "too many connections (limit %d)", g_ws_limit);
+        ws_reject(conn, METRICS_REJECT_GLOBAL, message);
+        return -1;
+    }
+    if (route < 0)
+    {
+        return 0;
+    }
+
+    websocket_path_scheduling *entry = &websocket_path_scheduling_table[route];
+    int count = __atomic_add_fetch(&entry->connections, 1, __ATOMIC_RELAXED);
+    if (entry->max_connections > 0 && count > entry->max_connections)
+    {
+        __atomic_sub_fetch(&entry->connections, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&g_ws_connections, 1, __ATOMIC_RELAXED);
+        snprintf(message, sizeof(message), "too many connections on %s (limit %d)", entry->patch,
+                 entry->max_connections);
+        ws_reject(conn, METRICS_REJECT_PATH, message);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 归还ws_admit占用的连接名额
+ *
+ * @param route 路由表下标，-1表示只占用了全局名额
+ */
+static void ws_release(int route)
+{
+    if (route >= 0)
+    {
+        __atomic_sub_fetch(&websocket_path_scheduling_table[route].connections, 1,
+                           __ATOMIC_RELAXED);
+    }
+    __atomic_sub_fetch(&g_ws_connections, 1, __ATOMIC_RELAXED);
+}
 
 /**
  * @brief WebSocket连接处理器
  *
- * 客户端尝试建立连接时调用，分配并初始化会话数据。
+ * 客户端尝试建立连接时调用，检查全局与路径的连接数上限，分配并初始化会话数据。
  *
  * @param conn 连接指针
  * @param user_data 用户数据（未使用）
@@ -81,25 +240,27 @@ static int ws_connect_handler(const struct mg_connection *conn, void *user_data)
 {
     (void)user_data; /* unused */
 
-    // 分配连接数据
-    struct per_session_data *pss =
-        (struct per_session_data *)calloc(1, sizeof(struct per_session_data));
-    if (!pss)
-    {
-        return 1; // 拒绝连接
-    }
-
     // 获取请求路径
     const struct mg_request_info *ri = mg_get_request_info(conn);
-    if (ri && ri->local_uri)
+    const char *uri = (ri && ri->local_uri) ? ri->local_uri : "/"; // 默认路径
+    int route = ws_route_find(uri);
+    if (ws_admit(route, conn) != 0)
     {
-        strncpy(pss->path, ri->local_uri, sizeof(pss->path) - 1);
-        pss->path[sizeof(pss->path) - 1] = '\0';
+        return 1; // 拒绝连接
     }
-    else
+
+    // 分配连接数据
+    struct per_session_data *pss =
+        (struct per_session_data *)metrics_calloc(METRICS_MODULE_CORE, 1,
+                                                  sizeof(struct per_session_data));
+    if (!pss)
     {
-        strcpy(pss->path, "/"); // 默认路径
+        ws_release(route);
+        return 1; // 拒绝连接
     }
+    strncpy(pss->path, uri, sizeof(pss->path) - 1);
+    pss->path[sizeof(pss->path) - 1] = '\0';
+    pss->route = route;
 
     // 设置用户数据（注意：需要将 const 转换为非 const）
     mg_set_user_connection_data((struct mg_connection *)conn, pss);
@@ -111,15 +272,30 @@ static int ws_connect_handler(const struct mg_connection *conn, void *user_data)
 /**
  * @brief WebSocket就绪处理器
  *
- * @details 当WebSocket连接就绪时调用，打印连接就绪信息。
+ * @details 当WebSocket连接就绪时调用，登记连接以接收推送事件。
  *
  * @param conn 连接指针
  * @param user_data 用户数据（未使用）
  */
 static void ws_ready_handler(struct mg_connection *conn, void *user_data)
 {
-    (void)conn;      /* unused */
     (void)user_data; /* unused */
+
+    // 登记连接以接收该路径的推送事件
+    struct per_session_data *pss = (struct per_session_data *)mg_get_user_connection_data(conn);
+    if (pss)
+    {
+        pss->sub = ws_register_connection(conn, pss->path);
+        for (size_t i = 0; i < WEBSOCKET_PATH_SCHEDULING_TABLE_SIZE; i++)
+        {
+            if (strcmp(pss->path, websocket_path_scheduling_table[i].patch) == 0)
+            {
+                pss->metrics_path = websocket_path_scheduling_table[i].patch;
+                metrics_connection_opened(pss->metrics_path);
+                break;
+            }
+        }
+    }
     printf("WebSocket 连接就绪\n");
 }
 
@@ -140,14 +316,6 @@ static int ws_data_handler(struct mg_connection *conn, int opcode, char *data, s
 {
     (void)user_data; /* unused */
 
-    // 只处理文本消息
-    if ((opcode & 0xf) != MG_WEBSOCKET_OPCODE_TEXT)
-    {
-        return 1; // 保持连接
-    }
-
-    printf("收到消息 (长度 %zu): %.*s\n", datasize, (int)datasize, data);
-
     // 获取连接数据
     struct per_session_data *pss = (struct per_session_data *)mg_get_user_connection_data(conn);
     if (!pss)
@@ -155,10 +323,34 @@ static int ws_data_handler(struct mg_connection *conn, int opcode, char *data, s
         return 0; // 关闭连接
     }
 
+    // 任意帧（含PONG）都说明连接存活；已被回收的连接在此关闭
+    bool text = (opcode & 0xf) == MG_WEBSOCKET_OPCODE_TEXT;
+    if (!ws_connection_touch(pss->sub, text))
+    {
+        return 0; // 关闭连接
+    }
+
+    // 只处理文本消息
+    if (!text)
+    {
+        return 1; // 保持连接
+    }
+
+    printf("收到消息 (长度 %zu): %.*s\n", datasize, (int)datasize, data);
+
     // 使用 cJSON 解析 JSON
+    int64_t parse_start = qos_now_us();
     cJSON *root = cJSON_ParseWithLength(data, datasize);
+    int64_t parse_us = qos_now_us() - parse_start;
+
+    // 开始追踪本请求的各阶段耗时，请求信封中debug为true时响应附带timing对象
+    metrics_trace_begin(parse_start,
+                        root && cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "debug")));
+    metrics_observe_stage(METRICS_STAGE_PARSE, parse_us);
     if (!root)
     {
+        metrics_trace_clear();
+        metrics_count_message("invalid_json");
         const char *error_ptr = cJSON_GetErrorPtr();
         fprintf(stderr, "JSON 解析失败! %s\n", error_ptr ? error_ptr : "未知错误");
 
@@ -179,7 +371,9 @@ static int ws_data_handler(struct mg_connection *conn, int opcode, char *data, s
             if (websocket_path_scheduling_table[i].scheduler != NULL)
             {
                 printf("调用 %s 路径的调度器\n", pss->path);
+                int64_t dispatch_start = qos_now_us();
                 websocket_path_scheduling_table[i].scheduler(conn, root);
+                metrics_observe_stage(METRICS_STAGE_DISPATCH, qos_now_us() - dispatch_start);
             }
             else
             {
@@ -202,6 +396,9 @@ static int ws_data_handler(struct mg_connection *conn, int opcode, char *data, s
         ws_send_text(conn, unsupported_resp);
     }
 
+    // 已完成的请求在qos_record中结束追踪，移交给模块队列的请求由执行线程继续追踪
+    metrics_trace_clear();
+
     // 释放解析的 JSON 树
     cJSON_Delete(root);
     return 1; // 保持连接
@@ -220,15 +417,164 @@ static void ws_close_handler(const struct mg_connection *conn, void *user_data)
     (void)user_data; /* unused */
 
     // 释放连接数据
+    ws_unregister_connection(conn);
     struct per_session_data *pss = (struct per_session_data *)mg_get_user_connection_data(conn);
     if (pss)
     {
-        free(pss);
+        if (pss->metrics_path)
+        {
+            metrics_connection_closed(pss->metrics_path);
+        }
+        // 通知模块连接已关闭，避免后台任务向已关闭的连接写入
+        for (size_t i = 0; i < WEBSOCKET_PATH_SCHEDULING_TABLE_SIZE; i++)
+        {
+            if (strcmp(pss->path, websocket_path_scheduling_table[i].patch) == 0 &&
+                websocket_path_scheduling_table[i].on_close != NULL)
+            {
+                websocket_path_scheduling_table[i].on_close(conn);
+                break;
+            }
+        }
+        ws_release(pss->route);
+        metrics_free(pss);
     }
 
     printf("客户端连接已关闭.\n");
 }
 
+/**
+ * @brief 指标导出处理器
+ *
+ * @details 以Prometheus文本格式输出运行指标，供采集端通过HTTP GET拉取。
+ *
+ * @param conn 连接指针
+ * @param cbdata 回调数据（未使用）
+ * @return int HTTP状态码
+ */
+static int metrics_http_handler(struct mg_connection *conn, void *cbdata)
+{
+    (void)cbdata; /* unused */
+
+    size_t len = 0;
+    char *text = metrics_render(&len);
+    if (!text)
+    {
+        mg_send_http_error(conn, 500, "%s", "metrics unavailable");
+        return 500;
+    }
+    mg_printf(conn,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+              "Content-Length: %zu\r\n"
+              "Cache-Control: no-cache\r\n"
+              "Connection: close\r\n\r\n",
+              len);
+    mg_write(conn, text, len);
+    free(text);
+    return 200;
+}
+
+/**
+ * @brief 解析UNIX域套接字路径并清理上次运行残留的套接字文件
+ *
+ * 环境变量优先于编译期默认值。路径过长、含逗号（listening_ports的分隔符）、
+ * 所在目录不可写或已被非套接字文件占用时跳过，只监听TCP，不影响服务启动。
+ *
+ * @return const char* 套接字路径，不监听UNIX域套接字时返回NULL
+ */
+static const char *unix_socket_prepare(void)
+{
+    const char *path = getenv(SERVER_UNIX_SOCKET_ENV);
+    if (!path)
+    {
+        path = SERVER_UNIX_SOCKET;
+    }
+    if (path[0] == '\0')
+    {
+        return NULL;
+    }
+    if (strlen(path) + 1 >= sizeof(((struct sockaddr_un *)0)->sun_path) || strchr(path, ','))
+    {
+        fprintf(stderr, "UNIX域套接字路径无效: %s，仅监听TCP\n", path);
+        return NULL;
+    }
+
+    char dir[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (!slash)
+    {
+        snprintf(dir, sizeof(dir), ".");
+    }
+    else
+    {
+        slash[slash == dir ? 1 : 0] = '\0';
+    }
+    if (access(dir, W_OK | X_OK) != 0)
+    {
+        fprintf(stderr, "UNIX域套接字目录 %s 不可写，仅监听TCP\n", dir);
+        return NULL;
+    }
+
+    struct stat st;
+    if (lstat(path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            fprintf(stderr, "%s 已存在且不是套接字，仅监听TCP\n", path);
+            return NULL;
+        }
+        // 上次运行未正常退出时残留的套接字文件会使bind失败
+        unlink(path);
+    }
+    return path;
+}
+
+/**
+ * @brief 读取整数配置，环境变量优先于编译期默认值
+ *
+ * @param name 环境变量名
+ * @param def 编译期默认值
+ * @param min 允许的最小值，小于该值时使用默认值
+ * @return int 配置值
+ */
+static int config_env_int(const char *name, int def, int min)
+{
+    const char *value = getenv(name);
+    if (!value || value[0] == '\0')
+    {
+        return def;
+    }
+    char *end = NULL;
+    long v = strtol(value, &end, 10);
+    if (*end != '\0' || v < min || v > INT_MAX)
+    {
+        fprintf(stderr, "%s=%s 无效，使用默认值 %d\n", name, value, def);
+        return def;
+    }
+    return (int)v;
+}
+
+/**
+ * @brief 解析civetweb工作线程数并计算WebSocket连接数上限
+ *
+ * @param threads 输出工作线程数
+ * @return int WebSocket连接数上限
+ */
+static int server_threads_resolve(int *threads)
+{
+    int n = config_env_int(SERVER_NUM_THREADS_ENV, SERVER_NUM_THREADS,
+                           SERVER_RESERVED_THREADS + 1);
+    int limit = n - SERVER_RESERVED_THREADS;
+    int max = config_env_int(WS_MAX_CONNECTIONS_ENV, WS_MAX_CONNECTIONS, 0);
+    if (max > 0 && max < limit)
+    {
+        limit = max;
+    }
+    *threads = n;
+    return limit;
+}
+
 /**
  * @brief 信号处理器
  *
@@ -247,6 +593,9 @@ static void signal_handler(int sig)
  */
 int main(void)
 {
+    // 安装计数分配器，须在创建任何cJSON对象之前
+    metrics_alloc_init();
+
     // 初始化 civetweb 库
     unsigned features = mg_init_library(MG_FEATURES_WEBSOCKET);
     if (features == 0)
@@ -259,10 +608,82 @@ int main(void)
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-    // 配置服务器选项
-    char port_str[16];
-    snprintf(port_str, sizeof(port_str), "%d", SERVER_PORT);
-    const char *server_options[] = {"listening_ports", port_str, "num_threads", "10", NULL, NULL};
+    // 启动后端事件线程，各模块的描述符与定时器都注册到这里
+    if (reactor_init() != 0)
+    {
+        fprintf(stderr, "事件线程启动失败\n");
+        mg_exit_library();
+        return 1;
+    }
+
+    // 启动推送发送线程，推送事件由它们写出，不在事件线程上写连接
+    if (ws_push_init() != 0)
+    {
+        fprintf(stderr, "推送发送线程启动失败\n");
+        reactor_deinit();
+        mg_exit_library();
+        return 1;
+    }
+
+    // 初始化各功能模块
+    if (wifi_scheduler_init() != 0)
+    {
+        fprintf(stderr, "WiFi 模块初始化失败\n");
+        state_store_deinit();
+        ws_push_deinit();
+        reactor_deinit();
+        mg_exit_library();
+        return 1;
+    }
+    if (brightness_scheduler_init() != 0)
+    {
+        fprintf(stderr, "亮度模块初始化失败\n");
+        wifi_scheduler_deinit();
+        state_store_deinit();
+        ws_push_deinit();
+        reactor_deinit();
+        mg_exit_library();
+        return 1;
+    }
+
+    // 配置服务器选项：TCP端口与UNIX域套接字（civetweb以x前缀表示，需USE_X_DOM_SOCKET）
+    const char *unix_path = unix_socket_prepare();
+    char port_str[16 + sizeof(((struct sockaddr_un *)0)->sun_path)];
+    if (unix_path)
+    {
+        snprintf(port_str, sizeof(port_str), "%d,x%s", SERVER_PORT, unix_path);
+    }
+    else
+    {
+        snprintf(port_str, sizeof(port_str), "%d", SERVER_PORT);
+    }
+    int threads = 0;
+    g_ws_limit = server_threads_resolve(&threads);
+    metrics_set_connection_limit(g_ws_limit);
+    char threads_str[16];
+    snprintf(threads_str, sizeof(threads_str), "%d", threads);
+
+    // 保活参数：PING由civetweb发送，应答期限与空闲超时由回收检查执行
+    ws_keepalive_config keepalive = {
+        .ping_interval_ms = config_env_int(WS_PING_INTERVAL_MS_ENV, WS_PING_INTERVAL_MS, 0),
+        .pong_timeout_ms = config_env_int(WS_PONG_TIMEOUT_MS_ENV, WS_PONG_TIMEOUT_MS, 0),
+        .idle_timeout_ms = config_env_int(WS_IDLE_TIMEOUT_MS_ENV, WS_IDLE_TIMEOUT_MS, 0),
+    };
+    if (keepalive.ping_interval_ms == 0)
+    {
+        keepalive.pong_timeout_ms = 0; // 不发送PING时无从判断应答
+    }
+    char ping_str[16];
+    snprintf(ping_str, sizeof(ping_str), "%d", keepalive.ping_interval_ms);
+    const char *server_options[10] = {"listening_ports", port_str, "num_threads", threads_str};
+    size_t option_count = 4;
+    if (keepalive.ping_interval_ms > 0)
+    {
+        server_options[option_count++] = "enable_websocket_ping_pong";
+        server_options[option_count++] = "yes";
+        server_options[option_count++] = "websocket_timeout_ms";
+        server_options[option_count++] = ping_str;
+    }
 
     // 启动服务器
     struct mg_callbacks callbacks = {0};
@@ -278,10 +699,19 @@ int main(void)
     mg_start_error_data.text = errtxtbuf;
     mg_start_error_data.text_buffer_size = sizeof(errtxtbuf);
 
+    // 套接字文件在mg_start2内bind时创建，创建前以umask限定权限，不留可被任意用户连接的窗口；
+    // umask为进程级设置，期间其他线程新建的文件只会更严格
+    mode_t old_umask = umask(~(mode_t)SERVER_UNIX_SOCKET_MODE & 0777);
     g_ctx = mg_start2(&mg_start_init_data, &mg_start_error_data);
+    umask(old_umask);
     if (!g_ctx)
     {
         fprintf(stderr, "无法启动服务器: %s\n", errtxtbuf);
+        brightness_scheduler_deinit();
+        wifi_scheduler_deinit();
+        state_store_deinit();
+        ws_push_deinit();
+        reactor_deinit();
         mg_exit_library();
         return 1;
     }
@@ -294,13 +724,29 @@ int main(void)
                                  ws_close_handler, user_data);
     }
 
+    // 注册指标导出HTTP处理器
+    mg_set_request_handler(g_ctx, METRICS_PATH, metrics_http_handler, NULL);
+
+    if (ws_keepalive_start(&keepalive) != 0)
+    {
+        fprintf(stderr, "连接回收检查启动失败，失联连接只能等待civetweb的PING超时关闭\n");
+    }
+
     printf("WebSocket 服务器启动，监听端口 %d...\n", SERVER_PORT);
+    printf("工作线程 %d，WebSocket 连接上限 %d\n", threads, g_ws_limit);
+    printf("保活: PING间隔 %d ms，应答期限 %d ms，空闲超时 %d ms\n", keepalive.ping_interval_ms,
+           keepalive.pong_timeout_ms, keepalive.idle_timeout_ms);
+    if (unix_path)
+    {
+        printf("UNIX域套接字: %s (权限 %04o)\n", unix_path, SERVER_UNIX_SOCKET_MODE);
+    }
     printf("等待客户端连接...\n");
     printf("支持的路径:\n");
     for (size_t i = 0; i < WEBSOCKET_PATH_SCHEDULING_TABLE_SIZE; i++)
     {
         printf("  - %s\n", websocket_path_scheduling_table[i].patch);
     }
+    printf("指标导出: http://<host>:%d%s\n", SERVER_PORT, METRICS_PATH);
 
     // 运行服务器
     while (!g_exit)
@@ -312,6 +758,17 @@ int main(void)
 
     // 停止服务器并清理
     mg_stop(g_ctx);
+    ws_keepalive_stop();
+    if (unix_path)
+    {
+        unlink(unix_path);
+    }
+    brightness_scheduler_deinit();
+    wifi_scheduler_deinit();
+    state_store_deinit();
+    ws_push_deinit();
+    reactor_deinit();
+    qos_log_stats();
     mg_exit_library();
 
     return 0;
@@ -0,0 +1,1221 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file metrics.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 运行指标统计实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 计数器按线程分片：每个线程第一次记录时分配自己的分片并挂入全局链表，之后只写自己的
+ * 分片（单写者，relaxed存储即可，无锁无原子读改写）；导出时遍历所有分片求和。
+ * 线程退出后分片保留，计数不会丢失。队列深度为全局最新值，直接原子存储。
+ *
+ * 请求追踪同样是线程局部的：处理请求的线程在记录阶段耗时时顺带累加到当前追踪，
+ * 跨线程移交时整体复制，不需要任何同步。
+ *
+ * 计数分配器在每块内存前加一个头部记录大小与归属，释放时按头部扣减。内存常在另一个
+ * 线程释放（如提交线程复制的请求数据由队列线程释放），因此分配统计使用全局原子计数。
+ */
+#include "metrics.h"
+#include "qos.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 直方图桶上界(微秒)，最后一桶为+Inf
+ */
+static const int64_t g_bucket_bounds_us[METRICS_BUCKETS - 1] = {
+    100,    250,    500,     1000,    2500,    5000,    10000,   25000,
+    50000,  100000, 250000,  500000,  1000000, 2500000, 5000000, 10000000,
+};
+
+static const char *const g_stage_names[METRICS_STAGE_COUNT] = {
+    "parse", "dispatch", "queue_wait", "serialize", "send",
+};
+
+static const char *const g_module_names[METRICS_MODULE_COUNT] = {
+    "wifi",
+    "brightness",
+    "core",
+};
+
+static const char *const g_backend_names[METRICS_BACKEND_COUNT] = {
+    "wifi_enable",     "wifi_scan",       "wifi_status",      "wifi_connect",
+    "wifi_disconnect", "brightness_read", "brightness_write",
+};
+
+static const char *const g_exec_names[METRICS_EXEC_COUNT] = {
+    "ok",
+    "failed",
+    "timeout",
+    "cancelled",
+};
+
+static const char *const g_reject_names[METRICS_REJECT_COUNT] = {
+    "global",
+    "path",
+};
+
+static const char *const g_reap_names[METRICS_REAP_COUNT] = {
+    "pong_timeout",
+    "idle",
+    "overflow",
+};
+
+static const char *const g_queue_names[METRICS_QUEUE_COUNT] = {
+    "wifi_commands",
+    "wifi_reads",
+    "brightness_pending",
+};
+
+/**
+ * @brief 延迟直方图（桶不累积，导出时再累加）
+ */
+typedef struct
+{
+    uint64_t buckets[METRICS_BUCKETS]; ///< 各桶计数
+    uint64_t count;                    ///< 样本数
+    uint64_t sum_us;                   ///< 累计耗时(微秒)
+} metrics_histogram;
+
+/**
+ * @brief 单个线程的计数分片
+ */
+typedef struct metrics_shard
+{
+    struct metrics_shard *next;                                    ///< 链表中的下一个分片
+    int64_t connections[METRICS_MAX_PATHS];                        ///< 连接数增量
+    uint64_t messages[METRICS_MAX_TYPES];                          ///< 各类型消息数
+    uint64_t responses[METRICS_MODULE_COUNT][METRICS_ERROR_SLOTS]; ///< 各模块错误码计数
+    metrics_histogram requests[METRICS_MAX_TYPES];                 ///< 各类型请求延迟
+    metrics_histogram stages[METRICS_STAGE_COUNT];                 ///< 各阶段耗时
+    uint64_t backend_errors[METRICS_BACKEND_COUNT];                ///< 后端操作失败数
+    metrics_histogram backend[METRICS_BACKEND_COUNT];              ///< 后端操作耗时
+    metrics_histogram exec[METRICS_EXEC_COUNT];                    ///< 外部命令执行耗时
+} metrics_shard;
+
+/**
+ * @brief 标签表：只追加，写入持锁，读取无锁
+ */
+typedef struct
+{
+    pthread_mutex_t lock; ///< 追加锁
+    const char **names;   ///< 标签值（常量字符串）
+    int capacity;         ///< 容量，最后一项保留给溢出标签
+    int count;            ///< 已登记数量（release发布）
+} metrics_labels;
+
+static const char *g_type_names[METRICS_MAX_TYPES];
+static const char *g_path_names[METRICS_MAX_PATHS];
+static metrics_labels g_types = {PTHREAD_MUTEX_INITIALIZER, g_type_names, METRICS_MAX_TYPES, 0};
+static metrics_labels g_paths = {PTHREAD_MUTEX_INITIALIZER, g_path_names, METRICS_MAX_PATHS, 0};
+
+static pthread_mutex_t g_shards_lock = PTHREAD_MUTEX_INITIALIZER;
+static metrics_shard *g_shards = NULL;
+static __thread metrics_shard *t_shard = NULL;
+
+static int64_t g_queue_depths[METRICS_QUEUE_COUNT];
+static int64_t g_connection_limit;
+static uint64_t g_connections_rejected[METRICS_REJECT_COUNT];
+static uint64_t g_connections_reaped[METRICS_REAP_COUNT];
+
+#define METRICS_ALLOC_NONE METRICS_MAX_TYPES ///< 没有请求上下文的分配
+#define METRICS_ALLOC_MAGIC 0x6d616c63u        ///< 分配头部校验值
+
+/**
+ * @brief 计数分配器的内存头部（联合体保证其后的用户内存满足最大对齐）
+ */
+typedef union
+{
+    struct
+    {
+        size_t size;        ///< 用户请求的字节数
+        uint16_t module;    ///< 归属模块
+        uint16_t type_slot; ///< 归属请求类型下标
+        uint32_t magic;     ///< 校验值
+    } h;
+    long double align_ld; ///< 对齐占位
+    long long align_ll;   ///< 对齐占位
+    void *align_ptr;      ///< 对齐占位
+} metrics_alloc_header;
+
+/**
+ * @brief 一个归属维度的分配统计
+ */
+typedef struct
+{
+    uint64_t allocs; ///< 分配次数
+    int64_t live;    ///< 存活字节数
+    int64_t peak;    ///< 存活字节数峰值
+} metrics_alloc_stats;
+
+static metrics_alloc_stats g_alloc[METRICS_MODULE_COUNT][METRICS_MAX_TYPES + 1];
+static metrics_alloc_stats g_alloc_module[METRICS_MODULE_COUNT];
+
+static __thread metrics_trace t_trace;
+static pthread_once_t g_slow_once = PTHREAD_ONCE_INIT;
+static int64_t g_slow_request_us = (int64_t)METRICS_SLOW_REQUEST_MS * 1000;
+
+/**
+ * @brief 获取调用线程的分片，首次调用时分配
+ *
+ * @return metrics_shard* 分配失败返回NULL
+ */
+static metrics_shard *metrics_shard_get(void)
+{
+    metrics_shard *shard = t_shard;
+    if (shard)
+    {
+        return shard;
+    }
+    shard = (metrics_shard *)calloc(1, sizeof(metrics_shard));
+    if (!shard)
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&g_shards_lock);
+    shard->next = g_shards;
+    __atomic_store_n(&g_shards, shard, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_shards_lock);
+    t_shard = shard;
+    return shard;
+}
+
+/**
+ * @brief 单写者计数器累加
+ */
+static inline void counter_add(uint64_t *counter, uint64_t value)
+{
+    __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 记录直方图样本
+ */
+static void histogram_observe(metrics_histogram *h, int64_t latency_us)
+{
+    uint64_t us = latency_us > 0 ? (uint64_t)latency_us : 0;
+    int bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && us > (uint64_t)g_bucket_bounds_us[bucket])
+    {
+        bucket++;
+    }
+    counter_add(&h->buckets[bucket], 1);
+    counter_add(&h->count, 1);
+    counter_add(&h->sum_us, us);
+}
+
+/**
+ * @brief 查找或登记标签值
+ *
+ * @param labels 标签表
+ * @param name 标签值（常量字符串）
+ * @param overflow 标签表已满时使用的标签值
+ * @return int 标签下标
+ */
+static int metrics_label_index(metrics_labels *labels, const char *name, const char *overflow)
+{
+    int count = __atomic_load_n(&labels->count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++)
+    {
+        if (labels->names[i] == name || strcmp(labels->names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+
+    pthread_mutex_lock(&labels->lock);
+    int i;
+    for (i = count; i < labels->count; i++)
+    {
+        if (strcmp(labels->names[i], name) == 0)
+        {
+            break;
+        }
+    }
+    if (i == labels->count)
+    {
+        if (labels->count >= labels->capacity - 1)
+        {
+            // 保留最后一项给溢出标签
+            name = overflow;
+            for (i = 0; i < labels->count && strcmp(labels->names[i], overflow) != 0; i++)
+            {
+            }
+        }
+        if (i == labels->count)
+        {
+            labels->names[i] = name;
+            __atomic_store_n(&labels->count, i + 1, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&labels->lock);
+    return i;
+}
+
+/**
+ * @brief 读取慢请求阈值环境变量
+ */
+static void metrics_slow_init(void)
+{
+    const char *env = getenv(METRICS_SLOW_REQUEST_MS_ENV);
+    if (env && *env)
+    {
+        char *end = NULL;
+        long long ms = strtoll(env, &end, 10);
+        if (end && *end == '\0' && ms >= 0)
+        {
+            g_slow_request_us = ms * 1000;
+        }
+    }
+}
+
+/**
+ * @brief 调度与桥接开销：总耗时减去其他已计量阶段
+ *
+ * @param trace 追踪
+ * @param total_us 总耗时
+ * @return int64_t 开销(微秒)
+ */
+static int64_t metrics_trace_dispatch_us(const metrics_trace *trace, int64_t total_us)
+{
+    int64_t rest = total_us - trace->backend_us;
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++)
+    {
+        if (i != METRICS_STAGE_DISPATCH)
+        {
+            rest -= trace->stage_us[i];
+        }
+    }
+    return rest > 0 ? rest : 0;
+}
+
+/**
+ * @brief 在当前线程开始追踪一个请求
+ *
+ * @param start_us 收到请求的qos_now_us()
+ * @param debug 是否在响应中附带timing对象
+ */
+void metrics_trace_begin(int64_t start_us, bool debug)
+{
+    memset(&t_trace, 0, sizeof(t_trace));
+    t_trace.active = true;
+    t_trace.debug = debug;
+    t_trace.module = METRICS_MODULE_CORE;
+    t_trace.type_slot = METRICS_ALLOC_NONE;
+    t_trace.start_us = start_us;
+}
+
+/**
+ * @brief 为当前追踪记录模块、请求类型与请求ID
+ *
+ * @param module 处理请求的模块
+ * @param type 请求类型
+ * @param request_id 请求ID，可为NULL
+ */
+void metrics_trace_identify(metrics_module_t module, const char *type, const char *request_id)
+{
+    if (!t_trace.active)
+    {
+        return;
+    }
+    t_trace.module = module;
+    t_trace.type = type;
+    t_trace.type_slot = type ? metrics_label_index(&g_types, type, "other") : METRICS_ALLOC_NONE;
+    snprintf(t_trace.request_id, sizeof(t_trace.request_id), "%s", request_id ? request_id : "");
+}
+
+/**
+ * @brief 复制当前追踪
+ *
+ * @param out 输出追踪
+ */
+void metrics_trace_capture(metrics_trace *out)
+{
+    if (out)
+    {
+        *out = t_trace;
+    }
+}
+
+/**
+ * @brief 在当前线程继续一个移交过来的追踪
+ *
+ * @param trace 追踪
+ */
+void metrics_trace_resume(const metrics_trace *trace)
+{
+    if (trace)
+    {
+        t_trace = *trace;
+    }
+}
+
+/**
+ * @brief 放弃当前线程的追踪
+ */
+void metrics_trace_clear(void)
+{
+    t_trace.active = false;
+}
+
+/**
+ * @brief 请求携带debug: true时向响应添加timing对象
+ *
+ * @param response 即将发送的响应
+ */
+void metrics_trace_annotate(cJSON *response)
+{
+    if (!t_trace.active || !t_trace.debug || !response ||
+        !cJSON_GetObjectItemCaseSensitive(response, "request_id") ||
+        cJSON_GetObjectItemCaseSensitive(response, "timing"))
+    {
+        return;
+    }
+    cJSON *timing = cJSON_AddObjectToObject(response, "timing");
+    if (!timing)
+    {
+        return;
+    }
+    int64_t total = qos_now_us() - t_trace.start_us;
+    cJSON_AddNumberToObject(timing, "parse_us", (double)t_trace.stage_us[METRICS_STAGE_PARSE]);
+    cJSON_AddNumberToObject(timing, "dispatch_us",
+                            (double)metrics_trace_dispatch_us(&t_trace, total));
+    cJSON_AddNumberToObject(timing, "queue_wait_us",
+                            (double)t_trace.stage_us[METRICS_STAGE_QUEUE_WAIT]);
+    cJSON_AddNumberToObject(timing, "backend_us", (double)t_trace.backend_us);
+    cJSON_AddNumberToObject(timing, "total_us", (double)total);
+}
+
+/**
+ * @brief 结束当前追踪，超过阈值时输出慢请求日志
+ *
+ * @param type 请求类型
+ * @param latency_us 总耗时
+ */
+static void metrics_trace_finish(const char *type, int64_t latency_us)
+{
+    t_trace.active = false;
+    pthread_once(&g_slow_once, metrics_slow_init);
+    if (g_slow_request_us <= 0 || latency_us < g_slow_request_us)
+    {
+        return;
+    }
+    const int64_t *st = t_trace.stage_us;
+    fprintf(stderr,
+            "metrics: 慢请求 %s (request_id=%s) 耗时 %lld us: parse %lld, dispatch %lld, "
+            "queue_wait %lld, backend %lld, serialize %lld, send %lld\n",
+            t_trace.type ? t_trace.type : (type ? type : "?"), t_trace.request_id,
+            (long long)latency_us, (long long)st[METRICS_STAGE_PARSE],
+            (long long)metrics_trace_dispatch_us(&t_trace, latency_us),
+            (long long)st[METRICS_STAGE_QUEUE_WAIT], (long long)t_trace.backend_us,
+            (long long)st[METRICS_STAGE_SERIALIZE], (long long)st[METRICS_STAGE_SEND]);
+}
+
+/**
+ * @brief 更新一个归属维度的分配统计
+ *
+ * @param st 统计
+ * @param delta 存活字节数变化
+ * @param is_alloc 是否为一次分配
+ */
+static void alloc_stats_update(metrics_alloc_stats *st, int64_t delta, bool is_alloc)
+{
+    if (is_alloc)
+    {
+        __atomic_fetch_add(&st->allocs, 1, __ATOMIC_RELAXED);
+    }
+    int64_t live = __atomic_add_fetch(&st->live, delta, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&st->peak, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&st->peak, &peak, live, true,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/**
+ * @brief 记录分配或释放
+ *
+ * @param module 归属模块
+ * @param slot 归属请求类型下标
+ * @param delta 存活字节数变化
+ * @param is_alloc 是否为一次分配
+ */
+static void alloc_account(int module, int slot, int64_t delta, bool is_alloc)
+{
+    if (module < 0 || module >= METRICS_MODULE_COUNT)
+    {
+        module = METRICS_MODULE_CORE;
+    }
+    if (slot < 0 || slot > METRICS_ALLOC_NONE)
+    {
+        slot = METRICS_ALLOC_NONE;
+    }
+    alloc_stats_update(&g_alloc[module][slot], delta, is_alloc);
+    alloc_stats_update(&g_alloc_module[module], delta, is_alloc);
+}
+
+/**
+ * @brief 填写头部并计入统计
+ *
+ * @param hdr 头部
+ * @param module 模块
+ * @param size 用户字节数
+ * @return void* 用户内存
+ */
+static void *alloc_commit(metrics_alloc_header *hdr, metrics_module_t module, size_t size)
+{
+    int slot = t_trace.active ? t_trace.type_slot : METRICS_ALLOC_NONE;
+    hdr->h.size = size;
+    hdr->h.module = (uint16_t)module;
+    hdr->h.type_slot = (uint16_t)slot;
+    hdr->h.magic = METRICS_ALLOC_MAGIC;
+    alloc_account(module, slot, (int64_t)size, true);
+    return hdr + 1;
+}
+
+/**
+ * @brief 取得用户内存对应的头部，校验失败时终止进程
+ *
+ * @param ptr 用户内存
+ * @return metrics_alloc_header* 头部
+ */
+static metrics_alloc_header *alloc_header(void *ptr)
+{
+    metrics_alloc_header *hdr = (metrics_alloc_header *)ptr - 1;
+    if (hdr->h.magic != METRICS_ALLOC_MAGIC)
+    {
+        fprintf(stderr, "metrics: 释放了不是由计数分配器分配的内存 %p\n", ptr);
+        abort();
+    }
+    return hdr;
+}
+
+/**
+ * @brief 计数分配
+ *
+ * @param module 模块
+ * @param size 字节数
+ * @return void* 失败返回NULL
+ */
+void *metrics_malloc(metrics_module_t module, size_t size)
+{
+    if (size > SIZE_MAX - sizeof(metrics_alloc_header))
+    {
+        return NULL;
+    }
+    metrics_alloc_header *hdr = (metrics_alloc_header *)malloc(sizeof(*hdr) + size);
+    return hdr ? alloc_commit(hdr, module, size) : NULL;
+}
+
+/**
+ * @brief 计数分配并清零
+ *
+ * @param module 模块
+ * @param count 元素个数
+ * @param size 元素大小
+ * @return void* 失败返回NULL
+ */
+void *metrics_calloc(metrics_module_t module, size_t count, size_t size)
+{
+    if (size != 0 && count > (SIZE_MAX - sizeof(metrics_alloc_header)) / size)
+    {
+        return NULL;
+    }
+    metrics_alloc_header *hdr =
+        (metrics_alloc_header *)calloc(1, sizeof(metrics_alloc_header) + count * size);
+    return hdr ? alloc_commit(hdr, module, count * size) : NULL;
+}
+
+/**
+ * @brief 调整计数分配的内存大小，调整后按新的模块与当前请求类型归属
+ *
+ * @param module 模块
+ * @param ptr 原指针（可为NULL）
+ * @param size 新字节数
+ * @return void* 失败返回NULL，原内存保持不变
+ */
+void *metrics_realloc(metrics_module_t module, void *ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return metrics_malloc(module, size);
+    }
+    if (size > SIZE_MAX - sizeof(metrics_alloc_header))
+    {
+        return NULL;
+    }
+    metrics_alloc_header *old = alloc_header(ptr);
+    size_t old_size = old->h.size;
+    int old_module = old->h.module;
+    int old_slot = old->h.type_slot;
+    metrics_alloc_header *hdr =
+        (metrics_alloc_header *)realloc(old, sizeof(metrics_alloc_header) + size);
+    if (!hdr)
+    {
+        return NULL;
+    }
+    alloc_account(old_module, old_slot, -(int64_t)old_size, false);
+    return alloc_commit(hdr, module, size);
+}
+
+/**
+ * @brief 计数分配的strdup
+ *
+ * @param module 模块
+ * @param s 源字符串
+ * @return char* 失败返回NULL
+ */
+char *metrics_strdup(metrics_module_t module, const char *s)
+{
+    size_t len = strlen(s);
+    char *copy = (char *)metrics_malloc(module, len + 1);
+    if (copy)
+    {
+        memcpy(copy, s, len + 1);
+    }
+    return copy;
+}
+
+/**
+ * @brief 计数分配的strndup
+ *
+ * @param module 模块
+ * @param s 源字符串
+ * @param n 最多复制的字符数
+ * @return char* 失败返回NULL
+ */
+char *metrics_strndup(metrics_module_t module, const char *s, size_t n)
+{
+    size_t len = strnlen(s, n);
+    char *copy = (char *)metrics_malloc(module, len + 1);
+    if (copy)
+    {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * @brief 释放计数分配的内存
+ *
+ * @param ptr 指针（可为NULL）
+ */
+void metrics_free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    metrics_alloc_header *hdr = alloc_header(ptr);
+    alloc_account(hdr->h.module, hdr->h.type_slot, -(int64_t)hdr->h.size, false);
+    hdr->h.magic = 0;
+    free(hdr);
+}
+
+/**
+ * @brief cJSON分配钩子：归属到当前请求的模块
+ *
+ * @param size 字节数
+ * @return void* 失败返回NULL
+ */
+static void *metrics_cjson_malloc(size_t size)
+{
+    return metrics_malloc(t_trace.active ? t_trace.module : METRICS_MODULE_CORE, size);
+}
+
+/**
+ * @brief 安装计数分配器为cJSON的内存钩子
+ */
+void metrics_alloc_init(void)
+{
+    cJSON_Hooks hooks = {.malloc_fn = metrics_cjson_malloc, .free_fn = metrics_free};
+    cJSON_InitHooks(&hooks);
+}
+
+/**
+ * @brief 连接建立
+ *
+ * @param path WebSocket路径
+ */
+void metrics_connection_opened(const char *path)
+{
+    metrics_shard *shard = metrics_shard_get();
+    if (shard && path)
+    {
+        int i = metrics_label_index(&g_paths, path, "other");
+        __atomic_store_n(&shard->connections[i], shard->connections[i] + 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 连接关闭
+ *
+ * @param path WebSocket路径
+ */
+void metrics_connection_closed(const char *path)
+{
+    metrics_shard *shard = metrics_shard_get();
+    if (shard && path)
+    {
+        int i = metrics_label_index(&g_paths, path, "other");
+        __atomic_store_n(&shard->connections[i], shard->connections[i] - 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 设置WebSocket连接数上限
+ *
+ * @param limit 上限
+ */
+void metrics_set_connection_limit(int64_t limit)
+{
+    __atomic_store_n(&g_connection_limit, limit, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 统计一次被拒绝的WebSocket握手（只在达到上限时发生，直接原子累加）
+ *
+ * @param reason 拒绝原因
+ */
+void metrics_connection_rejected(metrics_reject_reason_t reason)
+{
+    if (reason >= 0 && reason < METRICS_REJECT_COUNT)
+    {
+        __atomic_fetch_add(&g_connections_rejected[reason], 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 统计一次被回收的WebSocket会话（只在回收时发生，直接原子累加）
+ *
+ * @param reason 回收原因
+ */
+void metrics_connection_reaped(metrics_reap_reason_t reason)
+{
+    if (reason >= 0 && reason < METRICS_REAP_COUNT)
+    {
+        __atomic_fetch_add(&g_connections_reaped[reason], 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 统计一条收到的消息
+ *
+ * @param type 请求类型，NULL计为"unknown"
+ */
+void metrics_count_message(const char *type)
+{
+    metrics_shard *shard = metrics_shard_get();
+    if (shard)
+    {
+        counter_add(&shard->messages[metrics_label_index(&g_types, type ? type : "unknown",
+                                                         "other")],
+                    1);
+    }
+}
+
+/**
+ * @brief 统计一次模块响应的错误码
+ *
+ * @param module 模块
+ * @param code 错误码（0表示成功）
+ */
+void metrics_count_error(metrics_module_t module, int code)
+{
+    metrics_shard *shard = metrics_shard_get();
+    if (!shard || module < 0 || module >= METRICS_MODULE_COUNT)
+    {
+        return;
+    }
+    int slot = code + 1;
+    if (slot < 0 || slot >= METRICS_ERROR_SLOTS)
+    {
+        slot = METRICS_ERROR_SLOTS - 1;
+    }
+    counter_add(&shard->responses[module][slot], 1);
+}
+
+/**
+ * @brief 按响应中的error字段统计模块错误码
+ *
+ * @param module 模块
+ * @param response 响应JSON对象，NULL或缺少error字段时计为-1（未知错误）
+ */
+void metrics_count_response(metrics_module_t module, const cJSON *response)
+{
+    const cJSON *error = response ? cJSON_GetObjectItemCaseSensitive(response, "error") : NULL;
+    metrics_count_error(module, cJSON_IsNumber(error) ? error->valueint : -1);
+}
+
+/**
+ * @brief 记录请求从收到到响应发出的延迟，并结束当前线程的追踪
+ *
+ * @param type 请求类型
+ * @param latency_us 延迟(微秒)
+ */
+void metrics_observe_request(const char *type, int64_t latency_us)
+{
+    if (t_trace.active)
+    {
+        metrics_trace_finish(type, latency_us);
+    }
+    metrics_shard *shard = metrics_shard_get();
+    if (shard)
+    {
+        histogram_observe(
+            &shard->requests[metrics_label_index(&g_types, type ? type : "unknown", "other")],
+            latency_us);
+    }
+}
+
+/**
+ * @brief 记录处理阶段耗时
+ *
+ * @param stage 阶段
+ * @param latency_us 耗时(微秒)
+ */
+void metrics_observe_stage(metrics_stage_t stage, int64_t latency_us)
+{
+    if (stage < 0 || stage >= METRICS_STAGE_COUNT)
+    {
+        return;
+    }
+    if (t_trace.active)
+    {
+        t_trace.stage_us[stage] += latency_us;
+    }
+    metrics_shard *shard = metrics_shard_get();
+    if (shard)
+    {
+        histogram_observe(&shard->stages[stage], latency_us);
+    }
+}
+
+/**
+ * @brief 记录一次后端操作
+ *
+ * @param op 操作
+ * @param latency_us 耗时(微秒)
+ * @param ok 是否成功
+ */
+void metrics_observe_backend(metrics_backend_t op, int64_t latency_us, bool ok)
+{
+    if (op < 0 || op >= METRICS_BACKEND_COUNT)
+    {
+        return;
+    }
+    if (t_trace.active)
+    {
+        t_trace.backend_us += latency_us;
+    }
+    metrics_shard *shard = metrics_shard_get();
+    if (shard)
+    {
+        histogram_observe(&shard->backend[op], latency_us);
+        if (!ok)
+        {
+            counter_add(&shard->backend_errors[op], 1);
+        }
+    }
+}
+
+/**
+ * @brief 记录一次外部命令执行
+ *
+ * @param result 执行结果
+ * @param latency_us 从启动到回收子进程的耗时(微秒)
+ */
+void metrics_observe_exec(metrics_exec_result_t result, int64_t latency_us)
+{
+    if (result < 0 || result >= METRICS_EXEC_COUNT)
+    {
+        return;
+    }
+    metrics_shard *shard = metrics_shard_get();
+    if (shard)
+    {
+        histogram_observe(&shard->exec[result], latency_us);
+    }
+}
+
+/**
+ * @brief 设置队列深度
+ *
+ * @param queue 队列
+ * @param depth 当前深度
+ */
+void metrics_set_queue_depth(metrics_queue_t queue, int64_t depth)
+{
+    if (queue >= 0 && queue < METRICS_QUEUE_COUNT)
+    {
+        __atomic_store_n(&g_queue_depths[queue], depth, __ATOMIC_RELAXED);
+    }
+}
+
+// ------------------------ 导出 ------------------------
+
+/**
+ * @brief 可增长的输出缓冲
+ */
+typedef struct
+{
+    char *data;  ///< 数据
+    size_t len;  ///< 长度
+    size_t cap;  ///< 容量
+    bool failed; ///< 是否发生分配失败
+} metrics_buf;
+
+static void buf_printf(metrics_buf *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void buf_printf(metrics_buf *b, const char *fmt, ...)
+{
+    if (b->failed)
+    {
+        return;
+    }
+    for (;;)
+    {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(b->data + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+        if (n < 0)
+        {
+            b->failed = true;
+            return;
+        }
+        if (b->len + (size_t)n < b->cap)
+        {
+            b->len += (size_t)n;
+            return;
+        }
+        size_t cap = b->cap * 2;
+        while (cap <= b->len + (size_t)n)
+        {
+            cap *= 2;
+        }
+        char *p = realloc(b->data, cap);
+        if (!p)
+        {
+            b->failed = true;
+            return;
+        }
+        b->data = p;
+        b->cap = cap;
+    }
+}
+
+static uint64_t load_u64(const uint64_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 合并所有分片中同一直方图
+ *
+ * @param offset 直方图在分片中的偏移
+ * @param out 合并结果
+ */
+static void histogram_sum(size_t offset, metrics_histogram *out)
+{
+    memset(out, 0, sizeof(*out));
+    for (metrics_shard *s = __atomic_load_n(&g_shards, __ATOMIC_ACQUIRE); s; s = s->next)
+    {
+        const metrics_histogram *h = (const metrics_histogram *)((const char *)s + offset);
+        for (int b = 0; b < METRICS_BUCKETS; b++)
+        {
+            out->buckets[b] += load_u64(&h->buckets[b]);
+        }
+        out->count += load_u64(&h->count);
+        out->sum_us += load_u64(&h->sum_us);
+    }
+}
+
+/**
+ * @brief 输出一组直方图样本
+ *
+ * @param b 输出缓冲
+ * @param name 指标名
+ * @param label 标签名
+ * @param value 标签值
+ * @param h 直方图
+ */
+static void render_histogram(metrics_buf *b, const char *name, const char *label,
+                             const char *value, const metrics_histogram *h)
+{
+    uint64_t cumulative = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++)
+    {
+        cumulative += h->buckets[i];
+        if (i < METRICS_BUCKETS - 1)
+        {
+            buf_printf(b, "%s_bucket{%s=\"%s\",le=\"%g\"} %llu\n", name, label, value,
+                       (double)g_bucket_bounds_us[i] / 1e6, (unsigned long long)cumulative);
+        }
+        else
+        {
+            buf_printf(b, "%s_bucket{%s=\"%s\",le=\"+Inf\"} %llu\n", name, label, value,
+                       (unsigned long long)cumulative);
+        }
+    }
+    buf_printf(b, "%s_sum{%s=\"%s\"} %.6f\n", name, label, value, (double)h->sum_us / 1e6);
+    buf_printf(b, "%s_count{%s=\"%s\"} %llu\n", name, label, value, (unsigned long long)h->count);
+}
+
+/**
+ * @brief 以Prometheus文本格式输出所有指标
+ *
+ * @param len 输出文本长度（可为NULL）
+ * @return char* 文本（调用者free），失败返回NULL
+ */
+char *metrics_render(size_t *len)
+{
+    metrics_buf b = {.data = malloc(4096), .cap = 4096};
+    if (!b.data)
+    {
+        return NULL;
+    }
+    b.data[0] = '\0';
+    metrics_shard *shards = __atomic_load_n(&g_shards, __ATOMIC_ACQUIRE);
+    int path_count = __atomic_load_n(&g_paths.count, __ATOMIC_ACQUIRE);
+    int type_count = __atomic_load_n(&g_types.count, __ATOMIC_ACQUIRE);
+
+    buf_printf(&b, "# HELP panel_ws_connections Open WebSocket connections per path.\n"
+                   "# TYPE panel_ws_connections gauge\n");
+    for (int i = 0; i < path_count; i++)
+    {
+        int64_t total = 0;
+        for (metrics_shard *s = shards; s; s = s->next)
+        {
+            total += __atomic_load_n(&s->connections[i], __ATOMIC_RELAXED);
+        }
+        buf_printf(&b, "panel_ws_connections{path=\"%s\"} %lld\n", g_paths.names[i],
+                   (long long)total);
+    }
+    buf_printf(&b,
+               "# HELP panel_ws_connection_limit Maximum concurrent WebSocket connections.\n"
+               "# TYPE panel_ws_connection_limit gauge\n"
+               "panel_ws_connection_limit %lld\n"
+               "# HELP panel_ws_connections_rejected_total WebSocket handshakes rejected at a "
+               "connection limit.\n"
+               "# TYPE panel_ws_connections_rejected_total counter\n",
+               (long long)__atomic_load_n(&g_connection_limit, __ATOMIC_RELAXED));
+    for (int i = 0; i < METRICS_REJECT_COUNT; i++)
+    {
+        buf_printf(&b, "panel_ws_connections_rejected_total{reason=\"%s\"} %llu\n",
+                   g_reject_names[i],
+                   (unsigned long long)__atomic_load_n(&g_connections_rejected[i],
+                                                       __ATOMIC_RELAXED));
+    }
+    buf_printf(&b, "# HELP panel_ws_connections_reaped_total WebSocket sessions reclaimed by the "
+                   "keepalive reaper or for a push backlog overflow.\n"
+                   "# TYPE panel_ws_connections_reaped_total counter\n");
+    for (int i = 0; i < METRICS_REAP_COUNT; i++)
+    {
+        buf_printf(&b, "panel_ws_connections_reaped_total{reason=\"%s\"} %llu\n", g_reap_names[i],
+                   (unsigned long long)__atomic_load_n(&g_connections_reaped[i],
+                                                       __ATOMIC_RELAXED));
+    }
+
+    buf_printf(&b, "# HELP panel_ws_messages_total Received WebSocket messages per type.\n"
+                   "# TYPE panel_ws_messages_total counter\n");
+    for (int i = 0; i < type_count; i++)
+    {
+        uint64_t total = 0;
+        for (metrics_shard *s = shards; s; s = s->next)
+        {
+            total += load_u64(&s->messages[i]);
+        }
+        if (total > 0)
+        {
+            buf_printf(&b, "panel_ws_messages_total{type=\"%s\"} %llu\n", g_types.names[i],
+                       (unsigned long long)total);
+        }
+    }
+
+    buf_printf(&b, "# HELP panel_responses_total Responses per module and error code.\n"
+                   "# TYPE panel_responses_total counter\n");
+    for (int m = 0; m < METRICS_MODULE_COUNT; m++)
+    {
+        for (int slot = 0; slot < METRICS_ERROR_SLOTS; slot++)
+        {
+            uint64_t total = 0;
+            for (metrics_shard *s = shards; s; s = s->next)
+            {
+                total += load_u64(&s->responses[m][slot]);
+            }
+            if (total == 0)
+            {
+                continue;
+            }
+            if (slot == METRICS_ERROR_SLOTS - 1)
+            {
+                buf_printf(&b, "panel_responses_total{module=\"%s\",error=\"other\"} %llu\n",
+                           g_module_names[m], (unsigned long long)total);
+            }
+            else
+            {
+                buf_printf(&b, "panel_responses_total{module=\"%s\",error=\"%d\"} %llu\n",
+                           g_module_names[m], slot - 1, (unsigned long long)total);
+            }
+        }
+    }
+
+    metrics_histogram h;
+    buf_printf(&b, "# HELP panel_request_duration_seconds Request latency from receipt to "
+                   "response per type.\n"
+                   "# TYPE panel_request_duration_seconds histogram\n");
+    for (int i = 0; i < type_count; i++)
+    {
+        histogram_sum(offsetof(metrics_shard, requests) + (size_t)i * sizeof(metrics_histogram),
+                      &h);
+        if (h.count > 0)
+        {
+            render_histogram(&b, "panel_request_duration_seconds", "type", g_types.names[i], &h);
+        }
+    }
+
+    buf_printf(&b, "# HELP panel_stage_duration_seconds Time spent per processing stage.\n"
+                   "# TYPE panel_stage_duration_seconds histogram\n");
+    for (int i = 0; i < METRICS_STAGE_COUNT; i++)
+    {
+        histogram_sum(offsetof(metrics_shard, stages) + (size_t)i * sizeof(metrics_histogram),
+                      &h);
+        render_histogram(&b, "panel_stage_duration_seconds", "stage", g_stage_names[i], &h);
+    }
+
+    buf_printf(&b, "# HELP panel_backend_duration_seconds Backend operation duration.\n"
+                   "# TYPE panel_backend_duration_seconds histogram\n");
+    for (int i = 0; i < METRICS_BACKEND_COUNT; i++)
+    {
+        histogram_sum(offsetof(metrics_shard, backend) + (size_t)i * sizeof(metrics_histogram),
+                      &h);
+        render_histogram(&b, "panel_backend_duration_seconds", "op", g_backend_names[i], &h);
+    }
+
+    buf_printf(&b, "# HELP panel_backend_errors_total Failed backend operations.\n"
+                   "# TYPE panel_backend_errors_total counter\n");
+    for (int i = 0; i < METRICS_BACKEND_COUNT; i++)
+    {
+        uint64_t total = 0;
+        for (metrics_shard *s = shards; s; s = s->next)
+        {
+            total += load_u64(&s->backend_errors[i]);
+        }
+        buf_printf(&b, "panel_backend_errors_total{op=\"%s\"} %llu\n", g_backend_names[i],
+                   (unsigned long long)total);
+    }
+
+    buf_printf(&b, "# HELP panel_exec_duration_seconds External command duration.\n"
+                   "# TYPE panel_exec_duration_seconds histogram\n");
+    for (int i = 0; i < METRICS_EXEC_COUNT; i++)
+    {
+        histogram_sum(offsetof(metrics_shard, exec) + (size_t)i * sizeof(metrics_histogram), &h);
+        render_histogram(&b, "panel_exec_duration_seconds", "result", g_exec_names[i], &h);
+    }
+
+    buf_printf(&b, "# HELP panel_alloc_total Allocations per module and request type.\n"
+                   "# TYPE panel_alloc_total counter\n");
+    for (int m = 0; m < METRICS_MODULE_COUNT; m++)
+    {
+        for (int slot = 0; slot <= METRICS_ALLOC_NONE; slot++)
+        {
+            if (slot >= type_count && slot != METRICS_ALLOC_NONE)
+            {
+                continue;
+            }
+            const metrics_alloc_stats *st = &g_alloc[m][slot];
+            uint64_t allocs = load_u64(&st->allocs);
+            if (allocs > 0)
+            {
+                buf_printf(&b, "panel_alloc_total{module=\"%s\",type=\"%s\"} %llu\n",
+                           g_module_names[m],
+                           slot == METRICS_ALLOC_NONE ? "none" : g_types.names[slot],
+                           (unsigned long long)allocs);
+            }
+        }
+    }
+    static const char *const alloc_gauges[2][2] = {
+        {"panel_alloc_live_bytes", "Live allocated bytes per module and request type."},
+        {"panel_alloc_peak_bytes", "Peak live bytes per module and request type."},
+    };
+    for (int g = 0; g < 2; g++)
+    {
+        buf_printf(&b, "# HELP %s %s\n# TYPE %s gauge\n", alloc_gauges[g][0], alloc_gauges[g][1],
+                   alloc_gauges[g][0]);
+        for (int m = 0; m < METRICS_MODULE_COUNT; m++)
+        {
+            for (int slot = 0; slot <= METRICS_ALLOC_NONE; slot++)
+            {
+                if (slot >= type_count && slot != METRICS_ALLOC_NONE)
+                {
+                    continue;
+                }
+                const metrics_alloc_stats *st = &g_alloc[m][slot];
+                if (load_u64(&st->allocs) == 0)
+                {
+                    continue;
+                }
+                int64_t v = __atomic_load_n(g == 0 ? &st->live : &st->peak, __ATOMIC_RELAXED);
+                buf_printf(&b, "%s{module=\"%s\",type=\"%s\"} %lld\n", alloc_gauges[g][0],
+                           g_module_names[m],
+                           slot == METRICS_ALLOC_NONE ? "none" : g_types.names[slot],
+                           (long long)v);
+            }
+        }
+    }
+    buf_printf(&b, "# HELP panel_alloc_module_live_bytes Live allocated bytes per module.\n"
+                   "# TYPE panel_alloc_module_live_bytes gauge\n");
+    for (int m = 0; m < METRICS_MODULE_COUNT; m++)
+    {
+        buf_printf(&b, "panel_alloc_module_live_bytes{module=\"%s\"} %lld\n", g_module_names[m],
+                   (long long)__atomic_load_n(&g_alloc_module[m].live, __ATOMIC_RELAXED));
+    }
+    buf_printf(&b, "# HELP panel_alloc_module_peak_bytes Peak live bytes per module.\n"
+                   "# TYPE panel_alloc_module_peak_bytes gauge\n");
+    for (int m = 0; m < METRICS_MODULE_COUNT; m++)
+    {
+        buf_printf(&b, "panel_alloc_module_peak_bytes{module=\"%s\"} %lld\n", g_module_names[m],
+                   (long long)__atomic_load_n(&g_alloc_module[m].peak, __ATOMIC_RELAXED));
+    }
+
+    buf_printf(&b, "# HELP panel_queue_depth Current depth of module work queues.\n"
+                   "# TYPE panel_queue_depth gauge\n");
+    for (int i = 0; i < METRICS_QUEUE_COUNT; i++)
+    {
+        buf_printf(&b, "panel_queue_depth{queue=\"%s\"} %lld\n", g_queue_names[i],
+                   (long long)__atomic_load_n(&g_queue_depths[i], __ATOMIC_RELAXED));
+    }
+
+    if (b.failed)
+    {
+        free(b.data);
+        return NULL;
+    }
+    if (len)
+    {
+        *len = b.len;
+    }
+    return b.data;
+}
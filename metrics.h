@@ -0,0 +1,379 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file metrics.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 运行指标统计接口（Prometheus文本格式导出）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "cJSON.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICS_PATH "/metrics" ///< HTTP导出路径
+
+#ifndef METRICS_MAX_TYPES
+#define METRICS_MAX_TYPES 32 ///< 最多统计的请求类型数，超出的类型计入"other"
+#endif
+
+#ifndef METRICS_MAX_PATHS
+#define METRICS_MAX_PATHS 8 ///< 最多统计的WebSocket路径数
+#endif
+
+#ifndef METRICS_SLOW_REQUEST_MS
+#define METRICS_SLOW_REQUEST_MS 1000 ///< 慢请求日志阈值(毫秒)，0表示关闭
+#endif
+
+#define METRICS_SLOW_REQUEST_MS_ENV "METRICS_SLOW_REQUEST_MS" ///< 覆盖慢请求阈值的环境变量
+#define METRICS_TRACE_ID_MAX 64                              ///< 追踪中保存的请求ID最大长度
+
+#define METRICS_ERROR_SLOTS 32 ///< 每个模块统计的错误码数（-1..30，其余计入最后一项）
+#define METRICS_BUCKETS 17     ///< 延迟直方图桶数（最后一桶为+Inf）
+
+/**
+ * @brief 请求处理阶段
+ */
+typedef enum
+{
+    METRICS_STAGE_PARSE = 0,  ///< JSON解析
+    METRICS_STAGE_DISPATCH,   ///< 调度器在WebSocket工作线程内的处理
+    METRICS_STAGE_QUEUE_WAIT, ///< 在模块队列中等待
+    METRICS_STAGE_SERIALIZE,  ///< 响应序列化
+    METRICS_STAGE_SEND,       ///< WebSocket写出
+    METRICS_STAGE_COUNT
+} metrics_stage_t;
+
+/**
+ * @brief 模块（错误码统计维度）
+ */
+typedef enum
+{
+    METRICS_MODULE_WIFI = 0,   ///< wifi_error_t
+    METRICS_MODULE_BRIGHTNESS, ///< brightness_error_t
+    METRICS_MODULE_CORE,       ///< 服务器框架（连接、会话表等，不属于具体模块）
+    METRICS_MODULE_COUNT
+} metrics_module_t;
+
+/**
+ * @brief 后端操作
+ */
+typedef enum
+{
+    METRICS_BACKEND_WIFI_ENABLE = 0,  ///< wifi_impl_enable
+    METRICS_BACKEND_WIFI_SCAN,        ///< wifi_impl_scan
+    METRICS_BACKEND_WIFI_STATUS,      ///< wifi_impl_get_status
+    METRICS_BACKEND_WIFI_CONNECT,     ///< wifi_impl_connect
+    METRICS_BACKEND_WIFI_DISCONNECT,  ///< wifi_impl_disconnect
+    METRICS_BACKEND_BRIGHTNESS_READ,  ///< 背光sysfs读取
+    METRICS_BACKEND_BRIGHTNESS_WRITE, ///< 背光sysfs写入
+    METRICS_BACKEND_COUNT
+} metrics_backend_t;
+
+/**
+ * @brief 外部命令执行结果
+ */
+typedef enum
+{
+    METRICS_EXEC_OK = 0,    ///< 正常退出且退出码为0
+    METRICS_EXEC_FAILED,    ///< 无法启动、被信号终止或退出码非0
+    METRICS_EXEC_TIMEOUT,   ///< 超过期限被终止
+    METRICS_EXEC_CANCELLED, ///< 所属操作被取消而终止
+    METRICS_EXEC_COUNT
+} metrics_exec_result_t;
+
+/**
+ * @brief WebSocket握手被拒绝的原因
+ */
+typedef enum
+{
+    METRICS_REJECT_GLOBAL = 0, ///< 达到全局连接数上限
+    METRICS_REJECT_PATH,       ///< 达到该路径的连接数上限
+    METRICS_REJECT_COUNT
+} metrics_reject_reason_t;
+
+/**
+ * @brief WebSocket会话被回收的原因
+ */
+typedef enum
+{
+    METRICS_REAP_PONG_TIMEOUT = 0, ///< PING后在期限内未收到任何帧（半开连接）
+    METRICS_REAP_IDLE,             ///< 超过空闲超时未收到业务消息
+    METRICS_REAP_OVERFLOW,         ///< 推送积压超过发送队列容量（客户端读得太慢）
+    METRICS_REAP_COUNT
+} metrics_reap_reason_t;
+
+/**
+ * @brief 队列深度
+ */
+typedef enum
+{
+    METRICS_QUEUE_WIFI_COMMANDS = 0,  ///< WiFi命令队列排队任务数
+    METRICS_QUEUE_WIFI_READS,         ///< WiFi读通道排队任务数
+    METRICS_QUEUE_BRIGHTNESS_PENDING, ///< 亮度合并器待写入设备数
+    METRICS_QUEUE_COUNT
+} metrics_queue_t;
+
+/**
+ * @brief 单个请求的阶段耗时追踪
+ *
+ * 每个线程有一个当前追踪：ws_data_handler开始追踪，各阶段的metrics_observe_stage与
+ * metrics_observe_backend同时累加到当前追踪，qos_record结束追踪并按阈值记录慢请求日志。
+ * 请求移交给模块队列时用metrics_trace_capture复制追踪，由执行线程metrics_trace_resume继续。
+ */
+typedef struct
+{
+    bool active;                           ///< 是否正在追踪
+    bool debug;                            ///< 请求是否携带debug: true
+    metrics_module_t module;               ///< 处理请求的模块，未识别时为METRICS_MODULE_CORE
+    int type_slot;                         ///< 请求类型在标签表中的下标（用于分配归属）
+    const char *type;                      ///< 请求类型（常量字符串），未识别时为NULL
+    char request_id[METRICS_TRACE_ID_MAX]; ///< 请求ID（截断）
+    int64_t start_us;                      ///< 收到请求的时间
+    int64_t stage_us[METRICS_STAGE_COUNT]; ///< 各阶段累计耗时(微秒)
+    int64_t backend_us;                    ///< 后端操作累计耗时(微秒)
+} metrics_trace;
+
+/**
+ * @brief 在当前线程开始追踪一个请求
+ *
+ * @param start_us 收到请求的qos_now_us()
+ * @param debug 是否在响应中附带timing对象
+ */
+void metrics_trace_begin(int64_t start_us, bool debug);
+
+/**
+ * @brief 为当前追踪记录模块、请求类型与请求ID
+ *
+ * 之后本线程的内存分配归属到该模块与请求类型。
+ *
+ * @param module 处理请求的模块
+ * @param type 请求类型（须为常量字符串）
+ * @param request_id 请求ID（复制，可为NULL）
+ */
+void metrics_trace_identify(metrics_module_t module, const char *type, const char *request_id);
+
+/**
+ * @brief 复制当前追踪，用于把请求移交给其他线程
+ *
+ * @param out 输出追踪，当前线程没有追踪时active为false
+ */
+void metrics_trace_capture(metrics_trace *out);
+
+/**
+ * @brief 在当前线程继续一个移交过来的追踪
+ *
+ * @param trace 追踪（复制）
+ */
+void metrics_trace_resume(const metrics_trace *trace);
+
+/**
+ * @brief 放弃当前线程的追踪（不记录日志）
+ */
+void metrics_trace_clear(void);
+
+/**
+ * @brief 请求携带debug: true时向响应添加timing对象
+ *
+ * 只处理带有request_id的响应；序列化与发送尚未发生，不计入timing。
+ *
+ * @param response 即将发送的响应
+ */
+void metrics_trace_annotate(cJSON *response);
+
+/**
+ * @brief 安装计数分配器为cJSON的内存钩子
+ *
+ * 必须在创建任何cJSON对象之前调用。cJSON分配归属到当前请求的模块与类型，
+ * 没有请求上下文时归属到METRICS_MODULE_CORE。
+ */
+void metrics_alloc_init(void);
+
+/**
+ * @brief 计数分配：记录分配次数、存活字节数与峰值，归属到模块与当前请求类型
+ *
+ * 返回的内存只能用metrics_free/metrics_realloc释放或调整。
+ *
+ * @param module 模块
+ * @param size 字节数
+ * @return void* 失败返回NULL
+ */
+void *metrics_malloc(metrics_module_t module, size_t size);
+
+/**
+ * @brief 计数分配并清零
+ *
+ * @param module 模块
+ * @param count 元素个数
+ * @param size 元素大小
+ * @return void* 失败返回NULL
+ */
+void *metrics_calloc(metrics_module_t module, size_t count, size_t size);
+
+/**
+ * @brief 调整计数分配的内存大小
+ *
+ * @param module 模块
+ * @param ptr 原指针（可为NULL）
+ * @param size 新字节数
+ * @return void* 失败返回NULL，原内存保持不变
+ */
+void *metrics_realloc(metrics_module_t module, void *ptr, size_t size);
+
+/**
+ * @brief 计数分配的strdup
+ *
+ * @param module 模块
+ * @param s 源字符串
+ * @return char* 失败返回NULL
+ */
+char *metrics_strdup(metrics_module_t module, const char *s);
+
+/**
+ * @brief 计数分配的strndup
+ *
+ * @param module 模块
+ * @param s 源字符串
+ * @param n 最多复制的字符数
+ * @return char* 失败返回NULL
+ */
+char *metrics_strndup(metrics_module_t module, const char *s, size_t n);
+
+/**
+ * @brief 释放计数分配的内存
+ *
+ * @param ptr 指针（可为NULL）
+ */
+void metrics_free(void *ptr);
+
+/**
+ * @brief 连接建立
+ *
+ * @param path WebSocket路径（须为常量字符串）
+ */
+void metrics_connection_opened(const char *path);
+
+/**
+ * @brief 连接关闭
+ *
+ * @param path WebSocket路径（须为常量字符串）
+ */
+void metrics_connection_closed(const char *path);
+
+/**
+ * @brief 设置WebSocket连接数上限（导出为panel_ws_connection_limit）
+ *
+ * @param limit 上限
+ */
+void metrics_set_connection_limit(int64_t limit);
+
+/**
+ * @brief 统计一次因达到连接数上限而被拒绝的WebSocket握手
+ *
+ * @param reason 拒绝原因
+ */
+void metrics_connection_rejected(metrics_reject_reason_t reason);
+
+/**
+ * @brief 统计一次被回收的WebSocket会话
+ *
+ * @param reason 回收原因
+ */
+void metrics_connection_reaped(metrics_reap_reason_t reason);
+
+/**
+ * @brief 统计一条收到的消息
+ *
+ * @param type 请求类型（须为调度表中的常量字符串），NULL计为"unknown"
+ */
+void metrics_count_message(const char *type);
+
+/**
+ * @brief 统计一次模块响应的错误码
+ *
+ * @param module 模块
+ * @param code 错误码（0表示成功）
+ */
+void metrics_count_error(metrics_module_t module, int code);
+
+/**
+ * @brief 按响应中的error字段统计模块错误码
+ *
+ * @param module 模块
+ * @param response 响应JSON对象
+ */
+void metrics_count_response(metrics_module_t module, const cJSON *response);
+
+/**
+ * @brief 记录请求从收到到响应发出的延迟，并结束当前线程的追踪
+ *
+ * 延迟超过慢请求阈值时输出包含各阶段耗时的日志。
+ *
+ * @param type 请求类型（须为常量字符串）
+ * @param latency_us 延迟(微秒)
+ */
+void metrics_observe_request(const char *type, int64_t latency_us);
+
+/**
+ * @brief 记录处理阶段耗时
+ *
+ * @param stage 阶段
+ * @param latency_us 耗时(微秒)
+ */
+void metrics_observe_stage(metrics_stage_t stage, int64_t latency_us);
+
+/**
+ * @brief 记录一次后端操作
+ *
+ * @param op 操作
+ * @param latency_us 耗时(微秒)
+ * @param ok 是否成功
+ */
+void metrics_observe_backend(metrics_backend_t op, int64_t latency_us, bool ok);
+
+/**
+ * @brief 记录一次外部命令执行（不计入请求追踪，耗时已包含在所属后端操作中）
+ *
+ * @param result 执行结果
+ * @param latency_us 从启动到回收子进程的耗时(微秒)
+ */
+void metrics_observe_exec(metrics_exec_result_t result, int64_t latency_us);
+
+/**
+ * @brief 设置队列深度
+ *
+ * @param queue 队列
+ * @param depth 当前深度
+ */
+void metrics_set_queue_depth(metrics_queue_t queue, int64_t depth);
+
+/**
+ * @brief 以Prometheus文本格式输出所有指标
+ *
+ * @param len 输出文本长度（可为NULL）
+ * @return char* 文本（调用者free），失败返回NULL
+ */
+char *metrics_render(size_t *len);
+
+#endif
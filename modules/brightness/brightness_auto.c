@@ -0,0 +1,290 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_auto.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 自动亮度控制实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_auto.h"
+#include "../../reactor.h"
+#include "brightness_persist.h"
+#include "brightness_watcher.h"
+#include "impl/brightness_als.h"
+#include "impl/brightness_impl.h"
+#include "impl/brightness_ramp.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static const brightness_auto_point g_auto_curve[] = BRIGHTNESS_AUTO_CURVE;
+#define BRIGHTNESS_AUTO_CURVE_SIZE (sizeof(g_auto_curve) / sizeof(g_auto_curve[0]))
+
+/**
+ * @brief 自动亮度状态
+ */
+typedef struct
+{
+    pthread_mutex_t lock; ///< 保护以下字段及传感器读取
+    int timer_fd;         ///< 采样定时器（reactor定时器），关闭自动亮度时停止
+    bool started;         ///< 采样定时器是否已注册
+    bool enabled;         ///< 是否启用自动亮度
+    bool has_ema;         ///< 是否已有平均值
+    int64_t ema_mlux;     ///< 照度指数平均值(毫勒克斯)
+    int64_t applied_mlux; ///< 上次调节时的照度
+    int applied_percent;  ///< 上次调节的目标亮度，-1表示尚未调节
+    int interval_ms;      ///< 当前采样间隔
+    int device;           ///< 调节的背光设备（默认设备）
+} brightness_auto;
+
+static brightness_auto g_auto = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .timer_fd = -1,
+    .applied_percent = -1,
+    .interval_ms = BRIGHTNESS_AUTO_MIN_INTERVAL_MS,
+    .device = -1,
+};
+
+/**
+ * @brief 按亮度曲线将照度换算为亮度百分比
+ *
+ * @param mlux 照度(毫勒克斯)
+ * @return int 亮度百分比（0-100）
+ */
+static int auto_curve_percent(int64_t mlux)
+{
+    if (mlux <= (int64_t)g_auto_curve[0].lux * 1000)
+    {
+        return g_auto_curve[0].percent;
+    }
+    for (size_t i = 1; i < BRIGHTNESS_AUTO_CURVE_SIZE; i++)
+    {
+        int64_t x1 = (int64_t)g_auto_curve[i].lux * 1000;
+        if (mlux <= x1)
+        {
+            int64_t x0 = (int64_t)g_auto_curve[i - 1].lux * 1000;
+            int y0 = g_auto_curve[i - 1].percent;
+            int y1 = g_auto_curve[i].percent;
+            if (x1 == x0)
+            {
+                return y1;
+            }
+            return y0 + (int)((int64_t)(y1 - y0) * (mlux - x0) / (x1 - x0));
+        }
+    }
+    return g_auto_curve[BRIGHTNESS_AUTO_CURVE_SIZE - 1].percent;
+}
+
+/**
+ * @brief 取绝对值
+ *
+ * @param v 数值
+ * @return int64_t 绝对值
+ */
+static int64_t auto_abs64(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+/**
+ * @brief 采样一次并在照度变化超出门限时调节亮度（调用者持有lock）
+ *
+ * @param a 自动亮度状态
+ * @return int 新的目标亮度，未调节返回-1
+ */
+static int auto_sample_locked(brightness_auto *a)
+{
+    int64_t mlux = 0;
+    if (brightness_als_read(&mlux) != BRIGHTNESS_ERR_OK)
+    {
+        a->interval_ms = BRIGHTNESS_AUTO_MAX_INTERVAL_MS;
+        return -1;
+    }
+
+    bool first = !a->has_ema;
+    if (first)
+    {
+        a->ema_mlux = mlux;
+        a->has_ema = true;
+    }
+    else
+    {
+        a->ema_mlux += (mlux - a->ema_mlux) / (1 << BRIGHTNESS_AUTO_EMA_SHIFT);
+    }
+
+    int64_t threshold = a->applied_mlux * BRIGHTNESS_AUTO_HYSTERESIS_PERCENT / 100;
+    if (threshold < BRIGHTNESS_AUTO_HYSTERESIS_MIN_MLUX)
+    {
+        threshold = BRIGHTNESS_AUTO_HYSTERESIS_MIN_MLUX;
+    }
+
+    // 采样值仍偏离平均值时保持高频采样，环境光稳定后逐步降低采样频率
+    if (auto_abs64(mlux - a->ema_mlux) > threshold)
+    {
+        a->interval_ms = BRIGHTNESS_AUTO_MIN_INTERVAL_MS;
+    }
+    else if (a->interval_ms < BRIGHTNESS_AUTO_MAX_INTERVAL_MS)
+    {
+        a->interval_ms *= 2;
+        if (a->interval_ms > BRIGHTNESS_AUTO_MAX_INTERVAL_MS)
+        {
+            a->interval_ms = BRIGHTNESS_AUTO_MAX_INTERVAL_MS;
+        }
+    }
+
+    if (!first && auto_abs64(a->ema_mlux - a->applied_mlux) <= threshold)
+    {
+        return -1;
+    }
+    a->applied_mlux = a->ema_mlux;
+    a->interval_ms = BRIGHTNESS_AUTO_MIN_INTERVAL_MS;
+
+    int percent = auto_curve_percent(a->ema_mlux);
+    if (percent == a->applied_percent)
+    {
+        return -1;
+    }
+    a->device = brightness_impl_default_device();
+    brightness_error_t err =
+        brightness_ramp_start(a->device, percent, BRIGHTNESS_AUTO_TRANSITION_MS);
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        fprintf(stderr, "brightness_auto: 调节亮度失败 (错误码 %d)\n", err);
+        return -1;
+    }
+    a->applied_percent = percent;
+    return percent;
+}
+
+/**
+ * @brief 采样定时器回调（事件线程）：采样一次并按自适应间隔安排下一次采样
+ *
+ * @param arg 自动亮度状态
+ */
+static void brightness_auto_tick(void *arg)
+{
+    brightness_auto *a = (brightness_auto *)arg;
+
+    pthread_mutex_lock(&a->lock);
+    if (!a->enabled)
+    {
+        pthread_mutex_unlock(&a->lock);
+        return;
+    }
+    int percent = auto_sample_locked(a);
+    int device = a->device;
+    reactor_timer_arm(a->timer_fd, a->interval_ms, 0);
+    pthread_mutex_unlock(&a->lock);
+
+    if (percent >= 0)
+    {
+        brightness_persist_note(device, percent);
+        brightness_event_broadcast(device, percent);
+    }
+}
+
+/**
+ * @brief 注册自动亮度采样定时器
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_auto_init(void)
+{
+    brightness_auto *a = &g_auto;
+    a->timer_fd = reactor_timer_create(brightness_auto_tick, a);
+    if (a->timer_fd < 0)
+    {
+        fprintf(stderr, "brightness_auto_init: 无法创建采样定时器\n");
+        return -1;
+    }
+    a->started = true;
+    return 0;
+}
+
+/**
+ * @brief 注销自动亮度采样定时器
+ */
+void brightness_auto_deinit(void)
+{
+    brightness_auto *a = &g_auto;
+    if (!a->started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&a->lock);
+    a->started = false;
+    __atomic_store_n(&a->enabled, false, __ATOMIC_RELAXED);
+    reactor_timer_arm(a->timer_fd, 0, 0);
+    pthread_mutex_unlock(&a->lock);
+    reactor_timer_destroy(a->timer_fd);
+    a->timer_fd = -1;
+    brightness_als_close();
+}
+
+/**
+ * @brief 启用或关闭自动亮度
+ *
+ * @param enable 是否启用
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_auto_set_enabled(bool enable)
+{
+    brightness_auto *a = &g_auto;
+    if (!a->started)
+    {
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+
+    brightness_error_t err = BRIGHTNESS_ERR_OK;
+    pthread_mutex_lock(&a->lock);
+    if (enable && !a->enabled)
+    {
+        err = brightness_als_open();
+        if (err == BRIGHTNESS_ERR_OK)
+        {
+            a->has_ema = false;
+            a->applied_percent = -1;
+            a->interval_ms = BRIGHTNESS_AUTO_MIN_INTERVAL_MS;
+            __atomic_store_n(&a->enabled, true, __ATOMIC_RELAXED);
+            // 启用后尽快采样一次
+            reactor_timer_arm(a->timer_fd, 1, 0);
+        }
+    }
+    else if (!enable && a->enabled)
+    {
+        __atomic_store_n(&a->enabled, false, __ATOMIC_RELAXED);
+        reactor_timer_arm(a->timer_fd, 0, 0);
+        brightness_als_close();
+    }
+    pthread_mutex_unlock(&a->lock);
+    return err;
+}
+
+/**
+ * @brief 查询自动亮度是否启用
+ *
+ * @return bool 是否启用
+ */
+bool brightness_auto_enabled(void)
+{
+    return __atomic_load_n(&g_auto.enabled, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,104 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_auto.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 自动亮度控制声明（环境光传感器 -> 亮度曲线 -> 渐变写入）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_AUTO_H
+#define BRIGHTNESS_AUTO_H
+
+#include "brightness_def.h"
+
+#ifndef BRIGHTNESS_AUTO_MIN_INTERVAL_MS
+#define BRIGHTNESS_AUTO_MIN_INTERVAL_MS 250 ///< 环境光变化时的采样间隔(毫秒)
+#endif
+
+#ifndef BRIGHTNESS_AUTO_MAX_INTERVAL_MS
+#define BRIGHTNESS_AUTO_MAX_INTERVAL_MS 4000 ///< 环境光稳定时的最长采样间隔(毫秒)
+#endif
+
+#ifndef BRIGHTNESS_AUTO_TRANSITION_MS
+#define BRIGHTNESS_AUTO_TRANSITION_MS 1000 ///< 自动调节时的渐变时间(毫秒)
+#endif
+
+#ifndef BRIGHTNESS_AUTO_EMA_SHIFT
+#define BRIGHTNESS_AUTO_EMA_SHIFT 2 ///< 指数平均系数为1/2^N
+#endif
+
+#ifndef BRIGHTNESS_AUTO_HYSTERESIS_PERCENT
+#define BRIGHTNESS_AUTO_HYSTERESIS_PERCENT 10 ///< 照度相对变化超过该比例才调节
+#endif
+
+#ifndef BRIGHTNESS_AUTO_HYSTERESIS_MIN_MLUX
+#define BRIGHTNESS_AUTO_HYSTERESIS_MIN_MLUX 1000 ///< 照度变化的最小调节门限(毫勒克斯)
+#endif
+
+// 照度(勒克斯) -> 亮度百分比曲线，点之间线性插值，照度须递增
+// 可在编译时通过 -DBRIGHTNESS_AUTO_CURVE="{{0, 10}, {500, 100}}" 覆盖
+#ifndef BRIGHTNESS_AUTO_CURVE
+#define BRIGHTNESS_AUTO_CURVE                                                                      \
+    {                                                                                              \
+        {0, 5}, {10, 15}, {50, 30}, {200, 50}, {1000, 75}, {5000, 100}                             \
+    } ///< 默认亮度曲线
+#endif
+
+/**
+ * @brief 亮度曲线上的点
+ */
+typedef struct
+{
+    int lux;     ///< 环境照度(勒克斯)
+    int percent; ///< 对应的亮度百分比
+} brightness_auto_point;
+
+/**
+ * @brief 注册自动亮度采样定时器（默认关闭自动亮度，须在reactor_init之后调用）
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_auto_init(void);
+
+/**
+ * @brief 注销自动亮度采样定时器
+ */
+void brightness_auto_deinit(void);
+
+/**
+ * @brief 启用或关闭自动亮度
+ *
+ * 启用时打开环境光传感器，之后按采样结果以渐变方式调节默认背光设备的亮度。
+ * 采样在事件线程上按自适应间隔进行，返回后（关闭时）不会再发起新的渐变。
+ *
+ * @param enable 是否启用
+ * @return brightness_error_t 错误码，无传感器时返回BRIGHTNESS_ERR_NOT_SUPPORTED
+ */
+brightness_error_t brightness_auto_set_enabled(bool enable);
+
+/**
+ * @brief 查询自动亮度是否启用
+ *
+ * @return bool 是否启用
+ */
+bool brightness_auto_enabled(void);
+
+#endif
@@ -0,0 +1,431 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file brightness_coalescer.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度设置请求合并器实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_coalescer.h"
+#include "../../metrics.h"
+#include "../../protocol/protocol_utils.h"
+#include "../../qos.h"
+#include "brightness_persist.h"
+#include "impl/brightness_impl.h"
+#include "impl/brightness_ramp.h"
+#include "protocol/brightness_set.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 等待回复的设置请求
+ */
+typedef struct brightness_waiter
+{
+    struct brightness_waiter *next; ///< 下一个等待者
+    struct mg_connection *conn;     ///< 发起请求的连接，NULL表示连接已关闭
+    const char *response_type;      ///< 响应类型（指向调度表中的常量字符串）
+    char *request_id;               ///< 请求ID副本
+    int64_t start_us;               ///< 收到请求的时间
+    int64_t deadline_us;            ///< 请求期限，0表示没有
+    int64_t enqueue_us;             ///< 提交到合并器的时间
+    metrics_trace trace;            ///< 提交线程移交的请求追踪
+} brightness_waiter;
+
+/**
+ * @brief 单个背光设备的待写入状态
+ */
+typedef struct
+{
+    bool has_pending;                ///< 是否有待写入的值
+    int pending;                     ///< 待写入的亮度（最新一次请求）
+    int pending_transition_ms;       ///< 待写入请求的渐变时间
+    brightness_waiter *waiters_head; ///< 等待下一次写入的请求
+    brightness_waiter *waiters_tail; ///< 等待队列尾
+} brightness_coalescer_slot;
+
+/**
+ * @brief 合并器状态（所有设备共用一个写入线程，各设备独立合并）
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                                    ///< 保护以下字段
+    pthread_cond_t cond;                                     ///< 有待写入的值或需要退出
+    pthread_cond_t sent;                                     ///< 写入线程完成一次回复发送
+    pthread_t thread;                                        ///< 写入线程
+    bool started;                                            ///< 写入线程是否已启动
+    bool stop;                                               ///< 是否请求退出
+    int pending_count;                                       ///< 有待写入值的设备数量
+    int next_slot;                                           ///< 下一次优先检查的设备
+    brightness_coalescer_slot slots[BRIGHTNESS_MAX_DEVICES]; ///< 各设备的待写入状态
+    brightness_waiter *inflight;                             ///< 正在写入的值对应的请求
+    brightness_waiter *expired;                              ///< 期限已过、等待回复超时的请求
+    const struct mg_connection *sending;                     ///< 写入线程正在（不持锁）回复的连接
+} brightness_coalescer;
+
+static brightness_coalescer g_coalescer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .sent = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * @brief 释放等待者链表
+ *
+ * @param w 链表头
+ */
+static void brightness_waiters_free(brightness_waiter *w)
+{
+    while (w)
+    {
+        brightness_waiter *next = w->next;
+        metrics_free(w->request_id);
+        metrics_free(w);
+        w = next;
+    }
+}
+
+/**
+ * @brief 向一批等待者回复写入结果（调用者不持有lock）
+ *
+ * 等待者仍挂在合并器上，连接关闭时可被解除关联：每次发送前在锁内取出连接并登记为sending，
+ * 关闭处理器等待sending清空后才返回，发送本身不持锁，慢连接不会阻塞其他设置请求。
+ *
+ * @param c 合并器
+ * @param waiters 等待者链表
+ * @param device 设备名
+ * @param resp 写入结果
+ * @param write_start_us 开始写入的时间
+ * @param write_us 写入耗时(微秒)，所有被合并的请求共同承担
+ */
+static void brightness_coalescer_reply(brightness_coalescer *c, brightness_waiter *waiters,
+                                       const char *device, const brightness_set_resp_t *resp,
+                                       int64_t write_start_us, int64_t write_us)
+{
+    for (brightness_waiter *w = waiters; w; w = w->next)
+    {
+        pthread_mutex_lock(&c->lock);
+        struct mg_connection *conn = w->conn;
+        c->sending = conn;
+        pthread_mutex_unlock(&c->lock);
+        if (!conn)
+        {
+            continue;
+        }
+        w->trace.backend_us += write_us;
+        metrics_trace_resume(&w->trace);
+        metrics_observe_stage(METRICS_STAGE_QUEUE_WAIT, write_start_us - w->enqueue_us);
+        cJSON *response = protocol_create_response(
+            w->response_type, w->request_id, (resp->error == BRIGHTNESS_ERR_OK), resp->error);
+        if (response)
+        {
+            if (resp->error == BRIGHTNESS_ERR_OK)
+            {
+                cJSON *res_data = cJSON_GetObjectItem(response, "data");
+                if (res_data)
+                {
+                    cJSON_AddStringToObject(res_data, "device", device);
+                    cJSON_AddNumberToObject(res_data, "brightness", resp->brightness);
+                }
+            }
+            protocol_send_response(conn, response);
+            cJSON_Delete(response);
+        }
+        metrics_count_error(METRICS_MODULE_BRIGHTNESS, resp->error);
+        qos_record(QOS_CLASS_INTERACTIVE, "brightness_set_request", w->start_us);
+
+        pthread_mutex_lock(&c->lock);
+        c->sending = NULL;
+        pthread_cond_broadcast(&c->sent);
+        pthread_mutex_unlock(&c->lock);
+    }
+}
+
+/**
+ * @brief 从等待者链表中摘出期限已过的请求（调用者持有lock）
+ *
+ * @param waiters 等待者链表
+ * @param expired 输出期限已过的等待者链表，需回复BRIGHTNESS_ERR_TIMEOUT
+ * @return brightness_waiter* 剩余的等待者链表
+ */
+static brightness_waiter *brightness_waiters_shed_expired(brightness_waiter *waiters,
+                                                          brightness_waiter **expired)
+{
+    brightness_waiter *live = NULL;
+    brightness_waiter **tail = &live;
+    brightness_waiter **expired_tail = expired;
+    while (waiters)
+    {
+        brightness_waiter *w = waiters;
+        waiters = w->next;
+        w->next = NULL;
+        if (protocol_deadline_expired(w->deadline_us))
+        {
+            *expired_tail = w;
+            expired_tail = &w->next;
+        }
+        else
+        {
+            *tail = w;
+            tail = &w->next;
+        }
+    }
+    return live;
+}
+
+/**
+ * @brief 写入线程：每次只写入最新的值，并回复期间累积的所有请求
+ *
+ * @param arg 合并器
+ * @return void* 始终为NULL
+ */
+static void *brightness_coalescer_worker(void *arg)
+{
+    brightness_coalescer *c = (brightness_coalescer *)arg;
+
+    pthread_mutex_lock(&c->lock);
+    while (!c->stop)
+    {
+        if (c->pending_count == 0)
+        {
+            pthread_cond_wait(&c->cond, &c->lock);
+            continue;
+        }
+
+        // 轮流检查各设备，避免一个设备的连续请求饿死其他设备
+        int dev = c->next_slot;
+        while (!c->slots[dev].has_pending)
+        {
+            dev = (dev + 1) % BRIGHTNESS_MAX_DEVICES;
+        }
+        c->next_slot = (dev + 1) % BRIGHTNESS_MAX_DEVICES;
+
+        brightness_coalescer_slot *slot = &c->slots[dev];
+        brightness_set_req_t req = {.device = dev,
+                                    .brightness = slot->pending,
+                                    .transition_ms = slot->pending_transition_ms,
+                                    .valid = true};
+        slot->has_pending = false;
+        c->pending_count--;
+        metrics_set_queue_depth(METRICS_QUEUE_BRIGHTNESS_PENDING, c->pending_count);
+        c->expired = NULL;
+        c->inflight = brightness_waiters_shed_expired(slot->waiters_head, &c->expired);
+        slot->waiters_head = NULL;
+        slot->waiters_tail = NULL;
+        brightness_waiter *expired = c->expired;
+        brightness_waiter *live = c->inflight;
+        pthread_mutex_unlock(&c->lock);
+
+        // 回复期间等待者仍挂在expired/inflight上，连接关闭时可被解除关联
+        if (expired)
+        {
+            const brightness_set_resp_t timeout = {.error = BRIGHTNESS_ERR_TIMEOUT};
+            brightness_coalescer_reply(c, expired, NULL, &timeout, qos_now_us(), 0);
+        }
+        // 合并的请求都已过期时没有人等待这次写入
+        if (live)
+        {
+            int64_t write_start_us = qos_now_us();
+            brightness_set_resp_t resp = brightness_set(&req);
+            int64_t write_us = qos_now_us() - write_start_us;
+            if (resp.error == BRIGHTNESS_ERR_OK)
+            {
+                brightness_persist_note(dev, resp.brightness);
+            }
+            brightness_device_info_t info = {0};
+            brightness_impl_device_info(dev, &info);
+            brightness_coalescer_reply(c, live, info.name, &resp, write_start_us, write_us);
+        }
+
+        pthread_mutex_lock(&c->lock);
+        c->expired = NULL;
+        c->inflight = NULL;
+        brightness_waiters_free(expired);
+        brightness_waiters_free(live);
+    }
+    pthread_mutex_unlock(&c->lock);
+    return NULL;
+}
+
+/**
+ * @brief 启动亮度写入线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_coalescer_init(void)
+{
+    brightness_coalescer *c = &g_coalescer;
+    c->stop = false;
+    if (pthread_create(&c->thread, NULL, brightness_coalescer_worker, c) != 0)
+    {
+        fprintf(stderr, "brightness_coalescer_init: 无法创建写入线程\n");
+        return -1;
+    }
+    c->started = true;
+    return 0;
+}
+
+/**
+ * @brief 停止亮度写入线程，丢弃未完成的请求
+ */
+void brightness_coalescer_deinit(void)
+{
+    brightness_coalescer *c = &g_coalescer;
+    if (!c->started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&c->lock);
+    c->stop = true;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+    c->started = false;
+
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        brightness_coalescer_slot *slot = &c->slots[dev];
+        brightness_waiters_free(slot->waiters_head);
+        slot->waiters_head = NULL;
+        slot->waiters_tail = NULL;
+        slot->has_pending = false;
+    }
+    c->pending_count = 0;
+}
+
+/**
+ * @brief 提交亮度设置请求
+ *
+ * @param conn 发起请求的连接
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param device 设备索引
+ * @param percent 亮度百分比
+ * @param transition_ms 渐变时间(毫秒)
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限，0表示没有
+ * @return brightness_error_t BRIGHTNESS_ERR_OK表示已提交
+ */
+brightness_error_t brightness_coalescer_submit(struct mg_connection *conn,
+                                               const char *response_type, const char *request_id,
+                                               int device, int percent, int transition_ms,
+                                               int64_t start_us, int64_t deadline_us)
+{
+    brightness_coalescer *c = &g_coalescer;
+    if (device < 0 || device >= BRIGHTNESS_MAX_DEVICES)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+    if (!c->started)
+    {
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+
+    brightness_waiter *w = (brightness_waiter *)metrics_calloc(METRICS_MODULE_BRIGHTNESS, 1,
+                                                               sizeof(brightness_waiter));
+    if (!w)
+    {
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+    w->conn = conn;
+    w->response_type = response_type;
+    w->request_id = metrics_strdup(METRICS_MODULE_BRIGHTNESS, request_id ? request_id : "");
+    w->start_us = start_us;
+    w->deadline_us = deadline_us;
+    w->enqueue_us = qos_now_us();
+    metrics_trace_capture(&w->trace);
+    if (!w->request_id)
+    {
+        metrics_free(w);
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+
+    // 新的设置请求立即终止进行中的渐变，不等写入线程处理
+    brightness_ramp_cancel(device);
+
+    pthread_mutex_lock(&c->lock);
+    brightness_coalescer_slot *slot = &c->slots[device];
+    slot->pending = percent;
+    slot->pending_transition_ms = transition_ms;
+    if (!slot->has_pending)
+    {
+        slot->has_pending = true;
+        c->pending_count++;
+        metrics_set_queue_depth(METRICS_QUEUE_BRIGHTNESS_PENDING, c->pending_count);
+    }
+    if (slot->waiters_tail)
+    {
+        slot->waiters_tail->next = w;
+    }
+    else
+    {
+        slot->waiters_head = w;
+    }
+    slot->waiters_tail = w;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+    return BRIGHTNESS_ERR_OK;
+}
+
+/**
+ * @brief 解除连接与待回复请求的关联
+ *
+ * @param conn 正在关闭的连接
+ */
+void brightness_coalescer_detach_connection(const struct mg_connection *conn)
+{
+    brightness_coalescer *c = &g_coalescer;
+
+    pthread_mutex_lock(&c->lock);
+    for (brightness_waiter *w = c->inflight; w; w = w->next)
+    {
+        if (w->conn == conn)
+        {
+            w->conn = NULL;
+        }
+    }
+    for (brightness_waiter *w = c->expired; w; w = w->next)
+    {
+        if (w->conn == conn)
+        {
+            w->conn = NULL;
+        }
+    }
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        for (brightness_waiter *w = c->slots[dev].waiters_head; w; w = w->next)
+        {
+            if (w->conn == conn)
+            {
+                w->conn = NULL;
+            }
+        }
+    }
+    // 写入线程可能正在不持锁地回复该连接，等发送结束后连接才能释放
+    while (c->sending == conn)
+    {
+        pthread_cond_wait(&c->sent, &c->lock);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
@@ -0,0 +1,78 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file brightness_coalescer.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度设置请求合并器声明（只写入最新值）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_COALESCER_H
+#define BRIGHTNESS_COALESCER_H
+
+#include "brightness_def.h"
+#include "civetweb.h"
+#include <stdint.h>
+
+/**
+ * @brief 启动亮度写入线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_coalescer_init(void);
+
+/**
+ * @brief 停止亮度写入线程，丢弃未完成的请求
+ */
+void brightness_coalescer_deinit(void);
+
+/**
+ * @brief 提交亮度设置请求
+ *
+ * 写入进行中时新请求覆盖同一设备待写入的值，写入完成后只写入最新值（后沿写入）。
+ * 不同设备的请求互不合并。
+ * 被覆盖的请求与最终写入的请求一起回复，响应中的亮度为实际写入的值。
+ * 提交时立即取消进行中的渐变；带渐变时间的请求在渐变开始后即回复。
+ * 轮到写入时期限已过的请求回复BRIGHTNESS_ERR_TIMEOUT，合并的请求全部过期时不写入sysfs。
+ *
+ * @param conn 发起请求的连接
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param device 设备索引
+ * @param percent 亮度百分比（调用者已校验范围）
+ * @param transition_ms 渐变时间(毫秒)，0表示立即设置（调用者已校验范围）
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限（qos_now_us()时间，见protocol_get_deadline_us），0表示没有
+ * @return brightness_error_t BRIGHTNESS_ERR_OK表示已提交，响应由写入线程发送
+ */
+brightness_error_t brightness_coalescer_submit(struct mg_connection *conn,
+                                               const char *response_type, const char *request_id,
+                                               int device, int percent, int transition_ms,
+                                               int64_t start_us, int64_t deadline_us);
+
+/**
+ * @brief 解除连接与待回复请求的关联
+ *
+ * 写入线程正在向该连接发送回复时等待发送结束，返回后不会再向该连接写入。
+ *
+ * @param conn 正在关闭的连接
+ */
+void brightness_coalescer_detach_connection(const struct mg_connection *conn);
+
+#endif
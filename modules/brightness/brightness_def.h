@@ -29,6 +29,10 @@ limitations under the License.
 #include <stdbool.h>
 #include <stddef.h>
 
+#define BRIGHTNESS_MAX_DEVICES 8      ///< 支持的背光设备数量上限
+#define BRIGHTNESS_DEVICE_NAME_MAX 64 ///< 背光设备名最大长度（含结尾0）
+#define BRIGHTNESS_DEVICE_TYPE_MAX 16 ///< 背光设备类型最大长度（含结尾0）
+
 /**
  * @brief 亮度模块错误码
  */
@@ -41,7 +45,8 @@ typedef enum
     BRIGHTNESS_ERR_NOT_SUPPORTED = 3, ///< 设备不支持亮度调节
     BRIGHTNESS_ERR_PERMISSION = 4,    ///< 权限不足
     BRIGHTNESS_ERR_DEVICE_ERROR = 5,  ///< 硬件设备错误
-    BRIGHTNESS_ERR_INTERNAL = 6       ///< 后端内部错误
+    BRIGHTNESS_ERR_INTERNAL = 6,      ///< 后端内部错误
+    BRIGHTNESS_ERR_TIMEOUT = 7        ///< 请求期限已过，未执行
 } brightness_error_t;
 
 /**
@@ -49,8 +54,10 @@ typedef enum
  */
 typedef struct
 {
-    int brightness; ///< 亮度值（0-100）
-    bool valid;    ///< 请求是否有效
+    int device;        ///< 背光设备索引
+    int brightness;    ///< 亮度值（0-100）
+    int transition_ms; ///< 渐变时间(毫秒)，0表示立即设置
+    bool valid;        ///< 请求是否有效
 } brightness_set_req_t;
 
 /**
@@ -62,6 +69,24 @@ typedef struct
     int brightness;          ///< 实际设置的亮度值
 } brightness_set_resp_t;
 
+/**
+ * @brief 自动亮度请求结构体
+ */
+typedef struct
+{
+    bool enable; ///< 是否启用自动亮度
+    bool valid;  ///< 请求是否有效
+} brightness_auto_req_t;
+
+/**
+ * @brief 自动亮度响应结构体
+ */
+typedef struct
+{
+    brightness_error_t error; ///< 错误码
+    bool auto_brightness;     ///< 当前自动亮度状态
+} brightness_auto_resp_t;
+
 /**
  * @brief 查询亮度响应结构体
  */
@@ -71,4 +96,25 @@ typedef struct
     int brightness;          ///< 当前亮度值（0-100）
 } brightness_status_resp_t;
 
+/**
+ * @brief 背光设备信息
+ */
+typedef struct
+{
+    char name[BRIGHTNESS_DEVICE_NAME_MAX]; ///< 设备名（/sys/class/backlight下的目录名）
+    char type[BRIGHTNESS_DEVICE_TYPE_MAX]; ///< 设备类型（firmware/platform/raw）
+    int max_brightness;                    ///< 最大原始亮度
+    bool is_default;                       ///< 是否为默认设备
+} brightness_device_info_t;
+
+/**
+ * @brief 背光设备列表响应结构体
+ */
+typedef struct
+{
+    brightness_error_t error;                                 ///< 错误码
+    int count;                                                ///< 设备数量
+    brightness_device_info_t devices[BRIGHTNESS_MAX_DEVICES]; ///< 设备列表
+} brightness_devices_resp_t;
+
 #endif
@@ -0,0 +1,249 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_persist.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度持久化实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_persist.h"
+#include "../../reactor.h"
+#include "impl/brightness_impl.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief 持久化状态
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                ///< 保护以下字段
+    int timer_fd;                        ///< 延迟写入定时器（reactor定时器）
+    bool started;                        ///< 延迟写入定时器是否已注册
+    bool dirty;                          ///< 是否有未写入的值
+    int percent[BRIGHTNESS_MAX_DEVICES]; ///< 各设备最新应用的亮度，-1表示未知
+    char path[256];                      ///< 持久化文件路径，空串表示不持久化
+} brightness_persist;
+
+static brightness_persist g_persist = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .timer_fd = -1,
+};
+
+/**
+ * @brief 解析持久化文件路径
+ *
+ * @param p 持久化状态
+ */
+static void persist_resolve_path(brightness_persist *p)
+{
+    const char *path = getenv(BRIGHTNESS_PERSIST_PATH_ENV);
+    if (!path)
+    {
+        path = BRIGHTNESS_PERSIST_PATH;
+    }
+    snprintf(p->path, sizeof(p->path), "%s", path);
+}
+
+/**
+ * @brief 将亮度写入临时文件后原子替换持久化文件
+ *
+ * @param path 持久化文件路径
+ * @param percent 各设备亮度
+ * @return int 成功返回0，失败返回-1
+ */
+static int persist_write_file(const char *path, const int *percent)
+{
+    char tmp[272];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp)
+    {
+        perror("brightness_persist: fopen");
+        return -1;
+    }
+
+    // 每行一个设备：设备名 亮度百分比
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        brightness_device_info_t info;
+        if (percent[dev] >= 0 && brightness_impl_device_info(dev, &info) == BRIGHTNESS_ERR_OK)
+        {
+            fprintf(fp, "%s %d\n", info.name, percent[dev]);
+        }
+    }
+
+    int ok = (fflush(fp) == 0 && fsync(fileno(fp)) == 0);
+    if (fclose(fp) != 0)
+    {
+        ok = 0;
+    }
+    if (!ok || rename(tmp, path) != 0)
+    {
+        perror("brightness_persist: 写入失败");
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 延迟写入定时器回调（事件线程）：亮度稳定后写入一次
+ *
+ * @param arg 持久化状态
+ */
+static void brightness_persist_tick(void *arg)
+{
+    brightness_persist *p = (brightness_persist *)arg;
+
+    pthread_mutex_lock(&p->lock);
+    if (!p->dirty)
+    {
+        pthread_mutex_unlock(&p->lock);
+        return;
+    }
+    int snapshot[BRIGHTNESS_MAX_DEVICES];
+    memcpy(snapshot, p->percent, sizeof(snapshot));
+    p->dirty = false;
+    pthread_mutex_unlock(&p->lock);
+    persist_write_file(p->path, snapshot);
+}
+
+/**
+ * @brief 从持久化文件恢复各设备亮度
+ */
+void brightness_persist_restore(void)
+{
+    brightness_persist *p = &g_persist;
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        p->percent[dev] = -1;
+    }
+    persist_resolve_path(p);
+    if (p->path[0] == '\0')
+    {
+        return;
+    }
+
+    FILE *fp = fopen(p->path, "r");
+    if (!fp)
+    {
+        return;
+    }
+    char name[BRIGHTNESS_DEVICE_NAME_MAX];
+    int percent = 0;
+    while (fscanf(fp, "%63s %d", name, &percent) == 2)
+    {
+        int dev = brightness_impl_find_device(name);
+        if (dev < 0 || percent < 0 || percent > 100)
+        {
+            continue;
+        }
+        brightness_error_t err = brightness_impl_set(dev, percent);
+        if (err == BRIGHTNESS_ERR_OK)
+        {
+            p->percent[dev] = percent;
+            printf("恢复亮度: %s = %d%%\n", name, percent);
+        }
+        else
+        {
+            fprintf(stderr, "brightness_persist: 恢复 %s 亮度失败 (错误码 %d)\n", name, err);
+        }
+    }
+    fclose(fp);
+}
+
+/**
+ * @brief 注册延迟写入定时器
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_persist_init(void)
+{
+    brightness_persist *p = &g_persist;
+    if (p->path[0] == '\0')
+    {
+        // 未启用持久化时不注册定时器，note直接忽略
+        return 0;
+    }
+
+    p->timer_fd = reactor_timer_create(brightness_persist_tick, p);
+    if (p->timer_fd < 0)
+    {
+        fprintf(stderr, "brightness_persist_init: 无法创建延迟写入定时器\n");
+        return -1;
+    }
+    p->started = true;
+    return 0;
+}
+
+/**
+ * @brief 注销延迟写入定时器，未写入的值立即写入
+ */
+void brightness_persist_deinit(void)
+{
+    brightness_persist *p = &g_persist;
+    if (!p->started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->started = false;
+    pthread_mutex_unlock(&p->lock);
+    reactor_timer_destroy(p->timer_fd);
+    p->timer_fd = -1;
+
+    if (p->dirty)
+    {
+        persist_write_file(p->path, p->percent);
+        p->dirty = false;
+    }
+}
+
+/**
+ * @brief 记录设备最新应用的亮度
+ *
+ * @param device 设备索引
+ * @param percent 亮度百分比
+ */
+void brightness_persist_note(int device, int percent)
+{
+    brightness_persist *p = &g_persist;
+    if (device < 0 || device >= BRIGHTNESS_MAX_DEVICES)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    if (p->started)
+    {
+        p->percent[device] = percent;
+        p->dirty = true;
+        // 重新设置定时器即推迟写入，亮度连续变化时只在稳定后写入一次
+        reactor_timer_arm(p->timer_fd, BRIGHTNESS_PERSIST_DELAY_MS, 0);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
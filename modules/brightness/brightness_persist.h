@@ -0,0 +1,74 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_persist.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度持久化声明（防抖延迟写入，启动时恢复）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_PERSIST_H
+#define BRIGHTNESS_PERSIST_H
+
+// 持久化文件路径可配置：编译时通过 -DBRIGHTNESS_PERSIST_PATH="\"/path\"" 覆盖，
+// 运行时可通过环境变量 BRIGHTNESS_PERSIST_PATH 覆盖，设为空串表示不持久化
+#ifndef BRIGHTNESS_PERSIST_PATH
+#define BRIGHTNESS_PERSIST_PATH                                                                    \
+    "/var/lib/CWebSocketServerForFlutterPanel/brightness" ///< 持久化文件路径
+#endif
+
+#define BRIGHTNESS_PERSIST_PATH_ENV "BRIGHTNESS_PERSIST_PATH" ///< 覆盖持久化文件路径的环境变量
+
+#ifndef BRIGHTNESS_PERSIST_DELAY_MS
+#define BRIGHTNESS_PERSIST_DELAY_MS 3000 ///< 亮度稳定多久后写入(毫秒)
+#endif
+
+/**
+ * @brief 从持久化文件恢复各设备亮度
+ *
+ * 应在背光设备扫描之后、监视器与WebSocket监听启动之前调用。
+ * 文件不存在或设备已不存在时跳过。
+ */
+void brightness_persist_restore(void);
+
+/**
+ * @brief 注册延迟写入定时器（须在reactor_init之后调用）
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_persist_init(void);
+
+/**
+ * @brief 注销延迟写入定时器，未写入的值立即写入
+ */
+void brightness_persist_deinit(void);
+
+/**
+ * @brief 记录设备最新应用的亮度
+ *
+ * 只更新内存中的值并推迟写入时间，亮度稳定BRIGHTNESS_PERSIST_DELAY_MS后才在事件线程上
+ * 写入文件，拖动滑块时的中间值不会落盘。
+ *
+ * @param device 设备索引
+ * @param percent 亮度百分比
+ */
+void brightness_persist_note(int device, int percent);
+
+#endif
@@ -24,8 +24,18 @@ limitations under the License.
  *
  */
 #include "brightness_scheduler.h"
+#include "../../metrics.h"
 #include "../../protocol/protocol_utils.h"
+#include "../../qos.h"
+#include "brightness_auto.h"
+#include "brightness_coalescer.h"
 #include "brightness_def.h"
+#include "brightness_persist.h"
+#include "brightness_watcher.h"
+#include "impl/brightness_impl.h"
+#include "impl/brightness_ramp.h"
+#include "protocol/brightness_auto.h"
+#include "protocol/brightness_devices.h"
 #include "protocol/brightness_set.h"
 #include "protocol/brightness_status.h"
 #include <stdio.h>
@@ -39,42 +49,140 @@ typedef struct
     const char *request;  ///< 请求类型字符串
     const char *response; ///< 响应类型字符串
     void (*bridge)(struct mg_connection *conn, const char *response_type, const char *request_id,
-                   cJSON *data); ///< JSON与结构体转换桥接函数
+                   cJSON *data); ///< 同步桥接函数，在当前线程处理并发送响应
+    void (*submit)(struct mg_connection *conn, const char *response_type, const char *request_id,
+                   cJSON *data, int64_t start_us,
+                   int64_t deadline_us); ///< 异步桥接函数，响应由后台线程发送
+    qos_class_t qos;                     ///< 延迟等级
 } brightness_dispatch;
 
+/**
+ * @brief 解析请求中的device字段
+ *
+ * @param data JSON数据对象
+ * @param device 输出设备索引，未指定device时为默认设备
+ * @return brightness_error_t 错误码，设备不存在返回BRIGHTNESS_ERR_NOT_SUPPORTED
+ */
+static brightness_error_t bridge_resolve_device(cJSON *data, int *device)
+{
+    cJSON *device_item = data ? cJSON_GetObjectItem(data, "device") : NULL;
+    const char *name = NULL;
+    if (device_item)
+    {
+        if (!cJSON_IsString(device_item) || !device_item->valuestring)
+        {
+            return BRIGHTNESS_ERR_BAD_REQUEST;
+        }
+        name = device_item->valuestring;
+    }
+    *device = brightness_impl_find_device(name);
+    return (*device >= 0) ? BRIGHTNESS_ERR_OK : BRIGHTNESS_ERR_NOT_SUPPORTED;
+}
+
 /**
  * @brief brightness_set请求的桥接函数
  *
+ * 参数校验失败时立即回复；合法请求先关闭自动亮度再交给合并器，连续的设置请求
+ * 只写入最新值，响应由合并器在写入完成（或渐变开始）后发送。
+ *
  * @param conn 连接指针
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象
+ * @param start_us 收到请求的时间
+ * @param deadline_us 请求期限，0表示没有
  */
 static void bridge_brightness_set(struct mg_connection *conn, const char *response_type,
-                                  const char *request_id, cJSON *data)
+                                  const char *request_id, cJSON *data, int64_t start_us,
+                                  int64_t deadline_us)
 {
     brightness_set_req_t req = {0};
     cJSON *brightness_item = data ? cJSON_GetObjectItem(data, "brightness") : NULL;
+    cJSON *transition_item = data ? cJSON_GetObjectItem(data, "transition_ms") : NULL;
     if (brightness_item && cJSON_IsNumber(brightness_item))
     {
         req.brightness = brightness_item->valueint;
         req.valid = true;
     }
+    if (transition_item)
+    {
+        if (cJSON_IsNumber(transition_item))
+        {
+            req.transition_ms = transition_item->valueint;
+        }
+        else
+        {
+            req.valid = false;
+        }
+    }
 
-    brightness_set_resp_t resp = brightness_set(&req);
+    brightness_error_t err = BRIGHTNESS_ERR_OK;
+    if (!req.valid)
+    {
+        err = BRIGHTNESS_ERR_BAD_REQUEST;
+    }
+    else if (req.brightness < 0 || req.brightness > 100 || req.transition_ms < 0 ||
+             req.transition_ms > BRIGHTNESS_RAMP_MAX_MS)
+    {
+        err = BRIGHTNESS_ERR_INVALID_VALUE;
+    }
+    else
+    {
+        err = bridge_resolve_device(data, &req.device);
+    }
+
+    if (err == BRIGHTNESS_ERR_OK)
+    {
+        // 手动设置自动亮度所控制的设备即退出自动亮度，避免自动调节覆盖用户的选择
+        if (req.device == brightness_impl_default_device())
+        {
+            brightness_auto_set_enabled(false);
+        }
+        err = brightness_coalescer_submit(conn, response_type, request_id, req.device,
+                                          req.brightness, req.transition_ms, start_us,
+                                          deadline_us);
+    }
+
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        protocol_send_standard_response(conn, response_type, request_id, false, err);
+        metrics_count_error(METRICS_MODULE_BRIGHTNESS, err);
+        qos_record(QOS_CLASS_INTERACTIVE, "brightness_set_request", start_us);
+    }
+}
 
+/**
+ * @brief brightness_status请求的桥接函数
+ *
+ * @param conn 连接指针
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（可选device字段）
+ */
+static void bridge_brightness_status(struct mg_connection *conn, const char *response_type,
+                                     const char *request_id, cJSON *data)
+{
+    brightness_status_resp_t resp = {0};
+    brightness_device_info_t info = {0};
+    int device = -1;
+    resp.error = bridge_resolve_device(data, &device);
+    if (resp.error == BRIGHTNESS_ERR_OK)
+    {
+        resp = brightness_status(device);
+        brightness_impl_device_info(device, &info);
+    }
+
+    metrics_count_error(METRICS_MODULE_BRIGHTNESS, resp.error);
     cJSON *response =
         protocol_create_response(response_type, request_id, (resp.error == BRIGHTNESS_ERR_OK),
                                  resp.error);
     if (response)
     {
-        if (resp.error == BRIGHTNESS_ERR_OK)
+        cJSON *res_data = cJSON_GetObjectItem(response, "data");
+        if (res_data && resp.error == BRIGHTNESS_ERR_OK)
         {
-            cJSON *res_data = cJSON_GetObjectItem(response, "data");
-            if (res_data)
-            {
-                cJSON_AddNumberToObject(res_data, "brightness", resp.brightness);
-            }
+            cJSON_AddStringToObject(res_data, "device", info.name);
+            cJSON_AddNumberToObject(res_data, "brightness", resp.brightness);
         }
         protocol_send_response(conn, response);
         cJSON_Delete(response);
@@ -82,19 +190,67 @@ static void bridge_brightness_set(struct mg_connection *conn, const char *respon
 }
 
 /**
- * @brief brightness_status请求的桥接函数
+ * @brief brightness_devices请求的桥接函数
  *
  * @param conn 连接指针
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象（未使用）
  */
-static void bridge_brightness_status(struct mg_connection *conn, const char *response_type,
-                                     const char *request_id, cJSON *data)
+static void bridge_brightness_devices(struct mg_connection *conn, const char *response_type,
+                                      const char *request_id, cJSON *data)
 {
     (void)data;
-    brightness_status_resp_t resp = brightness_status();
+    brightness_devices_resp_t resp;
+    brightness_devices(&resp);
 
+    metrics_count_error(METRICS_MODULE_BRIGHTNESS, resp.error);
+    cJSON *response =
+        protocol_create_response(response_type, request_id, (resp.error == BRIGHTNESS_ERR_OK),
+                                 resp.error);
+    if (response)
+    {
+        cJSON *res_data = cJSON_GetObjectItem(response, "data");
+        cJSON *devices = res_data ? cJSON_AddArrayToObject(res_data, "devices") : NULL;
+        for (int i = 0; devices && i < resp.count; i++)
+        {
+            cJSON *item = cJSON_CreateObject();
+            if (!item)
+            {
+                break;
+            }
+            cJSON_AddStringToObject(item, "name", resp.devices[i].name);
+            cJSON_AddStringToObject(item, "type", resp.devices[i].type);
+            cJSON_AddNumberToObject(item, "max_brightness", resp.devices[i].max_brightness);
+            cJSON_AddBoolToObject(item, "default", resp.devices[i].is_default);
+            cJSON_AddItemToArray(devices, item);
+        }
+        protocol_send_response(conn, response);
+        cJSON_Delete(response);
+    }
+}
+
+/**
+ * @brief brightness_auto请求的桥接函数
+ *
+ * @param conn 连接指针
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象
+ */
+static void bridge_brightness_auto(struct mg_connection *conn, const char *response_type,
+                                   const char *request_id, cJSON *data)
+{
+    brightness_auto_req_t req = {0};
+    cJSON *enable_item = data ? cJSON_GetObjectItem(data, "enable") : NULL;
+    if (enable_item && cJSON_IsBool(enable_item))
+    {
+        req.enable = cJSON_IsTrue(enable_item);
+        req.valid = true;
+    }
+    brightness_auto_resp_t resp = brightness_auto(&req);
+
+    metrics_count_error(METRICS_MODULE_BRIGHTNESS, resp.error);
     cJSON *response =
         protocol_create_response(response_type, request_id, (resp.error == BRIGHTNESS_ERR_OK),
                                  resp.error);
@@ -103,8 +259,68 @@ static void bridge_brightness_status(struct mg_connection *conn, const char *res
         cJSON *res_data = cJSON_GetObjectItem(response, "data");
         if (res_data)
         {
-            cJSON_AddNumberToObject(res_data, "brightness", resp.brightness);
+            cJSON_AddBoolToObject(res_data, "auto_brightness", resp.auto_brightness);
+        }
+        protocol_send_response(conn, response);
+        cJSON_Delete(response);
+    }
+}
+
+/**
+ * @brief 会话恢复快照：各设备当前亮度与自动亮度开关
+ *
+ * @return cJSON* {"auto_brightness": ..., "devices": [...]}，失败返回NULL
+ */
+static cJSON *brightness_resume_snapshot(void)
+{
+    brightness_devices_resp_t resp;
+    brightness_devices(&resp);
+    if (resp.error != BRIGHTNESS_ERR_OK)
+    {
+        return NULL;
+    }
+    cJSON *snapshot = cJSON_CreateObject();
+    if (!snapshot)
+    {
+        return NULL;
+    }
+    cJSON_AddBoolToObject(snapshot, "auto_brightness", brightness_auto_enabled());
+    cJSON *devices = cJSON_AddArrayToObject(snapshot, "devices");
+    for (int i = 0; devices && i < resp.count; i++)
+    {
+        brightness_status_resp_t status = brightness_status(i);
+        cJSON *item = cJSON_CreateObject();
+        if (!item)
+        {
+            break;
+        }
+        cJSON_AddStringToObject(item, "device", resp.devices[i].name);
+        if (status.error == BRIGHTNESS_ERR_OK)
+        {
+            cJSON_AddNumberToObject(item, "brightness", status.brightness);
         }
+        cJSON_AddBoolToObject(item, "default", resp.devices[i].is_default);
+        cJSON_AddItemToArray(devices, item);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief brightness_resume请求的桥接函数：补发重连前错过的事件，无法补发时附带亮度快照
+ *
+ * @param conn 连接指针
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（epoch与last_seq）
+ */
+static void bridge_brightness_resume(struct mg_connection *conn, const char *response_type,
+                                     const char *request_id, cJSON *data)
+{
+    cJSON *response = protocol_resume(conn, BRIGHTNESS_EVENT_PATH, response_type, request_id,
+                                      data, brightness_resume_snapshot);
+    metrics_count_error(METRICS_MODULE_BRIGHTNESS, BRIGHTNESS_ERR_OK);
+    if (response)
+    {
         protocol_send_response(conn, response);
         cJSON_Delete(response);
     }
@@ -113,43 +329,141 @@ static void bridge_brightness_status(struct mg_connection *conn, const char *res
 /* ---- 调度表 ---- */
 
 static brightness_dispatch brightness_dispatch_table[] = {
-    {"brightness_status_request", "brightness_status_response", bridge_brightness_status},
-    {"brightness_set_request", "brightness_set_response", bridge_brightness_set},
+    {"brightness_status_request", "brightness_status_response", bridge_brightness_status, NULL,
+     QOS_CLASS_NORMAL},
+    {"brightness_set_request", "brightness_set_response", NULL, bridge_brightness_set,
+     QOS_CLASS_INTERACTIVE},
+    {"brightness_auto_request", "brightness_auto_response", bridge_brightness_auto, NULL,
+     QOS_CLASS_NORMAL},
+    {"brightness_devices_request", "brightness_devices_response", bridge_brightness_devices, NULL,
+     QOS_CLASS_NORMAL},
+    {"brightness_resume_request", "brightness_resume_response", bridge_brightness_resume, NULL,
+     QOS_CLASS_NORMAL},
 };
 #define BRIGHTNESS_DISPATCH_TABLE_SIZE                                                              \
     (sizeof(brightness_dispatch_table) / sizeof(brightness_dispatch_table[0]))
 
+/**
+ * @brief 初始化亮度模块
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_scheduler_init(void)
+{
+    // 设备暂不可用时仍启动服务，后续请求会重新尝试打开
+    brightness_error_t err = brightness_impl_init();
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        fprintf(stderr, "brightness_scheduler_init: 未找到可用的背光设备 (错误码 %d)\n", err);
+    }
+    // 在监视线程与WebSocket监听启动之前恢复亮度，恢复的写入不会被当作外部变化
+    brightness_persist_restore();
+    if (brightness_persist_init() != 0)
+    {
+        return -1;
+    }
+    if (brightness_ramp_init() != 0)
+    {
+        brightness_persist_deinit();
+        return -1;
+    }
+    if (brightness_coalescer_init() != 0)
+    {
+        brightness_ramp_deinit();
+        brightness_persist_deinit();
+        return -1;
+    }
+    if (brightness_watcher_init() != 0)
+    {
+        brightness_coalescer_deinit();
+        brightness_ramp_deinit();
+        brightness_persist_deinit();
+        return -1;
+    }
+    if (brightness_auto_init() != 0)
+    {
+        brightness_watcher_deinit();
+        brightness_coalescer_deinit();
+        brightness_ramp_deinit();
+        brightness_persist_deinit();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放亮度模块资源
+ */
+void brightness_scheduler_deinit(void)
+{
+    brightness_auto_deinit();
+    brightness_watcher_deinit();
+    brightness_coalescer_deinit();
+    brightness_ramp_deinit();
+    brightness_persist_deinit();
+    brightness_impl_deinit();
+}
+
+/**
+ * @brief 亮度连接关闭通知
+ *
+ * @param conn 正在关闭的连接
+ */
+void brightness_scheduler_close(const struct mg_connection *conn)
+{
+    brightness_coalescer_detach_connection(conn);
+}
+
 /**
  * @brief 亮度模块消息调度入口
  *
- * 根据JSON中的type字段分发到对应的桥接函数处理。
+ * 根据JSON中的type字段分发到对应的桥接函数处理。请求信封中的期限（deadline_ms/timeout_ms）
+ * 在到达时已过的请求直接回复BRIGHTNESS_ERR_TIMEOUT，不访问sysfs。
  *
  * @param conn WebSocket连接指针
  * @param root 解析后的JSON根对象
  */
 void brightness_scheduler(struct mg_connection *conn, cJSON *root)
 {
+    int64_t start_us = qos_now_us();
     cJSON *type_item = cJSON_GetObjectItemCaseSensitive(root, "type");
 
     if (!cJSON_IsString(type_item) || !type_item->valuestring)
     {
         fprintf(stderr, "缺少或无效的 'type' 字段\n");
+        metrics_count_message(NULL);
         return;
     }
 
     const char *request_id = protocol_get_request_id(root);
     cJSON *data = cJSON_GetObjectItem(root, "data");
+    int64_t deadline_us = protocol_get_deadline_us(root, start_us);
 
     for (size_t i = 0; i < BRIGHTNESS_DISPATCH_TABLE_SIZE; i++)
     {
         if (strcmp(type_item->valuestring, brightness_dispatch_table[i].request) == 0)
         {
-            if (brightness_dispatch_table[i].bridge != NULL)
+            const brightness_dispatch *entry = &brightness_dispatch_table[i];
+            metrics_count_message(entry->request);
+            metrics_trace_identify(METRICS_MODULE_BRIGHTNESS, entry->request, request_id);
+            if (protocol_deadline_expired(deadline_us))
+            {
+                protocol_send_standard_response(conn, entry->response, request_id, false,
+                                                BRIGHTNESS_ERR_TIMEOUT);
+                metrics_count_error(METRICS_MODULE_BRIGHTNESS, BRIGHTNESS_ERR_TIMEOUT);
+                qos_record(entry->qos, entry->request, start_us);
+            }
+            else if (entry->submit != NULL)
+            {
+                entry->submit(conn, entry->response, request_id, data, start_us, deadline_us);
+            }
+            else if (entry->bridge != NULL)
             {
-                brightness_dispatch_table[i].bridge(conn, brightness_dispatch_table[i].response,
-                                                    request_id, data);
+                entry->bridge(conn, entry->response, request_id, data);
+                qos_record(entry->qos, entry->request, start_us);
             }
             return;
         }
     }
+    metrics_count_message(NULL);
 }
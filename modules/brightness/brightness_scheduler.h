@@ -37,4 +37,23 @@ limitations under the License.
  */
 void brightness_scheduler(struct mg_connection *conn, cJSON *root);
 
+/**
+ * @brief 初始化亮度模块（启动亮度写入线程，须在reactor_init之后调用）
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_scheduler_init(void);
+
+/**
+ * @brief 释放亮度模块资源
+ */
+void brightness_scheduler_deinit(void);
+
+/**
+ * @brief 亮度连接关闭通知
+ *
+ * @param conn 正在关闭的连接
+ */
+void brightness_scheduler_close(const struct mg_connection *conn);
+
 #endif
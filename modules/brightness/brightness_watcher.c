@@ -0,0 +1,249 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_watcher.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度变化监视器实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_watcher.h"
+#include "../../reactor.h"
+#include "../../ws_utils.h"
+#include "brightness_auto.h"
+#include "brightness_persist.h"
+#include "cJSON.h"
+#include "impl/brightness_impl.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+/**
+ * @brief 监视器状态（只在事件线程与init/deinit中访问）
+ */
+typedef struct
+{
+    bool started;                           ///< 事件源是否已注册
+    int timer_fd;                           ///< 轮询/兜底刷新定时器（reactor定时器）
+    int interval_ms;                        ///< 当前刷新间隔，0表示尚未设置
+    int notify_fds[BRIGHTNESS_MAX_DEVICES]; ///< 各设备actual_brightness的通知描述符，-1表示没有
+} brightness_watcher;
+
+static brightness_watcher g_watcher = {
+    .timer_fd = -1,
+};
+
+/**
+ * @brief 向所有亮度连接推送brightness_event
+ *
+ * @param device 设备索引
+ * @param percent 新的亮度百分比
+ */
+void brightness_event_broadcast(int device, int percent)
+{
+    brightness_device_info_t info = {0};
+    if (brightness_impl_device_info(device, &info) != BRIGHTNESS_ERR_OK)
+    {
+        return;
+    }
+
+    cJSON *event = cJSON_CreateObject();
+    if (!event)
+    {
+        return;
+    }
+    cJSON_AddStringToObject(event, "type", "brightness_event");
+    cJSON *data = cJSON_AddObjectToObject(event, "data");
+    if (data)
+    {
+        cJSON_AddStringToObject(data, "device", info.name);
+        cJSON_AddNumberToObject(data, "brightness", percent);
+        cJSON_AddBoolToObject(data, "auto_brightness",
+                              info.is_default && brightness_auto_enabled());
+    }
+
+    ws_broadcast_event(BRIGHTNESS_EVENT_PATH, event);
+    cJSON_Delete(event);
+}
+
+/**
+ * @brief 刷新设备亮度缓存，外部变化时推送事件
+ *
+ * @param dev 设备索引
+ */
+static void watcher_refresh(int dev)
+{
+    int percent = 0;
+    bool changed = false;
+    if (brightness_impl_refresh(dev, &percent, &changed) == BRIGHTNESS_ERR_OK && changed)
+    {
+        brightness_persist_note(dev, percent);
+        brightness_event_broadcast(dev, percent);
+    }
+}
+
+/**
+ * @brief 关闭设备的通知描述符
+ *
+ * @param w 监视器
+ * @param dev 设备索引
+ */
+static void watcher_close_notify(brightness_watcher *w, int dev)
+{
+    if (w->notify_fds[dev] >= 0)
+    {
+        reactor_remove(w->notify_fds[dev]);
+        close(w->notify_fds[dev]);
+        w->notify_fds[dev] = -1;
+    }
+}
+
+/**
+ * @brief 通知描述符就绪回调（事件线程）：设备亮度变化
+ *
+ * @param fd 通知描述符
+ * @param events epoll事件
+ * @param arg 设备索引
+ */
+static void watcher_on_notify(int fd, uint32_t events, void *arg)
+{
+    (void)events;
+    brightness_watcher *w = &g_watcher;
+    int dev = (int)(intptr_t)arg;
+
+    // sysfs属性需重新读取一次，之后才会等待下一次通知
+    char buf[32];
+    if (pread(fd, buf, sizeof(buf), 0) < 0)
+    {
+        // 由下一次定时刷新重新打开，期间按轮询间隔刷新
+        watcher_close_notify(w, dev);
+        reactor_timer_arm(w->timer_fd, BRIGHTNESS_WATCH_POLL_MS, BRIGHTNESS_WATCH_POLL_MS);
+        w->interval_ms = BRIGHTNESS_WATCH_POLL_MS;
+    }
+    watcher_refresh(dev);
+}
+
+/**
+ * @brief 打开并注册设备的通知描述符
+ *
+ * @param w 监视器
+ * @param dev 设备索引
+ */
+static void watcher_open_notify(brightness_watcher *w, int dev)
+{
+    int fd = brightness_impl_open_notify(dev);
+    if (fd < 0)
+    {
+        return;
+    }
+    // sysfs属性需先读取一次，之后的通知才会触发
+    char buf[32];
+    if (pread(fd, buf, sizeof(buf), 0) < 0 ||
+        reactor_add(fd, EPOLLPRI, watcher_on_notify, (void *)(intptr_t)dev) != 0)
+    {
+        close(fd);
+        return;
+    }
+    w->notify_fds[dev] = fd;
+}
+
+/**
+ * @brief 刷新定时器回调（事件线程）：打开尚未打开的通知描述符并刷新所有设备
+ *
+ * 只要有一个设备不支持通知，就按轮询间隔刷新，否则按兜底间隔刷新。
+ *
+ * @param arg 监视器
+ */
+static void watcher_on_timer(void *arg)
+{
+    brightness_watcher *w = (brightness_watcher *)arg;
+
+    int count = brightness_impl_device_count();
+    bool polling = (count == 0);
+    for (int dev = 0; dev < count; dev++)
+    {
+        // 设备可能晚于服务加载，未打开时每个周期重试
+        if (w->notify_fds[dev] < 0)
+        {
+            watcher_open_notify(w, dev);
+        }
+        if (w->notify_fds[dev] < 0)
+        {
+            polling = true;
+        }
+        watcher_refresh(dev);
+    }
+
+    int interval_ms = polling ? BRIGHTNESS_WATCH_POLL_MS : BRIGHTNESS_WATCH_NOTIFY_FALLBACK_MS;
+    if (interval_ms != w->interval_ms)
+    {
+        reactor_timer_arm(w->timer_fd, interval_ms, interval_ms);
+        w->interval_ms = interval_ms;
+    }
+}
+
+/**
+ * @brief 注册亮度监视器的事件源
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_watcher_init(void)
+{
+    brightness_watcher *w = &g_watcher;
+    for (int i = 0; i < BRIGHTNESS_MAX_DEVICES; i++)
+    {
+        w->notify_fds[i] = -1;
+    }
+    w->interval_ms = 0;
+    w->timer_fd = reactor_timer_create(watcher_on_timer, w);
+    if (w->timer_fd < 0)
+    {
+        fprintf(stderr, "brightness_watcher_init: 无法创建刷新定时器\n");
+        return -1;
+    }
+    // 尽快在事件线程上打开通知描述符
+    reactor_timer_arm(w->timer_fd, 1, 0);
+    w->started = true;
+    return 0;
+}
+
+/**
+ * @brief 注销亮度监视器的事件源
+ */
+void brightness_watcher_deinit(void)
+{
+    brightness_watcher *w = &g_watcher;
+    if (!w->started)
+    {
+        return;
+    }
+
+    // 先注销定时器，之后不会再有新的通知描述符被打开
+    reactor_timer_destroy(w->timer_fd);
+    w->timer_fd = -1;
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        watcher_close_notify(w, dev);
+    }
+    w->started = false;
+}
@@ -0,0 +1,66 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_watcher.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度变化监视器声明（维护亮度缓存并推送brightness_event）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_WATCHER_H
+#define BRIGHTNESS_WATCHER_H
+
+// 驱动支持sysfs_notify时的兜底刷新间隔（部分驱动的变化不会触发通知）
+#ifndef BRIGHTNESS_WATCH_NOTIFY_FALLBACK_MS
+#define BRIGHTNESS_WATCH_NOTIFY_FALLBACK_MS 5000 ///< 兜底刷新间隔(毫秒)
+#endif
+
+// 驱动不支持sysfs_notify时的轮询间隔
+#ifndef BRIGHTNESS_WATCH_POLL_MS
+#define BRIGHTNESS_WATCH_POLL_MS 1000 ///< 轮询间隔(毫秒)
+#endif
+
+#define BRIGHTNESS_EVENT_PATH "/brightness" ///< brightness_event推送的连接路径
+
+/**
+ * @brief 注册亮度监视器的事件源（须在reactor_init之后调用）
+ *
+ * 在事件线程上等待各设备actual_brightness的sysfs_notify（不支持时定期轮询），刷新亮度缓存；
+ * 亮度被其他来源（硬件按键、其他工具等）修改时向所有/brightness连接推送brightness_event。
+ * 本服务自身的写入不会产生事件。
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_watcher_init(void);
+
+/**
+ * @brief 注销亮度监视器的事件源
+ */
+void brightness_watcher_deinit(void);
+
+/**
+ * @brief 向所有/brightness连接推送brightness_event
+ *
+ * @param device 设备索引
+ * @param percent 新的亮度百分比
+ */
+void brightness_event_broadcast(int device, int percent);
+
+#endif
@@ -0,0 +1,289 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_als.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 环境光传感器（IIO sysfs）读取实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_als.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**
+ * @brief 照度属性候选（按优先级排列）
+ */
+typedef struct
+{
+    const char *value;  ///< 照度属性文件名
+    const char *scale;  ///< 对应的scale属性，NULL表示已是勒克斯
+    const char *offset; ///< 对应的offset属性
+} brightness_als_attr;
+
+static const brightness_als_attr g_als_attrs[] = {
+    {"in_illuminance_input", NULL, NULL},
+    {"in_illuminance0_input", NULL, NULL},
+    {"in_illuminance_raw", "in_illuminance_scale", "in_illuminance_offset"},
+    {"in_illuminance0_raw", "in_illuminance0_scale", "in_illuminance0_offset"},
+};
+#define BRIGHTNESS_ALS_ATTRS_SIZE (sizeof(g_als_attrs) / sizeof(g_als_attrs[0]))
+
+/**
+ * @brief 已打开的传感器
+ */
+typedef struct
+{
+    int fd;        ///< 照度属性的文件描述符，-1表示未打开
+    double scale;  ///< 原始值换算为勒克斯的比例
+    double offset; ///< 原始值偏移
+} brightness_als;
+
+static brightness_als g_als = {
+    .fd = -1,
+    .scale = 1.0,
+    .offset = 0.0,
+};
+
+/**
+ * @brief 读取一次性属性（scale/offset）的浮点值
+ *
+ * @param path 属性路径
+ * @param out 输出参数，文件不存在时保持不变
+ */
+static void read_double_file(const char *path, double *out)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        return;
+    }
+    double value = 0.0;
+    if (fscanf(fp, "%lf", &value) == 1)
+    {
+        *out = value;
+    }
+    fclose(fp);
+}
+
+/**
+ * @brief 解析十进制定点数（如"123.456"）为千分之一单位
+ *
+ * 读取路径上只做整数运算，不调用strtod。
+ *
+ * @param buf 文本
+ * @param len 文本长度
+ * @param out 输出参数，数值乘以1000
+ * @return bool 解析成功返回true
+ */
+static bool parse_milli(const char *buf, ssize_t len, int64_t *out)
+{
+    ssize_t i = 0;
+    while (i < len && (buf[i] == ' ' || buf[i] == '\t'))
+    {
+        i++;
+    }
+    bool negative = (i < len && buf[i] == '-');
+    if (negative)
+    {
+        i++;
+    }
+    if (i >= len || buf[i] < '0' || buf[i] > '9')
+    {
+        return false;
+    }
+
+    int64_t value = 0;
+    for (; i < len && buf[i] >= '0' && buf[i] <= '9'; i++)
+    {
+        value = value * 10 + (buf[i] - '0');
+    }
+    value *= 1000;
+    if (i < len && buf[i] == '.')
+    {
+        int64_t unit = 100;
+        for (i++; i < len && buf[i] >= '0' && buf[i] <= '9'; i++)
+        {
+            value += (buf[i] - '0') * unit;
+            unit /= 10;
+        }
+    }
+    *out = negative ? -value : value;
+    return true;
+}
+
+/**
+ * @brief 拼接目录与文件名
+ *
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @param dir 目录
+ * @param name 文件名
+ * @return bool 成功返回true，路径超出缓冲区返回false
+ */
+static bool als_join_path(char *buf, size_t size, const char *dir, const char *name)
+{
+    int n = snprintf(buf, size, "%s/%s", dir, name);
+    return n >= 0 && (size_t)n < size;
+}
+
+/**
+ * @brief 在单个IIO设备目录中查找照度属性
+ *
+ * @param dir 设备目录
+ * @return bool 找到并打开返回true
+ */
+static bool als_try_device(const char *dir)
+{
+    char path[512];
+    for (size_t i = 0; i < BRIGHTNESS_ALS_ATTRS_SIZE; i++)
+    {
+        const brightness_als_attr *attr = &g_als_attrs[i];
+        if (!als_join_path(path, sizeof(path), dir, attr->value))
+        {
+            return false; // 目录路径过长，不使用该设备
+        }
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        g_als.scale = 1.0;
+        g_als.offset = 0.0;
+        if (attr->scale)
+        {
+            if (!als_join_path(path, sizeof(path), dir, attr->scale))
+            {
+                close(fd);
+                return false;
+            }
+            read_double_file(path, &g_als.scale);
+            if (!als_join_path(path, sizeof(path), dir, attr->offset))
+            {
+                close(fd);
+                return false;
+            }
+            read_double_file(path, &g_als.offset);
+        }
+        g_als.fd = fd;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 查找并打开环境光传感器
+ *
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_als_open(void)
+{
+    if (g_als.fd >= 0)
+    {
+        return BRIGHTNESS_ERR_OK;
+    }
+
+    const char *root = getenv(BRIGHTNESS_IIO_DIR_ENV);
+    if (!root || root[0] == '\0')
+    {
+        root = BRIGHTNESS_IIO_DIR;
+    }
+    DIR *dir = opendir(root);
+    if (!dir)
+    {
+        return (errno == EACCES) ? BRIGHTNESS_ERR_PERMISSION : BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        if (!als_join_path(path, sizeof(path), root, entry->d_name))
+        {
+            continue;
+        }
+        if (als_try_device(path))
+        {
+            break;
+        }
+    }
+    closedir(dir);
+    return (g_als.fd >= 0) ? BRIGHTNESS_ERR_OK : BRIGHTNESS_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief 关闭环境光传感器
+ */
+void brightness_als_close(void)
+{
+    if (g_als.fd >= 0)
+    {
+        close(g_als.fd);
+        g_als.fd = -1;
+    }
+}
+
+/**
+ * @brief 读取环境光照度
+ *
+ * @param mlux 输出参数，照度(毫勒克斯)
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_als_read(int64_t *mlux)
+{
+    if (!mlux)
+    {
+        return BRIGHTNESS_ERR_BAD_REQUEST;
+    }
+    if (g_als.fd < 0)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+
+    char buf[32];
+    ssize_t n = pread(g_als.fd, buf, sizeof(buf) - 1, 0);
+    if (n < 0)
+    {
+        return BRIGHTNESS_ERR_DEVICE_ERROR;
+    }
+    int64_t value = 0;
+    if (!parse_milli(buf, n, &value))
+    {
+        return BRIGHTNESS_ERR_DEVICE_ERROR;
+    }
+
+    // 常见传感器scale为1.0、offset为0，跳过浮点运算
+    if (g_als.scale != 1.0 || g_als.offset != 0.0)
+    {
+        value = (int64_t)(((double)value + g_als.offset * 1000.0) * g_als.scale);
+    }
+    *mlux = value < 0 ? 0 : value;
+    return BRIGHTNESS_ERR_OK;
+}
@@ -0,0 +1,66 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_als.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 环境光传感器（IIO sysfs）读取接口声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_ALS_H
+#define BRIGHTNESS_ALS_H
+
+#include "../brightness_def.h"
+#include <stdint.h>
+
+// IIO设备目录可配置：默认 /sys/bus/iio/devices
+// 编译时可通过 -DBRIGHTNESS_IIO_DIR="\"/path\"" 覆盖，运行时可通过环境变量
+// BRIGHTNESS_IIO_DIR 覆盖（如指向临时目录中的模拟sysfs树）
+#ifndef BRIGHTNESS_IIO_DIR
+#define BRIGHTNESS_IIO_DIR "/sys/bus/iio/devices" ///< IIO设备目录
+#endif
+
+#define BRIGHTNESS_IIO_DIR_ENV "BRIGHTNESS_IIO_DIR" ///< 覆盖IIO设备目录的环境变量
+
+/**
+ * @brief 查找并打开环境光传感器
+ *
+ * 依次扫描IIO设备目录下的设备，使用第一个提供in_illuminance_input或
+ * in_illuminance_raw（配合scale/offset）属性的设备。已打开时直接返回。
+ * 调用者负责串行化本文件中的所有函数。
+ *
+ * @return brightness_error_t 错误码，未找到传感器返回BRIGHTNESS_ERR_NOT_SUPPORTED
+ */
+brightness_error_t brightness_als_open(void);
+
+/**
+ * @brief 关闭环境光传感器
+ */
+void brightness_als_close(void);
+
+/**
+ * @brief 读取环境光照度
+ *
+ * @param mlux 输出参数，照度(毫勒克斯)
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_als_read(int64_t *mlux);
+
+#endif
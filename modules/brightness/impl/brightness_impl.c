@@ -25,88 +25,230 @@ limitations under the License.
  */
 #include "brightness_impl.h"
 #include "../brightness_def.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <dirent.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#ifndef SYSFS_MAGIC
+#define SYSFS_MAGIC 0x62656572 ///< sysfs文件系统的f_type
+#endif
+
+/**
+ * @brief 单个背光设备的常驻文件描述符与缓存值
+ */
+typedef struct
+{
+    char name[BRIGHTNESS_DEVICE_NAME_MAX]; ///< 设备名
+    char type[BRIGHTNESS_DEVICE_TYPE_MAX]; ///< 设备类型
+    pthread_mutex_t lock;                  ///< 保护打开/关闭过程
+    pthread_mutex_t io_lock;               ///< 串行化写入与刷新，保证缓存与写入顺序一致
+    int brightness_fd;                     ///< brightness属性的文件描述符，-1表示未打开
+    int max;                               ///< 缓存的max_brightness（驱动加载后不会变化）
+    int raw;                               ///< 最近一次读取或写入的原始亮度，-1表示未知
+    bool truncate;                         ///< 属性文件不在sysfs上（如临时目录），写入后需截断
+} brightness_backlight;
+
+/**
+ * @brief 已发现的背光设备表
+ *
+ * 设备只追加不删除：先填好槽位再发布count，读取方无需加锁。
+ */
+typedef struct
+{
+    pthread_mutex_t scan_lock;                            ///< 串行化设备扫描
+    char root[256];                                       ///< 背光设备根目录
+    brightness_backlight devices[BRIGHTNESS_MAX_DEVICES]; ///< 设备槽位
+    int count;                                            ///< 已发布的设备数量
+    int default_device;                                   ///< 默认设备索引，-1表示无设备
+    int64_t scanned_us;                                   ///< 最近一次扫描时间（scan_lock保护）
+} brightness_backlight_table;
+
+static brightness_backlight_table g_backlights = {
+    .scan_lock = PTHREAD_MUTEX_INITIALIZER,
+    .default_device = -1,
+};
+
+/**
+ * @brief 将errno映射为亮度错误码
+ *
+ * @param err errno值
+ * @return brightness_error_t 错误码
+ */
+static brightness_error_t errno_to_error(int err)
+{
+    if (err == EACCES || err == EPERM)
+    {
+        return BRIGHTNESS_ERR_PERMISSION;
+    }
+    if (err == ENOENT || err == ENODEV)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+    return BRIGHTNESS_ERR_DEVICE_ERROR;
+}
 
 /**
- * @brief 从文件读取整数值
+ * @brief 将原始亮度换算为百分比
  *
- * @param path 文件路径
+ * @param raw 原始亮度
+ * @param max 最大原始亮度（大于0）
+ * @return int 亮度百分比（0-100）
+ */
+static int raw_to_percent(int raw, int max)
+{
+    int percent = (int)((double)raw * 100.0 / (double)max + 0.5);
+    if (percent < 0)
+    {
+        percent = 0;
+    }
+    if (percent > 100)
+    {
+        percent = 100;
+    }
+    return percent;
+}
+
+/**
+ * @brief 从文件描述符读取整数值（从偏移0读取，sysfs每次都会重新生成内容）
+ *
+ * @param fd 文件描述符
  * @param out 输出参数，存储读取的值
  * @return brightness_error_t 错误码
  */
-static brightness_error_t read_int_file(const char *path, int *out)
+static brightness_error_t read_int_fd(int fd, int *out)
 {
-    FILE *fp = fopen(path, "r");
-    if (!fp)
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n < 0)
     {
-        if (errno == EACCES || errno == EPERM)
-        {
-            return BRIGHTNESS_ERR_PERMISSION;
-        }
-        if (errno == ENOENT)
-        {
-            return BRIGHTNESS_ERR_NOT_SUPPORTED;
-        }
-        return BRIGHTNESS_ERR_DEVICE_ERROR;
+        return errno_to_error(errno);
     }
-    int value = -1;
-    if (fscanf(fp, "%d", &value) != 1)
+
+    ssize_t i = 0;
+    while (i < n && (buf[i] == ' ' || buf[i] == '\t'))
+    {
+        i++;
+    }
+    if (i >= n || buf[i] < '0' || buf[i] > '9')
     {
-        fclose(fp);
         return BRIGHTNESS_ERR_DEVICE_ERROR;
     }
-    fclose(fp);
+
+    int value = 0;
+    for (; i < n && buf[i] >= '0' && buf[i] <= '9'; i++)
+    {
+        value = value * 10 + (buf[i] - '0');
+    }
     *out = value;
     return BRIGHTNESS_ERR_OK;
 }
 
 /**
- * @brief 将整数值写入文件
+ * @brief 将非负整数值写入文件描述符
  *
- * @param path 文件路径
+ * @param fd 文件描述符
  * @param value 要写入的值
+ * @param truncate 写入后是否截断文件（普通文件需要，sysfs属性不需要）
  * @return brightness_error_t 错误码
  */
-static brightness_error_t write_int_file(const char *path, int value)
+static brightness_error_t write_int_fd(int fd, int value, bool truncate)
 {
-    FILE *fp = fopen(path, "w");
-    if (!fp)
+    // 在栈上从低位向高位格式化，避免snprintf
+    char buf[16];
+    char *p = buf + sizeof(buf);
+    unsigned int v = (unsigned int)value;
+    do
     {
-        if (errno == EACCES || errno == EPERM)
-        {
-            return BRIGHTNESS_ERR_PERMISSION;
-        }
-        if (errno == ENOENT)
-        {
-            return BRIGHTNESS_ERR_NOT_SUPPORTED;
-        }
-        return BRIGHTNESS_ERR_DEVICE_ERROR;
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    size_t len = (size_t)(buf + sizeof(buf) - p);
+    ssize_t n = pwrite(fd, p, len, 0);
+    if (n < 0)
+    {
+        return errno_to_error(errno);
     }
-    int rc = fprintf(fp, "%d", value);
-    if (rc < 0)
+    if ((size_t)n != len)
     {
-        fclose(fp);
         return BRIGHTNESS_ERR_DEVICE_ERROR;
     }
-    fclose(fp);
+    if (truncate && ftruncate(fd, (off_t)len) != 0)
+    {
+        return errno_to_error(errno);
+    }
     return BRIGHTNESS_ERR_OK;
 }
 
 /**
- * @brief 设置屏幕亮度
+ * @brief 设备类型的优先级（固件接口通常能控制整条背光，优先于平台与原始接口）
  *
- * @param percent 亮度百分比（0-100）
+ * @param type 设备类型
+ * @return int 优先级，越大越优先
+ */
+static int backlight_type_rank(const char *type)
+{
+    if (strcmp(type, "firmware") == 0)
+    {
+        return 3;
+    }
+    if (strcmp(type, "platform") == 0)
+    {
+        return 2;
+    }
+    if (strcmp(type, "raw") == 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 拼接设备属性路径
+ *
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @param bl 背光设备
+ * @param attr 属性名
+ */
+static void backlight_path(char *buf, size_t size, const brightness_backlight *bl,
+                           const char *attr)
+{
+    snprintf(buf, size, "%s/%s/%s", g_backlights.root, bl->name, attr);
+}
+
+/**
+ * @brief 打开背光属性并缓存max_brightness（调用者持有bl->lock）
+ *
+ * @param bl 背光设备
  * @return brightness_error_t 错误码
  */
-brightness_error_t brightness_impl_set(int percent)
+static brightness_error_t backlight_open_locked(brightness_backlight *bl)
 {
-    if (percent < 0 || percent > 100)
+    if (bl->brightness_fd >= 0)
     {
-        return BRIGHTNESS_ERR_INVALID_VALUE;
+        return BRIGHTNESS_ERR_OK;
+    }
+
+    char path[512];
+    backlight_path(path, sizeof(path), bl, "max_brightness");
+    int max_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (max_fd < 0)
+    {
+        return errno_to_error(errno);
     }
     int max = 0;
-    brightness_error_t err = read_int_file(BRIGHTNESS_SYSFS_MAX_BRIGHTNESS_PATH, &max);
+    brightness_error_t err = read_int_fd(max_fd, &max);
+    close(max_fd);
     if (err != BRIGHTNESS_ERR_OK)
     {
         return err;
@@ -115,6 +257,308 @@ brightness_error_t brightness_impl_set(int percent)
     {
         return BRIGHTNESS_ERR_DEVICE_ERROR;
     }
+
+    backlight_path(path, sizeof(path), bl, "brightness");
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return errno_to_error(errno);
+    }
+
+    int raw = -1;
+    if (read_int_fd(fd, &raw) != BRIGHTNESS_ERR_OK)
+    {
+        raw = -1;
+    }
+
+    struct statfs sfs;
+    bl->truncate = (fstatfs(fd, &sfs) == 0 && sfs.f_type != SYSFS_MAGIC);
+    bl->max = max;
+    __atomic_store_n(&bl->raw, raw, __ATOMIC_RELAXED);
+    __atomic_store_n(&bl->brightness_fd, fd, __ATOMIC_RELEASE);
+    return BRIGHTNESS_ERR_OK;
+}
+
+/**
+ * @brief 扫描背光根目录，追加新发现的设备并重新选择默认设备（调用者持有scan_lock）
+ *
+ * @return brightness_error_t 至少有一个设备时返回BRIGHTNESS_ERR_OK
+ */
+static brightness_error_t backlight_scan_locked(void)
+{
+    brightness_backlight_table *t = &g_backlights;
+    t->scanned_us = qos_now_us();
+    DIR *dir = opendir(t->root);
+    if (!dir)
+    {
+        return t->count > 0 ? BRIGHTNESS_ERR_OK : errno_to_error(errno);
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && t->count < BRIGHTNESS_MAX_DEVICES)
+    {
+        if (entry->d_name[0] == '.' || strlen(entry->d_name) >= BRIGHTNESS_DEVICE_NAME_MAX)
+        {
+            continue;
+        }
+        bool known = false;
+        for (int i = 0; i < t->count; i++)
+        {
+            if (strcmp(t->devices[i].name, entry->d_name) == 0)
+            {
+                known = true;
+                break;
+            }
+        }
+        if (known)
+        {
+            continue;
+        }
+
+        brightness_backlight *bl = &t->devices[t->count];
+        memset(bl, 0, sizeof(*bl));
+        strcpy(bl->name, entry->d_name);
+        bl->brightness_fd = -1;
+        bl->raw = -1;
+        pthread_mutex_init(&bl->lock, NULL);
+        pthread_mutex_init(&bl->io_lock, NULL);
+
+        char path[512];
+        backlight_path(path, sizeof(path), bl, "type");
+        FILE *fp = fopen(path, "r");
+        if (fp)
+        {
+            if (fscanf(fp, "%15s", bl->type) != 1)
+            {
+                bl->type[0] = '\0';
+            }
+            fclose(fp);
+        }
+
+        // 打开失败（如驱动未就绪）仍登记设备，使用时会再次尝试打开
+        pthread_mutex_lock(&bl->lock);
+        backlight_open_locked(bl);
+        pthread_mutex_unlock(&bl->lock);
+        __atomic_store_n(&t->count, t->count + 1, __ATOMIC_RELEASE);
+    }
+    closedir(dir);
+
+    // 环境变量指定的设备优先，否则按类型优先级、同级按名称选择
+    const char *preferred = getenv(BRIGHTNESS_DEVICE_ENV);
+    int best = -1;
+    for (int i = 0; i < t->count; i++)
+    {
+        const brightness_backlight *bl = &t->devices[i];
+        if (preferred && strcmp(bl->name, preferred) == 0)
+        {
+            best = i;
+            break;
+        }
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+        const brightness_backlight *cur = &t->devices[best];
+        int rank = backlight_type_rank(bl->type);
+        int cur_rank = backlight_type_rank(cur->type);
+        if (rank > cur_rank || (rank == cur_rank && strcmp(bl->name, cur->name) < 0))
+        {
+            best = i;
+        }
+    }
+    __atomic_store_n(&t->default_device, best, __ATOMIC_RELEASE);
+    return t->count > 0 ? BRIGHTNESS_ERR_OK : BRIGHTNESS_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief 按索引获取背光设备
+ *
+ * @param dev 设备索引
+ * @return brightness_backlight* 设备，索引无效时返回NULL
+ */
+static brightness_backlight *backlight_get(int dev)
+{
+    int count = __atomic_load_n(&g_backlights.count, __ATOMIC_ACQUIRE);
+    if (dev < 0 || dev >= count)
+    {
+        return NULL;
+    }
+    return &g_backlights.devices[dev];
+}
+
+/**
+ * @brief 获取已打开的背光设备，未打开时尝试打开（驱动可能晚于服务加载）
+ *
+ * @param dev 设备索引
+ * @param out 输出背光设备
+ * @param fd 输出brightness属性的文件描述符
+ * @return brightness_error_t 错误码
+ */
+static brightness_error_t backlight_acquire(int dev, brightness_backlight **out, int *fd)
+{
+    brightness_backlight *bl = backlight_get(dev);
+    if (!bl)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+    *out = bl;
+    int cur = __atomic_load_n(&bl->brightness_fd, __ATOMIC_ACQUIRE);
+    if (cur >= 0)
+    {
+        *fd = cur;
+        return BRIGHTNESS_ERR_OK;
+    }
+
+    pthread_mutex_lock(&bl->lock);
+    brightness_error_t err = backlight_open_locked(bl);
+    *fd = bl->brightness_fd;
+    pthread_mutex_unlock(&bl->lock);
+    if (err == BRIGHTNESS_ERR_OK && bl->max <= 0)
+    {
+        err = BRIGHTNESS_ERR_DEVICE_ERROR;
+    }
+    return err;
+}
+
+/**
+ * @brief 扫描背光设备并打开属性文件
+ *
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_init(void)
+{
+    brightness_backlight_table *t = &g_backlights;
+    const char *root = getenv(BRIGHTNESS_SYSFS_ROOT_ENV);
+    if (!root || root[0] == '\0')
+    {
+        root = BRIGHTNESS_SYSFS_ROOT;
+    }
+
+    pthread_mutex_lock(&t->scan_lock);
+    snprintf(t->root, sizeof(t->root), "%s", root);
+    brightness_error_t err = backlight_scan_locked();
+    pthread_mutex_unlock(&t->scan_lock);
+    return err;
+}
+
+/**
+ * @brief 关闭所有背光属性文件并清空设备表
+ */
+void brightness_impl_deinit(void)
+{
+    brightness_backlight_table *t = &g_backlights;
+    pthread_mutex_lock(&t->scan_lock);
+    for (int i = 0; i < t->count; i++)
+    {
+        brightness_backlight *bl = &t->devices[i];
+        if (bl->brightness_fd >= 0)
+        {
+            close(bl->brightness_fd);
+        }
+        pthread_mutex_destroy(&bl->lock);
+        pthread_mutex_destroy(&bl->io_lock);
+    }
+    __atomic_store_n(&t->count, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&t->default_device, -1, __ATOMIC_RELEASE);
+    t->scanned_us = 0;
+    pthread_mutex_unlock(&t->scan_lock);
+}
+
+/**
+ * @brief 获取已发现的背光设备数量
+ *
+ * @return int 设备数量
+ */
+int brightness_impl_device_count(void)
+{
+    return __atomic_load_n(&g_backlights.count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 获取默认背光设备
+ *
+ * @return int 设备索引，没有设备时返回-1
+ */
+int brightness_impl_default_device(void)
+{
+    return __atomic_load_n(&g_backlights.default_device, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 按设备名查找背光设备
+ *
+ * @param name 设备名，NULL或空串表示默认设备
+ * @return int 设备索引，未找到返回-1
+ */
+int brightness_impl_find_device(const char *name)
+{
+    brightness_backlight_table *t = &g_backlights;
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (!name || name[0] == '\0')
+        {
+            int dev = brightness_impl_default_device();
+            if (dev >= 0)
+            {
+                return dev;
+            }
+        }
+        else
+        {
+            int count = brightness_impl_device_count();
+            for (int i = 0; i < count; i++)
+            {
+                if (strcmp(t->devices[i].name, name) == 0)
+                {
+                    return i;
+                }
+            }
+        }
+
+        // 未找到时重新扫描一次，支持服务启动后才加载的背光驱动；扫描限频，
+        // 等锁期间他人刚完成的扫描直接沿用，第二轮查找即可看到其结果
+        pthread_mutex_lock(&t->scan_lock);
+        if (qos_now_us() - t->scanned_us >= (int64_t)BRIGHTNESS_RESCAN_INTERVAL_MS * 1000)
+        {
+            backlight_scan_locked();
+        }
+        pthread_mutex_unlock(&t->scan_lock);
+    }
+    return -1;
+}
+
+/**
+ * @brief 获取背光设备信息
+ *
+ * @param dev 设备索引
+ * @param info 输出设备信息
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_device_info(int dev, brightness_device_info_t *info)
+{
+    brightness_backlight *bl = backlight_get(dev);
+    if (!bl || !info)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+    memset(info, 0, sizeof(*info));
+    strcpy(info->name, bl->name);
+    strcpy(info->type, bl->type);
+    info->max_brightness = bl->max;
+    info->is_default = (dev == brightness_impl_default_device());
+    return BRIGHTNESS_ERR_OK;
+}
+
+/**
+ * @brief 将亮度百分比换算为原始值
+ *
+ * @param percent 亮度百分比（0-100）
+ * @param max 最大原始亮度
+ * @return int 原始亮度（0-max）
+ */
+int brightness_impl_percent_to_raw(int percent, int max)
+{
     int raw = (int)((double)percent * (double)max / 100.0 + 0.5);
     if (raw < 0)
     {
@@ -124,49 +568,208 @@ brightness_error_t brightness_impl_set(int percent)
     {
         raw = max;
     }
-    err = write_int_file(BRIGHTNESS_SYSFS_BRIGHTNESS_PATH, raw);
-    return err;
+    return raw;
 }
 
 /**
- * @brief 获取屏幕亮度
+ * @brief 获取当前原始亮度与最大原始亮度
  *
- * @param percent 输出参数，亮度百分比（0-100）
+ * @param dev 设备索引
+ * @param raw 输出参数，当前原始亮度（缓存值，未知时读取sysfs）
+ * @param max 输出参数，最大原始亮度
  * @return brightness_error_t 错误码
  */
-brightness_error_t brightness_impl_get_status(int *percent)
+brightness_error_t brightness_impl_get_raw(int dev, int *raw, int *max)
 {
-    if (!percent)
+    if (!raw || !max)
     {
         return BRIGHTNESS_ERR_BAD_REQUEST;
     }
+    brightness_backlight *bl = NULL;
+    int fd = -1;
+    brightness_error_t err = backlight_acquire(dev, &bl, &fd);
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        return err;
+    }
+    if (__atomic_load_n(&bl->raw, __ATOMIC_RELAXED) < 0)
+    {
+        err = brightness_impl_refresh(dev, NULL, NULL);
+        if (err != BRIGHTNESS_ERR_OK)
+        {
+            return err;
+        }
+    }
+    *raw = __atomic_load_n(&bl->raw, __ATOMIC_RELAXED);
+    *max = bl->max;
+    return BRIGHTNESS_ERR_OK;
+}
 
-    int raw = 0;
-    int max = 0;
-    brightness_error_t err = read_int_file(BRIGHTNESS_SYSFS_BRIGHTNESS_PATH, &raw);
+/**
+ * @brief 写入原始亮度
+ *
+ * @param dev 设备索引
+ * @param raw 原始亮度（0-max）
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_set_raw(int dev, int raw)
+{
+    brightness_backlight *bl = NULL;
+    int fd = -1;
+    brightness_error_t err = backlight_acquire(dev, &bl, &fd);
     if (err != BRIGHTNESS_ERR_OK)
     {
         return err;
     }
-    err = read_int_file(BRIGHTNESS_SYSFS_MAX_BRIGHTNESS_PATH, &max);
+    if (raw < 0 || raw > bl->max)
+    {
+        return BRIGHTNESS_ERR_INVALID_VALUE;
+    }
+
+    // 写入与缓存更新在io_lock内完成，监视器不会把本进程的写入误判为外部变化；
+    // 缓存可能落后于外部修改（监视器轮询间隔内），因此不以缓存判断是否需要写入
+    pthread_mutex_lock(&bl->io_lock);
+    int64_t io_start = qos_now_us();
+    err = write_int_fd(fd, raw, bl->truncate);
+    metrics_observe_backend(METRICS_BACKEND_BRIGHTNESS_WRITE, qos_now_us() - io_start,
+                            err == BRIGHTNESS_ERR_OK);
+    if (err == BRIGHTNESS_ERR_OK)
+    {
+        __atomic_store_n(&bl->raw, raw, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&bl->io_lock);
+    return err;
+}
+
+/**
+ * @brief 设置屏幕亮度
+ *
+ * @param dev 设备索引
+ * @param percent 亮度百分比（0-100）
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_set(int dev, int percent)
+{
+    if (percent < 0 || percent > 100)
+    {
+        return BRIGHTNESS_ERR_INVALID_VALUE;
+    }
+    brightness_backlight *bl = NULL;
+    int fd = -1;
+    brightness_error_t err = backlight_acquire(dev, &bl, &fd);
     if (err != BRIGHTNESS_ERR_OK)
     {
         return err;
     }
-    if (max <= 0)
+    return brightness_impl_set_raw(dev, brightness_impl_percent_to_raw(percent, bl->max));
+}
+
+/**
+ * @brief 重新读取亮度并更新缓存
+ *
+ * @param dev 设备索引
+ * @param percent 输出参数，亮度百分比（0-100），可为NULL
+ * @param changed 输出参数，读取值与缓存不同时为true，可为NULL
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_refresh(int dev, int *percent, bool *changed)
+{
+    brightness_backlight *bl = NULL;
+    int fd = -1;
+    brightness_error_t err = backlight_acquire(dev, &bl, &fd);
+    if (err != BRIGHTNESS_ERR_OK)
     {
-        return BRIGHTNESS_ERR_DEVICE_ERROR;
+        return err;
+    }
+
+    int raw = 0;
+    int prev = -1;
+    pthread_mutex_lock(&bl->io_lock);
+    int64_t io_start = qos_now_us();
+    err = read_int_fd(fd, &raw);
+    metrics_observe_backend(METRICS_BACKEND_BRIGHTNESS_READ, qos_now_us() - io_start,
+                            err == BRIGHTNESS_ERR_OK);
+    if (err == BRIGHTNESS_ERR_OK)
+    {
+        prev = __atomic_exchange_n(&bl->raw, raw, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&bl->io_lock);
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        return err;
     }
 
-    int percent_value = (int)((double)raw * 100.0 / (double)max + 0.5);
-    if (percent_value < 0)
+    if (percent)
     {
-        percent_value = 0;
+        *percent = raw_to_percent(raw, bl->max);
     }
-    if (percent_value > 100)
+    if (changed)
     {
-        percent_value = 100;
+        // 首次读取（缓存未知）不算外部变化
+        *changed = (prev >= 0 && prev != raw);
     }
-    *percent = percent_value;
     return BRIGHTNESS_ERR_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 打开用于等待亮度变化通知的属性文件
+ *
+ * @param dev 设备索引
+ * @return int 文件描述符，设备不支持时返回-1
+ */
+int brightness_impl_open_notify(int dev)
+{
+    brightness_backlight *bl = backlight_get(dev);
+    if (!bl)
+    {
+        return -1;
+    }
+    char path[512];
+    backlight_path(path, sizeof(path), bl, "actual_brightness");
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    // 只有sysfs属性会在变化时唤醒poll，普通文件上poll总是立即返回
+    struct statfs sfs;
+    if (fstatfs(fd, &sfs) != 0 || sfs.f_type != SYSFS_MAGIC)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 获取屏幕亮度
+ *
+ * 优先返回缓存值（由设置路径和监视器维护），缓存未知时读取sysfs。
+ *
+ * @param dev 设备索引
+ * @param percent 输出参数，亮度百分比（0-100）
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_get_status(int dev, int *percent)
+{
+    if (!percent)
+    {
+        return BRIGHTNESS_ERR_BAD_REQUEST;
+    }
+
+    brightness_backlight *bl = NULL;
+    int fd = -1;
+    brightness_error_t err = backlight_acquire(dev, &bl, &fd);
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        return err;
+    }
+    int raw = __atomic_load_n(&bl->raw, __ATOMIC_RELAXED);
+    if (raw >= 0)
+    {
+        *percent = raw_to_percent(raw, bl->max);
+        return BRIGHTNESS_ERR_OK;
+    }
+    return brightness_impl_refresh(dev, percent, NULL);
+}
@@ -27,32 +27,140 @@ limitations under the License.
 #define BRIGHTNESS_IMPL_H
 
 #include "../brightness_def.h"
-// 亮度设备目录可配置：默认 /sys/class/backlight/backlight
-// 可在此处修改，或在编译时通过 -DBRIGHTNESS_SYSFS_DIR="\"/sys/class/backlight/intel_backlight\""
-// 覆盖
-#ifndef BRIGHTNESS_SYSFS_DIR
-#define BRIGHTNESS_SYSFS_DIR "/sys/class/backlight/backlight" ///< 亮度设备目录
+// 背光设备根目录可配置：默认 /sys/class/backlight
+// 编译时可通过 -DBRIGHTNESS_SYSFS_ROOT="\"/path\"" 覆盖，运行时可通过环境变量
+// BRIGHTNESS_SYSFS_ROOT 覆盖（如指向tmpfs中的模拟sysfs树）
+#ifndef BRIGHTNESS_SYSFS_ROOT
+#define BRIGHTNESS_SYSFS_ROOT "/sys/class/backlight" ///< 背光设备根目录
 #endif
 
-// 派生的具体文件路径宏
-#define BRIGHTNESS_SYSFS_BRIGHTNESS_PATH BRIGHTNESS_SYSFS_DIR "/brightness" ///< 亮度文件路径
-#define BRIGHTNESS_SYSFS_MAX_BRIGHTNESS_PATH                                                       \
-    BRIGHTNESS_SYSFS_DIR "/max_brightness" ///< 最大亮度文件路径
+#define BRIGHTNESS_SYSFS_ROOT_ENV "BRIGHTNESS_SYSFS_ROOT" ///< 覆盖背光设备根目录的环境变量
+#define BRIGHTNESS_DEVICE_ENV "BRIGHTNESS_DEVICE"         ///< 指定默认背光设备名的环境变量
+
+#ifndef BRIGHTNESS_RESCAN_INTERVAL_MS
+#define BRIGHTNESS_RESCAN_INTERVAL_MS 1000 ///< 按名称查找失败触发重新扫描的最小间隔
+#endif
+
+/**
+ * @brief 扫描背光设备并打开属性文件
+ *
+ * 枚举根目录下的所有设备，按类型（firmware > platform > raw）选择默认设备，
+ * 环境变量BRIGHTNESS_DEVICE可指定默认设备。打开失败的设备仍会登记，使用时再次尝试打开。
+ *
+ * @return brightness_error_t 错误码，未发现任何设备返回BRIGHTNESS_ERR_NOT_SUPPORTED
+ */
+brightness_error_t brightness_impl_init(void);
+
+/**
+ * @brief 关闭所有背光属性文件并清空设备表
+ */
+void brightness_impl_deinit(void);
+
+/**
+ * @brief 获取已发现的背光设备数量
+ *
+ * @return int 设备数量，设备索引范围为0到数量-1
+ */
+int brightness_impl_device_count(void);
+
+/**
+ * @brief 获取默认背光设备
+ *
+ * @return int 设备索引，没有设备时返回-1
+ */
+int brightness_impl_default_device(void);
+
+/**
+ * @brief 按设备名查找背光设备
+ *
+ * 未找到时重新扫描一次根目录，距上次扫描不足BRIGHTNESS_RESCAN_INTERVAL_MS时不扫描，
+ * 请求不存在的设备名不会让每个请求都遍历sysfs。
+ *
+ * @param name 设备名，NULL或空串表示默认设备
+ * @return int 设备索引，未找到返回-1
+ */
+int brightness_impl_find_device(const char *name);
+
+/**
+ * @brief 获取背光设备信息
+ *
+ * @param dev 设备索引
+ * @param info 输出设备信息
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_device_info(int dev, brightness_device_info_t *info);
+
+/**
+ * @brief 将亮度百分比换算为原始值
+ *
+ * @param percent 亮度百分比（0-100）
+ * @param max 最大原始亮度
+ * @return int 原始亮度（0-max）
+ */
+int brightness_impl_percent_to_raw(int percent, int max);
+
+/**
+ * @brief 获取当前原始亮度与最大原始亮度
+ *
+ * @param dev 设备索引
+ * @param raw 输出参数，当前原始亮度（缓存值，未知时读取sysfs）
+ * @param max 输出参数，最大原始亮度
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_get_raw(int dev, int *raw, int *max);
+
+/**
+ * @brief 写入原始亮度
+ *
+ * 总是写入sysfs：缓存值可能落后于其他进程的修改，不能据此跳过写入。
+ *
+ * @param dev 设备索引
+ * @param raw 原始亮度（0-max）
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_set_raw(int dev, int raw);
 
 /**
  * @brief 设置屏幕亮度
  *
+ * 与brightness_impl_set_raw相同，总是写入sysfs。
+ *
+ * @param dev 设备索引
  * @param percent 亮度百分比（0-100）
  * @return brightness_error_t 错误码
  */
-brightness_error_t brightness_impl_set(int percent);
+brightness_error_t brightness_impl_set(int dev, int percent);
+
+/**
+ * @brief 重新读取亮度并更新缓存
+ *
+ * @param dev 设备索引
+ * @param percent 输出参数，亮度百分比（0-100），可为NULL
+ * @param changed 输出参数，读取值与缓存不同（即亮度被其他来源修改）时为true，可为NULL
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_impl_refresh(int dev, int *percent, bool *changed);
+
+/**
+ * @brief 打开用于等待亮度变化通知的属性文件
+ *
+ * 返回的文件描述符可用于poll(POLLPRI)，读取一次后等待下一次sysfs_notify。
+ * 调用者负责关闭。
+ *
+ * @param dev 设备索引
+ * @return int 文件描述符，设备不支持通知时返回-1
+ */
+int brightness_impl_open_notify(int dev);
 
 /**
  * @brief 获取屏幕亮度
  *
+ * 优先返回缓存值（由设置路径和监视器维护），缓存未知时读取sysfs。
+ *
+ * @param dev 设备索引
  * @param percent 输出参数，亮度百分比（0-100）
  * @return brightness_error_t 错误码
  */
-brightness_error_t brightness_impl_get_status(int *percent);
+brightness_error_t brightness_impl_get_status(int dev, int *percent);
 
 #endif
\ No newline at end of file
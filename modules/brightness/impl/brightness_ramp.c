@@ -0,0 +1,328 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_ramp.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度渐变引擎实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "brightness_ramp.h"
+#include "../../../reactor.h"
+#include "brightness_impl.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief 单个背光设备的渐变状态
+ */
+typedef struct
+{
+    int lut_max;                       ///< 查找表对应的max_brightness，0表示未生成
+    int lut[BRIGHTNESS_RAMP_LUT_SIZE]; ///< 感知亮度级 -> 原始亮度
+    bool active;                       ///< 是否有进行中的渐变
+    int64_t start_us;                  ///< 渐变开始时间
+    int64_t duration_us;               ///< 渐变时长
+    int from_level;                    ///< 起始感知亮度级
+    int to_level;                      ///< 目标感知亮度级
+    int target_raw;                    ///< 目标原始亮度（最后一步精确写入）
+    int written_raw;                   ///< 本次渐变最近写入的原始亮度，-1表示尚未写入
+} brightness_ramp_slot;
+
+/**
+ * @brief 渐变引擎状态（所有设备共用事件线程上的一个步进定时器）
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                               ///< 保护以下字段，渐变写入也在锁内完成
+    bool started;                                       ///< 步进定时器是否已注册
+    int timer_fd;                                       ///< 步进定时器（reactor定时器）
+    int active_count;                                   ///< 进行中的渐变数量
+    brightness_ramp_slot slots[BRIGHTNESS_MAX_DEVICES]; ///< 各设备的渐变状态
+} brightness_ramp;
+
+static brightness_ramp g_ramp = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .timer_fd = -1,
+};
+
+/**
+ * @brief 获取单调时钟微秒数
+ *
+ * @return int64_t 微秒
+ */
+static int64_t ramp_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief 按max_brightness生成感知亮度查找表（调用者持有lock）
+ *
+ * 每个max_brightness只计算一次，步进过程中不再做浮点幂运算。
+ *
+ * @param slot 设备渐变状态
+ * @param max 最大原始亮度
+ */
+static void ramp_build_lut_locked(brightness_ramp_slot *slot, int max)
+{
+    if (slot->lut_max == max)
+    {
+        return;
+    }
+    for (int i = 0; i < BRIGHTNESS_RAMP_LUT_SIZE; i++)
+    {
+        double level = (double)i / (double)(BRIGHTNESS_RAMP_LUT_SIZE - 1);
+        slot->lut[i] = (int)(pow(level, BRIGHTNESS_RAMP_GAMMA) * (double)max + 0.5);
+    }
+    slot->lut_max = max;
+}
+
+/**
+ * @brief 查找原始亮度对应的感知亮度级（查找表单调不减，二分查找）
+ *
+ * @param slot 设备渐变状态
+ * @param raw 原始亮度
+ * @return int 第一个不小于raw的级
+ */
+static int ramp_level_of_raw(const brightness_ramp_slot *slot, int raw)
+{
+    int lo = 0;
+    int hi = BRIGHTNESS_RAMP_LUT_SIZE - 1;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (slot->lut[mid] < raw)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief 结束设备的渐变，没有进行中的渐变时停止定时器（调用者持有lock）
+ *
+ * @param r 渐变引擎
+ * @param slot 设备渐变状态
+ */
+static void ramp_finish_locked(brightness_ramp *r, brightness_ramp_slot *slot)
+{
+    if (!slot->active)
+    {
+        return;
+    }
+    slot->active = false;
+    if (--r->active_count == 0)
+    {
+        reactor_timer_arm(r->timer_fd, 0, 0);
+    }
+}
+
+/**
+ * @brief 执行一步渐变（调用者持有lock）
+ *
+ * @param r 渐变引擎
+ * @param dev 设备索引
+ */
+static void ramp_step_locked(brightness_ramp *r, int dev)
+{
+    brightness_ramp_slot *slot = &r->slots[dev];
+    int64_t elapsed = ramp_now_us() - slot->start_us;
+    bool done = elapsed >= slot->duration_us;
+
+    int raw = slot->target_raw;
+    if (!done)
+    {
+        int64_t span = (int64_t)(slot->to_level - slot->from_level);
+        int level = slot->from_level + (int)(span * elapsed / slot->duration_us);
+        raw = slot->lut[level];
+    }
+
+    // 中间步的原始值与上一步相同时不重复写入；最后一步总是写入，覆盖渐变期间的外部修改
+    brightness_error_t err = BRIGHTNESS_ERR_OK;
+    if (done || raw != slot->written_raw)
+    {
+        err = brightness_impl_set_raw(dev, raw);
+        slot->written_raw = raw;
+    }
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        fprintf(stderr, "brightness_ramp: 写入亮度失败 (错误码 %d)，渐变中止\n", err);
+        done = true;
+    }
+    if (done)
+    {
+        ramp_finish_locked(r, slot);
+    }
+}
+
+/**
+ * @brief 步进定时器回调（事件线程）：每次触发执行一步
+ *
+ * @param arg 渐变引擎
+ */
+static void brightness_ramp_tick(void *arg)
+{
+    brightness_ramp *r = (brightness_ramp *)arg;
+
+    pthread_mutex_lock(&r->lock);
+    // 错过的触发直接按当前时间计算位置，不补写中间值
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES && r->active_count > 0; dev++)
+    {
+        if (r->slots[dev].active)
+        {
+            ramp_step_locked(r, dev);
+        }
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief 注册渐变步进定时器
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_ramp_init(void)
+{
+    brightness_ramp *r = &g_ramp;
+    r->timer_fd = reactor_timer_create(brightness_ramp_tick, r);
+    if (r->timer_fd < 0)
+    {
+        fprintf(stderr, "brightness_ramp_init: 无法创建步进定时器\n");
+        return -1;
+    }
+    r->started = true;
+    return 0;
+}
+
+/**
+ * @brief 注销渐变步进定时器
+ */
+void brightness_ramp_deinit(void)
+{
+    brightness_ramp *r = &g_ramp;
+    if (!r->started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->started = false;
+    for (int dev = 0; dev < BRIGHTNESS_MAX_DEVICES; dev++)
+    {
+        r->slots[dev].active = false;
+    }
+    r->active_count = 0;
+    reactor_timer_arm(r->timer_fd, 0, 0);
+    pthread_mutex_unlock(&r->lock);
+    reactor_timer_destroy(r->timer_fd);
+    r->timer_fd = -1;
+}
+
+/**
+ * @brief 开始一次渐变
+ *
+ * @param dev 设备索引
+ * @param percent 目标亮度百分比（0-100）
+ * @param transition_ms 渐变时间(毫秒)
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_ramp_start(int dev, int percent, int transition_ms)
+{
+    brightness_ramp *r = &g_ramp;
+    if (dev < 0 || dev >= BRIGHTNESS_MAX_DEVICES)
+    {
+        return BRIGHTNESS_ERR_NOT_SUPPORTED;
+    }
+    if (percent < 0 || percent > 100 || transition_ms <= 0 ||
+        transition_ms > BRIGHTNESS_RAMP_MAX_MS)
+    {
+        return BRIGHTNESS_ERR_INVALID_VALUE;
+    }
+    if (!r->started)
+    {
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+
+    int raw = 0;
+    int max = 0;
+    brightness_error_t err = brightness_impl_get_raw(dev, &raw, &max);
+    if (err != BRIGHTNESS_ERR_OK)
+    {
+        return err;
+    }
+    int target_raw = brightness_impl_percent_to_raw(percent, max);
+
+    pthread_mutex_lock(&r->lock);
+    if (!r->started)
+    {
+        pthread_mutex_unlock(&r->lock);
+        return BRIGHTNESS_ERR_INTERNAL;
+    }
+    brightness_ramp_slot *slot = &r->slots[dev];
+    ramp_finish_locked(r, slot);
+
+    ramp_build_lut_locked(slot, max);
+    slot->from_level = ramp_level_of_raw(slot, raw);
+    slot->to_level = ramp_level_of_raw(slot, target_raw);
+    slot->target_raw = target_raw;
+    slot->written_raw = -1;
+    slot->start_us = ramp_now_us();
+    // 缓存值已是目标时仍写入一次（缓存可能落后于外部修改），第一步即最后一步
+    slot->duration_us = (raw == target_raw) ? 0 : (int64_t)transition_ms * 1000;
+    slot->active = true;
+    // 第一步在下一个周期执行，避免在请求线程内写入；已有渐变时沿用当前定时器
+    if (r->active_count++ == 0)
+    {
+        reactor_timer_arm(r->timer_fd, BRIGHTNESS_RAMP_INTERVAL_MS, BRIGHTNESS_RAMP_INTERVAL_MS);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return BRIGHTNESS_ERR_OK;
+}
+
+/**
+ * @brief 取消设备上进行中的渐变
+ *
+ * @param dev 设备索引
+ */
+void brightness_ramp_cancel(int dev)
+{
+    brightness_ramp *r = &g_ramp;
+    if (!r->started || dev < 0 || dev >= BRIGHTNESS_MAX_DEVICES)
+    {
+        return;
+    }
+
+    // 渐变写入在锁内完成，拿到锁即保证不会再有旧渐变的写入
+    pthread_mutex_lock(&r->lock);
+    ramp_finish_locked(r, &r->slots[dev]);
+    pthread_mutex_unlock(&r->lock);
+}
@@ -0,0 +1,82 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_ramp.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 亮度渐变引擎声明（timerfd驱动，按感知亮度曲线插值）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_RAMP_H
+#define BRIGHTNESS_RAMP_H
+
+#include "../brightness_def.h"
+
+#ifndef BRIGHTNESS_RAMP_INTERVAL_MS
+#define BRIGHTNESS_RAMP_INTERVAL_MS 16 ///< 渐变步进间隔(毫秒)，约60Hz
+#endif
+
+#ifndef BRIGHTNESS_RAMP_MAX_MS
+#define BRIGHTNESS_RAMP_MAX_MS 10000 ///< 允许的最长渐变时间(毫秒)
+#endif
+
+#ifndef BRIGHTNESS_RAMP_GAMMA
+#define BRIGHTNESS_RAMP_GAMMA 2.2 ///< 感知亮度曲线的gamma值
+#endif
+
+#ifndef BRIGHTNESS_RAMP_LUT_SIZE
+#define BRIGHTNESS_RAMP_LUT_SIZE 1024 ///< 感知亮度查找表的级数
+#endif
+
+/**
+ * @brief 注册渐变步进定时器（须在reactor_init之后调用）
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int brightness_ramp_init(void);
+
+/**
+ * @brief 注销渐变步进定时器，进行中的渐变停在当前亮度
+ */
+void brightness_ramp_deinit(void);
+
+/**
+ * @brief 开始一次渐变
+ *
+ * 从当前亮度在感知亮度空间内线性过渡到目标亮度，该设备上进行中的渐变被替换。
+ * 所有设备的步进由事件线程上的同一个定时器完成，本函数立即返回。
+ *
+ * @param dev 设备索引
+ * @param percent 目标亮度百分比（0-100）
+ * @param transition_ms 渐变时间(毫秒)，1-BRIGHTNESS_RAMP_MAX_MS
+ * @return brightness_error_t 错误码
+ */
+brightness_error_t brightness_ramp_start(int dev, int percent, int transition_ms);
+
+/**
+ * @brief 取消设备上进行中的渐变
+ *
+ * 返回后步进定时器不会再写入该设备，亮度停在当前值。
+ *
+ * @param dev 设备索引
+ */
+void brightness_ramp_cancel(int dev);
+
+#endif
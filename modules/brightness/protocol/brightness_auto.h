@@ -0,0 +1,40 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_auto.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 自动亮度控制协议处理声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_AUTO_PROTOCOL_H
+#define BRIGHTNESS_AUTO_PROTOCOL_H
+
+#include "../brightness_def.h"
+
+/**
+ * @brief 处理自动亮度控制请求
+ *
+ * @param req 自动亮度请求结构体
+ * @return brightness_auto_resp_t 自动亮度响应
+ */
+brightness_auto_resp_t brightness_auto(const brightness_auto_req_t *req);
+
+#endif
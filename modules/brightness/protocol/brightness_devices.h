@@ -0,0 +1,39 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file brightness_devices.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 背光设备列表协议处理声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef BRIGHTNESS_DEVICES_H
+#define BRIGHTNESS_DEVICES_H
+
+#include "../brightness_def.h"
+
+/**
+ * @brief 处理背光设备列表请求
+ *
+ * @param resp 输出设备列表响应
+ */
+void brightness_devices(brightness_devices_resp_t *resp);
+
+#endif
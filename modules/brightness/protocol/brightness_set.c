@@ -25,10 +25,13 @@ limitations under the License.
  */
 #include "brightness_set.h"
 #include "../impl/brightness_impl.h"
+#include "../impl/brightness_ramp.h"
 
 /**
  * @brief 处理设置亮度请求
  *
+ * transition_ms大于0时启动渐变并立即返回，resp.brightness为目标亮度。
+ *
  * @param req 设置亮度请求结构体
  * @return brightness_set_resp_t 设置亮度响应
  */
@@ -40,7 +43,14 @@ brightness_set_resp_t brightness_set(const brightness_set_req_t *req)
         resp.error = BRIGHTNESS_ERR_BAD_REQUEST;
         return resp;
     }
-    resp.error = brightness_impl_set(req->brightness);
+    if (req->transition_ms > 0)
+    {
+        resp.error = brightness_ramp_start(req->device, req->brightness, req->transition_ms);
+    }
+    else
+    {
+        resp.error = brightness_impl_set(req->device, req->brightness);
+    }
     if (resp.error == BRIGHTNESS_ERR_OK)
     {
         resp.brightness = req->brightness;
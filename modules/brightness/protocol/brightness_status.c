@@ -29,11 +29,12 @@ limitations under the License.
 /**
  * @brief 处理查询亮度状态请求
  *
+ * @param device 设备索引
  * @return brightness_status_resp_t 亮度状态响应
  */
-brightness_status_resp_t brightness_status(void)
+brightness_status_resp_t brightness_status(int device)
 {
     brightness_status_resp_t resp = {0};
-    resp.error = brightness_impl_get_status(&resp.brightness);
+    resp.error = brightness_impl_get_status(device, &resp.brightness);
     return resp;
 }
@@ -0,0 +1,457 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file wifi_exec.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 外部命令执行器实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "wifi_exec.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define WIFI_EXEC_READ_CHUNK 1024 ///< 每次读取前保证的空闲空间
+
+extern char **environ;
+
+/**
+ * @brief 子进程输出读取结果
+ */
+typedef enum
+{
+    WIFI_EXEC_DRAINED = 0, ///< 读到EOF或读取出错
+    WIFI_EXEC_DEADLINE,    ///< 超过期限
+    WIFI_EXEC_INTERRUPTED  ///< 所属操作被取消
+} wifi_exec_drain_t;
+
+static __thread const bool *t_cancel = NULL; ///< 当前线程绑定的取消标志
+static __thread int64_t t_deadline_us = 0;   ///< 当前线程绑定的请求期限，0表示没有
+
+/**
+ * @brief 为当前线程绑定取消标志
+ *
+ * @param flag 取消标志（以__atomic读取），NULL表示解除绑定
+ * @return const bool* 之前绑定的标志
+ */
+const bool *wifi_exec_bind_cancel(const bool *flag)
+{
+    const bool *prev = t_cancel;
+    t_cancel = flag;
+    return prev;
+}
+
+/**
+ * @brief 为当前线程绑定请求期限
+ *
+ * @param deadline_us 期限（qos_now_us()时间），0表示解除绑定
+ * @return int64_t 之前绑定的期限
+ */
+int64_t wifi_exec_bind_deadline(int64_t deadline_us)
+{
+    int64_t prev = t_deadline_us;
+    t_deadline_us = deadline_us;
+    return prev;
+}
+
+/**
+ * @brief 获取当前线程绑定的请求期限
+ *
+ * @return int64_t 期限（qos_now_us()时间），0表示没有
+ */
+int64_t wifi_exec_deadline(void)
+{
+    return t_deadline_us;
+}
+
+/**
+ * @brief 当前线程正在执行的操作是否已被取消
+ *
+ * @return bool 已取消返回true，未绑定取消标志时始终返回false
+ */
+bool wifi_exec_cancelled(void)
+{
+    return t_cancel && __atomic_load_n(t_cancel, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 可被取消的等待
+ *
+ * @param ms 等待时间(毫秒)
+ * @return bool 等满返回true，期间操作被取消或到达请求期限返回false
+ */
+bool wifi_exec_sleep_ms(int ms)
+{
+    int64_t deadline_us = qos_now_us() + (int64_t)ms * 1000;
+    for (;;)
+    {
+        if (wifi_exec_cancelled())
+        {
+            return false;
+        }
+        int64_t now_us = qos_now_us();
+        if (t_deadline_us && now_us >= t_deadline_us)
+        {
+            return false;
+        }
+        int64_t remain_us = deadline_us - now_us;
+        if (remain_us <= 0)
+        {
+            return true;
+        }
+        if (t_deadline_us && remain_us > t_deadline_us - now_us)
+        {
+            remain_us = t_deadline_us - now_us;
+        }
+        if (t_cancel && remain_us > WIFI_EXEC_CANCEL_POLL_MS * 1000)
+        {
+            remain_us = WIFI_EXEC_CANCEL_POLL_MS * 1000;
+        }
+        struct timespec ts = {.tv_sec = remain_us / 1000000,
+                              .tv_nsec = (long)(remain_us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+/**
+ * @brief 保证缓冲区至少还有extra字节空闲（另留一字节给NUL）
+ *
+ * @param buf 输出缓冲区
+ * @param extra 需要的空闲字节数
+ * @return int 成功返回0，超出上限或分配失败返回-1
+ */
+static int wifi_exec_buf_reserve(wifi_exec_buf *buf, size_t extra)
+{
+    size_t need = buf->len + extra + 1;
+    if (need <= buf->cap)
+    {
+        return 0;
+    }
+    if (need > WIFI_EXEC_OUTPUT_MAX + 1)
+    {
+        return -1;
+    }
+    size_t cap = buf->cap ? buf->cap : WIFI_EXEC_READ_CHUNK;
+    while (cap < need)
+    {
+        cap *= 2;
+    }
+    char *data = (char *)metrics_realloc(METRICS_MODULE_WIFI, buf->data, cap);
+    if (!data)
+    {
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief 启动子进程，标准输出接到管道写端
+ *
+ * @param argv 以NULL结尾的参数数组
+ * @param out_fd 管道写端
+ * @param pid 输出子进程ID
+ * @return int 成功返回0，失败返回错误码
+ */
+static int wifi_exec_spawn(const char *const argv[], int out_fd, pid_t *pid)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    int rc = posix_spawn_file_actions_init(&actions);
+    if (rc != 0)
+    {
+        return rc;
+    }
+    rc = posix_spawnattr_init(&attr);
+    if (rc != 0)
+    {
+        posix_spawn_file_actions_destroy(&actions);
+        return rc;
+    }
+
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    // 子进程不继承工作线程的信号屏蔽字，SIGPIPE恢复默认处理
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    rc = posix_spawnp(pid, argv[0], &actions, &attr, (char *const *)argv, environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc;
+}
+
+/**
+ * @brief 读取子进程输出直到EOF、期限或操作被取消
+ *
+ * 输出超过WIFI_EXEC_OUTPUT_MAX时继续读到EOF（子进程不会因管道写满而阻塞），超出部分丢弃。
+ *
+ * @param fd 管道读端
+ * @param deadline_us 期限（qos_now_us()时间）
+ * @param out 输出缓冲区，NULL表示丢弃
+ * @param dropped 输出超出上限被丢弃的字节数
+ * @return wifi_exec_drain_t 读取结果
+ */
+static wifi_exec_drain_t wifi_exec_drain(int fd, int64_t deadline_us, wifi_exec_buf *out,
+                                         size_t *dropped)
+{
+    char discard[WIFI_EXEC_READ_CHUNK];
+    for (;;)
+    {
+        if (wifi_exec_cancelled())
+        {
+            return WIFI_EXEC_INTERRUPTED;
+        }
+        int64_t remain_ms = (deadline_us - qos_now_us() + 999) / 1000;
+        if (remain_ms <= 0)
+        {
+            return WIFI_EXEC_DEADLINE;
+        }
+        if (t_cancel && remain_ms > WIFI_EXEC_CANCEL_POLL_MS)
+        {
+            remain_ms = WIFI_EXEC_CANCEL_POLL_MS;
+        }
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int n = poll(&pfd, 1, (int)remain_ms);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            return WIFI_EXEC_DRAINED;
+        }
+        if (n == 0)
+        {
+            continue;
+        }
+
+        char *dst = discard;
+        size_t room = sizeof(discard);
+        size_t left = out ? WIFI_EXEC_OUTPUT_MAX - out->len : 0;
+        size_t want = left < WIFI_EXEC_READ_CHUNK ? left : WIFI_EXEC_READ_CHUNK;
+        if (want > 0 && wifi_exec_buf_reserve(out, want) == 0)
+        {
+            dst = out->data + out->len;
+            room = out->cap - out->len - 1;
+            room = room < left ? room : left;
+        }
+        ssize_t r = read(fd, dst, room);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            return WIFI_EXEC_DRAINED;
+        }
+        if (dst != discard)
+        {
+            out->len += (size_t)r;
+            out->data[out->len] = '\0';
+        }
+        else if (out)
+        {
+            *dropped += (size_t)r;
+        }
+    }
+}
+
+/**
+ * @brief 回收子进程，期限到达或操作被取消时仍未退出则强制终止
+ *
+ * @param pid 子进程ID
+ * @param deadline_us 期限（qos_now_us()时间）
+ * @param state 输入输出：输出读取结果，等待期间超过期限或被取消时更新
+ * @return int waitpid状态，无法回收时返回-1
+ */
+static int wifi_exec_reap(pid_t pid, int64_t deadline_us, wifi_exec_drain_t *state)
+{
+    int status = 0;
+    if (*state == WIFI_EXEC_DRAINED)
+    {
+        // 输出已结束，子进程通常已经或即将退出
+        for (;;)
+        {
+            pid_t w = waitpid(pid, &status, WNOHANG);
+            if (w == pid)
+            {
+                return status;
+            }
+            if (w < 0 && errno != EINTR)
+            {
+                return -1;
+            }
+            if (wifi_exec_cancelled())
+            {
+                *state = WIFI_EXEC_INTERRUPTED;
+                break;
+            }
+            if (qos_now_us() >= deadline_us)
+            {
+                *state = WIFI_EXEC_DEADLINE;
+                break;
+            }
+            usleep(1000);
+        }
+    }
+
+    kill(pid, SIGKILL);
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief 直接执行argv（不经过/bin/sh），捕获标准输出
+ *
+ * @param argv 以NULL结尾的参数数组
+ * @param timeout_ms 期限(毫秒)，<=0表示WIFI_EXEC_TIMEOUT_MS
+ * @param out 输出缓冲区，执行前清空；NULL表示丢弃输出
+ * @return wifi_error_t 退出码为0返回WIFI_ERR_OK，超时返回WIFI_ERR_TIMEOUT，
+ *         被取消返回WIFI_ERR_CANCELLED，无法启动、被信号终止或退出码非0返回WIFI_ERR_TOOL_ERROR
+ */
+wifi_error_t wifi_exec_run(const char *const argv[], int timeout_ms, wifi_exec_buf *out)
+{
+    if (!argv || !argv[0])
+    {
+        return WIFI_ERR_BAD_REQUEST;
+    }
+    if (out)
+    {
+        out->len = 0;
+        if (wifi_exec_buf_reserve(out, 0) != 0)
+        {
+            return WIFI_ERR_INTERNAL;
+        }
+        out->data[0] = '\0';
+    }
+    if (wifi_exec_cancelled())
+    {
+        return WIFI_ERR_CANCELLED;
+    }
+
+    int64_t start_us = qos_now_us();
+    if (t_deadline_us && start_us >= t_deadline_us)
+    {
+        return WIFI_ERR_TIMEOUT;
+    }
+    int64_t deadline_us =
+        start_us + (int64_t)(timeout_ms > 0 ? timeout_ms : WIFI_EXEC_TIMEOUT_MS) * 1000;
+    if (t_deadline_us && t_deadline_us < deadline_us)
+    {
+        deadline_us = t_deadline_us;
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+    {
+        perror("wifi_exec: pipe2");
+        metrics_observe_exec(METRICS_EXEC_FAILED, qos_now_us() - start_us);
+        return WIFI_ERR_TOOL_ERROR;
+    }
+
+    pid_t pid;
+    int rc = wifi_exec_spawn(argv, fds[1], &pid);
+    close(fds[1]);
+    if (rc != 0)
+    {
+        close(fds[0]);
+        fprintf(stderr, "wifi_exec: 无法执行 %s: %s\n", argv[0], strerror(rc));
+        metrics_observe_exec(METRICS_EXEC_FAILED, qos_now_us() - start_us);
+        return WIFI_ERR_TOOL_ERROR;
+    }
+
+    size_t dropped = 0;
+    wifi_exec_drain_t state = wifi_exec_drain(fds[0], deadline_us, out, &dropped);
+    close(fds[0]);
+    int status = wifi_exec_reap(pid, deadline_us, &state);
+
+    metrics_exec_result_t result = METRICS_EXEC_FAILED;
+    wifi_error_t err = WIFI_ERR_TOOL_ERROR;
+    if (state == WIFI_EXEC_INTERRUPTED)
+    {
+        result = METRICS_EXEC_CANCELLED;
+        err = WIFI_ERR_CANCELLED;
+    }
+    else if (state == WIFI_EXEC_DEADLINE)
+    {
+        fprintf(stderr, "wifi_exec: %s 超过 %d ms，已终止\n", argv[0],
+                (int)((deadline_us - start_us) / 1000));
+        result = METRICS_EXEC_TIMEOUT;
+        err = WIFI_ERR_TIMEOUT;
+    }
+    else if (dropped > 0)
+    {
+        // 截断的输出可能在任意位置断开，按工具错误处理，不交给解析器
+        fprintf(stderr, "wifi_exec: %s 输出超过 %d 字节上限，丢弃了 %zu 字节\n", argv[0],
+                (int)WIFI_EXEC_OUTPUT_MAX, dropped);
+    }
+    else if (status >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        result = METRICS_EXEC_OK;
+        err = WIFI_ERR_OK;
+    }
+    metrics_observe_exec(result, qos_now_us() - start_us);
+    return err;
+}
+
+/**
+ * @brief 释放输出缓冲区
+ *
+ * @param buf 输出缓冲区
+ */
+void wifi_exec_buf_free(wifi_exec_buf *buf)
+{
+    if (!buf)
+    {
+        return;
+    }
+    metrics_free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
@@ -0,0 +1,125 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_exec.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 外部命令执行器（posix_spawn + 管道，带期限）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef WIFI_EXEC_H
+#define WIFI_EXEC_H
+
+#include "../wifi_def.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef WIFI_EXEC_TIMEOUT_MS
+#define WIFI_EXEC_TIMEOUT_MS 5000 ///< 单条命令的默认期限(毫秒)，超时的子进程被SIGKILL
+#endif
+
+#ifndef WIFI_EXEC_CANCEL_POLL_MS
+#define WIFI_EXEC_CANCEL_POLL_MS 50 ///< 绑定取消标志时检查标志的间隔(毫秒)
+#endif
+
+#ifndef WIFI_EXEC_OUTPUT_MAX
+#define WIFI_EXEC_OUTPUT_MAX (1024 * 1024) ///< 捕获输出的上限，超出时执行按工具错误返回
+#endif
+
+/**
+ * @brief 可复用的输出缓冲区（连续多次执行时只在需要时扩容）
+ */
+typedef struct
+{
+    char *data; ///< 输出内容，始终以NUL结尾
+    size_t len; ///< 输出长度
+    size_t cap; ///< 已分配容量
+} wifi_exec_buf;
+
+/**
+ * @brief 直接执行argv（不经过/bin/sh），捕获标准输出
+ *
+ * 标准输入与标准错误重定向到/dev/null，argv[0]按PATH查找。
+ * 超过期限（与当前线程绑定的请求期限取较早者）或绑定的取消标志置位时子进程被SIGKILL并回收，
+ * 不会遗留僵尸进程；请求期限在启动前已过时直接返回WIFI_ERR_TIMEOUT，不启动子进程。
+ *
+ * @param argv 以NULL结尾的参数数组
+ * @param timeout_ms 期限(毫秒)，<=0表示WIFI_EXEC_TIMEOUT_MS
+ * @param out 输出缓冲区，执行前清空；NULL表示丢弃输出
+ * @return wifi_error_t 退出码为0返回WIFI_ERR_OK，超时返回WIFI_ERR_TIMEOUT，
+ *         被取消返回WIFI_ERR_CANCELLED，无法启动、被信号终止、退出码非0或输出超过
+ *         WIFI_EXEC_OUTPUT_MAX返回WIFI_ERR_TOOL_ERROR（out保留前WIFI_EXEC_OUTPUT_MAX字节）
+ */
+wifi_error_t wifi_exec_run(const char *const argv[], int timeout_ms, wifi_exec_buf *out);
+
+/**
+ * @brief 为当前线程绑定取消标志
+ *
+ * 绑定期间wifi_exec_run与wifi_exec_sleep_ms每WIFI_EXEC_CANCEL_POLL_MS检查一次标志，
+ * 置位后终止子进程或提前返回。队列工作线程执行任务前绑定任务的标志，执行后解除绑定；
+ * 取消后仍必须执行的清理命令可临时解除绑定，完成后再恢复。
+ *
+ * @param flag 取消标志（以__atomic读取），NULL表示解除绑定
+ * @return const bool* 之前绑定的标志
+ */
+const bool *wifi_exec_bind_cancel(const bool *flag);
+
+/**
+ * @brief 为当前线程绑定请求期限
+ *
+ * 绑定期间wifi_exec_run的期限不晚于该期限，wifi_exec_sleep_ms到期提前返回。
+ * 与取消标志一样由执行请求的线程在执行前绑定、执行后解除。
+ *
+ * @param deadline_us 期限（qos_now_us()时间），0表示解除绑定
+ * @return int64_t 之前绑定的期限
+ */
+int64_t wifi_exec_bind_deadline(int64_t deadline_us);
+
+/**
+ * @brief 获取当前线程绑定的请求期限
+ *
+ * @return int64_t 期限（qos_now_us()时间），0表示没有
+ */
+int64_t wifi_exec_deadline(void);
+
+/**
+ * @brief 当前线程正在执行的操作是否已被取消
+ *
+ * @return bool 已取消返回true，未绑定取消标志时始终返回false
+ */
+bool wifi_exec_cancelled(void);
+
+/**
+ * @brief 可被取消的等待
+ *
+ * @param ms 等待时间(毫秒)
+ * @return bool 等满返回true，期间操作被取消或到达请求期限返回false
+ */
+bool wifi_exec_sleep_ms(int ms);
+
+/**
+ * @brief 释放输出缓冲区
+ *
+ * @param buf 输出缓冲区
+ */
+void wifi_exec_buf_free(wifi_exec_buf *buf);
+
+#endif
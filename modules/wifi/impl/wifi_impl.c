@@ -24,60 +24,97 @@ limitations under the License.
  *
  */
 #include "wifi_impl.h"
+#include "../../../metrics.h"
 #include "../wifi_def.h"
+#include "wifi_exec.h"
+#include "wifi_parse.h"
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+
+#define WPA_CLI_MAX_ARGS 16        ///< wpa_cli参数数组大小（含前缀与结尾NULL）
+#define WIFI_SSID_MAX_LEN 32       ///< SSID最大字节数
+#define WIFI_PSK_HEX_LEN 64        ///< 十六进制原始PSK长度
+#define WIFI_PASSPHRASE_MIN_LEN 8  ///< WPA口令最短字符数
+#define WIFI_PASSPHRASE_MAX_LEN 63 ///< WPA口令最长字符数
+
+static char g_wpa_ctrl_dir[256];
+static pthread_once_t g_wpa_cli_once = PTHREAD_ONCE_INIT;
 
 /**
- * @brief 解码UTF-8转义序列（如\\xE4\\xBD\\xA0）
+ * @brief 读取wpa_supplicant控制接口目录
  *
- * @param input 输入字符串
- * @param output 输出缓冲区
- * @param output_size 输出缓冲区大小
- * @return int 成功返回0，失败返回-1
+ * @details 设置了WIFI_CTRL_DIR环境变量时通过-p指定控制接口目录，
+ *          用于连接非默认目录下的wpa_supplicant（如tools/wpa_sim模拟器）。
  */
-static int decode_utf8_escape_sequence(const char *input, char *output, size_t output_size)
+static void wpa_ctrl_dir_init(void)
 {
-    if (!input || !output || output_size == 0)
+    const char *dir = getenv(WIFI_CTRL_DIR_ENV);
+    if (dir)
     {
-        return -1;
+        snprintf(g_wpa_ctrl_dir, sizeof(g_wpa_ctrl_dir), "%s", dir);
     }
+}
 
-    const char *src = input;
-    char *dst = output;
-    size_t dst_len = 0;
+/**
+ * @brief 执行一条wpa_cli命令（"wpa_cli [-p dir] -i <ifname> <cmd> [args...]"）
+ *
+ * @details 参数直接作为argv传给wpa_cli，SSID与密码无需shell转义。
+ *
+ * @param out 输出缓冲区，NULL表示丢弃输出
+ * @param cmd wpa_cli命令
+ * @param ... 命令参数（const char *），以NULL结尾
+ * @return wifi_error_t 见wifi_exec_run
+ */
+static wifi_error_t wpa_cli(wifi_exec_buf *out, const char *cmd, ...)
+{
+    pthread_once(&g_wpa_cli_once, wpa_ctrl_dir_init);
 
-    while (*src && dst_len < output_size - 1)
+    const char *argv[WPA_CLI_MAX_ARGS];
+    int argc = 0;
+    argv[argc++] = "wpa_cli";
+    if (g_wpa_ctrl_dir[0] != '\0')
     {
-        if (*src == '\\' && *(src + 1) == 'x' && src + 3 < input + strlen(input))
-        {
-            char hex_str[3] = {src[2], src[3], '\0'};
-            char *endptr;
-            unsigned long hex_val = strtoul(hex_str, &endptr, 16);
-
-            if (*endptr == '\0' && hex_val <= 0xFF)
-            {
-                *dst++ = (char)hex_val;
-                dst_len++;
-                src += 4;
-            }
-            else
-            {
-                *dst++ = *src++;
-                dst_len++;
-            }
-        }
-        else
-        {
-            *dst++ = *src++;
-            dst_len++;
-        }
+        argv[argc++] = "-p";
+        argv[argc++] = g_wpa_ctrl_dir;
     }
+    argv[argc++] = "-i";
+    argv[argc++] = WIFI_DEVICE;
+    argv[argc++] = cmd;
+
+    va_list ap;
+    va_start(ap, cmd);
+    const char *arg;
+    while ((arg = va_arg(ap, const char *)) != NULL && argc < WPA_CLI_MAX_ARGS - 1)
+    {
+        argv[argc++] = arg;
+    }
+    va_end(ap);
+    argv[argc] = NULL;
+
+    return wifi_exec_run(argv, WIFI_EXEC_TIMEOUT_MS, out);
+}
 
-    *dst = '\0';
-    return 0;
+/**
+ * @brief 执行一次wpa_cli status并解析全部字段
+ *
+ * @param out 复用的输出缓冲区
+ * @param status 输出解析结果
+ * @return wifi_error_t 见wifi_exec_run
+ */
+static wifi_error_t wpa_cli_status(wifi_exec_buf *out, wifi_status_info *status)
+{
+    wifi_error_t err = wpa_cli(out, "status", NULL);
+    if (err == WIFI_ERR_OK)
+    {
+        wifi_parse_status(out->data, status);
+    }
+    return err;
 }
 
 /**
@@ -88,32 +125,21 @@ static int decode_utf8_escape_sequence(const char *input, char *output, size_t o
  */
 wifi_error_t wifi_impl_enable(bool is_enable)
 {
-    char command[256];
-    int result;
-
     if (is_enable)
     {
-        snprintf(command, sizeof(command), "wpa_cli -i %s enable_network all", WIFI_DEVICE);
-        result = system(command);
-        if (result != 0)
+        if (wpa_cli(NULL, "enable_network", "all", NULL) != WIFI_ERR_OK)
         {
             return WIFI_ERR_TOOL_ERROR;
         }
-
-        snprintf(command, sizeof(command), "wpa_cli -i %s reconnect", WIFI_DEVICE);
-        result = system(command);
-        if (result != 0)
+        if (wpa_cli(NULL, "reconnect", NULL) != WIFI_ERR_OK)
         {
             return WIFI_ERR_TOOL_ERROR;
         }
     }
     else
     {
-        snprintf(command, sizeof(command), "wpa_cli -i %s disable_network all", WIFI_DEVICE);
-        system(command);
-
-        snprintf(command, sizeof(command), "wpa_cli -i %s disconnect", WIFI_DEVICE);
-        system(command);
+        wpa_cli(NULL, "disable_network", "all", NULL);
+        wpa_cli(NULL, "disconnect", NULL);
     }
 
     printf("wifi_impl_enable: Wi-Fi %s\n", is_enable ? "enabled" : "disabled");
@@ -129,198 +155,100 @@ wifi_error_t wifi_impl_enable(bool is_enable)
  */
 wifi_error_t wifi_impl_scan(bool rescan, wifi_scan_result *result)
 {
-    FILE *fp;
-    char buffer[512];
-    char command[256];
+    wifi_exec_buf out = {0};
 
     result->networks = NULL;
     result->network_count = 0;
 
-    if (rescan)
-    {
-        snprintf(command, sizeof(command), "wpa_cli -i %s scan 2>/dev/null", WIFI_DEVICE);
-        system(command);
-        snprintf(command, sizeof(command), "wpa_cli -i %s scan_results 2>/dev/null", WIFI_DEVICE);
-    }
-    else
+    if (rescan && wpa_cli(NULL, "scan", NULL) == WIFI_ERR_CANCELLED)
     {
-        snprintf(command, sizeof(command), "wpa_cli -i %s scan_results 2>/dev/null", WIFI_DEVICE);
+        return WIFI_ERR_CANCELLED;
     }
 
-    fp = popen(command, "r");
-    if (fp == NULL)
+    wifi_error_t err = wpa_cli(&out, "scan_results", NULL);
+    if (err != WIFI_ERR_OK)
     {
-        return WIFI_ERR_TOOL_ERROR;
+        wifi_exec_buf_free(&out);
+        return (err == WIFI_ERR_TIMEOUT || err == WIFI_ERR_CANCELLED) ? err : WIFI_ERR_TOOL_ERROR;
     }
 
-    if (fgets(buffer, sizeof(buffer), fp) == NULL)
+    // 第一行为表头
+    char *save = NULL;
+    char *line = strtok_r(out.data, "\n", &save);
+    if (line == NULL)
     {
-        pclose(fp);
+        wifi_exec_buf_free(&out);
         return WIFI_ERR_TOOL_ERROR;
     }
 
-    wifi_network_info *temp_networks = malloc(sizeof(wifi_network_info) * 64);
+    wifi_network_info *temp_networks =
+        metrics_malloc(METRICS_MODULE_WIFI, sizeof(wifi_network_info) * 64);
     if (!temp_networks)
     {
-        pclose(fp);
+        wifi_exec_buf_free(&out);
         return WIFI_ERR_INTERNAL;
     }
 
     size_t count = 0;
     size_t max_networks = 64;
 
-    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    while ((line = strtok_r(NULL, "\n", &save)) != NULL)
     {
         if (count >= max_networks)
         {
             max_networks *= 2;
             wifi_network_info *new_networks =
-                realloc(temp_networks, sizeof(wifi_network_info) * max_networks);
+                metrics_realloc(METRICS_MODULE_WIFI, temp_networks,
+                                sizeof(wifi_network_info) * max_networks);
             if (!new_networks)
             {
                 for (size_t i = 0; i < count; i++)
                 {
-                    free(temp_networks[i].ssid);
-                    free(temp_networks[i].bssid);
-                    free(temp_networks[i].security);
+                    metrics_free(temp_networks[i].ssid);
+                    metrics_free(temp_networks[i].bssid);
+                    metrics_free(temp_networks[i].security);
                 }
-                free(temp_networks);
-                pclose(fp);
+                metrics_free(temp_networks);
+                wifi_exec_buf_free(&out);
                 return WIFI_ERR_INTERNAL;
             }
             temp_networks = new_networks;
         }
 
-        int frequency, signal;
-        char bssid[32], security[128], ssid[128];
-
-        char *token = strtok(buffer, "\t");
-        if (token)
+        if (wifi_parse_scan_line(line, &temp_networks[count]) == 0)
         {
-            strncpy(bssid, token, sizeof(bssid) - 1);
-            bssid[sizeof(bssid) - 1] = '\0';
-            token = strtok(NULL, "\t");
-            if (token)
-            {
-                frequency = atoi(token);
-                token = strtok(NULL, "\t");
-                if (token)
-                {
-                    signal = atoi(token);
-                    token = strtok(NULL, "\t");
-                    if (token)
-                    {
-                        char *security_start = token;
-                        snprintf(security, sizeof(security), "%s", security_start);
-
-                        token = strtok(NULL, "\t");
-                        if (token)
-                        {
-                            token[strcspn(token, "\n")] = 0;
-
-                            char decoded_ssid[128];
-                            if (decode_utf8_escape_sequence(token, decoded_ssid,
-                                                            sizeof(decoded_ssid)) == 0)
-                            {
-                                snprintf(ssid, sizeof(ssid), "%s", decoded_ssid);
-                            }
-                            else
-                            {
-                                snprintf(ssid, sizeof(ssid), "%s", token);
-                            }
-                        }
-                        else
-                        {
-                            ssid[0] = '\0';
-                        }
-
-                        temp_networks[count].frequency_mhz = frequency;
-                        temp_networks[count].bssid = strdup(bssid);
-                        temp_networks[count].signal = signal;
-                        temp_networks[count].ssid = strdup(ssid[0] ? ssid : "\\x00");
-
-                        if (strlen(security) == 0)
-                        {
-                            temp_networks[count].security = strdup("Open");
-                        }
-                        else
-                        {
-                            temp_networks[count].security = strdup(security);
-                        }
-
-                        if (frequency >= 2412 && frequency <= 2484)
-                        {
-                            temp_networks[count].channel = (frequency - 2407) / 5;
-                        }
-                        else if (frequency >= 5035 && frequency <= 5895)
-                        {
-                            temp_networks[count].channel = (frequency - 5000) / 5;
-                        }
-                        else
-                        {
-                            temp_networks[count].channel = 0;
-                        }
-
-                        temp_networks[count].recorded = false;
-                        count++;
-                    }
-                }
-            }
+            count++;
         }
     }
 
-    pclose(fp);
-
-    snprintf(command, sizeof(command), "wpa_cli -i %s list_networks 2>/dev/null", WIFI_DEVICE);
-    fp = popen(command, "r");
-    if (fp != NULL)
+    // 输出缓冲区复用于list_networks
+    if (wpa_cli(&out, "list_networks", NULL) == WIFI_ERR_OK)
     {
-        fgets(buffer, sizeof(buffer), fp);
-
-        while (fgets(buffer, sizeof(buffer), fp) != NULL)
+        save = NULL;
+        for (line = strtok_r(out.data, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
         {
-            char *token = strtok(buffer, "\t");
-            if (token)
+            int id;
+            char recorded_ssid[128];
+            if (wifi_parse_network_line(line, &id, recorded_ssid, sizeof(recorded_ssid)) != 0)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < count; i++)
             {
-                token = strtok(NULL, "\t");
-                if (token)
+                if (strcmp(temp_networks[i].ssid, recorded_ssid) == 0)
                 {
-                    token[strcspn(token, "\n")] = 0;
-
-                    char decoded_recorded_ssid[128];
-                    if (decode_utf8_escape_sequence(token, decoded_recorded_ssid,
-                                                    sizeof(decoded_recorded_ssid)) == 0)
-                    {
-                        for (size_t i = 0; i < count; i++)
-                        {
-                            if (strcmp(temp_networks[i].ssid, decoded_recorded_ssid) == 0)
-                            {
-                                temp_networks[i].recorded = true;
-                                break;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        for (size_t i = 0; i < count; i++)
-                        {
-                            if (strcmp(temp_networks[i].ssid, token) == 0)
-                            {
-                                temp_networks[i].recorded = true;
-                                break;
-                            }
-                        }
-                    }
+                    temp_networks[i].recorded = true;
+                    break;
                 }
             }
         }
-        pclose(fp);
     }
+    wifi_exec_buf_free(&out);
 
     if (count > 0)
     {
         wifi_network_info *final_networks =
-            realloc(temp_networks, sizeof(wifi_network_info) * count);
+            metrics_realloc(METRICS_MODULE_WIFI, temp_networks, sizeof(wifi_network_info) * count);
         if (final_networks)
         {
             temp_networks = final_networks;
@@ -328,7 +256,7 @@ wifi_error_t wifi_impl_scan(bool rescan, wifi_scan_result *result)
     }
     else
     {
-        free(temp_networks);
+        metrics_free(temp_networks);
         temp_networks = NULL;
     }
 
@@ -347,18 +275,53 @@ void wifi_impl_scan_result_free(wifi_scan_result *result)
 
     for (size_t i = 0; i < result->network_count; i++)
     {
-        free(result->networks[i].ssid);
-        free(result->networks[i].bssid);
-        free(result->networks[i].security);
+        metrics_free(result->networks[i].ssid);
+        metrics_free(result->networks[i].bssid);
+        metrics_free(result->networks[i].security);
     }
-    free(result->networks);
+    metrics_free(result->networks);
     result->networks = NULL;
     result->network_count = 0;
 }
 
+/**
+ * @brief 读取网卡的IPv4地址
+ *
+ * @param ifname 网卡名
+ * @return char* 地址字符串（由函数分配），没有地址时返回NULL
+ */
+static char *wifi_impl_ipv4_address(const char *ifname)
+{
+    struct ifaddrs *ifaddr;
+    if (getifaddrs(&ifaddr) != 0)
+    {
+        return NULL;
+    }
+
+    char *ip = NULL;
+    for (struct ifaddrs *ifa = ifaddr; ifa; ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET &&
+            strcmp(ifa->ifa_name, ifname) == 0)
+        {
+            char buffer[INET_ADDRSTRLEN];
+            const struct sockaddr_in *sin = (const struct sockaddr_in *)ifa->ifa_addr;
+            if (inet_ntop(AF_INET, &sin->sin_addr, buffer, sizeof(buffer)))
+            {
+                ip = metrics_strdup(METRICS_MODULE_WIFI, buffer);
+            }
+            break;
+        }
+    }
+    freeifaddrs(ifaddr);
+    return ip;
+}
+
 /**
  * @brief 获取WiFi连接状态
  *
+ * @details wpa_cli status只执行一次并整体解析，取代逐字段的管道命令。
+ *
  * @param status 状态信息（由函数分配部分字段，调用者需调用wifi_impl_status_free释放）
  * @return wifi_error_t 错误码
  */
@@ -375,117 +338,36 @@ wifi_error_t wifi_impl_get_status(wifi_status_info *status)
     status->channel = 0;
     status->frequency_mhz = 0;
 
-    FILE *fp;
-    char buffer[256];
-    char command[256];
-
-    snprintf(command, sizeof(command),
-             "wpa_cli -i %s status 2>/dev/null | grep wpa_state | cut -d= -f2", WIFI_DEVICE);
-    fp = popen(command, "r");
-    if (fp != NULL)
+    wifi_exec_buf out = {0};
+    wifi_error_t err = wpa_cli_status(&out, status);
+    if (err != WIFI_ERR_OK)
     {
-        if (fgets(buffer, sizeof(buffer), fp) != NULL)
-        {
-            status->enable =
-                (strstr(buffer, "COMPLETED") != NULL || strstr(buffer, "ASSOCIATED") != NULL ||
-                 strstr(buffer, "ASSOCIATING") != NULL || strstr(buffer, "SCANNING") != NULL);
-            status->connected = (strstr(buffer, "COMPLETED") != NULL);
-        }
-        pclose(fp);
+        wifi_exec_buf_free(&out);
+        return err;
     }
 
     if (status->enable)
     {
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep '^ssid=' | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                buffer[strcspn(buffer, "\n")] = 0;
-                status->ssid = strdup(buffer);
-            }
-            pclose(fp);
-        }
-
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep bssid | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                buffer[strcspn(buffer, "\n")] = 0;
-                status->bssid = strdup(buffer);
-            }
-            pclose(fp);
-        }
-
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s signal_poll 2>/dev/null | grep RSSI | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                status->signal = atoi(buffer);
-            }
-            pclose(fp);
-        }
-
-        snprintf(command, sizeof(command),
-                 "ip addr show %s 2>/dev/null | grep 'inet ' | awk '{print $2}' | cut -d/ -f1",
-                 WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                buffer[strcspn(buffer, "\n")] = 0;
-                status->ip = strdup(buffer);
-            }
-            pclose(fp);
-        }
-
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep key_mgmt | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                buffer[strcspn(buffer, "\n")] = 0;
-                status->security = strdup(buffer);
-            }
-            pclose(fp);
-        }
-
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep channel | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
+        // 未关联时signal_poll失败属正常，只有超时与取消需要上报
+        err = wpa_cli(&out, "signal_poll", NULL);
+        if (err == WIFI_ERR_OK)
         {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
+            const char *rssi = strstr(out.data, "RSSI=");
+            if (rssi)
             {
-                status->channel = atoi(buffer);
+                status->signal = atoi(rssi + strlen("RSSI="));
             }
-            pclose(fp);
         }
-
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep freq | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
+        else if (err == WIFI_ERR_TIMEOUT || err == WIFI_ERR_CANCELLED)
         {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                status->frequency_mhz = atoi(buffer);
-            }
-            pclose(fp);
+            wifi_exec_buf_free(&out);
+            wifi_impl_status_free(status);
+            return err;
         }
+        status->ip = wifi_impl_ipv4_address(WIFI_DEVICE);
     }
 
+    wifi_exec_buf_free(&out);
     return WIFI_ERR_OK;
 }
 
@@ -501,10 +383,10 @@ void wifi_impl_status_free(wifi_status_info *status)
         return;
     }
 
-    free(status->ssid);
-    free(status->bssid);
-    free(status->ip);
-    free(status->security);
+    metrics_free(status->ssid);
+    metrics_free(status->bssid);
+    metrics_free(status->ip);
+    metrics_free(status->security);
 
     status->ssid = NULL;
     status->bssid = NULL;
@@ -512,6 +394,47 @@ void wifi_impl_status_free(wifi_status_info *status)
     status->security = NULL;
 }
 
+/**
+ * @brief 在已保存的网络中查找SSID
+ *
+ * @param out 复用的输出缓冲区
+ * @param ssid 网络SSID
+ * @return int 网络ID，未找到返回-1
+ */
+static int wifi_impl_find_network(wifi_exec_buf *out, const char *ssid)
+{
+    if (wpa_cli(out, "list_networks", NULL) != WIFI_ERR_OK)
+    {
+        return -1;
+    }
+    char *save = NULL;
+    for (char *line = strtok_r(out->data, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+    {
+        int id;
+        char recorded_ssid[128];
+        if (wifi_parse_network_line(line, &id, recorded_ssid, sizeof(recorded_ssid)) == 0 &&
+            strcmp(recorded_ssid, ssid) == 0)
+        {
+            return id;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 查询wpa_state是否为COMPLETED
+ *
+ * @param out 复用的输出缓冲区
+ * @return bool 是否已连接
+ */
+static bool wifi_impl_is_connected(wifi_exec_buf *out)
+{
+    wifi_status_info status = {0};
+    wpa_cli_status(out, &status);
+    wifi_impl_status_free(&status);
+    return status.connected;
+}
+
 /**
  * @brief 连接WiFi网络
  *
@@ -522,9 +445,8 @@ void wifi_impl_status_free(wifi_status_info *status)
  */
 wifi_error_t wifi_impl_connect(const char *ssid, const char *password, int timeout_ms)
 {
-    FILE *fp;
-    char buffer[256];
-    char command[256];
+    wifi_exec_buf out = {0};
+    char id_str[16];
     int network_id = -1;
     int timeout;
     int wait_time;
@@ -534,75 +456,76 @@ wifi_error_t wifi_impl_connect(const char *ssid, const char *password, int timeo
     {
         return WIFI_ERR_BAD_REQUEST;
     }
-
-    if (!password || strlen(password) == 0)
+    size_t ssid_len = strlen(ssid);
+    if (ssid_len > WIFI_SSID_MAX_LEN)
     {
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s list_networks 2>/dev/null | grep -E '\t%s\t' | cut -f1",
-                 WIFI_DEVICE, ssid);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                network_id = atoi(buffer);
-            }
-            pclose(fp);
-        }
+        return WIFI_ERR_INVALID_SSID;
+    }
+    // 空密码表示开放网络；64位十六进制为原始PSK，其余按口令处理，须为8~63个字符
+    size_t password_len = password ? strlen(password) : 0;
+    bool raw_psk = password_len == WIFI_PSK_HEX_LEN &&
+                   strspn(password, "0123456789abcdefABCDEF") == WIFI_PSK_HEX_LEN;
+    if (password_len > 0 && !raw_psk &&
+        (password_len < WIFI_PASSPHRASE_MIN_LEN || password_len > WIFI_PASSPHRASE_MAX_LEN))
+    {
+        return WIFI_ERR_INVALID_PASSWORD;
+    }
 
+    if (password_len == 0)
+    {
+        network_id = wifi_impl_find_network(&out, ssid);
         if (network_id >= 0)
         {
-            snprintf(command, sizeof(command), "wpa_cli -i %s enable_network %d 2>/dev/null",
-                     WIFI_DEVICE, network_id);
-            system(command);
-
-            snprintf(command, sizeof(command), "wpa_cli -i %s select_network %d 2>/dev/null",
-                     WIFI_DEVICE, network_id);
-            system(command);
+            snprintf(id_str, sizeof(id_str), "%d", network_id);
+            wpa_cli(NULL, "enable_network", id_str, NULL);
+            wpa_cli(NULL, "select_network", id_str, NULL);
 
             goto wait_for_connection;
         }
     }
 
-    snprintf(command, sizeof(command), "wpa_cli -i %s add_network 2>/dev/null", WIFI_DEVICE);
-    fp = popen(command, "r");
-    if (fp != NULL)
+    if (wpa_cli(&out, "add_network", NULL) == WIFI_ERR_OK && out.len > 0)
     {
-        if (fgets(buffer, sizeof(buffer), fp) != NULL)
-        {
-            network_id = atoi(buffer);
-        }
-        pclose(fp);
+        network_id = atoi(out.data);
     }
 
     if (network_id < 0)
     {
+        wifi_exec_buf_free(&out);
         return WIFI_ERR_TOOL_ERROR;
     }
+    snprintf(id_str, sizeof(id_str), "%d", network_id);
 
-    snprintf(command, sizeof(command), "wpa_cli -i %s set_network %d ssid '\"%s\"' 2>/dev/null",
-             WIFI_DEVICE, network_id, ssid);
-    system(command);
+    // SSID以十六进制传入，任意字节（引号、反斜杠、UTF-8）都无需转义
+    char ssid_hex[2 * WIFI_SSID_MAX_LEN + 1];
+    for (size_t i = 0; i < ssid_len; i++)
+    {
+        snprintf(&ssid_hex[2 * i], 3, "%02x", (unsigned char)ssid[i]);
+    }
+    ssid_hex[2 * ssid_len] = '\0';
+    wpa_cli(NULL, "set_network", id_str, "ssid", ssid_hex, NULL);
 
-    if (password && strlen(password) > 0)
+    if (password_len > 0)
     {
-        snprintf(command, sizeof(command), "wpa_cli -i %s set_network %d psk '\"%s\"' 2>/dev/null",
-                 WIFI_DEVICE, network_id, password);
+        // 原始PSK直接传入，口令加引号
+        char psk[WIFI_PSK_HEX_LEN + 3];
+        if (raw_psk)
+        {
+            snprintf(psk, sizeof(psk), "%s", password);
+        }
+        else
+        {
+            snprintf(psk, sizeof(psk), "\"%s\"", password);
+        }
+        wpa_cli(NULL, "set_network", id_str, "psk", psk, NULL);
     }
     else
     {
-        snprintf(command, sizeof(command), "wpa_cli -i %s set_network %d key_mgmt NONE 2>/dev/null",
-                 WIFI_DEVICE, network_id);
+        wpa_cli(NULL, "set_network", id_str, "key_mgmt", "NONE", NULL);
     }
-    system(command);
 
-    snprintf(command, sizeof(command), "wpa_cli -i %s enable_network %d 2>/dev/null", WIFI_DEVICE,
-             network_id);
-    system(command);
-
-    snprintf(command, sizeof(command), "wpa_cli -i %s select_network %d 2>/dev/null", WIFI_DEVICE,
-             network_id);
-    system(command);
+    wpa_cli(NULL, "enable_network", id_str, NULL);
+    wpa_cli(NULL, "select_network", id_str, NULL);
 
 wait_for_connection:
     timeout = timeout_ms > 0 ? timeout_ms : 20000;
@@ -611,40 +534,36 @@ wait_for_connection:
 
     while (wait_time < timeout)
     {
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep wpa_state | cut -d= -f2", WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
+        if (wifi_impl_is_connected(&out))
         {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                if (strstr(buffer, "COMPLETED") != NULL)
-                {
-                    connected = true;
-                    pclose(fp);
-                    break;
-                }
-            }
-            pclose(fp);
+            connected = true;
+            break;
         }
 
-        sleep(1);
+        if (!wifi_exec_sleep_ms(1000))
+        {
+            break;
+        }
         wait_time += 1000;
     }
+    wifi_exec_buf_free(&out);
 
     if (!connected)
     {
+        bool cancelled = wifi_exec_cancelled();
         if (network_id >= 0)
         {
-            snprintf(command, sizeof(command), "wpa_cli -i %s disable_network %d 2>/dev/null",
-                     WIFI_DEVICE, network_id);
-            system(command);
+            // 取消或超过请求期限后仍要禁用该网络，否则wpa_supplicant会在后台继续尝试连接
+            const bool *cancel = wifi_exec_bind_cancel(NULL);
+            int64_t deadline_us = wifi_exec_bind_deadline(0);
+            wpa_cli(NULL, "disable_network", id_str, NULL);
+            wifi_exec_bind_deadline(deadline_us);
+            wifi_exec_bind_cancel(cancel);
         }
-        return WIFI_ERR_TIMEOUT;
+        return cancelled ? WIFI_ERR_CANCELLED : WIFI_ERR_TIMEOUT;
     }
 
-    snprintf(command, sizeof(command), "wpa_cli -i %s save_config 2>/dev/null", WIFI_DEVICE);
-    system(command);
+    wpa_cli(NULL, "save_config", NULL);
 
     return WIFI_ERR_OK;
 }
@@ -657,61 +576,29 @@ wait_for_connection:
  */
 wifi_error_t wifi_impl_disconnect(const char *ssid)
 {
-    FILE *fp;
-    char buffer[256];
-    char command[256];
-    bool is_connected = false;
+    wifi_exec_buf out = {0};
+    wifi_status_info status = {0};
+    wpa_cli_status(&out, &status);
+    wifi_exec_buf_free(&out);
 
-    snprintf(command, sizeof(command),
-             "wpa_cli -i %s status 2>/dev/null | grep wpa_state | cut -d= -f2", WIFI_DEVICE);
-    fp = popen(command, "r");
-    if (fp != NULL)
-    {
-        if (fgets(buffer, sizeof(buffer), fp) != NULL)
-        {
-            if (strstr(buffer, "COMPLETED") != NULL)
-            {
-                is_connected = true;
-            }
-        }
-        pclose(fp);
-    }
+    bool is_connected = status.connected;
+    bool same_ssid = !ssid || strlen(ssid) == 0 || (status.ssid && strcmp(status.ssid, ssid) == 0);
+    wifi_impl_status_free(&status);
 
     if (!is_connected)
     {
         return WIFI_ERR_NOT_CONNECTED;
     }
 
-    if (ssid && strlen(ssid) > 0)
+    if (!same_ssid)
     {
-        char current_ssid[256] = {0};
-        snprintf(command, sizeof(command),
-                 "wpa_cli -i %s status 2>/dev/null | grep '^ssid=' | head -1 | cut -d= -f2",
-                 WIFI_DEVICE);
-        fp = popen(command, "r");
-        if (fp != NULL)
-        {
-            if (fgets(buffer, sizeof(buffer), fp) != NULL)
-            {
-                buffer[strcspn(buffer, "\n")] = 0;
-                snprintf(current_ssid, sizeof(current_ssid), "%s", buffer);
-            }
-            pclose(fp);
-        }
-
-        if (strcmp(current_ssid, ssid) != 0)
-        {
-            return WIFI_ERR_BAD_REQUEST;
-        }
+        return WIFI_ERR_BAD_REQUEST;
     }
 
-    snprintf(command, sizeof(command), "wpa_cli -i %s disconnect 2>/dev/null", WIFI_DEVICE);
-    int result = system(command);
-
-    if (result != 0)
+    if (wpa_cli(NULL, "disconnect", NULL) != WIFI_ERR_OK)
     {
         return WIFI_ERR_TOOL_ERROR;
     }
 
     return WIFI_ERR_OK;
-}
\ No newline at end of file
+}
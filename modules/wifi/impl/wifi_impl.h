@@ -31,6 +31,7 @@ limitations under the License.
 #include <stddef.h>
 
 #define WIFI_DEVICE "wlan0"
+#define WIFI_CTRL_DIR_ENV "WIFI_CTRL_DIR" ///< 指定wpa_supplicant控制接口目录的环境变量（wpa_cli -p）
 
 /**
  * @brief 启用或禁用Wi-Fi功能（不保证连接成功）
@@ -75,9 +76,10 @@ void wifi_impl_status_free(wifi_status_info *status);
  * @brief 连接WiFi网络
  *
  * @param ssid 网络SSID
- * @param password 网络密码（可为NULL或空字符串）
+ * @param password 网络密码：NULL或空字符串表示开放网络，否则须为8~63个字符的口令
+ *                 或64位十六进制原始PSK
  * @param timeout_ms 超时时间（毫秒），0表示使用默认值
- * @return wifi_error_t 错误码
+ * @return wifi_error_t 错误码，密码格式不符返回WIFI_ERR_INVALID_PASSWORD
  */
 wifi_error_t wifi_impl_connect(const char *ssid, const char *password, int timeout_ms);
 
@@ -0,0 +1,324 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_impl_sim.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi模块模拟后端（不依赖wpa_supplicant，用于压测与无网卡环境）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 与wifi_impl.c实现相同的接口，由CMake选项BUILD_BENCHMARKS链接进模拟服务器。
+ * 行为通过环境变量配置：
+ * - WIFI_SIM_NETWORKS：扫描结果中的网络数量（默认32）
+ * - WIFI_SIM_LATENCY_MS：单次wpa_cli往返的模拟耗时（默认20），
+ *   扫描/连接按真实实现中的调用次数放大
+ */
+#include "wifi_impl.h"
+#include "../../../metrics.h"
+#include "wifi_exec.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIFI_SIM_DEFAULT_NETWORKS 32   ///< 默认模拟网络数量
+#define WIFI_SIM_DEFAULT_LATENCY_MS 20 ///< 默认单次命令耗时(毫秒)
+#define WIFI_SIM_SCAN_FACTOR 10        ///< 重新扫描相对单次命令的耗时倍数
+#define WIFI_SIM_CONNECT_FACTOR 5      ///< 连接相对单次命令的耗时倍数
+
+/**
+ * @brief 模拟设备状态
+ */
+typedef struct
+{
+    pthread_mutex_t lock; ///< 保护以下字段
+    bool enabled;         ///< WiFi是否启用
+    char connected[128];  ///< 已连接的SSID，空串表示未连接
+    int network_count;    ///< 扫描结果中的网络数量，-1表示未读取配置
+    int latency_ms;       ///< 单次命令耗时
+} wifi_sim_state;
+
+static wifi_sim_state g_sim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .enabled = true,
+    .network_count = -1,
+};
+
+/**
+ * @brief 读取非负整数环境变量
+ *
+ * @param name 变量名
+ * @param def 未设置或无效时的默认值
+ * @return int 数值
+ */
+static int sim_env_int(const char *name, int def)
+{
+    const char *value = getenv(name);
+    if (!value || value[0] == '\0')
+    {
+        return def;
+    }
+    int v = atoi(value);
+    return v >= 0 ? v : def;
+}
+
+/**
+ * @brief 读取模拟配置（调用者持有lock）
+ */
+static void sim_load_config_locked(void)
+{
+    if (g_sim.network_count >= 0)
+    {
+        return;
+    }
+    g_sim.network_count = sim_env_int("WIFI_SIM_NETWORKS", WIFI_SIM_DEFAULT_NETWORKS);
+    g_sim.latency_ms = sim_env_int("WIFI_SIM_LATENCY_MS", WIFI_SIM_DEFAULT_LATENCY_MS);
+}
+
+/**
+ * @brief 模拟命令耗时（与真实实现一样可被取消、受请求期限约束）
+ *
+ * @param factor 相对单次命令的倍数
+ * @return bool 等满返回true，期间操作被取消或到达请求期限返回false
+ */
+static bool sim_delay(int factor)
+{
+    pthread_mutex_lock(&g_sim.lock);
+    sim_load_config_locked();
+    int ms = g_sim.latency_ms * factor;
+    pthread_mutex_unlock(&g_sim.lock);
+
+    return wifi_exec_sleep_ms(ms);
+}
+
+/**
+ * @brief 启用或禁用Wi-Fi功能
+ *
+ * @param is_enable true启用，false禁用
+ * @return wifi_error_t 错误码
+ */
+wifi_error_t wifi_impl_enable(bool is_enable)
+{
+    sim_delay(1);
+    pthread_mutex_lock(&g_sim.lock);
+    g_sim.enabled = is_enable;
+    if (!is_enable)
+    {
+        g_sim.connected[0] = '\0';
+    }
+    pthread_mutex_unlock(&g_sim.lock);
+    return WIFI_ERR_OK;
+}
+
+/**
+ * @brief 执行WiFi扫描操作（生成固定的模拟网络列表）
+ *
+ * @param rescan 是否强制重新扫描
+ * @param result 扫描结果（由函数分配内存，调用者需要释放）
+ * @return wifi_error_t 错误码
+ */
+wifi_error_t wifi_impl_scan(bool rescan, wifi_scan_result *result)
+{
+    result->networks = NULL;
+    result->network_count = 0;
+    if (!sim_delay(rescan ? WIFI_SIM_SCAN_FACTOR : 2))
+    {
+        return wifi_exec_cancelled() ? WIFI_ERR_CANCELLED : WIFI_ERR_TIMEOUT;
+    }
+
+    pthread_mutex_lock(&g_sim.lock);
+    bool enabled = g_sim.enabled;
+    int count = g_sim.network_count;
+    pthread_mutex_unlock(&g_sim.lock);
+    if (!enabled)
+    {
+        return WIFI_ERR_WIFI_DISABLED;
+    }
+    if (count == 0)
+    {
+        return WIFI_ERR_OK;
+    }
+
+    wifi_network_info *networks =
+        metrics_calloc(METRICS_MODULE_WIFI, (size_t)count, sizeof(wifi_network_info));
+    if (!networks)
+    {
+        return WIFI_ERR_INTERNAL;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "sim-ap-%04d", i);
+        networks[i].ssid = metrics_strdup(METRICS_MODULE_WIFI, buf);
+        snprintf(buf, sizeof(buf), "02:00:00:%02x:%02x:%02x", (i >> 16) & 0xff, (i >> 8) & 0xff,
+                 i & 0xff);
+        networks[i].bssid = metrics_strdup(METRICS_MODULE_WIFI, buf);
+        networks[i].security =
+            metrics_strdup(METRICS_MODULE_WIFI, i % 4 == 0 ? "Open" : "[WPA2-PSK-CCMP][ESS]");
+        networks[i].signal = -30 - (i % 60);
+        networks[i].frequency_mhz = (i % 2 == 0) ? 2412 + 5 * (i % 13) : 5180 + 20 * (i % 8);
+        networks[i].channel = (networks[i].frequency_mhz < 5000)
+                                  ? (networks[i].frequency_mhz - 2407) / 5
+                                  : (networks[i].frequency_mhz - 5000) / 5;
+        networks[i].recorded = (i == 0);
+    }
+    result->networks = networks;
+    result->network_count = (size_t)count;
+    return WIFI_ERR_OK;
+}
+
+/**
+ * @brief 释放扫描结果内存
+ *
+ * @param result 扫描结果指针
+ */
+void wifi_impl_scan_result_free(wifi_scan_result *result)
+{
+    if (!result || !result->networks)
+    {
+        return;
+    }
+    for (size_t i = 0; i < result->network_count; i++)
+    {
+        metrics_free(result->networks[i].ssid);
+        metrics_free(result->networks[i].bssid);
+        metrics_free(result->networks[i].security);
+    }
+    metrics_free(result->networks);
+    result->networks = NULL;
+    result->network_count = 0;
+}
+
+/**
+ * @brief 获取WiFi连接状态
+ *
+ * @param status 状态信息（由函数分配部分字段，调用者需调用wifi_impl_status_free释放）
+ * @return wifi_error_t 错误码
+ */
+wifi_error_t wifi_impl_get_status(wifi_status_info *status)
+{
+    memset(status, 0, sizeof(*status));
+    status->interface = WIFI_DEVICE;
+    sim_delay(1);
+
+    pthread_mutex_lock(&g_sim.lock);
+    status->enable = g_sim.enabled;
+    status->connected = (g_sim.connected[0] != '\0');
+    if (status->connected)
+    {
+        status->ssid = metrics_strdup(METRICS_MODULE_WIFI, g_sim.connected);
+        status->bssid = metrics_strdup(METRICS_MODULE_WIFI, "02:00:00:00:00:00");
+        status->ip = metrics_strdup(METRICS_MODULE_WIFI, "192.168.100.2");
+        status->security = metrics_strdup(METRICS_MODULE_WIFI, "WPA2-PSK");
+        status->signal = -42;
+        status->channel = 1;
+        status->frequency_mhz = 2412;
+    }
+    pthread_mutex_unlock(&g_sim.lock);
+    return WIFI_ERR_OK;
+}
+
+/**
+ * @brief 释放状态信息内存
+ *
+ * @param status 状态信息指针
+ */
+void wifi_impl_status_free(wifi_status_info *status)
+{
+    if (!status)
+    {
+        return;
+    }
+
+    metrics_free(status->ssid);
+    metrics_free(status->bssid);
+    metrics_free(status->ip);
+    metrics_free(status->security);
+
+    status->ssid = NULL;
+    status->bssid = NULL;
+    status->ip = NULL;
+    status->security = NULL;
+}
+
+/**
+ * @brief 连接WiFi网络（SSID以sim-ap-开头的网络视为存在）
+ *
+ * @param ssid 网络SSID
+ * @param password 密码（可为NULL或空）
+ * @param timeout_ms 超时毫秒数（未使用）
+ * @return wifi_error_t 错误码
+ */
+wifi_error_t wifi_impl_connect(const char *ssid, const char *password, int timeout_ms)
+{
+    (void)password;
+    (void)timeout_ms;
+    if (!ssid)
+    {
+        return WIFI_ERR_BAD_REQUEST;
+    }
+    if (!sim_delay(WIFI_SIM_CONNECT_FACTOR))
+    {
+        return wifi_exec_cancelled() ? WIFI_ERR_CANCELLED : WIFI_ERR_TIMEOUT;
+    }
+
+    if (strncmp(ssid, "sim-ap-", 7) != 0)
+    {
+        return WIFI_ERR_NETWORK_NOT_FOUND;
+    }
+    pthread_mutex_lock(&g_sim.lock);
+    wifi_error_t err = WIFI_ERR_OK;
+    if (!g_sim.enabled)
+    {
+        err = WIFI_ERR_WIFI_DISABLED;
+    }
+    else
+    {
+        snprintf(g_sim.connected, sizeof(g_sim.connected), "%s", ssid);
+    }
+    pthread_mutex_unlock(&g_sim.lock);
+    return err;
+}
+
+/**
+ * @brief 断开WiFi连接
+ *
+ * @param ssid 要断开的SSID（NULL表示断开当前连接）
+ * @return wifi_error_t 错误码
+ */
+wifi_error_t wifi_impl_disconnect(const char *ssid)
+{
+    sim_delay(1);
+    pthread_mutex_lock(&g_sim.lock);
+    wifi_error_t err = WIFI_ERR_OK;
+    if (g_sim.connected[0] == '\0')
+    {
+        err = WIFI_ERR_NOT_CONNECTED;
+    }
+    else if (ssid && ssid[0] != '\0' && strcmp(ssid, g_sim.connected) != 0)
+    {
+        err = WIFI_ERR_BAD_REQUEST;
+    }
+    else
+    {
+        g_sim.connected[0] = '\0';
+    }
+    pthread_mutex_unlock(&g_sim.lock);
+    return err;
+}
@@ -0,0 +1,250 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_parse.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief wpa_cli输出解析
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "wifi_parse.h"
+#include "../../../metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 解码UTF-8转义序列（如\\xE4\\xBD\\xA0）
+ *
+ * @param input 输入字符串
+ * @param output 输出缓冲区
+ * @param output_size 输出缓冲区大小
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_parse_decode_utf8_escape(const char *input, char *output, size_t output_size)
+{
+    if (!input || !output || output_size == 0)
+    {
+        return -1;
+    }
+
+    const char *src = input;
+    char *dst = output;
+    size_t dst_len = 0;
+
+    while (*src && dst_len < output_size - 1)
+    {
+        if (*src == '\\' && *(src + 1) == 'x' && src + 3 < input + strlen(input))
+        {
+            char hex_str[3] = {src[2], src[3], '\0'};
+            char *endptr;
+            unsigned long hex_val = strtoul(hex_str, &endptr, 16);
+
+            if (*endptr == '\0' && hex_val <= 0xFF)
+            {
+                *dst++ = (char)hex_val;
+                dst_len++;
+                src += 4;
+            }
+            else
+            {
+                *dst++ = *src++;
+                dst_len++;
+            }
+        }
+        else
+        {
+            *dst++ = *src++;
+            dst_len++;
+        }
+    }
+
+    *dst = '\0';
+    return 0;
+}
+
+/**
+ * @brief 由频率换算信道
+ *
+ * @param freq 频率(MHz)
+ * @return int 信道，无法识别时返回0
+ */
+static int wifi_parse_channel(int freq)
+{
+    if (freq >= 2412 && freq <= 2484)
+    {
+        return (freq - 2407) / 5;
+    }
+    if (freq >= 5035 && freq <= 5895)
+    {
+        return (freq - 5000) / 5;
+    }
+    return 0;
+}
+
+/**
+ * @brief 解析scan_results的一行
+ *
+ * @param line 行文本（会被修改）
+ * @param network 解析结果
+ * @return int 成功返回0，行格式不完整返回-1
+ */
+int wifi_parse_scan_line(char *line, wifi_network_info *network)
+{
+    char *save = NULL;
+    char ssid[128];
+
+    char *bssid = strtok_r(line, "\t", &save);
+    char *frequency = bssid ? strtok_r(NULL, "\t", &save) : NULL;
+    char *signal = frequency ? strtok_r(NULL, "\t", &save) : NULL;
+    char *security = signal ? strtok_r(NULL, "\t", &save) : NULL;
+    if (!security)
+    {
+        return -1;
+    }
+
+    char *token = strtok_r(NULL, "\t", &save);
+    if (token)
+    {
+        token[strcspn(token, "\n")] = 0;
+
+        char decoded_ssid[128];
+        if (wifi_parse_decode_utf8_escape(token, decoded_ssid, sizeof(decoded_ssid)) == 0)
+        {
+            snprintf(ssid, sizeof(ssid), "%s", decoded_ssid);
+        }
+        else
+        {
+            snprintf(ssid, sizeof(ssid), "%s", token);
+        }
+    }
+    else
+    {
+        ssid[0] = '\0';
+    }
+
+    int freq = atoi(frequency);
+    network->frequency_mhz = freq;
+    network->bssid = metrics_strndup(METRICS_MODULE_WIFI, bssid, 31);
+    network->signal = atoi(signal);
+    network->ssid = metrics_strdup(METRICS_MODULE_WIFI, ssid[0] ? ssid : "\\x00");
+    network->security = metrics_strndup(METRICS_MODULE_WIFI, security[0] ? security : "Open", 127);
+
+    network->channel = wifi_parse_channel(freq);
+    network->recorded = false;
+    return 0;
+}
+
+/**
+ * @brief 解析list_networks的一行（network id\\tssid\\tbssid\\tflags）
+ *
+ * @param line 行文本（会被修改）
+ * @param id 输出网络ID
+ * @param ssid 输出解码后的SSID
+ * @param ssid_size ssid缓冲区大小
+ * @return int 成功返回0，行格式不完整（如表头）返回-1
+ */
+int wifi_parse_network_line(char *line, int *id, char *ssid, size_t ssid_size)
+{
+    char *save = NULL;
+    char *id_token = strtok_r(line, "\t", &save);
+    char *ssid_token = id_token ? strtok_r(NULL, "\t", &save) : NULL;
+    if (!ssid_token)
+    {
+        return -1;
+    }
+    char *end = NULL;
+    long value = strtol(id_token, &end, 10);
+    if (end == id_token || *end != '\0' || value < 0)
+    {
+        return -1;
+    }
+    ssid_token[strcspn(ssid_token, "\n")] = 0;
+    if (wifi_parse_decode_utf8_escape(ssid_token, ssid, ssid_size) != 0)
+    {
+        snprintf(ssid, ssid_size, "%s", ssid_token);
+    }
+    *id = (int)value;
+    return 0;
+}
+
+/**
+ * @brief 复制字段值（已有值时保留第一次出现的值）
+ *
+ * @param field 字段
+ * @param value 值
+ */
+static void wifi_parse_set_field(char **field, const char *value)
+{
+    if (!*field)
+    {
+        *field = metrics_strdup(METRICS_MODULE_WIFI, value);
+    }
+}
+
+/**
+ * @brief 一次解析wpa_cli status的完整输出（key=value，每行一项）
+ *
+ * @param text 输出文本（会被修改）
+ * @param status 解析结果，ssid/bssid/security由函数分配，调用者负责释放；
+ *               未出现的字段保持不变
+ */
+void wifi_parse_status(char *text, wifi_status_info *status)
+{
+    char *save = NULL;
+    for (char *line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+    {
+        char *value = strchr(line, '=');
+        if (!value)
+        {
+            continue;
+        }
+        *value++ = '\0';
+
+        if (strcmp(line, "wpa_state") == 0)
+        {
+            status->connected = strcmp(value, "COMPLETED") == 0;
+            status->enable = status->connected || strcmp(value, "ASSOCIATED") == 0 ||
+                             strcmp(value, "ASSOCIATING") == 0 || strcmp(value, "SCANNING") == 0;
+        }
+        else if (strcmp(line, "ssid") == 0)
+        {
+            char decoded[128];
+            if (wifi_parse_decode_utf8_escape(value, decoded, sizeof(decoded)) == 0)
+            {
+                value = decoded;
+            }
+            wifi_parse_set_field(&status->ssid, value);
+        }
+        else if (strcmp(line, "bssid") == 0)
+        {
+            wifi_parse_set_field(&status->bssid, value);
+        }
+        else if (strcmp(line, "key_mgmt") == 0)
+        {
+            wifi_parse_set_field(&status->security, value);
+        }
+        else if (strcmp(line, "freq") == 0)
+        {
+            status->frequency_mhz = atoi(value);
+            status->channel = wifi_parse_channel(status->frequency_mhz);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_parse.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief wpa_cli输出解析函数声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef WIFI_PARSE_H
+#define WIFI_PARSE_H
+
+#include "../wifi_def.h"
+#include <stddef.h>
+
+/**
+ * @brief 解码UTF-8转义序列（如\\xE4\\xBD\\xA0）
+ *
+ * @param input 输入字符串
+ * @param output 输出缓冲区
+ * @param output_size 输出缓冲区大小
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_parse_decode_utf8_escape(const char *input, char *output, size_t output_size);
+
+/**
+ * @brief 解析scan_results的一行（bssid\\tfrequency\\tsignal\\tflags\\tssid）
+ *
+ * @param line 行文本（会被修改）
+ * @param network 解析结果，成功时ssid/bssid/security由函数分配，调用者负责释放
+ * @return int 成功返回0，行格式不完整返回-1
+ */
+int wifi_parse_scan_line(char *line, wifi_network_info *network);
+
+/**
+ * @brief 解析list_networks的一行（network id\\tssid\\tbssid\\tflags）
+ *
+ * @param line 行文本（会被修改）
+ * @param id 输出网络ID
+ * @param ssid 输出解码后的SSID
+ * @param ssid_size ssid缓冲区大小
+ * @return int 成功返回0，行格式不完整（如表头）返回-1
+ */
+int wifi_parse_network_line(char *line, int *id, char *ssid, size_t ssid_size);
+
+/**
+ * @brief 一次解析wpa_cli status的完整输出（key=value，每行一项）
+ *
+ * @param text 输出文本（会被修改）
+ * @param status 解析结果，ssid/bssid/security由函数分配，调用者负责释放；
+ *               未出现的字段保持不变
+ */
+void wifi_parse_status(char *text, wifi_status_info *status);
+
+#endif
@@ -24,6 +24,8 @@ limitations under the License.
  *
  */
 #include "wifi_connect.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include "../impl/wifi_impl.h"
 #include <string.h>
 
@@ -42,6 +44,9 @@ wifi_connect_resp_t wifi_connect(const wifi_connect_req_t *req)
         return resp;
     }
     const char *password = (strlen(req->password) > 0) ? req->password : NULL;
+    int64_t backend_start = qos_now_us();
     resp.error = wifi_impl_connect(req->ssid, password, req->timeout_ms);
+    metrics_observe_backend(METRICS_BACKEND_WIFI_CONNECT, qos_now_us() - backend_start,
+                            resp.error == WIFI_ERR_OK);
     return resp;
 }
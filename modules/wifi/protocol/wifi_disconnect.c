@@ -24,6 +24,8 @@ limitations under the License.
  *
  */
 #include "wifi_disconnect.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include "../impl/wifi_impl.h"
 
 /**
@@ -36,6 +38,9 @@ wifi_disconnect_resp_t wifi_disconnect(const wifi_disconnect_req_t *req)
 {
     wifi_disconnect_resp_t resp = {0};
     const char *ssid = (req && req->has_ssid) ? req->ssid : NULL;
+    int64_t backend_start = qos_now_us();
     resp.error = wifi_impl_disconnect(ssid);
+    metrics_observe_backend(METRICS_BACKEND_WIFI_DISCONNECT, qos_now_us() - backend_start,
+                            resp.error == WIFI_ERR_OK);
     return resp;
 }
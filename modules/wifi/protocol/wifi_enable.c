@@ -24,6 +24,8 @@ limitations under the License.
  *
  */
 #include "wifi_enable.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include "../impl/wifi_impl.h"
 
 /**
@@ -40,7 +42,10 @@ wifi_enable_resp_t wifi_enable(const wifi_enable_req_t *req)
         resp.error = WIFI_ERR_BAD_REQUEST;
         return resp;
     }
+    int64_t backend_start = qos_now_us();
     resp.error = wifi_impl_enable(req->enable);
+    metrics_observe_backend(METRICS_BACKEND_WIFI_ENABLE, qos_now_us() - backend_start,
+                            resp.error == WIFI_ERR_OK);
     if (resp.error == WIFI_ERR_OK)
     {
         resp.enable = req->enable;
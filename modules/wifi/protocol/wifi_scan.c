@@ -24,6 +24,8 @@ limitations under the License.
  *
  */
 #include "wifi_scan.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include "../impl/wifi_impl.h"
 
 /**
@@ -35,6 +37,9 @@ limitations under the License.
 wifi_scan_resp_t wifi_scan(const wifi_scan_req_t *req)
 {
     wifi_scan_resp_t resp = {0};
+    int64_t backend_start = qos_now_us();
     resp.error = wifi_impl_scan(req ? req->rescan : false, &resp.result);
+    metrics_observe_backend(METRICS_BACKEND_WIFI_SCAN, qos_now_us() - backend_start,
+                            resp.error == WIFI_ERR_OK);
     return resp;
 }
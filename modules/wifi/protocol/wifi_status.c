@@ -24,16 +24,23 @@ limitations under the License.
  *
  */
 #include "wifi_status.h"
+#include "../../../metrics.h"
+#include "../../../qos.h"
 #include "../impl/wifi_impl.h"
 
 /**
  * @brief 处理查询WiFi状态请求
  *
+ * 每次调用都查询后端；请求路径经状态存储读取，只在记录过期时调用本函数。
+ *
  * @return wifi_status_resp_t 状态响应结构体
  */
 wifi_status_resp_t wifi_status(void)
 {
     wifi_status_resp_t resp = {0};
+    int64_t backend_start = qos_now_us();
     resp.error = wifi_impl_get_status(&resp.status);
+    metrics_observe_backend(METRICS_BACKEND_WIFI_STATUS, qos_now_us() - backend_start,
+                            resp.error == WIFI_ERR_OK);
     return resp;
 }
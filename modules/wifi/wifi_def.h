@@ -52,7 +52,8 @@ typedef enum
     WIFI_ERR_TOOL_ERROR = 14,       ///< 底层工具错误（nmcli/wpa_cli）
     WIFI_ERR_CONFIG_ERROR = 15,     ///< 配置存储/读取失败
     WIFI_ERR_IO_ERROR = 16,         ///< I/O异常
-    WIFI_ERR_NOT_CONNECTED = 17     ///< 未连接
+    WIFI_ERR_NOT_CONNECTED = 17,    ///< 未连接
+    WIFI_ERR_CANCELLED = 18         ///< 操作已被取消（cancel_request或连接关闭）
 } wifi_error_t;
 
 /* ---- 数据结构体（供 impl 和 protocol 共用） ---- */
@@ -0,0 +1,643 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file wifi_queue.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi设备命令队列实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "wifi_queue.h"
+#include "../../metrics.h"
+#include "../../protocol/protocol_utils.h"
+#include "../../qos.h"
+#include "impl/wifi_exec.h"
+#include "impl/wifi_impl.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief 队列任务
+ */
+typedef struct wifi_queue_job
+{
+    struct wifi_queue_job *next; ///< 同优先级链表中的下一个任务
+    struct mg_connection *conn;  ///< 发起请求的连接，NULL表示连接已关闭
+    const char *request_type;    ///< 请求类型（指向调度表中的常量字符串）
+    const char *response_type;   ///< 响应类型（指向调度表中的常量字符串）
+    char *request_id;            ///< 请求ID副本
+    cJSON *data;                 ///< 请求数据副本
+    wifi_queue_exec_fn exec;     ///< 执行函数
+    int64_t start_us;            ///< 收到请求的时间
+    int64_t deadline_us;         ///< 请求期限，0表示没有
+    int64_t enqueue_us;          ///< 入队时间
+    qos_class_t qos;             ///< 延迟统计使用的服务等级
+    metrics_trace trace;         ///< 提交线程移交的请求追踪
+    bool cancelled;              ///< 执行中被取消（__atomic访问，执行线程协作检查）
+    bool announcing;             ///< 提交线程正在发送排队事件，发完前不得执行（lock保护）
+} wifi_queue_job;
+
+/**
+ * @brief 单个WiFi设备的命令队列
+ */
+typedef struct
+{
+    const char *device;    ///< 设备名
+    bool reads;            ///< 只读通道：不区分优先级，不发送排队事件
+    size_t max_pending;    ///< 允许排队的最大任务数
+    qos_class_t qos;       ///< 工作线程与任务延迟统计的服务等级
+    metrics_queue_t gauge; ///< 排队深度指标
+
+    pthread_mutex_t lock;                        ///< 保护队列与任务的连接指针
+    pthread_cond_t cond;                         ///< 有新任务或需要退出
+    pthread_cond_t sent;                         ///< 完成一次响应或排队事件的发送
+    pthread_t thread;                            ///< 工作线程
+    bool started;                                ///< 工作线程是否已启动
+    bool stop;                                   ///< 是否请求退出
+    wifi_queue_job *head[WIFI_QUEUE_PRIO_COUNT]; ///< 各优先级队首
+    wifi_queue_job *tail[WIFI_QUEUE_PRIO_COUNT]; ///< 各优先级队尾
+    size_t pending;                              ///< 排队中的任务数
+    wifi_queue_job *running;                     ///< 正在执行的任务
+    const struct mg_connection *sending;         ///< 工作线程正在（不持锁）写入的连接
+} wifi_device_queue;
+
+/**
+ * 每个设备两个通道：写操作在命令通道按优先级串行执行；只读请求的后端刷新在读通道执行，
+ * 不占用WebSocket工作线程，也不排在耗时的写操作之后。
+ */
+static wifi_device_queue g_wifi_queues[] = {
+    {.device = WIFI_DEVICE,
+     .max_pending = WIFI_QUEUE_MAX_PENDING,
+     .qos = QOS_CLASS_BACKGROUND,
+     .gauge = METRICS_QUEUE_WIFI_COMMANDS},
+    {.device = WIFI_DEVICE,
+     .reads = true,
+     .max_pending = WIFI_QUEUE_MAX_READS,
+     .qos = QOS_CLASS_NORMAL,
+     .gauge = METRICS_QUEUE_WIFI_READS},
+};
+#define WIFI_QUEUE_COUNT (sizeof(g_wifi_queues) / sizeof(g_wifi_queues[0]))
+
+/**
+ * @brief 按设备名查找队列
+ *
+ * @param device 设备名，NULL表示默认设备
+ * @param reads 是否查找只读通道
+ * @return wifi_device_queue* 找不到返回NULL
+ */
+static wifi_device_queue *wifi_queue_find(const char *device, bool reads)
+{
+    for (size_t i = 0; i < WIFI_QUEUE_COUNT; i++)
+    {
+        if (g_wifi_queues[i].reads == reads &&
+            (!device || strcmp(g_wifi_queues[i].device, device) == 0))
+        {
+            return &g_wifi_queues[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 释放任务
+ *
+ * @param job 任务指针
+ */
+static void wifi_queue_job_free(wifi_queue_job *job)
+{
+    if (!job)
+    {
+        return;
+    }
+    metrics_free(job->request_id);
+    cJSON_Delete(job->data);
+    metrics_free(job);
+}
+
+/**
+ * @brief 取出优先级最高的任务（调用者持有lock）
+ *
+ * @param q 设备队列
+ * @return wifi_queue_job* 无任务返回NULL
+ */
+static wifi_queue_job *wifi_queue_pop(wifi_device_queue *q)
+{
+    for (int p = 0; p < WIFI_QUEUE_PRIO_COUNT; p++)
+    {
+        wifi_queue_job *job = q->head[p];
+        if (job)
+        {
+            q->head[p] = job->next;
+            if (!q->head[p])
+            {
+                q->tail[p] = NULL;
+            }
+            job->next = NULL;
+            q->pending--;
+            metrics_set_queue_depth(q->gauge, (int64_t)q->pending);
+            return job;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 从队列中摘下指定任务（调用者持有lock）
+ *
+ * @param q 设备队列
+ * @param prio 任务所在优先级
+ * @param prev 前一个任务，NULL表示任务位于队首
+ * @param job 任务
+ */
+static void wifi_queue_unlink(wifi_device_queue *q, int prio, wifi_queue_job *prev,
+                              wifi_queue_job *job)
+{
+    if (prev)
+    {
+        prev->next = job->next;
+    }
+    else
+    {
+        q->head[prio] = job->next;
+    }
+    if (q->tail[prio] == job)
+    {
+        q->tail[prio] = prev;
+    }
+    job->next = NULL;
+    q->pending--;
+    metrics_set_queue_depth(q->gauge, (int64_t)q->pending);
+}
+
+/**
+ * @brief 结束尚未执行就被取消的任务：回复WIFI_ERR_CANCELLED并释放
+ *
+ * 在释放队列锁之后调用，写入连接期间不阻塞其他连接的提交与取消。
+ *
+ * @param job 已从队列摘下的任务
+ */
+static void wifi_queue_finish_cancelled(wifi_queue_job *job)
+{
+    // 借用任务的追踪完成统计，之后恢复当前线程自己的追踪
+    metrics_trace saved;
+    metrics_trace_capture(&saved);
+    metrics_trace_resume(&job->trace);
+    if (job->conn)
+    {
+        protocol_send_standard_response(job->conn, job->response_type, job->request_id, false,
+                                        WIFI_ERR_CANCELLED);
+    }
+    metrics_count_error(METRICS_MODULE_WIFI, WIFI_ERR_CANCELLED);
+    qos_record(job->qos, job->request_type, job->start_us);
+    metrics_trace_resume(&saved);
+    wifi_queue_job_free(job);
+}
+
+/**
+ * @brief 结束一串被取消的任务
+ *
+ * @param job 链表头（经next串联）
+ */
+static void wifi_queue_finish_list(wifi_queue_job *job)
+{
+    while (job)
+    {
+        wifi_queue_job *next = job->next;
+        job->next = NULL;
+        wifi_queue_finish_cancelled(job);
+        job = next;
+    }
+}
+
+/**
+ * @brief 设备队列工作线程
+ *
+ * @param arg 设备队列
+ * @return void* 始终为NULL
+ */
+static void *wifi_queue_worker(void *arg)
+{
+    wifi_device_queue *q = (wifi_device_queue *)arg;
+
+    // 命令通道按后台类降低调度优先级，避免与交互类请求争抢CPU
+    qos_apply_thread_class(q->qos);
+
+    pthread_mutex_lock(&q->lock);
+    while (!q->stop)
+    {
+        wifi_queue_job *job = wifi_queue_pop(q);
+        if (!job)
+        {
+            pthread_cond_wait(&q->cond, &q->lock);
+            continue;
+        }
+        q->running = job;
+        // 排队事件须先于最终响应到达客户端，等提交线程发完再执行
+        while (job->announcing)
+        {
+            pthread_cond_wait(&q->sent, &q->lock);
+        }
+        pthread_mutex_unlock(&q->lock);
+        metrics_trace_resume(&job->trace);
+        metrics_observe_stage(METRICS_STAGE_QUEUE_WAIT, qos_now_us() - job->enqueue_us);
+
+        cJSON *response;
+        if (protocol_deadline_expired(job->deadline_us))
+        {
+            // 排队期间已超过请求期限：不再访问wpa_supplicant
+            response = protocol_create_response(job->response_type, job->request_id, false,
+                                                WIFI_ERR_TIMEOUT);
+        }
+        else
+        {
+            wifi_exec_bind_cancel(&job->cancelled);
+            wifi_exec_bind_deadline(job->deadline_us);
+            response = job->exec(job->response_type, job->request_id, job->data);
+            wifi_exec_bind_deadline(0);
+            wifi_exec_bind_cancel(NULL);
+        }
+
+        // 发送时不持有队列锁，慢连接不会阻塞其他连接的提交与取消；
+        // 该连接的关闭处理器等待sending清空后才返回，保证之后不再向它写入
+        pthread_mutex_lock(&q->lock);
+        q->running = NULL;
+        struct mg_connection *conn = response ? job->conn : NULL;
+        q->sending = conn;
+        pthread_mutex_unlock(&q->lock);
+
+        if (conn)
+        {
+            protocol_send_response(conn, response);
+        }
+        metrics_count_response(METRICS_MODULE_WIFI, response);
+        qos_record(job->qos, job->request_type, job->start_us);
+        cJSON_Delete(response);
+        wifi_queue_job_free(job);
+
+        pthread_mutex_lock(&q->lock);
+        if (q->sending)
+        {
+            q->sending = NULL;
+            pthread_cond_broadcast(&q->sent);
+        }
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+/**
+ * @brief 初始化所有WiFi设备的命令队列并启动工作线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_queue_init(void)
+{
+    for (size_t i = 0; i < WIFI_QUEUE_COUNT; i++)
+    {
+        wifi_device_queue *q = &g_wifi_queues[i];
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->cond, NULL);
+        pthread_cond_init(&q->sent, NULL);
+        q->stop = false;
+
+        if (pthread_create(&q->thread, NULL, wifi_queue_worker, q) != 0)
+        {
+            fprintf(stderr, "wifi_queue_init: 无法为 %s 创建%s工作线程\n", q->device,
+                    q->reads ? "读通道" : "命令通道");
+            wifi_queue_deinit();
+            return -1;
+        }
+        q->started = true;
+    }
+    return 0;
+}
+
+/**
+ * @brief 停止工作线程并丢弃未执行的任务
+ */
+void wifi_queue_deinit(void)
+{
+    for (size_t i = 0; i < WIFI_QUEUE_COUNT; i++)
+    {
+        wifi_device_queue *q = &g_wifi_queues[i];
+        if (!q->started)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&q->lock);
+        q->stop = true;
+        pthread_cond_broadcast(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+        pthread_join(q->thread, NULL);
+        q->started = false;
+
+        wifi_queue_job *job;
+        while ((job = wifi_queue_pop(q)) != NULL)
+        {
+            wifi_queue_job_free(job);
+        }
+    }
+}
+
+/**
+ * @brief 创建任务并加入队列
+ *
+ * @param q 设备队列
+ * @param prio 优先级
+ * @param conn 发起请求的连接
+ * @param request_type 请求类型
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（内部复制，可为NULL）
+ * @param exec 执行函数
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限，0表示没有
+ * @return wifi_error_t WIFI_ERR_OK表示已入队
+ */
+static wifi_error_t wifi_queue_enqueue(wifi_device_queue *q, wifi_queue_prio_t prio,
+                                       struct mg_connection *conn, const char *request_type,
+                                       const char *response_type, const char *request_id,
+                                       cJSON *data, wifi_queue_exec_fn exec, int64_t start_us,
+                                       int64_t deadline_us)
+{
+    if (!q || !q->started)
+    {
+        return WIFI_ERR_INTERFACE_DOWN;
+    }
+    if (prio < 0 || prio >= WIFI_QUEUE_PRIO_COUNT || !exec)
+    {
+        return WIFI_ERR_INTERNAL;
+    }
+
+    wifi_queue_job *job =
+        (wifi_queue_job *)metrics_calloc(METRICS_MODULE_WIFI, 1, sizeof(wifi_queue_job));
+    if (!job)
+    {
+        return WIFI_ERR_INTERNAL;
+    }
+    job->conn = conn;
+    job->request_type = request_type;
+    job->response_type = response_type;
+    job->request_id = metrics_strdup(METRICS_MODULE_WIFI, request_id ? request_id : "");
+    job->data = data ? cJSON_Duplicate(data, 1) : NULL;
+    job->exec = exec;
+    job->start_us = start_us;
+    job->deadline_us = deadline_us;
+    job->qos = q->qos;
+    metrics_trace_capture(&job->trace);
+    if (!job->request_id || (data && !job->data))
+    {
+        wifi_queue_job_free(job);
+        return WIFI_ERR_INTERNAL;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    if (q->pending >= q->max_pending)
+    {
+        pthread_mutex_unlock(&q->lock);
+        wifi_queue_job_free(job);
+        return WIFI_ERR_BUSY;
+    }
+
+    // 排在前面的任务数：正在执行的任务 + 优先级不低于本任务的排队任务
+    size_t position = q->running ? 1 : 0;
+    for (int p = 0; p <= (int)prio; p++)
+    {
+        for (wifi_queue_job *it = q->head[p]; it; it = it->next)
+        {
+            position++;
+        }
+    }
+
+    if (q->tail[prio])
+    {
+        q->tail[prio]->next = job;
+    }
+    else
+    {
+        q->head[prio] = job;
+    }
+    q->tail[prio] = job;
+    q->pending++;
+    size_t pending = q->pending;
+    job->enqueue_us = qos_now_us();
+    bool announce = position > 0 && !q->reads;
+    job->announcing = announce;
+    metrics_set_queue_depth(q->gauge, (int64_t)pending);
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    // 不持锁发送排队事件；工作线程取到该任务后等待announcing清除，响应不会先于事件发出。
+    // 同一连接的取消与关闭处理都在本线程执行，发送期间任务不会被摘下释放
+    if (announce)
+    {
+        cJSON *event = cJSON_CreateObject();
+        if (event)
+        {
+            cJSON_AddStringToObject(event, "type", "wifi_queue_event");
+            cJSON *event_data = cJSON_AddObjectToObject(event, "data");
+            if (event_data)
+            {
+                cJSON_AddStringToObject(event_data, "request_id", request_id ? request_id : "");
+                cJSON_AddStringToObject(event_data, "device", q->device);
+                cJSON_AddNumberToObject(event_data, "position", (double)position);
+                cJSON_AddNumberToObject(event_data, "pending", (double)pending);
+            }
+            protocol_send_response(conn, event);
+            cJSON_Delete(event);
+        }
+        pthread_mutex_lock(&q->lock);
+        job->announcing = false;
+        pthread_cond_broadcast(&q->sent);
+        pthread_mutex_unlock(&q->lock);
+    }
+    return WIFI_ERR_OK;
+}
+
+/**
+ * @brief 提交写操作到设备命令队列
+ *
+ * @param device 设备名（如wlan0）
+ * @param prio 优先级
+ * @param conn 发起请求的连接
+ * @param request_type 请求类型
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（内部复制，可为NULL）
+ * @param exec 执行函数
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限，0表示没有
+ * @return wifi_error_t WIFI_ERR_OK表示已入队
+ */
+wifi_error_t wifi_queue_submit(const char *device, wifi_queue_prio_t prio,
+                               struct mg_connection *conn, const char *request_type,
+                               const char *response_type, const char *request_id, cJSON *data,
+                               wifi_queue_exec_fn exec, int64_t start_us, int64_t deadline_us)
+{
+    return wifi_queue_enqueue(wifi_queue_find(device, false), prio, conn, request_type,
+                              response_type, request_id, data, exec, start_us, deadline_us);
+}
+
+/**
+ * @brief 提交只读请求到设备读通道
+ *
+ * @param device 设备名（如wlan0）
+ * @param conn 发起请求的连接
+ * @param request_type 请求类型
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（内部复制，可为NULL）
+ * @param exec 执行函数
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限，0表示没有
+ * @return wifi_error_t WIFI_ERR_OK表示已入队
+ */
+wifi_error_t wifi_queue_submit_read(const char *device, struct mg_connection *conn,
+                                    const char *request_type, const char *response_type,
+                                    const char *request_id, cJSON *data,
+                                    wifi_queue_exec_fn exec, int64_t start_us,
+                                    int64_t deadline_us)
+{
+    return wifi_queue_enqueue(wifi_queue_find(device, true), WIFI_QUEUE_PRIO_HIGH, conn,
+                              request_type, response_type, request_id, data, exec, start_us,
+                              deadline_us);
+}
+
+/**
+ * @brief 取消连接的任务（调用者持有lock）
+ *
+ * 排队中的任务移入cancelled链表，由调用者释放锁后调用wifi_queue_finish_cancelled。
+ *
+ * @param q 设备队列
+ * @param conn 发起请求的连接
+ * @param request_id 请求ID，NULL表示该连接的全部任务
+ * @param detach 是否同时解除与连接的关联（连接正在关闭）
+ * @param cancelled 输出被移出队列的任务链表
+ * @return bool 是否找到任务
+ */
+static bool wifi_queue_cancel_locked(wifi_device_queue *q, const struct mg_connection *conn,
+                                     const char *request_id, bool detach,
+                                     wifi_queue_job **cancelled)
+{
+    bool found = false;
+    wifi_queue_job *job = q->running;
+    if (job && job->conn == conn && (!request_id || strcmp(job->request_id, request_id) == 0))
+    {
+        __atomic_store_n(&job->cancelled, true, __ATOMIC_RELEASE);
+        if (detach)
+        {
+            job->conn = NULL;
+        }
+        found = true;
+    }
+    for (int p = 0; p < WIFI_QUEUE_PRIO_COUNT; p++)
+    {
+        wifi_queue_job *prev = NULL;
+        job = q->head[p];
+        while (job)
+        {
+            wifi_queue_job *next = job->next;
+            if (job->conn == conn && (!request_id || strcmp(job->request_id, request_id) == 0))
+            {
+                wifi_queue_unlink(q, p, prev, job);
+                if (detach)
+                {
+                    job->conn = NULL;
+                }
+                job->next = *cancelled;
+                *cancelled = job;
+                found = true;
+            }
+            else
+            {
+                prev = job;
+            }
+            job = next;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief 取消连接发起的指定请求
+ *
+ * 排队中的任务立即移出队列并回复WIFI_ERR_CANCELLED；正在执行的任务被标记取消，
+ * 由后端在下一次检查时中止，其响应照常发送（被中止时错误码为WIFI_ERR_CANCELLED）。
+ *
+ * @param conn 发起请求的连接
+ * @param request_id 请求ID
+ * @return bool 是否找到该请求
+ */
+bool wifi_queue_cancel(const struct mg_connection *conn, const char *request_id)
+{
+    if (!request_id)
+    {
+        return false;
+    }
+    bool found = false;
+    for (size_t i = 0; i < WIFI_QUEUE_COUNT; i++)
+    {
+        wifi_device_queue *q = &g_wifi_queues[i];
+        if (!q->started)
+        {
+            continue;
+        }
+
+        wifi_queue_job *cancelled = NULL;
+        pthread_mutex_lock(&q->lock);
+        found = wifi_queue_cancel_locked(q, conn, request_id, false, &cancelled) || found;
+        pthread_mutex_unlock(&q->lock);
+        wifi_queue_finish_list(cancelled);
+    }
+    return found;
+}
+
+/**
+ * @brief 取消连接的全部任务并解除关联
+ *
+ * 连接关闭时调用：排队中的任务直接丢弃，正在执行的任务被标记取消，完成后不再发送响应。
+ *
+ * @param conn 正在关闭的连接
+ */
+void wifi_queue_cancel_connection(const struct mg_connection *conn)
+{
+    for (size_t i = 0; i < WIFI_QUEUE_COUNT; i++)
+    {
+        wifi_device_queue *q = &g_wifi_queues[i];
+        if (!q->started)
+        {
+            continue;
+        }
+
+        wifi_queue_job *cancelled = NULL;
+        pthread_mutex_lock(&q->lock);
+        wifi_queue_cancel_locked(q, conn, NULL, true, &cancelled);
+        // 工作线程可能正在不持锁地向该连接写入响应，等写入结束后连接才能释放
+        while (q->sending == conn)
+        {
+            pthread_cond_wait(&q->sent, &q->lock);
+        }
+        pthread_mutex_unlock(&q->lock);
+        wifi_queue_finish_list(cancelled);
+    }
+}
@@ -0,0 +1,151 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file wifi_queue.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi设备命令队列声明（写操作串行执行，只读请求的后端刷新在独立的读通道执行）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef WIFI_QUEUE_H
+#define WIFI_QUEUE_H
+
+#include "cJSON.h"
+#include "civetweb.h"
+#include "wifi_def.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef WIFI_QUEUE_MAX_PENDING
+#define WIFI_QUEUE_MAX_PENDING 8 ///< 每个设备允许排队的最大写操作数，超出返回WIFI_ERR_BUSY
+#endif
+
+#ifndef WIFI_QUEUE_MAX_READS
+#define WIFI_QUEUE_MAX_READS 32 ///< 每个设备读通道允许排队的最大只读请求数，超出返回WIFI_ERR_BUSY
+#endif
+
+/**
+ * @brief 写操作优先级（数值越小越先执行，同优先级按提交顺序执行）
+ */
+typedef enum
+{
+    WIFI_QUEUE_PRIO_NONE = -1, ///< 只读请求，不进入命令队列
+    WIFI_QUEUE_PRIO_HIGH = 0,  ///< 开关/断开等需要立即生效的操作
+    WIFI_QUEUE_PRIO_NORMAL,    ///< 连接
+    WIFI_QUEUE_PRIO_LOW,       ///< 重新扫描
+    WIFI_QUEUE_PRIO_COUNT
+} wifi_queue_prio_t;
+
+/**
+ * @brief 队列任务执行函数：执行后端操作并构造响应
+ *
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象
+ * @return cJSON* 响应JSON对象，由队列负责发送和释放
+ */
+typedef cJSON *(*wifi_queue_exec_fn)(const char *response_type, const char *request_id,
+                                     cJSON *data);
+
+/**
+ * @brief 初始化所有WiFi设备的命令队列并启动工作线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_queue_init(void);
+
+/**
+ * @brief 停止工作线程并丢弃未执行的任务
+ */
+void wifi_queue_deinit(void);
+
+/**
+ * @brief 提交写操作到设备命令队列
+ *
+ * 队列已满时直接返回WIFI_ERR_BUSY，调用者负责回复；
+ * 成功入队后由工作线程执行并发送响应，排队中的请求会先收到wifi_queue_event，再收到响应。
+ * 队列任务按后台类（QOS_CLASS_BACKGROUND）统计延迟。
+ * 轮到执行时请求期限已过的任务不再执行，直接回复WIFI_ERR_TIMEOUT。
+ *
+ * @param device 设备名（如wlan0）
+ * @param prio 优先级
+ * @param conn 发起请求的连接
+ * @param request_type 请求类型（用于延迟统计）
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（内部复制，可为NULL）
+ * @param exec 执行函数
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限（qos_now_us()时间，见protocol_get_deadline_us），0表示没有
+ * @return wifi_error_t WIFI_ERR_OK表示已入队
+ */
+wifi_error_t wifi_queue_submit(const char *device, wifi_queue_prio_t prio,
+                               struct mg_connection *conn, const char *request_type,
+                               const char *response_type, const char *request_id, cJSON *data,
+                               wifi_queue_exec_fn exec, int64_t start_us, int64_t deadline_us);
+
+/**
+ * @brief 提交只读请求到设备读通道
+ *
+ * 状态记录过期、需要访问wpa_supplicant的只读请求由读通道的工作线程执行，
+ * 不占用WebSocket工作线程；读通道与命令通道互不等待，按提交顺序执行，不发送wifi_queue_event。
+ * 队列已满时直接返回WIFI_ERR_BUSY，调用者负责回复。读通道任务按普通类（QOS_CLASS_NORMAL）
+ * 统计延迟，期限与取消的处理与命令队列相同。
+ *
+ * @param device 设备名（如wlan0）
+ * @param conn 发起请求的连接
+ * @param request_type 请求类型（用于延迟统计）
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（内部复制，可为NULL）
+ * @param exec 执行函数
+ * @param start_us 收到请求时的qos_now_us()
+ * @param deadline_us 请求期限（qos_now_us()时间，见protocol_get_deadline_us），0表示没有
+ * @return wifi_error_t WIFI_ERR_OK表示已入队
+ */
+wifi_error_t wifi_queue_submit_read(const char *device, struct mg_connection *conn,
+                                    const char *request_type, const char *response_type,
+                                    const char *request_id, cJSON *data,
+                                    wifi_queue_exec_fn exec, int64_t start_us,
+                                    int64_t deadline_us);
+
+/**
+ * @brief 取消连接发起的指定请求
+ *
+ * 排队中的任务立即移出队列并回复WIFI_ERR_CANCELLED；正在执行的任务被标记取消，
+ * 由后端在下一次检查时中止，其响应照常发送（被中止时错误码为WIFI_ERR_CANCELLED）。
+ *
+ * @param conn 发起请求的连接（只能取消自己的请求）
+ * @param request_id 请求ID
+ * @return bool 是否找到该请求
+ */
+bool wifi_queue_cancel(const struct mg_connection *conn, const char *request_id);
+
+/**
+ * @brief 取消连接的全部任务并解除关联
+ *
+ * 连接关闭时调用：排队中的任务直接丢弃，正在执行的任务被标记取消，完成后不再发送响应，
+ * 工作线程与无线电尽快让给其他连接。
+ *
+ * @param conn 正在关闭的连接
+ */
+void wifi_queue_cancel_connection(const struct mg_connection *conn);
+
+#endif
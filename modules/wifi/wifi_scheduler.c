@@ -24,7 +24,11 @@ limitations under the License.
  *
  */
 #include "wifi_scheduler.h"
+#include "../../metrics.h"
 #include "../../protocol/protocol_utils.h"
+#include "../../qos.h"
+#include "../../state_store.h"
+#include "impl/wifi_exec.h"
 #include "impl/wifi_impl.h"
 #include "protocol/wifi_connect.h"
 #include "protocol/wifi_disconnect.h"
@@ -32,9 +36,17 @@ limitations under the License.
 #include "protocol/wifi_scan.h"
 #include "protocol/wifi_status.h"
 #include "wifi_def.h"
+#include "wifi_queue.h"
+#include "wifi_snapshot.h"
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
+#define WIFI_CANCEL_REQUEST "cancel_request"         ///< 取消请求类型
+#define WIFI_CANCEL_RESPONSE "cancel_response"       ///< 取消响应类型
+#define WIFI_RESUME_REQUEST "wifi_resume_request"   ///< 会话恢复请求类型
+#define WIFI_RESUME_RESPONSE "wifi_resume_response" ///< 会话恢复响应类型
+
 /**
  * @brief WiFi请求类型与桥接函数映射
  */
@@ -42,20 +54,21 @@ typedef struct
 {
     const char *request;  ///< 请求类型字符串
     const char *response; ///< 响应类型字符串
-    void (*bridge)(struct mg_connection *conn, const char *response_type, const char *request_id,
-                   cJSON *data); ///< JSON与结构体转换桥接函数
+    cJSON *(*bridge)(const char *response_type, const char *request_id,
+                     cJSON *data); ///< JSON与结构体转换桥接函数，返回待发送的响应
+    wifi_queue_prio_t priority;    ///< 写操作优先级，WIFI_QUEUE_PRIO_NONE表示只读请求
+    qos_class_t qos;               ///< 延迟等级
 } wifi_dispatch;
 
 /**
  * @brief wifi_enable请求的桥接函数
  *
- * @param conn 连接指针
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象
+ * @return cJSON* 响应JSON对象，需调用者释放
  */
-static void bridge_wifi_enable(struct mg_connection *conn, const char *response_type,
-                               const char *request_id, cJSON *data)
+static cJSON *bridge_wifi_enable(const char *response_type, const char *request_id, cJSON *data)
 {
     wifi_enable_req_t req = {0};
     cJSON *enable_item = data ? cJSON_GetObjectItem(data, "enable") : NULL;
@@ -66,6 +79,7 @@ static void bridge_wifi_enable(struct mg_connection *conn, const char *response_
     }
 
     wifi_enable_resp_t resp = wifi_enable(&req);
+    state_store_invalidate(STATE_WIFI_STATUS);
 
     cJSON *response = protocol_create_response(response_type, request_id,
                                                (resp.error == WIFI_ERR_OK), resp.error);
@@ -76,66 +90,238 @@ static void bridge_wifi_enable(struct mg_connection *conn, const char *response_
         {
             cJSON_AddBoolToObject(res_data, "enable", resp.enable);
         }
-        protocol_send_response(conn, response);
-        cJSON_Delete(response);
     }
+    return response;
 }
 
 /**
- * @brief wifi_status请求的桥接函数
+ * @brief 将连接状态写入响应data对象
  *
- * @param conn 连接指针
- * @param response_type 响应类型
- * @param request_id 请求ID
- * @param data JSON数据对象（未使用）
+ * @param res_data data对象
+ * @param status 连接状态
  */
-static void bridge_wifi_status(struct mg_connection *conn, const char *response_type,
-                               const char *request_id, cJSON *data)
+static void wifi_status_fill(cJSON *res_data, const wifi_status_info *status)
 {
-    (void)data;
-    wifi_status_resp_t resp = wifi_status();
+    cJSON_AddBoolToObject(res_data, "enable", status->enable);
+    cJSON_AddBoolToObject(res_data, "connected", status->connected);
+    cJSON_AddStringToObject(res_data, "ssid", status->ssid ? status->ssid : "");
+    cJSON_AddStringToObject(res_data, "bssid", status->bssid ? status->bssid : "");
+    cJSON_AddStringToObject(res_data, "interface", status->interface ? status->interface : "");
+    cJSON_AddStringToObject(res_data, "ip", status->ip ? status->ip : "");
+    cJSON_AddNumberToObject(res_data, "signal", status->signal);
+    cJSON_AddStringToObject(res_data, "security", status->security ? status->security : "");
+    cJSON_AddNumberToObject(res_data, "channel", status->channel);
+    cJSON_AddNumberToObject(res_data, "frequency_mhz", status->frequency_mhz);
+}
 
-    cJSON *response = protocol_create_response(response_type, request_id,
-                                               (resp.error == WIFI_ERR_OK), resp.error);
-    if (response)
+/**
+ * @brief 将扫描结果写入响应data对象
+ *
+ * @param res_data data对象
+ * @param result 扫描结果
+ */
+static void wifi_scan_fill(cJSON *res_data, const wifi_scan_result *result)
+{
+    cJSON *networks_array = cJSON_CreateArray();
+    for (size_t i = 0; i < result->network_count; i++)
     {
-        cJSON *res_data = cJSON_GetObjectItem(response, "data");
+        const wifi_network_info *network = &result->networks[i];
+        cJSON *network_obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(network_obj, "ssid",
+                                (network->ssid && strlen(network->ssid) > 0) ? network->ssid : "");
+        cJSON_AddStringToObject(network_obj, "bssid", network->bssid);
+        cJSON_AddNumberToObject(network_obj, "signal", network->signal);
+        cJSON_AddStringToObject(network_obj, "security", network->security);
+        cJSON_AddNumberToObject(network_obj, "channel", network->channel);
+        cJSON_AddNumberToObject(network_obj, "frequency_mhz", network->frequency_mhz);
+        cJSON_AddBoolToObject(network_obj, "recorded", network->recorded);
+        cJSON_AddItemToArray(networks_array, network_obj);
+    }
+    cJSON_AddItemToObject(res_data, "networks", networks_array);
+}
+
+static bool g_state_seen[STATE_KEY_COUNT]; ///< 是否已发布过成功的记录（只在版本变化回调内访问）
+
+/**
+ * @brief 状态记录的有效期
+ *
+ * @param key 状态键
+ * @return int64_t 有效期(微秒)
+ */
+static int64_t wifi_state_max_age_us(state_key_t key)
+{
+    int64_t ttl_ms = (key == STATE_WIFI_SCAN) ? WIFI_SCAN_CACHE_TTL_MS : WIFI_STATUS_CACHE_TTL_MS;
+    return ttl_ms * 1000;
+}
+
+/**
+ * @brief 状态存储刷新：查询后端并生成与响应data相同结构的对象
+ *
+ * @param key 状态键
+ * @param data 输出对象（调用者释放），失败时也包含默认字段
+ * @return int wifi_error_t错误码
+ */
+static int wifi_state_refresh(state_key_t key, cJSON **data)
+{
+    // 刷新结果供所有读者共享，不受触发刷新的请求的期限与取消约束
+    int64_t deadline_us = wifi_exec_bind_deadline(0);
+    const bool *cancel = wifi_exec_bind_cancel(NULL);
+    cJSON *res_data = cJSON_CreateObject();
+    wifi_error_t err;
+    if (key == STATE_WIFI_SCAN)
+    {
+        wifi_scan_req_t req = {.rescan = false};
+        wifi_scan_resp_t resp = wifi_scan(&req);
+        err = resp.error;
         if (res_data)
         {
-            cJSON_AddBoolToObject(res_data, "enable", resp.status.enable);
-            cJSON_AddBoolToObject(res_data, "connected", resp.status.connected);
-            cJSON_AddStringToObject(res_data, "ssid", resp.status.ssid ? resp.status.ssid : "");
-            cJSON_AddStringToObject(res_data, "bssid", resp.status.bssid ? resp.status.bssid : "");
-            cJSON_AddStringToObject(res_data, "interface",
-                                    resp.status.interface ? resp.status.interface : "");
-            cJSON_AddStringToObject(res_data, "ip", resp.status.ip ? resp.status.ip : "");
-            cJSON_AddNumberToObject(res_data, "signal", resp.status.signal);
-            cJSON_AddStringToObject(res_data, "security",
-                                    resp.status.security ? resp.status.security : "");
-            cJSON_AddNumberToObject(res_data, "channel", resp.status.channel);
-            cJSON_AddNumberToObject(res_data, "frequency_mhz", resp.status.frequency_mhz);
+            wifi_scan_fill(res_data, &resp.result);
         }
-        protocol_send_response(conn, response);
-        cJSON_Delete(response);
+        wifi_impl_scan_result_free(&resp.result);
+    }
+    else
+    {
+        wifi_status_resp_t resp = wifi_status();
+        err = resp.error;
+        if (res_data)
+        {
+            wifi_status_fill(res_data, &resp.status);
+        }
+        wifi_impl_status_free(&resp.status);
+    }
+    wifi_exec_bind_cancel(cancel);
+    wifi_exec_bind_deadline(deadline_us);
+    *data = res_data;
+    return res_data ? err : WIFI_ERR_INTERNAL;
+}
+
+/**
+ * @brief 状态版本变化：记录到快照，并推送给订阅者
+ *
+ * 首个成功的记录由快照负责与启动时应答过的过期数据比较，之后的每个新版本都直接推送。
+ *
+ * @param key 状态键
+ * @param record 新记录
+ */
+static void wifi_state_changed(state_key_t key, const state_record *record)
+{
+    if (record->error != WIFI_ERR_OK)
+    {
+        return;
+    }
+    wifi_snapshot_section_t section =
+        (key == STATE_WIFI_SCAN) ? WIFI_SNAPSHOT_SCAN : WIFI_SNAPSHOT_STATUS;
+    cJSON *data = cJSON_CreateRaw(record->text);
+    if (data)
+    {
+        wifi_snapshot_note(section, data);
+        cJSON_Delete(data);
+    }
+    if (g_state_seen[key])
+    {
+        wifi_snapshot_broadcast(section, record->text);
+    }
+    g_state_seen[key] = true;
+}
+
+/**
+ * @brief 以状态记录生成响应（调用者处于读区间内）
+ *
+ * @param record 状态记录，NULL表示没有可用记录
+ * @param err 错误码
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @return cJSON* 响应JSON对象，需调用者释放
+ */
+static cJSON *wifi_record_response(const state_record *record, wifi_error_t err,
+                                   const char *response_type, const char *request_id)
+{
+    cJSON *response =
+        protocol_create_response(response_type, request_id, (err == WIFI_ERR_OK), err);
+    cJSON *res_data = (response && record) ? cJSON_CreateRaw(record->text) : NULL;
+    if (res_data)
+    {
+        cJSON_ReplaceItemInObjectCaseSensitive(response, "data", res_data);
+    }
+    return response;
+}
+
+/**
+ * @brief 以状态存储中的记录生成响应
+ *
+ * 记录未过期时不访问后端，data直接取自记录中已序列化的JSON文本。
+ * 请求期限只限制本请求的等待，到期时回复WIFI_ERR_TIMEOUT，共享的刷新照常完成。
+ * 记录过期时会执行wpa_cli，只能在读通道的工作线程中调用。
+ *
+ * @param key 状态键
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @return cJSON* 响应JSON对象，需调用者释放
+ */
+static cJSON *wifi_state_response(state_key_t key, const char *response_type,
+                                  const char *request_id)
+{
+    int64_t deadline_us = wifi_exec_deadline();
+    state_store_enter();
+    const state_record *record =
+        state_store_fetch(key, wifi_state_max_age_us(key), wifi_state_refresh, deadline_us);
+    wifi_error_t err = record ? (wifi_error_t)record->error : WIFI_ERR_INTERNAL;
+    if (protocol_deadline_expired(deadline_us))
+    {
+        record = NULL;
+        err = WIFI_ERR_TIMEOUT;
     }
+    cJSON *response = wifi_record_response(record, err, response_type, request_id);
+    state_store_leave();
+    return response;
+}
 
-    wifi_impl_status_free(&resp.status);
+/**
+ * @brief wifi_status请求的桥接函数
+ *
+ * 启动后首次刷新完成前直接以快照中的过期状态应答，之后从状态存储读取。
+ *
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @param data JSON数据对象（未使用）
+ * @return cJSON* 响应JSON对象，需调用者释放
+ */
+static cJSON *bridge_wifi_status(const char *response_type, const char *request_id, cJSON *data)
+{
+    (void)data;
+    cJSON *stale = wifi_snapshot_stale_response(WIFI_SNAPSHOT_STATUS, response_type, request_id);
+    if (stale)
+    {
+        return stale;
+    }
+    return wifi_state_response(STATE_WIFI_STATUS, response_type, request_id);
 }
 
 /**
  * @brief wifi_scan请求的桥接函数
  *
- * @param conn 连接指针
+ * 不带rescan的扫描在启动后首次刷新完成前直接以快照中的过期结果应答，之后从状态存储读取；
+ * rescan在命令队列中执行，新结果发布到状态存储。
+ *
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象
+ * @return cJSON* 响应JSON对象，需调用者释放
  */
-static void bridge_wifi_scan(struct mg_connection *conn, const char *response_type,
-                             const char *request_id, cJSON *data)
+static cJSON *bridge_wifi_scan(const char *response_type, const char *request_id, cJSON *data)
 {
     wifi_scan_req_t req = {0};
     cJSON *rescan_item = data ? cJSON_GetObjectItem(data, "rescan") : NULL;
     req.rescan = (rescan_item && cJSON_IsBool(rescan_item)) ? cJSON_IsTrue(rescan_item) : false;
+    if (!req.rescan)
+    {
+        cJSON *stale = wifi_snapshot_stale_response(WIFI_SNAPSHOT_SCAN, response_type, request_id);
+        if (stale)
+        {
+            return stale;
+        }
+        return wifi_state_response(STATE_WIFI_SCAN, response_type, request_id);
+    }
 
     wifi_scan_resp_t resp = wifi_scan(&req);
 
@@ -146,43 +332,28 @@ static void bridge_wifi_scan(struct mg_connection *conn, const char *response_ty
         cJSON *res_data = cJSON_GetObjectItem(response, "data");
         if (res_data)
         {
-            cJSON *networks_array = cJSON_CreateArray();
-            for (size_t i = 0; i < resp.result.network_count; i++)
+            wifi_scan_fill(res_data, &resp.result);
+            if (resp.error == WIFI_ERR_OK)
             {
-                cJSON *network_obj = cJSON_CreateObject();
-                cJSON_AddStringToObject(
-                    network_obj, "ssid",
-                    (resp.result.networks[i].ssid && strlen(resp.result.networks[i].ssid) > 0)
-                        ? resp.result.networks[i].ssid
-                        : "");
-                cJSON_AddStringToObject(network_obj, "bssid", resp.result.networks[i].bssid);
-                cJSON_AddNumberToObject(network_obj, "signal", resp.result.networks[i].signal);
-                cJSON_AddStringToObject(network_obj, "security", resp.result.networks[i].security);
-                cJSON_AddNumberToObject(network_obj, "channel", resp.result.networks[i].channel);
-                cJSON_AddNumberToObject(network_obj, "frequency_mhz",
-                                        resp.result.networks[i].frequency_mhz);
-                cJSON_AddBoolToObject(network_obj, "recorded", resp.result.networks[i].recorded);
-                cJSON_AddItemToArray(networks_array, network_obj);
+                // 新的扫描结果直接发布，其他连接不必再查询后端
+                state_store_publish(STATE_WIFI_SCAN, resp.error, res_data);
             }
-            cJSON_AddItemToObject(res_data, "networks", networks_array);
         }
-        protocol_send_response(conn, response);
-        cJSON_Delete(response);
     }
 
     wifi_impl_scan_result_free(&resp.result);
+    return response;
 }
 
 /**
  * @brief wifi_connect请求的桥接函数
  *
- * @param conn 连接指针
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象
+ * @return cJSON* 响应JSON对象，需调用者释放
  */
-static void bridge_wifi_connect(struct mg_connection *conn, const char *response_type,
-                                const char *request_id, cJSON *data)
+static cJSON *bridge_wifi_connect(const char *response_type, const char *request_id, cJSON *data)
 {
     wifi_connect_req_t req = {0};
     cJSON *ssid_item = data ? cJSON_GetObjectItem(data, "ssid") : NULL;
@@ -204,26 +375,23 @@ static void bridge_wifi_connect(struct mg_connection *conn, const char *response
     }
 
     wifi_connect_resp_t resp = wifi_connect(&req);
+    // 连接会新增已保存的网络，扫描结果中的recorded字段随之变化
+    state_store_invalidate(STATE_WIFI_STATUS);
+    state_store_invalidate(STATE_WIFI_SCAN);
 
-    cJSON *response = protocol_create_response(response_type, request_id,
-                                               (resp.error == WIFI_ERR_OK), resp.error);
-    if (response)
-    {
-        protocol_send_response(conn, response);
-        cJSON_Delete(response);
-    }
+    return protocol_create_response(response_type, request_id, (resp.error == WIFI_ERR_OK),
+                                    resp.error);
 }
 
 /**
  * @brief wifi_disconnect请求的桥接函数
  *
- * @param conn 连接指针
  * @param response_type 响应类型
  * @param request_id 请求ID
  * @param data JSON数据对象
+ * @return cJSON* 响应JSON对象，需调用者释放
  */
-static void bridge_wifi_disconnect(struct mg_connection *conn, const char *response_type,
-                                   const char *request_id, cJSON *data)
+static cJSON *bridge_wifi_disconnect(const char *response_type, const char *request_id, cJSON *data)
 {
     wifi_disconnect_req_t req = {0};
     cJSON *ssid_item = data ? cJSON_GetObjectItem(data, "ssid") : NULL;
@@ -235,14 +403,10 @@ static void bridge_wifi_disconnect(struct mg_connection *conn, const char *respo
     }
 
     wifi_disconnect_resp_t resp = wifi_disconnect(&req);
+    state_store_invalidate(STATE_WIFI_STATUS);
 
-    cJSON *response = protocol_create_response(response_type, request_id,
-                                               (resp.error == WIFI_ERR_OK), resp.error);
-    if (response)
-    {
-        protocol_send_response(conn, response);
-        cJSON_Delete(response);
-    }
+    return protocol_create_response(response_type, request_id, (resp.error == WIFI_ERR_OK),
+                                    resp.error);
 }
 
 /**
@@ -250,45 +414,341 @@ static void bridge_wifi_disconnect(struct mg_connection *conn, const char *respo
  *
  */
 static wifi_dispatch wifi_dispatch_table[] = {
-    {"wifi_enable_request", "wifi_enable_response", bridge_wifi_enable},
-    {"wifi_status_request", "wifi_status_response", bridge_wifi_status},
-    {"wifi_scan_request", "wifi_scan_response", bridge_wifi_scan},
-    {"wifi_connect_request", "wifi_connect_response", bridge_wifi_connect},
-    {"wifi_disconnect_request", "wifi_disconnect_response", bridge_wifi_disconnect},
+    {"wifi_enable_request", "wifi_enable_response", bridge_wifi_enable, WIFI_QUEUE_PRIO_HIGH,
+     QOS_CLASS_BACKGROUND},
+    {"wifi_status_request", "wifi_status_response", bridge_wifi_status, WIFI_QUEUE_PRIO_NONE,
+     QOS_CLASS_NORMAL},
+    {"wifi_scan_request", "wifi_scan_response", bridge_wifi_scan, WIFI_QUEUE_PRIO_LOW,
+     QOS_CLASS_BACKGROUND},
+    {"wifi_connect_request", "wifi_connect_response", bridge_wifi_connect,
+     WIFI_QUEUE_PRIO_NORMAL, QOS_CLASS_BACKGROUND},
+    {"wifi_disconnect_request", "wifi_disconnect_response", bridge_wifi_disconnect,
+     WIFI_QUEUE_PRIO_HIGH, QOS_CLASS_BACKGROUND},
 };
 #define WIFI_DISPATCH_TABLE_LEN (sizeof(wifi_dispatch_table) / sizeof(wifi_dispatch_table[0]))
 
+/**
+ * @brief 获取请求实际使用的队列优先级
+ *
+ * 不带rescan的扫描只读取已有结果，与其他只读请求一样不进入命令队列。
+ *
+ * @param entry 调度表项
+ * @param data JSON数据对象
+ * @return wifi_queue_prio_t 队列优先级
+ */
+static wifi_queue_prio_t wifi_dispatch_priority(const wifi_dispatch *entry, cJSON *data)
+{
+    if (entry->bridge == bridge_wifi_scan)
+    {
+        cJSON *rescan_item = data ? cJSON_GetObjectItem(data, "rescan") : NULL;
+        if (!cJSON_IsTrue(rescan_item))
+        {
+            return WIFI_QUEUE_PRIO_NONE;
+        }
+    }
+    return entry->priority;
+}
+
+/**
+ * @brief 以缓存应答只读请求，不访问后端
+ *
+ * 启动后首次刷新完成前使用快照中的过期数据，之后只使用状态存储中未过期的记录。
+ *
+ * @param entry 调度表项（wifi_status或不带rescan的wifi_scan）
+ * @param request_id 请求ID
+ * @return cJSON* 响应JSON对象，需调用者释放；没有可用缓存返回NULL
+ */
+static cJSON *wifi_cached_response(const wifi_dispatch *entry, const char *request_id)
+{
+    bool scan = entry->bridge == bridge_wifi_scan;
+    cJSON *response = wifi_snapshot_stale_response(scan ? WIFI_SNAPSHOT_SCAN : WIFI_SNAPSHOT_STATUS,
+                                                   entry->response, request_id);
+    if (response)
+    {
+        return response;
+    }
+    state_key_t key = scan ? STATE_WIFI_SCAN : STATE_WIFI_STATUS;
+    state_store_enter();
+    const state_record *record = state_store_peek(key, wifi_state_max_age_us(key));
+    if (record)
+    {
+        response = wifi_record_response(record, (wifi_error_t)record->error, entry->response,
+                                        request_id);
+    }
+    state_store_leave();
+    return response;
+}
+
+/**
+ * @brief 从状态存储读取分区数据
+ *
+ * @param section 分区
+ * @param refresh 记录过期时的刷新函数，NULL表示只读取当前记录
+ * @return cJSON* 与响应data相同结构的对象，失败返回NULL
+ */
+static cJSON *wifi_state_read(wifi_snapshot_section_t section, state_refresh_fn refresh)
+{
+    state_key_t key = (section == WIFI_SNAPSHOT_SCAN) ? STATE_WIFI_SCAN : STATE_WIFI_STATUS;
+    state_store_enter();
+    const state_record *record =
+        state_store_fetch(key, wifi_state_max_age_us(key), refresh, 0);
+    cJSON *res_data =
+        (record && record->error == WIFI_ERR_OK) ? cJSON_CreateRaw(record->text) : NULL;
+    state_store_leave();
+    return res_data;
+}
+
+/**
+ * @brief 快照刷新：从状态存储读取分区的实时数据（在快照刷新线程中执行）
+ *
+ * @param section 分区
+ * @return cJSON* 与响应data相同结构的对象，失败返回NULL
+ */
+static cJSON *wifi_snapshot_build(wifi_snapshot_section_t section)
+{
+    return wifi_state_read(section, wifi_state_refresh);
+}
+
+/**
+ * @brief 会话恢复快照：当前连接状态与扫描结果
+ *
+ * 在WebSocket工作线程中执行，只取状态存储中的当前记录，不刷新（不执行wpa_cli）；
+ * 记录之后的变化由wifi_status_event / wifi_scan_event推送。
+ *
+ * @return cJSON* {"status": ..., "scan": ...}，两部分都无法获取时返回NULL
+ */
+static cJSON *wifi_resume_snapshot(void)
+{
+    cJSON *snapshot = cJSON_CreateObject();
+    if (!snapshot)
+    {
+        return NULL;
+    }
+    cJSON *status = wifi_state_read(WIFI_SNAPSHOT_STATUS, NULL);
+    if (status)
+    {
+        cJSON_AddItemToObject(snapshot, "status", status);
+    }
+    cJSON *scan = wifi_state_read(WIFI_SNAPSHOT_SCAN, NULL);
+    if (scan)
+    {
+        cJSON_AddItemToObject(snapshot, "scan", scan);
+    }
+    if (!status && !scan)
+    {
+        cJSON_Delete(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+/**
+ * @brief 初始化WiFi模块
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_scheduler_init(void)
+{
+    if (wifi_queue_init() != 0)
+    {
+        return -1;
+    }
+    state_store_watch(STATE_WIFI_STATUS, wifi_state_changed);
+    state_store_watch(STATE_WIFI_SCAN, wifi_state_changed);
+    if (wifi_snapshot_init(wifi_snapshot_build) != 0)
+    {
+        state_store_watch(STATE_WIFI_STATUS, NULL);
+        state_store_watch(STATE_WIFI_SCAN, NULL);
+        wifi_queue_deinit();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放WiFi模块资源
+ */
+void wifi_scheduler_deinit(void)
+{
+    state_store_watch(STATE_WIFI_STATUS, NULL);
+    state_store_watch(STATE_WIFI_SCAN, NULL);
+    memset(g_state_seen, 0, sizeof(g_state_seen));
+    wifi_snapshot_deinit();
+    wifi_queue_deinit();
+}
+
+/**
+ * @brief WiFi连接关闭通知
+ *
+ * @param conn 正在关闭的连接
+ */
+void wifi_scheduler_close(const struct mg_connection *conn)
+{
+    wifi_queue_cancel_connection(conn);
+}
+
+/**
+ * @brief 处理cancel_request：取消本连接发起的、仍在排队或执行中的请求
+ *
+ * @param conn WebSocket连接指针
+ * @param request_id 取消请求自身的请求ID
+ * @param data JSON数据对象，data.request_id为要取消的请求
+ * @param start_us 收到请求时的qos_now_us()
+ */
+static void wifi_scheduler_cancel(struct mg_connection *conn, const char *request_id,
+                                  cJSON *data, int64_t start_us)
+{
+    cJSON *target_item = data ? cJSON_GetObjectItemCaseSensitive(data, "request_id") : NULL;
+    const char *target = cJSON_IsString(target_item) ? target_item->valuestring : NULL;
+
+    cJSON *response = NULL;
+    if (!target)
+    {
+        response = protocol_create_response(WIFI_CANCEL_RESPONSE, request_id, false,
+                                            WIFI_ERR_BAD_REQUEST);
+    }
+    else
+    {
+        bool cancelled = wifi_queue_cancel(conn, target);
+        response = protocol_create_response(WIFI_CANCEL_RESPONSE, request_id, true, WIFI_ERR_OK);
+        cJSON *res_data = response ? cJSON_GetObjectItem(response, "data") : NULL;
+        if (res_data)
+        {
+            cJSON_AddStringToObject(res_data, "request_id", target);
+            cJSON_AddBoolToObject(res_data, "cancelled", cancelled);
+        }
+    }
+    if (response)
+    {
+        protocol_send_response(conn, response);
+    }
+    metrics_count_response(METRICS_MODULE_WIFI, response);
+    cJSON_Delete(response);
+    qos_record(QOS_CLASS_INTERACTIVE, WIFI_CANCEL_REQUEST, start_us);
+}
+
+/**
+ * @brief 处理wifi_resume_request：补发重连前错过的事件，无法补发时附带状态快照
+ *
+ * @param conn WebSocket连接指针
+ * @param request_id 请求ID
+ * @param data JSON数据对象（epoch与last_seq）
+ * @param start_us 收到请求时的qos_now_us()
+ */
+static void wifi_scheduler_resume(struct mg_connection *conn, const char *request_id,
+                                  cJSON *data, int64_t start_us)
+{
+    cJSON *response = protocol_resume(conn, WIFI_SNAPSHOT_EVENT_PATH, WIFI_RESUME_RESPONSE,
+                                      request_id, data, wifi_resume_snapshot);
+    if (response)
+    {
+        protocol_send_response(conn, response);
+    }
+    metrics_count_response(METRICS_MODULE_WIFI, response);
+    cJSON_Delete(response);
+    qos_record(QOS_CLASS_NORMAL, WIFI_RESUME_REQUEST, start_us);
+}
+
 /**
  * @brief WiFi模块消息调度入口
  *
- * 根据JSON中的type字段分发到对应的桥接函数处理。
+ * 根据JSON中的type字段分发到对应的桥接函数处理。只读请求有未过期的记录时在当前线程直接应答，
+ * 否则交给设备读通道执行；写操作进入设备命令队列按优先级串行执行。请求信封中的期限（deadline_ms/timeout_ms）
+ * 在到达时已过的请求直接回复WIFI_ERR_TIMEOUT，否则随请求传递到wpa_cli调用。
  *
  * @param conn WebSocket连接指针
  * @param root 解析后的JSON根对象
  */
 void wifi_scheduler(struct mg_connection *conn, cJSON *root)
 {
+    int64_t start_us = qos_now_us();
     cJSON *type_item = cJSON_GetObjectItemCaseSensitive(root, "type");
 
     if (!cJSON_IsString(type_item) || !type_item->valuestring)
     {
         fprintf(stderr, "缺少或无效的 'type' 字段\n");
+        metrics_count_message(NULL);
         return;
     }
 
     const char *request_id = protocol_get_request_id(root);
     cJSON *data = cJSON_GetObjectItem(root, "data");
+    int64_t deadline_us = protocol_get_deadline_us(root, start_us);
+
+    if (strcmp(type_item->valuestring, WIFI_CANCEL_REQUEST) == 0)
+    {
+        metrics_count_message(WIFI_CANCEL_REQUEST);
+        metrics_trace_identify(METRICS_MODULE_WIFI, WIFI_CANCEL_REQUEST, request_id);
+        wifi_scheduler_cancel(conn, request_id, data, start_us);
+        return;
+    }
+    if (strcmp(type_item->valuestring, WIFI_RESUME_REQUEST) == 0)
+    {
+        metrics_count_message(WIFI_RESUME_REQUEST);
+        metrics_trace_identify(METRICS_MODULE_WIFI, WIFI_RESUME_REQUEST, request_id);
+        wifi_scheduler_resume(conn, request_id, data, start_us);
+        return;
+    }
 
     for (size_t i = 0; i < WIFI_DISPATCH_TABLE_LEN; i++)
     {
         if (strcmp(type_item->valuestring, wifi_dispatch_table[i].request) == 0)
         {
-            if (wifi_dispatch_table[i].bridge != NULL)
+            const wifi_dispatch *entry = &wifi_dispatch_table[i];
+            metrics_count_message(entry->request);
+            metrics_trace_identify(METRICS_MODULE_WIFI, entry->request, request_id);
+            if (entry->bridge == NULL)
+            {
+                return;
+            }
+            if (protocol_deadline_expired(deadline_us))
+            {
+                protocol_send_standard_response(conn, entry->response, request_id, false,
+                                                WIFI_ERR_TIMEOUT);
+                metrics_count_error(METRICS_MODULE_WIFI, WIFI_ERR_TIMEOUT);
+                qos_record(entry->qos, entry->request, start_us);
+                return;
+            }
+
+            wifi_queue_prio_t prio = wifi_dispatch_priority(entry, data);
+            if (prio != WIFI_QUEUE_PRIO_NONE)
+            {
+                wifi_error_t err =
+                    wifi_queue_submit(WIFI_DEVICE, prio, conn, entry->request, entry->response,
+                                      request_id, data, entry->bridge, start_us, deadline_us);
+                if (err != WIFI_ERR_OK)
+                {
+                    protocol_send_standard_response(conn, entry->response, request_id, false,
+                                                    err);
+                    metrics_count_error(METRICS_MODULE_WIFI, err);
+                    qos_record(QOS_CLASS_BACKGROUND, entry->request, start_us);
+                }
+                return;
+            }
+
+            // 后台类请求不允许占用WebSocket工作线程，只读形式（如不带rescan的扫描）按普通类处理；
+            // 当前线程只以缓存应答，需要执行wpa_cli的刷新交给读通道
+            cJSON *response = wifi_cached_response(entry, request_id);
+            if (!response)
+            {
+                wifi_error_t err =
+                    wifi_queue_submit_read(WIFI_DEVICE, conn, entry->request, entry->response,
+                                           request_id, data, entry->bridge, start_us, deadline_us);
+                if (err == WIFI_ERR_OK)
+                {
+                    return;
+                }
+                response = protocol_create_response(entry->response, request_id, false, err);
+            }
+            if (response)
             {
-                wifi_dispatch_table[i].bridge(conn, wifi_dispatch_table[i].response, request_id,
-                                              data);
+                protocol_send_response(conn, response);
             }
+            metrics_count_response(METRICS_MODULE_WIFI, response);
+            cJSON_Delete(response);
+            qos_record(QOS_CLASS_NORMAL, entry->request, start_us);
             return;
         }
     }
+    metrics_count_message(NULL);
 }
@@ -29,6 +29,14 @@ limitations under the License.
 #include "cJSON.h"
 #include "civetweb.h"
 
+#ifndef WIFI_STATUS_CACHE_TTL_MS
+#define WIFI_STATUS_CACHE_TTL_MS 2000 ///< 状态记录有效期(毫秒)
+#endif
+
+#ifndef WIFI_SCAN_CACHE_TTL_MS
+#define WIFI_SCAN_CACHE_TTL_MS 5000 ///< 扫描结果记录有效期(毫秒)，rescan会立即发布新结果
+#endif
+
 /**
  * @brief WiFi模块消息调度入口
  *
@@ -37,4 +45,23 @@ limitations under the License.
  */
 void wifi_scheduler(struct mg_connection *conn, cJSON *root);
 
+/**
+ * @brief 初始化WiFi模块（启动设备命令队列）
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_scheduler_init(void);
+
+/**
+ * @brief 释放WiFi模块资源
+ */
+void wifi_scheduler_deinit(void);
+
+/**
+ * @brief WiFi连接关闭通知
+ *
+ * @param conn 正在关闭的连接
+ */
+void wifi_scheduler_close(const struct mg_connection *conn);
+
 #endif
@@ -0,0 +1,574 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_snapshot.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi状态快照实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 文件格式（本机字节序，只在同一设备上读写）：
+ *   头部   magic "WIFISNAP"、版本、分区数
+ *   分区表 每个分区的偏移、长度（不含结尾NUL）与FNV-1a校验和，长度为0表示没有该分区
+ *   数据   各分区序列化后的JSON文本，以NUL结尾
+ * 启动时整个文件只读映射，过期应答直接引用映射中的文本，所有分区刷新后解除映射。
+ */
+#include "wifi_snapshot.h"
+#include "../../metrics.h"
+#include "../../protocol/protocol_utils.h"
+#include "../../qos.h"
+#include "../../ws_utils.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WIFI_SNAPSHOT_MAGIC "WIFISNAP" ///< 文件头校验值
+#define WIFI_SNAPSHOT_VERSION 1u       ///< 文件格式版本
+
+/**
+ * @brief 文件头部
+ */
+typedef struct
+{
+    char magic[8];    ///< WIFI_SNAPSHOT_MAGIC
+    uint32_t version; ///< WIFI_SNAPSHOT_VERSION
+    uint32_t count;   ///< 分区数
+} wifi_snapshot_file_header;
+
+/**
+ * @brief 分区表项
+ */
+typedef struct
+{
+    uint32_t offset;   ///< 数据偏移
+    uint32_t length;   ///< 数据长度（不含结尾NUL），0表示没有该分区
+    uint32_t checksum; ///< 数据的FNV-1a校验和
+    uint32_t reserved; ///< 保留
+} wifi_snapshot_file_entry;
+
+/**
+ * @brief 快照状态
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                   ///< 保护以下字段
+    pthread_cond_t cond;                    ///< 有新数据或需要退出
+    pthread_t writer;                       ///< 写入线程
+    pthread_t refresher;                    ///< 启动刷新线程
+    bool writer_started;                    ///< 写入线程是否已启动
+    bool refresher_started;                 ///< 刷新线程是否已启动
+    bool stop;                              ///< 是否请求退出
+    bool dirty;                             ///< 是否有未写入的数据
+    struct timespec deadline;               ///< 计划写入时间（CLOCK_MONOTONIC）
+    char path[256];                         ///< 快照文件路径，空串表示不使用快照
+    wifi_snapshot_build_fn build;           ///< 生成实时数据的函数
+    void *map;                              ///< 快照文件映射，所有分区刷新后解除
+    size_t map_len;                         ///< 映射长度
+    const char *stale[WIFI_SNAPSHOT_COUNT]; ///< 映射中各分区的JSON文本，NULL表示没有
+    bool live[WIFI_SNAPSHOT_COUNT];         ///< 分区是否已有实时数据
+    char *text[WIFI_SNAPSHOT_COUNT];        ///< 各分区最新的实时JSON文本（cJSON分配）
+} wifi_snapshot;
+
+static wifi_snapshot g_snapshot = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const char *const g_event_types[WIFI_SNAPSHOT_COUNT] = {
+    "wifi_status_event",
+    "wifi_scan_event",
+};
+
+/**
+ * @brief FNV-1a校验和
+ *
+ * @param data 数据
+ * @param len 长度
+ * @return uint32_t 校验和
+ */
+static uint32_t snapshot_checksum(const char *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 只读映射快照文件并校验各分区
+ *
+ * @param s 快照状态
+ */
+static void snapshot_load(wifi_snapshot *s)
+{
+    int fd = open(s->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(wifi_snapshot_file_header))
+    {
+        close(fd);
+        return;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("wifi_snapshot: mmap");
+        return;
+    }
+
+    const wifi_snapshot_file_header *hdr = (const wifi_snapshot_file_header *)map;
+    size_t table_end =
+        sizeof(*hdr) + (size_t)WIFI_SNAPSHOT_COUNT * sizeof(wifi_snapshot_file_entry);
+    if (len < table_end || memcmp(hdr->magic, WIFI_SNAPSHOT_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != WIFI_SNAPSHOT_VERSION || hdr->count != WIFI_SNAPSHOT_COUNT)
+    {
+        fprintf(stderr, "wifi_snapshot: %s 格式不符，忽略\n", s->path);
+        munmap(map, len);
+        return;
+    }
+
+    const wifi_snapshot_file_entry *entries = (const wifi_snapshot_file_entry *)(hdr + 1);
+    const char *base = (const char *)map;
+    int loaded = 0;
+    for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        const wifi_snapshot_file_entry *e = &entries[i];
+        if (e->length == 0 || e->offset < table_end || e->offset > len ||
+            (size_t)e->length >= len - e->offset || base[e->offset + e->length] != '\0' ||
+            snapshot_checksum(base + e->offset, e->length) != e->checksum)
+        {
+            continue;
+        }
+        s->stale[i] = base + e->offset;
+        loaded++;
+    }
+    if (loaded == 0)
+    {
+        munmap(map, len);
+        return;
+    }
+    s->map = map;
+    s->map_len = len;
+    printf("WiFi 快照已加载: %s\n", s->path);
+}
+
+/**
+ * @brief 将各分区写入临时文件后原子替换快照文件
+ *
+ * @param path 快照文件路径
+ * @param text 各分区JSON文本，NULL表示没有
+ * @return int 成功返回0，失败返回-1
+ */
+static int snapshot_write_file(const char *path, char *const *text)
+{
+    wifi_snapshot_file_header hdr = {.version = WIFI_SNAPSHOT_VERSION,
+                                     .count = WIFI_SNAPSHOT_COUNT};
+    memcpy(hdr.magic, WIFI_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    wifi_snapshot_file_entry entries[WIFI_SNAPSHOT_COUNT];
+    memset(entries, 0, sizeof(entries));
+    size_t offset = sizeof(hdr) + sizeof(entries);
+    for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        if (text[i])
+        {
+            size_t len = strlen(text[i]);
+            entries[i].offset = (uint32_t)offset;
+            entries[i].length = (uint32_t)len;
+            entries[i].checksum = snapshot_checksum(text[i], len);
+            offset += len + 1;
+        }
+    }
+
+    char tmp[272];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp)
+    {
+        perror("wifi_snapshot: fopen");
+        return -1;
+    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             fwrite(entries, sizeof(entries), 1, fp) == 1;
+    for (int i = 0; ok && i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        if (text[i])
+        {
+            ok = fwrite(text[i], strlen(text[i]) + 1, 1, fp) == 1;
+        }
+    }
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0)
+    {
+        ok = 0;
+    }
+    if (!ok || rename(tmp, path) != 0)
+    {
+        perror("wifi_snapshot: 写入失败");
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 写入线程：等到数据稳定后写入一次
+ *
+ * @param arg 快照状态
+ * @return void* 始终为NULL
+ */
+static void *wifi_snapshot_writer(void *arg)
+{
+    wifi_snapshot *s = (wifi_snapshot *)arg;
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->stop)
+    {
+        if (!s->dirty)
+        {
+            pthread_cond_wait(&s->cond, &s->lock);
+            continue;
+        }
+        // 期间有新数据时deadline会被推迟，超时才说明数据已稳定
+        if (pthread_cond_timedwait(&s->cond, &s->lock, &s->deadline) == 0)
+        {
+            continue;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec < s->deadline.tv_sec ||
+            (now.tv_sec == s->deadline.tv_sec && now.tv_nsec < s->deadline.tv_nsec))
+        {
+            continue;
+        }
+
+        char *copy[WIFI_SNAPSHOT_COUNT] = {0};
+        for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+        {
+            copy[i] = s->text[i] ? metrics_strdup(METRICS_MODULE_WIFI, s->text[i]) : NULL;
+        }
+        s->dirty = false;
+        pthread_mutex_unlock(&s->lock);
+        snapshot_write_file(s->path, copy);
+        for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+        {
+            metrics_free(copy[i]);
+        }
+        pthread_mutex_lock(&s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/**
+ * @brief 所有分区都已有实时数据时解除映射（调用者持有lock）
+ *
+ * @param s 快照状态
+ */
+static void snapshot_release_map(wifi_snapshot *s)
+{
+    if (!s->map)
+    {
+        return;
+    }
+    for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        if (!s->live[i] && s->stale[i])
+        {
+            return;
+        }
+    }
+    munmap(s->map, s->map_len);
+    s->map = NULL;
+    s->map_len = 0;
+    memset(s->stale, 0, sizeof(s->stale));
+}
+
+/**
+ * @brief 向订阅者推送分区的最新数据
+ *
+ * @param section 分区
+ * @param text 分区的实时JSON文本
+ */
+void wifi_snapshot_broadcast(wifi_snapshot_section_t section, const char *text)
+{
+    if (section < 0 || section >= WIFI_SNAPSHOT_COUNT || !text)
+    {
+        return;
+    }
+    cJSON *event = cJSON_CreateObject();
+    if (!event)
+    {
+        return;
+    }
+    cJSON_AddStringToObject(event, "type", g_event_types[section]);
+    cJSON_AddRawToObject(event, "data", text);
+    ws_broadcast_event(WIFI_SNAPSHOT_EVENT_PATH, event);
+    cJSON_Delete(event);
+}
+
+/**
+ * @brief 启动刷新线程：依次生成各分区的实时数据
+ *
+ * @param arg 快照状态
+ * @return void* 始终为NULL
+ */
+static void *wifi_snapshot_refresher(void *arg)
+{
+    wifi_snapshot *s = (wifi_snapshot *)arg;
+
+    // 刷新在后台进行，不与交互类请求争抢CPU
+    qos_apply_thread_class(QOS_CLASS_BACKGROUND);
+
+    for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        pthread_mutex_lock(&s->lock);
+        bool skip = s->stop || s->live[i];
+        pthread_mutex_unlock(&s->lock);
+        if (skip)
+        {
+            continue;
+        }
+
+        cJSON *data = s->build((wifi_snapshot_section_t)i);
+        if (data)
+        {
+            wifi_snapshot_note((wifi_snapshot_section_t)i, data);
+            cJSON_Delete(data);
+        }
+        else
+        {
+            // 刷新失败时不再以过期数据应答，后续请求直接查询后端
+            pthread_mutex_lock(&s->lock);
+            s->live[i] = true;
+            snapshot_release_map(s);
+            pthread_mutex_unlock(&s->lock);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 映射快照文件并启动后台刷新与写入线程
+ *
+ * @param build 生成实时数据的函数
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_snapshot_init(wifi_snapshot_build_fn build)
+{
+    wifi_snapshot *s = &g_snapshot;
+    const char *path = getenv(WIFI_SNAPSHOT_PATH_ENV);
+    snprintf(s->path, sizeof(s->path), "%s", path ? path : WIFI_SNAPSHOT_PATH);
+    if (s->path[0] == '\0' || !build)
+    {
+        // 未启用快照时所有分区直接视为实时，note直接忽略
+        for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+        {
+            s->live[i] = true;
+        }
+        return 0;
+    }
+    s->build = build;
+    snapshot_load(s);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    s->stop = false;
+    if (pthread_create(&s->writer, NULL, wifi_snapshot_writer, s) != 0)
+    {
+        fprintf(stderr, "wifi_snapshot_init: 无法创建写入线程\n");
+        wifi_snapshot_deinit();
+        return -1;
+    }
+    s->writer_started = true;
+    if (pthread_create(&s->refresher, NULL, wifi_snapshot_refresher, s) != 0)
+    {
+        fprintf(stderr, "wifi_snapshot_init: 无法创建刷新线程\n");
+        wifi_snapshot_deinit();
+        return -1;
+    }
+    s->refresher_started = true;
+    return 0;
+}
+
+/**
+ * @brief 停止后台线程，未写入的数据立即写入并解除映射
+ */
+void wifi_snapshot_deinit(void)
+{
+    wifi_snapshot *s = &g_snapshot;
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    if (s->writer_started)
+    {
+        pthread_cond_broadcast(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    if (s->refresher_started)
+    {
+        pthread_join(s->refresher, NULL);
+        s->refresher_started = false;
+    }
+    if (s->writer_started)
+    {
+        pthread_join(s->writer, NULL);
+        s->writer_started = false;
+        pthread_cond_destroy(&s->cond);
+    }
+
+    if (s->dirty)
+    {
+        snapshot_write_file(s->path, s->text);
+        s->dirty = false;
+    }
+    for (int i = 0; i < WIFI_SNAPSHOT_COUNT; i++)
+    {
+        cJSON_free(s->text[i]);
+        s->text[i] = NULL;
+        s->live[i] = true;
+    }
+    if (s->map)
+    {
+        munmap(s->map, s->map_len);
+        s->map = NULL;
+        memset(s->stale, 0, sizeof(s->stale));
+    }
+    s->build = NULL;
+}
+
+/**
+ * @brief 分区尚未刷新时用快照数据生成响应
+ *
+ * @param section 分区
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @return cJSON* 响应，分区已刷新或快照中没有该分区时返回NULL
+ */
+cJSON *wifi_snapshot_stale_response(wifi_snapshot_section_t section, const char *response_type,
+                                    const char *request_id)
+{
+    wifi_snapshot *s = &g_snapshot;
+    if (section < 0 || section >= WIFI_SNAPSHOT_COUNT ||
+        __atomic_load_n(&s->live[section], __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    cJSON *response = NULL;
+    pthread_mutex_lock(&s->lock);
+    if (!s->live[section] && s->stale[section])
+    {
+        response = protocol_create_response(response_type, request_id, true, 0);
+        cJSON *data = response ? cJSON_CreateRaw(s->stale[section]) : NULL;
+        if (data)
+        {
+            cJSON_ReplaceItemInObjectCaseSensitive(response, "data", data);
+            cJSON_AddBoolToObject(response, "stale", true);
+        }
+        else
+        {
+            cJSON_Delete(response);
+            response = NULL;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    return response;
+}
+
+/**
+ * @brief 记录分区的最新实时数据
+ *
+ * @param section 分区
+ * @param data 与响应data相同结构的对象
+ */
+void wifi_snapshot_note(wifi_snapshot_section_t section, const cJSON *data)
+{
+    wifi_snapshot *s = &g_snapshot;
+    if (section < 0 || section >= WIFI_SNAPSHOT_COUNT || !data || !s->writer_started)
+    {
+        return;
+    }
+    char *text = cJSON_PrintUnformatted(data);
+    if (!text)
+    {
+        return;
+    }
+
+    char *diff = NULL;
+    pthread_mutex_lock(&s->lock);
+    const char *prev = s->text[section] ? s->text[section] : s->stale[section];
+    bool changed = !prev || strcmp(prev, text) != 0;
+    if (!s->live[section])
+    {
+        // 首次得到实时数据：与已应答过的快照不同时推送给前端
+        if (changed && s->stale[section])
+        {
+            diff = metrics_strdup(METRICS_MODULE_WIFI, text);
+        }
+        __atomic_store_n(&s->live[section], true, __ATOMIC_RELEASE);
+        snapshot_release_map(s);
+    }
+    if (changed)
+    {
+        cJSON_free(s->text[section]);
+        s->text[section] = text;
+        text = NULL;
+        bool was_dirty = s->dirty;
+        s->dirty = true;
+        clock_gettime(CLOCK_MONOTONIC, &s->deadline);
+        s->deadline.tv_sec += WIFI_SNAPSHOT_DELAY_MS / 1000;
+        s->deadline.tv_nsec += (long)(WIFI_SNAPSHOT_DELAY_MS % 1000) * 1000000L;
+        if (s->deadline.tv_nsec >= 1000000000L)
+        {
+            s->deadline.tv_sec++;
+            s->deadline.tv_nsec -= 1000000000L;
+        }
+        if (!was_dirty)
+        {
+            pthread_cond_signal(&s->cond);
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    cJSON_free(text);
+
+    if (diff)
+    {
+        wifi_snapshot_broadcast(section, diff);
+        metrics_free(diff);
+    }
+}
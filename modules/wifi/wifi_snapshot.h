@@ -0,0 +1,116 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wifi_snapshot.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi状态快照（重启后立即以过期数据应答）声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef WIFI_SNAPSHOT_H
+#define WIFI_SNAPSHOT_H
+
+#include "cJSON.h"
+#include <stdbool.h>
+
+// 快照文件路径可配置：编译时通过 -DWIFI_SNAPSHOT_PATH="\"/path\"" 覆盖，
+// 运行时可通过环境变量 WIFI_SNAPSHOT_PATH 覆盖，设为空串表示不使用快照
+#ifndef WIFI_SNAPSHOT_PATH
+#define WIFI_SNAPSHOT_PATH                                                                         \
+    "/var/lib/CWebSocketServerForFlutterPanel/wifi_snapshot" ///< 快照文件路径
+#endif
+
+#define WIFI_SNAPSHOT_PATH_ENV "WIFI_SNAPSHOT_PATH" ///< 覆盖快照文件路径的环境变量
+
+#ifndef WIFI_SNAPSHOT_DELAY_MS
+#define WIFI_SNAPSHOT_DELAY_MS 2000 ///< 数据稳定多久后写入(毫秒)
+#endif
+
+#define WIFI_SNAPSHOT_EVENT_PATH "/wifi" ///< 状态事件推送的连接路径
+
+/**
+ * @brief 快照分区
+ */
+typedef enum
+{
+    WIFI_SNAPSHOT_STATUS = 0, ///< wifi_status_response的data
+    WIFI_SNAPSHOT_SCAN,       ///< wifi_scan_response的data（不带rescan的扫描结果）
+    WIFI_SNAPSHOT_COUNT
+} wifi_snapshot_section_t;
+
+/**
+ * @brief 生成分区的实时数据
+ *
+ * @param section 分区
+ * @return cJSON* 与响应data相同结构的对象（调用者释放），失败返回NULL
+ */
+typedef cJSON *(*wifi_snapshot_build_fn)(wifi_snapshot_section_t section);
+
+/**
+ * @brief 映射快照文件并启动后台刷新与写入线程
+ *
+ * 快照中的分区在刷新完成前以过期数据应答；刷新线程依次调用build生成实时数据，
+ * 与快照不同的分区推送wifi_status_event/wifi_scan_event。
+ * 应在WiFi命令队列初始化之后、WebSocket监听启动之前调用。
+ *
+ * @param build 生成实时数据的函数
+ * @return int 成功返回0，失败返回-1
+ */
+int wifi_snapshot_init(wifi_snapshot_build_fn build);
+
+/**
+ * @brief 停止后台线程，未写入的数据立即写入并解除映射
+ */
+void wifi_snapshot_deinit(void);
+
+/**
+ * @brief 分区尚未刷新时用快照数据生成响应
+ *
+ * 响应的data直接取自快照文件中已序列化的JSON文本，不再解析，并带有"stale": true。
+ *
+ * @param section 分区
+ * @param response_type 响应类型
+ * @param request_id 请求ID
+ * @return cJSON* 响应（调用者释放）；分区已刷新或快照中没有该分区时返回NULL
+ */
+cJSON *wifi_snapshot_stale_response(wifi_snapshot_section_t section, const char *response_type,
+                                    const char *request_id);
+
+/**
+ * @brief 记录分区的最新实时数据
+ *
+ * 与上次记录不同时推迟写入，数据稳定WIFI_SNAPSHOT_DELAY_MS后才写入文件。
+ *
+ * @param section 分区
+ * @param data 与响应data相同结构的对象
+ */
+void wifi_snapshot_note(wifi_snapshot_section_t section, const cJSON *data);
+
+/**
+ * @brief 向订阅者推送分区的最新数据
+ *
+ * 以wifi_status_event/wifi_scan_event推送到WIFI_SNAPSHOT_EVENT_PATH。
+ *
+ * @param section 分区
+ * @param text 与响应data相同结构的JSON文本
+ */
+void wifi_snapshot_broadcast(wifi_snapshot_section_t section, const char *text);
+
+#endif
@@ -24,9 +24,12 @@ limitations under the License.
  *
  */
 #include "protocol_utils.h"
+#include "../metrics.h"
+#include "../qos.h"
 #include "../ws_utils.h"
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 /**
  * @brief 从JSON对象中获取request_id
@@ -44,6 +47,59 @@ const char *protocol_get_request_id(cJSON *root)
     return "";
 }
 
+/**
+ * @brief 从请求外层获取客户端给出的期限
+ *
+ * @param root JSON根对象
+ * @param start_us 收到请求时的qos_now_us()
+ * @return int64_t 期限（qos_now_us()时间），没有期限返回0
+ */
+int64_t protocol_get_deadline_us(cJSON *root, int64_t start_us)
+{
+    int64_t deadline_us = 0;
+    bool has_deadline = false;
+
+    cJSON *timeout_item = cJSON_GetObjectItemCaseSensitive(root, "timeout_ms");
+    if (cJSON_IsNumber(timeout_item) && timeout_item->valuedouble > 0)
+    {
+        deadline_us = start_us + (int64_t)(timeout_item->valuedouble * 1000.0);
+        has_deadline = true;
+    }
+
+    cJSON *deadline_item = cJSON_GetObjectItemCaseSensitive(root, "deadline_ms");
+    if (cJSON_IsNumber(deadline_item) && deadline_item->valuedouble > 0)
+    {
+        // 墙上时钟的期限换算为单调时钟，之后不受系统时间调整影响
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int64_t now_ms = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+        int64_t absolute_us = start_us + ((int64_t)deadline_item->valuedouble - now_ms) * 1000;
+        if (!has_deadline || absolute_us < deadline_us)
+        {
+            deadline_us = absolute_us;
+        }
+        has_deadline = true;
+    }
+
+    // 0保留表示没有期限，早已过去的期限统一记为1
+    if (has_deadline && deadline_us <= 0)
+    {
+        deadline_us = 1;
+    }
+    return deadline_us;
+}
+
+/**
+ * @brief 期限是否已过
+ *
+ * @param deadline_us protocol_get_deadline_us()返回的期限，0表示没有期限
+ * @return bool 已过返回true
+ */
+bool protocol_deadline_expired(int64_t deadline_us)
+{
+    return deadline_us > 0 && qos_now_us() >= deadline_us;
+}
+
 /**
  * @brief 创建标准响应JSON对象
  *
@@ -88,6 +144,8 @@ int protocol_send_response(struct mg_connection *conn, cJSON *response)
         return -1;
     }
 
+    metrics_trace_annotate(response);
+    int64_t serialize_start = qos_now_us();
     char *response_str = cJSON_PrintUnformatted(response);
     if (!response_str)
     {
@@ -95,7 +153,10 @@ int protocol_send_response(struct mg_connection *conn, cJSON *response)
         return -1;
     }
 
+    int64_t send_start = qos_now_us();
+    metrics_observe_stage(METRICS_STAGE_SERIALIZE, send_start - serialize_start);
     int n = ws_send_text(conn, response_str);
+    metrics_observe_stage(METRICS_STAGE_SEND, qos_now_us() - send_start);
     if (n < 0)
     {
         printf("protocol_send_response: Failed to send response\n");
@@ -129,4 +190,45 @@ int protocol_send_standard_response(struct mg_connection *conn, const char *resp
     int ret = protocol_send_response(conn, response);
     cJSON_Delete(response);
     return ret;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 处理会话恢复请求
+ *
+ * @param conn WebSocket连接指针
+ * @param path 连接路径
+ * @param response_type 响应类型字符串
+ * @param request_id 请求ID字符串
+ * @param data 请求data对象
+ * @param snapshot 生成快照的函数
+ * @return cJSON* 响应JSON对象，需调用者释放
+ */
+cJSON *protocol_resume(struct mg_connection *conn, const char *path, const char *response_type,
+                       const char *request_id, cJSON *data, protocol_snapshot_fn snapshot)
+{
+    cJSON *epoch_item = data ? cJSON_GetObjectItemCaseSensitive(data, "epoch") : NULL;
+    cJSON *seq_item = data ? cJSON_GetObjectItemCaseSensitive(data, "last_seq") : NULL;
+    bool has_position = cJSON_IsNumber(epoch_item) && cJSON_IsNumber(seq_item) &&
+                        epoch_item->valuedouble > 0 && seq_item->valuedouble >= 0;
+
+    ws_resume_result result;
+    ws_resume_connection(conn, path, has_position,
+                         has_position ? (uint64_t)epoch_item->valuedouble : 0,
+                         has_position ? (uint64_t)seq_item->valuedouble : 0, &result);
+
+    cJSON *response = protocol_create_response(response_type, request_id, true, 0);
+    cJSON *res_data = response ? cJSON_GetObjectItem(response, "data") : NULL;
+    if (res_data)
+    {
+        cJSON_AddNumberToObject(res_data, "epoch", (double)result.epoch);
+        cJSON_AddNumberToObject(res_data, "seq", (double)result.seq);
+        cJSON_AddBoolToObject(res_data, "resumed", result.resumed);
+        cJSON_AddNumberToObject(res_data, "replayed", result.replayed);
+        cJSON *snap = (!result.resumed && snapshot) ? snapshot() : NULL;
+        if (snap)
+        {
+            cJSON_AddItemToObject(res_data, "snapshot", snap);
+        }
+    }
+    return response;
+}
@@ -30,6 +30,14 @@ limitations under the License.
 #include "civetweb.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 生成模块的精简状态快照
+ *
+ * @return cJSON* 快照对象（调用者释放），失败返回NULL
+ */
+typedef cJSON *(*protocol_snapshot_fn)(void);
 
 /**
  * @brief 从JSON对象中获取request_id
@@ -39,6 +47,26 @@ limitations under the License.
  */
 const char *protocol_get_request_id(cJSON *root);
 
+/**
+ * @brief 从请求外层获取客户端给出的期限
+ *
+ * deadline_ms为绝对期限（Unix毫秒时间戳），timeout_ms为从收到请求起的毫秒数，
+ * 两者都给出时取较早者；非正数视为未给出。
+ *
+ * @param root JSON根对象
+ * @param start_us 收到请求时的qos_now_us()
+ * @return int64_t 期限（qos_now_us()时间），没有期限返回0
+ */
+int64_t protocol_get_deadline_us(cJSON *root, int64_t start_us);
+
+/**
+ * @brief 期限是否已过
+ *
+ * @param deadline_us protocol_get_deadline_us()返回的期限，0表示没有期限
+ * @return bool 已过返回true
+ */
+bool protocol_deadline_expired(int64_t deadline_us);
+
 /**
  * @brief 创建标准响应JSON对象
  *
@@ -73,4 +101,21 @@ int protocol_send_response(struct mg_connection *conn, cJSON *response);
 int protocol_send_standard_response(struct mg_connection *conn, const char *response_type,
                                     const char *request_id, bool success, int error_code);
 
+/**
+ * @brief 处理会话恢复请求
+ *
+ * data中的epoch与last_seq为客户端上次收到的推送位置。能补发时先向连接补发错过的事件，
+ * 否则在响应的data.snapshot中附带snapshot生成的精简快照，客户端据此替换本地状态。
+ *
+ * @param conn WebSocket连接指针
+ * @param path 连接路径（推送事件所在的路径）
+ * @param response_type 响应类型字符串
+ * @param request_id 请求ID字符串
+ * @param data 请求data对象（可为NULL，视为首次连接）
+ * @param snapshot 生成快照的函数
+ * @return cJSON* 响应JSON对象，需要调用者释放
+ */
+cJSON *protocol_resume(struct mg_connection *conn, const char *path, const char *response_type,
+                       const char *request_id, cJSON *data, protocol_snapshot_fn snapshot);
+
 #endif
\ No newline at end of file
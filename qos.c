@@ -0,0 +1,220 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file qos.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 请求延迟等级（QoS）统计实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "qos.h"
+#include "metrics.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *const g_qos_class_names[QOS_CLASS_COUNT] = {
+    "interactive",
+    "normal",
+    "background",
+};
+
+static const int64_t g_qos_class_budgets_us[QOS_CLASS_COUNT] = {
+    QOS_INTERACTIVE_BUDGET_US,
+    QOS_NORMAL_BUDGET_US,
+    0,
+};
+
+// 统计只做原子累加，不加锁，记录路径不会阻塞请求线程
+static qos_class_stats g_qos_stats[QOS_CLASS_COUNT];
+
+// 各等级上次输出超预算日志的时间与期间被省略的次数
+static int64_t g_qos_last_log_us[QOS_CLASS_COUNT];
+static uint64_t g_qos_suppressed[QOS_CLASS_COUNT];
+
+/**
+ * @brief 获取单调时钟微秒数
+ *
+ * @return int64_t 微秒
+ */
+int64_t qos_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief 获取等级名称
+ *
+ * @param cls 等级
+ * @return const char* 名称
+ */
+const char *qos_class_name(qos_class_t cls)
+{
+    if (cls < 0 || cls >= QOS_CLASS_COUNT)
+    {
+        return "unknown";
+    }
+    return g_qos_class_names[cls];
+}
+
+/**
+ * @brief 获取等级的延迟预算
+ *
+ * @param cls 等级
+ * @return int64_t 预算(微秒)，0表示不设预算
+ */
+int64_t qos_class_budget_us(qos_class_t cls)
+{
+    if (cls < 0 || cls >= QOS_CLASS_COUNT)
+    {
+        return 0;
+    }
+    return g_qos_class_budgets_us[cls];
+}
+
+/**
+ * @brief 记录一次请求从收到到响应发出的延迟
+ *
+ * @param cls 等级
+ * @param request_type 请求类型
+ * @param start_us 收到请求时的qos_now_us()
+ */
+void qos_record(qos_class_t cls, const char *request_type, int64_t start_us)
+{
+    if (cls < 0 || cls >= QOS_CLASS_COUNT)
+    {
+        return;
+    }
+
+    int64_t elapsed = qos_now_us() - start_us;
+    uint64_t latency_us = elapsed > 0 ? (uint64_t)elapsed : 0;
+    qos_class_stats *stats = &g_qos_stats[cls];
+    metrics_observe_request(request_type, elapsed);
+
+    __atomic_fetch_add(&stats->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->total_us, latency_us, __ATOMIC_RELAXED);
+
+    uint64_t prev_max = __atomic_load_n(&stats->max_us, __ATOMIC_RELAXED);
+    while (latency_us > prev_max &&
+           !__atomic_compare_exchange_n(&stats->max_us, &prev_max, latency_us, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    int bucket = 0;
+    while (bucket < QOS_HISTOGRAM_BUCKETS - 1 && latency_us > (1000ULL << bucket))
+    {
+        bucket++;
+    }
+    __atomic_fetch_add(&stats->buckets[bucket], 1, __ATOMIC_RELAXED);
+
+    int64_t budget = g_qos_class_budgets_us[cls];
+    if (budget > 0 && latency_us > (uint64_t)budget)
+    {
+        __atomic_fetch_add(&stats->over_budget, 1, __ATOMIC_RELAXED);
+
+        // 日志限速：每个等级每QOS_OVER_BUDGET_LOG_INTERVAL_US最多一行，其余只计数
+        int64_t now = start_us + elapsed;
+        int64_t last = __atomic_load_n(&g_qos_last_log_us[cls], __ATOMIC_RELAXED);
+        if ((last != 0 && now - last < QOS_OVER_BUDGET_LOG_INTERVAL_US) ||
+            !__atomic_compare_exchange_n(&g_qos_last_log_us[cls], &last, now, false,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            __atomic_fetch_add(&g_qos_suppressed[cls], 1, __ATOMIC_RELAXED);
+            return;
+        }
+        uint64_t suppressed = __atomic_exchange_n(&g_qos_suppressed[cls], 0, __ATOMIC_RELAXED);
+        fprintf(stderr, "qos: %s 请求 %s 耗时 %llu us，超出预算 %lld us（此前省略 %llu 条）\n",
+                g_qos_class_names[cls], request_type ? request_type : "?",
+                (unsigned long long)latency_us, (long long)budget,
+                (unsigned long long)suppressed);
+    }
+}
+
+/**
+ * @brief 读取等级的延迟统计
+ *
+ * @param cls 等级
+ * @param out 输出统计
+ */
+void qos_get_stats(qos_class_t cls, qos_class_stats *out)
+{
+    if (!out)
+    {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (cls < 0 || cls >= QOS_CLASS_COUNT)
+    {
+        return;
+    }
+
+    const qos_class_stats *stats = &g_qos_stats[cls];
+    out->count = __atomic_load_n(&stats->count, __ATOMIC_RELAXED);
+    out->total_us = __atomic_load_n(&stats->total_us, __ATOMIC_RELAXED);
+    out->max_us = __atomic_load_n(&stats->max_us, __ATOMIC_RELAXED);
+    out->over_budget = __atomic_load_n(&stats->over_budget, __ATOMIC_RELAXED);
+    for (int i = 0; i < QOS_HISTOGRAM_BUCKETS; i++)
+    {
+        out->buckets[i] = __atomic_load_n(&stats->buckets[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 将调用线程调整为指定等级的调度优先级
+ *
+ * @param cls 等级
+ */
+void qos_apply_thread_class(qos_class_t cls)
+{
+    if (cls != QOS_CLASS_BACKGROUND)
+    {
+        return;
+    }
+
+    // Linux下nice值按线程生效，需使用线程ID而非进程ID
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    if (setpriority(PRIO_PROCESS, (id_t)tid, QOS_BACKGROUND_NICE) != 0)
+    {
+        perror("qos_apply_thread_class: setpriority");
+    }
+}
+
+/**
+ * @brief 打印各等级延迟统计
+ */
+void qos_log_stats(void)
+{
+    for (int cls = 0; cls < QOS_CLASS_COUNT; cls++)
+    {
+        qos_class_stats stats;
+        qos_get_stats((qos_class_t)cls, &stats);
+        unsigned long long avg = stats.count ? stats.total_us / stats.count : 0;
+        printf("qos: %-11s count=%llu avg=%lluus max=%lluus over_budget=%llu\n",
+               g_qos_class_names[cls], (unsigned long long)stats.count, avg,
+               (unsigned long long)stats.max_us, (unsigned long long)stats.over_budget);
+    }
+}
@@ -0,0 +1,132 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file qos.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 请求延迟等级（QoS）定义与统计接口
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#ifndef QOS_H
+#define QOS_H
+
+#include <stdint.h>
+
+/**
+ * @brief 请求延迟等级
+ *
+ * - 交互类：在WebSocket工作线程内直接执行，必须在一帧内完成（如拖动亮度滑块）
+ * - 普通类：只读查询，已有未过期的记录时在WebSocket工作线程内直接应答，
+ *   需要访问后端时交给模块的读工作线程
+ * - 后台类：耗时的硬件操作，只允许在模块自己的低优先级工作线程中执行，
+ *   不占用WebSocket工作线程，因此不会阻塞交互类请求
+ */
+typedef enum
+{
+    QOS_CLASS_INTERACTIVE = 0, ///< 交互类
+    QOS_CLASS_NORMAL,          ///< 普通类
+    QOS_CLASS_BACKGROUND,      ///< 后台类
+    QOS_CLASS_COUNT
+} qos_class_t;
+
+#ifndef QOS_INTERACTIVE_BUDGET_US
+#define QOS_INTERACTIVE_BUDGET_US 16000 ///< 交互类延迟预算（约一帧）
+#endif
+
+#ifndef QOS_NORMAL_BUDGET_US
+#define QOS_NORMAL_BUDGET_US 500000 ///< 普通类延迟预算
+#endif
+
+#ifndef QOS_BACKGROUND_NICE
+#define QOS_BACKGROUND_NICE 10 ///< 后台工作线程的nice值
+#endif
+
+#ifndef QOS_OVER_BUDGET_LOG_INTERVAL_US
+#define QOS_OVER_BUDGET_LOG_INTERVAL_US 1000000 ///< 每个等级超预算日志的最小间隔(微秒)
+#endif
+
+#define QOS_HISTOGRAM_BUCKETS 12 ///< 延迟直方图桶数（1ms起按2倍递增，最后一桶为溢出桶）
+
+/**
+ * @brief 单个等级的延迟统计
+ */
+typedef struct
+{
+    uint64_t count;                          ///< 请求数
+    uint64_t total_us;                       ///< 累计延迟(微秒)
+    uint64_t max_us;                         ///< 最大延迟(微秒)
+    uint64_t over_budget;                    ///< 超出预算的请求数
+    uint64_t buckets[QOS_HISTOGRAM_BUCKETS]; ///< 延迟直方图，第i桶上界为(1<<i)毫秒
+} qos_class_stats;
+
+/**
+ * @brief 获取单调时钟微秒数
+ *
+ * @return int64_t 微秒
+ */
+int64_t qos_now_us(void);
+
+/**
+ * @brief 获取等级名称
+ *
+ * @param cls 等级
+ * @return const char* 名称（interactive/normal/background）
+ */
+const char *qos_class_name(qos_class_t cls);
+
+/**
+ * @brief 获取等级的延迟预算
+ *
+ * @param cls 等级
+ * @return int64_t 预算(微秒)，0表示不设预算
+ */
+int64_t qos_class_budget_us(qos_class_t cls);
+
+/**
+ * @brief 记录一次请求从收到到响应发出的延迟
+ *
+ * @param cls 等级
+ * @param request_type 请求类型（超出预算时用于日志）
+ * @param start_us 收到请求时的qos_now_us()
+ */
+void qos_record(qos_class_t cls, const char *request_type, int64_t start_us);
+
+/**
+ * @brief 读取等级的延迟统计
+ *
+ * @param cls 等级
+ * @param out 输出统计
+ */
+void qos_get_stats(qos_class_t cls, qos_class_stats *out);
+
+/**
+ * @brief 将调用线程调整为指定等级的调度优先级
+ *
+ * 后台类线程降低nice值，其派生的子进程（如wpa_cli）同样继承较低优先级。
+ *
+ * @param cls 等级
+ */
+void qos_apply_thread_class(qos_class_t cls);
+
+/**
+ * @brief 打印各等级延迟统计
+ */
+void qos_log_stats(void);
+
+#endif
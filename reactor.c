@@ -0,0 +1,421 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file reactor.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 后端事件循环（epoll）实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ */
+#include "reactor.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define REACTOR_WAKE_TOKEN UINT64_MAX ///< 唤醒eventfd在epoll中的标识
+
+/**
+ * @brief 已注册的事件源
+ */
+typedef struct
+{
+    bool used;                 ///< 是否已注册
+    bool timer;                ///< 是否为定时器（事件线程负责读取到期次数）
+    int fd;                    ///< 描述符
+    uint32_t gen;              ///< 注册代数，用于丢弃已注销事件源的残留事件
+    reactor_fd_fn fd_fn;       ///< 描述符就绪回调
+    reactor_timer_fn timer_fn; ///< 定时器到期回调
+    void *arg;                 ///< 回调参数
+} reactor_source;
+
+/**
+ * @brief 事件循环状态
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                        ///< 保护以下字段
+    pthread_cond_t idle;                         ///< 回调执行完毕
+    pthread_t thread;                            ///< 事件线程
+    bool started;                                ///< 事件线程是否已启动
+    bool stop;                                   ///< 是否请求退出
+    int epoll_fd;                                ///< epoll实例
+    int wake_fd;                                 ///< 用于唤醒线程退出的eventfd
+    int running;                                 ///< 正在执行回调的事件源，-1表示没有
+    reactor_source sources[REACTOR_MAX_SOURCES]; ///< 事件源表
+} reactor;
+
+static reactor g_reactor = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+    .epoll_fd = -1,
+    .wake_fd = -1,
+    .running = -1,
+};
+
+/**
+ * @brief 当前线程是否为事件线程
+ *
+ * @param r 事件循环
+ * @return bool 是否为事件线程
+ */
+static bool reactor_in_thread(const reactor *r)
+{
+    return r->started && pthread_equal(pthread_self(), r->thread);
+}
+
+/**
+ * @brief 执行一个就绪事件源的回调
+ *
+ * @param r 事件循环
+ * @param ev epoll事件
+ */
+static void reactor_dispatch(reactor *r, const struct epoll_event *ev)
+{
+    int index = (int)(ev->data.u64 & 0xffffffffu);
+    uint32_t gen = (uint32_t)(ev->data.u64 >> 32);
+
+    pthread_mutex_lock(&r->lock);
+    reactor_source *src = &r->sources[index];
+    if (!src->used || src->gen != gen)
+    {
+        // 同一批事件中前面的回调已注销该事件源
+        pthread_mutex_unlock(&r->lock);
+        return;
+    }
+    reactor_source call = *src;
+    r->running = index;
+    pthread_mutex_unlock(&r->lock);
+
+    if (call.timer)
+    {
+        // 读取前被重新设置或停止时没有到期次数可读，本次不回调
+        uint64_t expirations = 0;
+        if (read(call.fd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations))
+        {
+            call.timer_fn(call.arg);
+        }
+    }
+    else
+    {
+        call.fd_fn(call.fd, ev->events, call.arg);
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->running = -1;
+    pthread_cond_broadcast(&r->idle);
+    pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief 事件线程：等待任一事件源就绪并依次执行回调
+ *
+ * @param arg 事件循环
+ * @return void* 始终为NULL
+ */
+static void *reactor_worker(void *arg)
+{
+    reactor *r = (reactor *)arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    for (;;)
+    {
+        int n = epoll_wait(r->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("reactor: epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.u64 == REACTOR_WAKE_TOKEN)
+            {
+                continue;
+            }
+            reactor_dispatch(r, &events[i]);
+        }
+
+        pthread_mutex_lock(&r->lock);
+        bool stop = r->stop;
+        pthread_mutex_unlock(&r->lock);
+        if (stop)
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 关闭epoll实例与唤醒eventfd
+ *
+ * @param r 事件循环
+ */
+static void reactor_close_fds(reactor *r)
+{
+    if (r->wake_fd >= 0)
+    {
+        close(r->wake_fd);
+        r->wake_fd = -1;
+    }
+    if (r->epoll_fd >= 0)
+    {
+        close(r->epoll_fd);
+        r->epoll_fd = -1;
+    }
+}
+
+/**
+ * @brief 启动事件线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int reactor_init(void)
+{
+    reactor *r = &g_reactor;
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    r->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = REACTOR_WAKE_TOKEN};
+    if (r->epoll_fd < 0 || r->wake_fd < 0 ||
+        epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->wake_fd, &ev) != 0)
+    {
+        perror("reactor_init: epoll");
+        reactor_close_fds(r);
+        return -1;
+    }
+
+    r->stop = false;
+    if (pthread_create(&r->thread, NULL, reactor_worker, r) != 0)
+    {
+        fprintf(stderr, "reactor_init: 无法创建事件线程\n");
+        reactor_close_fds(r);
+        return -1;
+    }
+    r->started = true;
+    return 0;
+}
+
+/**
+ * @brief 停止事件线程
+ */
+void reactor_deinit(void)
+{
+    reactor *r = &g_reactor;
+    if (!r->started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->stop = true;
+    pthread_mutex_unlock(&r->lock);
+    uint64_t one = 1;
+    if (write(r->wake_fd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+    {
+        perror("reactor_deinit: write");
+    }
+    pthread_join(r->thread, NULL);
+    r->started = false;
+
+    for (int i = 0; i < REACTOR_MAX_SOURCES; i++)
+    {
+        if (r->sources[i].used)
+        {
+            fprintf(stderr, "reactor_deinit: 描述符 %d 未注销\n", r->sources[i].fd);
+            r->sources[i].used = false;
+        }
+    }
+    reactor_close_fds(r);
+}
+
+/**
+ * @brief 登记事件源并加入epoll
+ *
+ * @param r 事件循环
+ * @param fd 描述符
+ * @param events 关注的epoll事件
+ * @param src 事件源模板（回调与参数）
+ * @return int 成功返回0，失败返回-1
+ */
+static int reactor_register(reactor *r, int fd, uint32_t events, const reactor_source *src)
+{
+    if (!r->started || fd < 0)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    int index = -1;
+    for (int i = 0; i < REACTOR_MAX_SOURCES; i++)
+    {
+        if (!r->sources[i].used)
+        {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0)
+    {
+        pthread_mutex_unlock(&r->lock);
+        fprintf(stderr, "reactor: 事件源已满 (REACTOR_MAX_SOURCES=%d)\n", REACTOR_MAX_SOURCES);
+        return -1;
+    }
+
+    reactor_source *slot = &r->sources[index];
+    uint32_t gen = slot->gen;
+    *slot = *src;
+    slot->gen = gen;
+    slot->fd = fd;
+    struct epoll_event ev = {.events = events,
+                             .data.u64 = ((uint64_t)gen << 32) | (uint32_t)index};
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        perror("reactor: epoll_ctl");
+        pthread_mutex_unlock(&r->lock);
+        return -1;
+    }
+    slot->used = true;
+    pthread_mutex_unlock(&r->lock);
+    return 0;
+}
+
+/**
+ * @brief 注册描述符
+ *
+ * @param fd 描述符
+ * @param events 关注的epoll事件
+ * @param fn 就绪回调
+ * @param arg 回调参数
+ * @return int 成功返回0，失败返回-1
+ */
+int reactor_add(int fd, uint32_t events, reactor_fd_fn fn, void *arg)
+{
+    const reactor_source src = {.fd_fn = fn, .arg = arg};
+    return fn ? reactor_register(&g_reactor, fd, events, &src) : -1;
+}
+
+/**
+ * @brief 注销描述符，等待其正在执行的回调结束
+ *
+ * @param fd 描述符
+ */
+void reactor_remove(int fd)
+{
+    reactor *r = &g_reactor;
+    if (fd < 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    for (int i = 0; i < REACTOR_MAX_SOURCES; i++)
+    {
+        reactor_source *src = &r->sources[i];
+        if (!src->used || src->fd != fd)
+        {
+            continue;
+        }
+        epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        src->used = false;
+        src->gen++;
+        while (r->running == i && !reactor_in_thread(r))
+        {
+            pthread_cond_wait(&r->idle, &r->lock);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief 创建定时器
+ *
+ * @param fn 到期回调
+ * @param arg 回调参数
+ * @return int 定时器描述符，失败返回-1
+ */
+int reactor_timer_create(reactor_timer_fn fn, void *arg)
+{
+    if (!fn)
+    {
+        return -1;
+    }
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0)
+    {
+        perror("reactor_timer_create: timerfd_create");
+        return -1;
+    }
+    const reactor_source src = {.timer = true, .timer_fn = fn, .arg = arg};
+    if (reactor_register(&g_reactor, fd, EPOLLIN, &src) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 设置定时器
+ *
+ * @param timer 定时器描述符
+ * @param first_ms 首次到期延迟(毫秒)，不大于0表示停止定时器
+ * @param interval_ms 周期(毫秒)，0表示只触发一次
+ */
+void reactor_timer_arm(int timer, int first_ms, int interval_ms)
+{
+    if (timer < 0)
+    {
+        return;
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (first_ms > 0)
+    {
+        its.it_value.tv_sec = first_ms / 1000;
+        its.it_value.tv_nsec = (long)(first_ms % 1000) * 1000000L;
+        its.it_interval.tv_sec = interval_ms / 1000;
+        its.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    }
+    timerfd_settime(timer, 0, &its, NULL);
+}
+
+/**
+ * @brief 注销并关闭定时器
+ *
+ * @param timer 定时器描述符
+ */
+void reactor_timer_destroy(int timer)
+{
+    if (timer < 0)
+    {
+        return;
+    }
+    reactor_remove(timer);
+    close(timer);
+}
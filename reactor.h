@@ -0,0 +1,120 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file reactor.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 后端事件循环（epoll）声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 所有后端事件源（sysfs通知、渐变与采样定时器、延迟写入等）共用一个epoll线程，
+ * 各模块只注册描述符与回调，不再各自创建线程。回调在事件线程内串行执行，
+ * 不得阻塞；需要推送的结果直接经ws_broadcast_event等发送路径发出。
+ */
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdint.h>
+
+#ifndef REACTOR_MAX_SOURCES
+#define REACTOR_MAX_SOURCES 32 ///< 可同时注册的描述符与定时器总数
+#endif
+
+#define REACTOR_MAX_EVENTS 16 ///< 单次epoll_wait取回的事件数
+
+/**
+ * @brief 描述符就绪回调
+ *
+ * @param fd 就绪的描述符
+ * @param events epoll返回的事件
+ * @param arg 注册时传入的参数
+ */
+typedef void (*reactor_fd_fn)(int fd, uint32_t events, void *arg);
+
+/**
+ * @brief 定时器到期回调
+ *
+ * @param arg 创建时传入的参数
+ */
+typedef void (*reactor_timer_fn)(void *arg);
+
+/**
+ * @brief 启动事件线程
+ *
+ * 须在各模块初始化之前调用。
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int reactor_init(void);
+
+/**
+ * @brief 停止事件线程
+ *
+ * 须在各模块注销全部事件源之后调用。
+ */
+void reactor_deinit(void);
+
+/**
+ * @brief 注册描述符
+ *
+ * 描述符仍归调用者所有，注销后由调用者关闭。
+ *
+ * @param fd 描述符
+ * @param events 关注的epoll事件（如EPOLLIN、EPOLLPRI）
+ * @param fn 就绪回调
+ * @param arg 回调参数
+ * @return int 成功返回0，失败返回-1
+ */
+int reactor_add(int fd, uint32_t events, reactor_fd_fn fn, void *arg);
+
+/**
+ * @brief 注销描述符
+ *
+ * 返回后该描述符的回调不会再被调用，也不在执行中（在回调内注销自身时除外），
+ * 因此调用者不得在持有回调会获取的锁时调用。
+ *
+ * @param fd 描述符
+ */
+void reactor_remove(int fd);
+
+/**
+ * @brief 创建定时器（创建后处于停止状态）
+ *
+ * @param fn 到期回调
+ * @param arg 回调参数
+ * @return int 定时器描述符，失败返回-1
+ */
+int reactor_timer_create(reactor_timer_fn fn, void *arg);
+
+/**
+ * @brief 设置定时器，可在任意线程调用，重新设置即替换之前的计划
+ *
+ * @param timer 定时器描述符
+ * @param first_ms 首次到期延迟(毫秒)，不大于0表示停止定时器
+ * @param interval_ms 周期(毫秒)，0表示只触发一次
+ */
+void reactor_timer_arm(int timer, int first_ms, int interval_ms);
+
+/**
+ * @brief 注销并关闭定时器（与reactor_remove相同的返回保证）
+ *
+ * @param timer 定时器描述符
+ */
+void reactor_timer_destroy(int timer);
+
+#endif
@@ -0,0 +1,514 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file state_store.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 设备状态存储实现
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 回收方式：每个线程首次进入读区间时登记一个读者槽，进入时写入当前全局纪元，离开时清零。
+ * 写者替换记录指针后把全局纪元加一，旧记录带着替换时的纪元进入待回收链表；
+ * 所有仍在读区间内的读者纪元都大于该纪元时，说明它们都是在替换之后进入的，旧记录即可释放。
+ */
+#include "state_store.h"
+#include "metrics.h"
+#include "qos.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STATE_STORE_REFRESH_ATTEMPTS 3 ///< 单个调用者最多刷新的次数（结果过时或发布失败时重试）
+
+/**
+ * @brief 记录节点（文本紧跟在节点之后）
+ */
+typedef struct state_node
+{
+    state_record record;     ///< 对外可见的记录
+    struct state_node *next; ///< 待回收链表中的下一个节点
+    uint64_t retire_epoch;   ///< 被替换时的全局纪元
+} state_node;
+
+/**
+ * @brief 线程的读者槽
+ */
+typedef struct state_reader
+{
+    struct state_reader *next; ///< 链表中的下一个读者槽
+    uint64_t epoch;            ///< 进入读区间时的全局纪元，0表示不在读区间内
+} state_reader;
+
+/**
+ * @brief 单个状态键
+ */
+typedef struct
+{
+    pthread_mutex_t lock; ///< 写者锁：串行发布、失效与刷新协调
+    pthread_cond_t cond;  ///< 刷新完成通知
+    bool refreshing;      ///< 是否有调用者正在刷新
+    uint64_t generation;  ///< 失效计数，刷新期间变化说明结果可能已过时
+    state_node *current;  ///< 当前记录（原子访问）
+    int64_t refreshed_us; ///< 最近一次刷新时间，0表示已失效（原子访问）
+    pthread_mutex_t notify_lock; ///< 回调锁：串行版本变化回调，不阻塞读者与写者
+    state_watch_fn watch;        ///< 版本变化回调（notify_lock保护）
+    uint64_t notified;           ///< 最近一次回调的版本号（notify_lock保护）
+} state_slot;
+
+#define STATE_SLOT_INITIALIZER                                                                     \
+    {.lock = PTHREAD_MUTEX_INITIALIZER,                                                            \
+     .cond = PTHREAD_COND_INITIALIZER,                                                             \
+     .notify_lock = PTHREAD_MUTEX_INITIALIZER}
+
+static state_slot g_slots[STATE_KEY_COUNT] = {
+    [STATE_WIFI_STATUS] = STATE_SLOT_INITIALIZER,
+    [STATE_WIFI_SCAN] = STATE_SLOT_INITIALIZER,
+};
+
+static uint64_t g_epoch = 1;        ///< 全局纪元，每替换一次记录加一
+static uint64_t g_unregistered = 0; ///< 未能登记读者槽的读区间数，非0时暂停回收
+
+static pthread_mutex_t g_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+static state_reader *g_readers = NULL;
+
+static pthread_mutex_t g_retired_lock = PTHREAD_MUTEX_INITIALIZER;
+static state_node *g_retired = NULL;
+
+static __thread state_reader *t_reader = NULL;
+static __thread unsigned t_depth = 0;
+
+/**
+ * @brief 获取当前线程的读者槽，首次调用时登记
+ *
+ * 读者槽随线程保留，线程退出后槽一直处于空闲状态，不影响回收。
+ *
+ * @return state_reader* 分配失败返回NULL
+ */
+static state_reader *state_reader_get(void)
+{
+    if (t_reader)
+    {
+        return t_reader;
+    }
+    state_reader *reader = (state_reader *)calloc(1, sizeof(state_reader));
+    if (!reader)
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&g_readers_lock);
+    reader->next = g_readers;
+    __atomic_store_n(&g_readers, reader, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_readers_lock);
+    t_reader = reader;
+    return reader;
+}
+
+/**
+ * @brief 等待他人的刷新完成（调用者持有slot->lock）
+ *
+ * @param slot 状态键
+ * @param deadline_us 等待期限（qos_now_us()时间），0表示不限
+ * @return bool 期限已到返回true
+ */
+static bool state_wait_refresh(state_slot *slot, int64_t deadline_us)
+{
+    if (deadline_us <= 0)
+    {
+        pthread_cond_wait(&slot->cond, &slot->lock);
+        return false;
+    }
+    int64_t remaining_us = deadline_us - qos_now_us();
+    if (remaining_us <= 0)
+    {
+        return true;
+    }
+    // 条件变量使用实时时钟，期限按剩余时间换算
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t nsec = ts.tv_nsec + (remaining_us % 1000000) * 1000;
+    ts.tv_sec += (time_t)(remaining_us / 1000000 + nsec / 1000000000);
+    ts.tv_nsec = (long)(nsec % 1000000000);
+    pthread_cond_timedwait(&slot->cond, &slot->lock, &ts);
+    return qos_now_us() >= deadline_us;
+}
+
+/**
+ * @brief 进入读区间
+ */
+void state_store_enter(void)
+{
+    if (t_depth++ > 0)
+    {
+        return;
+    }
+    state_reader *reader = state_reader_get();
+    if (!reader)
+    {
+        // 没有读者槽时退化为全局计数：计数非0期间不释放任何记录
+        __atomic_add_fetch(&g_unregistered, 1, __ATOMIC_SEQ_CST);
+        return;
+    }
+    // 纪元必须先于记录指针对写者可见，写者据此判断本线程是否可能持有旧记录
+    __atomic_store_n(&reader->epoch, __atomic_load_n(&g_epoch, __ATOMIC_SEQ_CST),
+                     __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief 离开读区间
+ */
+void state_store_leave(void)
+{
+    if (t_depth == 0 || --t_depth > 0)
+    {
+        return;
+    }
+    if (t_reader)
+    {
+        __atomic_store_n(&t_reader->epoch, 0, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        __atomic_sub_fetch(&g_unregistered, 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief 释放已没有读者引用的旧记录（调用者持有g_retired_lock）
+ */
+static void state_reclaim_locked(void)
+{
+    if (__atomic_load_n(&g_unregistered, __ATOMIC_SEQ_CST) > 0)
+    {
+        return;
+    }
+    uint64_t oldest = UINT64_MAX;
+    for (state_reader *reader = __atomic_load_n(&g_readers, __ATOMIC_ACQUIRE); reader;
+         reader = reader->next)
+    {
+        uint64_t epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+
+    state_node **link = &g_retired;
+    while (*link)
+    {
+        state_node *node = *link;
+        if (node->retire_epoch < oldest)
+        {
+            *link = node->next;
+            metrics_free(node);
+        }
+        else
+        {
+            link = &node->next;
+        }
+    }
+}
+
+/**
+ * @brief 旧记录进入待回收链表，并尝试回收
+ *
+ * @param node 已被替换的记录
+ */
+static void state_retire(state_node *node)
+{
+    node->retire_epoch = __atomic_fetch_add(&g_epoch, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&g_retired_lock);
+    node->next = g_retired;
+    g_retired = node;
+    state_reclaim_locked();
+    pthread_mutex_unlock(&g_retired_lock);
+}
+
+/**
+ * @brief 以当前记录调用版本变化回调（不持有写者锁）
+ *
+ * 回调锁串行同一键的回调；并发发布时后到者可能已看到更新的版本，
+ * 只回调尚未通知过的当前版本，中间版本被合并，回调看到的版本单调递增。
+ *
+ * @param key 状态键
+ */
+static void state_notify(state_key_t key)
+{
+    state_slot *slot = &g_slots[key];
+    state_store_enter();
+    pthread_mutex_lock(&slot->notify_lock);
+    state_node *node = __atomic_load_n(&slot->current, __ATOMIC_SEQ_CST);
+    if (slot->watch && node && node->record.version > slot->notified)
+    {
+        slot->notified = node->record.version;
+        slot->watch(key, &node->record);
+    }
+    pthread_mutex_unlock(&slot->notify_lock);
+    state_store_leave();
+}
+
+/**
+ * @brief 发布状态
+ *
+ * @param key 状态键
+ * @param generation 刷新开始时的失效计数，NULL表示不检查
+ * @param error 模块错误码
+ * @param data 与响应data相同结构的对象，NULL按空对象处理
+ * @return uint64_t 发布后的版本号；分配失败或刷新期间状态已失效返回0
+ */
+static uint64_t state_publish(state_key_t key, const uint64_t *generation, int error,
+                              const cJSON *data)
+{
+    state_slot *slot = &g_slots[key];
+    char *text = data ? cJSON_PrintUnformatted(data) : NULL;
+    if (data && !text)
+    {
+        return 0;
+    }
+    const char *body = text ? text : "{}";
+    size_t len = strlen(body);
+
+    pthread_mutex_lock(&slot->lock);
+    if (generation && *generation != slot->generation)
+    {
+        // 刷新期间有写操作完成，结果可能早于写操作，不发布
+        pthread_mutex_unlock(&slot->lock);
+        cJSON_free(text);
+        return 0;
+    }
+
+    state_node *prev = slot->current;
+    uint64_t version;
+    bool changed = false;
+    if (prev && prev->record.error == error && prev->record.len == len &&
+        memcmp(prev->record.text, body, len) == 0)
+    {
+        version = prev->record.version;
+        prev = NULL;
+    }
+    else
+    {
+        state_node *node =
+            (state_node *)metrics_malloc(METRICS_MODULE_CORE, sizeof(state_node) + len + 1);
+        if (!node)
+        {
+            pthread_mutex_unlock(&slot->lock);
+            cJSON_free(text);
+            return 0;
+        }
+        char *copy = (char *)(node + 1);
+        memcpy(copy, body, len + 1);
+        node->record.version = (prev ? prev->record.version : 0) + 1;
+        node->record.error = error;
+        node->record.text = copy;
+        node->record.len = len;
+        node->next = NULL;
+        node->retire_epoch = 0;
+        __atomic_store_n(&slot->current, node, __ATOMIC_SEQ_CST);
+        version = node->record.version;
+        changed = true;
+    }
+    __atomic_store_n(&slot->refreshed_us, qos_now_us(), __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&slot->lock);
+
+    if (changed)
+    {
+        state_notify(key);
+    }
+    if (prev)
+    {
+        state_retire(prev);
+    }
+    cJSON_free(text);
+    return version;
+}
+
+/**
+ * @brief 读取状态记录，过期或已失效时刷新
+ *
+ * @param key 状态键
+ * @param max_age_us 记录的最大允许年龄(微秒)
+ * @param refresh 刷新函数，NULL表示只读取当前记录
+ * @return const state_record* 当前记录，从未发布过时返回NULL
+ */
+const state_record *state_store_fetch(state_key_t key, int64_t max_age_us,
+                                      state_refresh_fn refresh, int64_t deadline_us)
+{
+    if (key < 0 || key >= STATE_KEY_COUNT)
+    {
+        return NULL;
+    }
+    state_slot *slot = &g_slots[key];
+    int attempts = 0;
+    for (;;)
+    {
+        state_node *node = __atomic_load_n(&slot->current, __ATOMIC_SEQ_CST);
+        int64_t refreshed_us = __atomic_load_n(&slot->refreshed_us, __ATOMIC_ACQUIRE);
+        int64_t now = qos_now_us();
+        bool fresh = refreshed_us > 0 && now - refreshed_us < max_age_us;
+        bool expired = deadline_us > 0 && now >= deadline_us;
+        if (!refresh || (node && fresh) || expired || attempts >= STATE_STORE_REFRESH_ATTEMPTS)
+        {
+            return node ? &node->record : NULL;
+        }
+
+        pthread_mutex_lock(&slot->lock);
+        if (slot->refreshing)
+        {
+            bool expired = state_wait_refresh(slot, deadline_us);
+            pthread_mutex_unlock(&slot->lock);
+            if (expired)
+            {
+                node = __atomic_load_n(&slot->current, __ATOMIC_SEQ_CST);
+                return node ? &node->record : NULL;
+            }
+            continue;
+        }
+        slot->refreshing = true;
+        uint64_t generation = slot->generation;
+        pthread_mutex_unlock(&slot->lock);
+
+        cJSON *data = NULL;
+        int error = refresh(key, &data);
+        state_publish(key, &generation, error, data);
+        cJSON_Delete(data);
+        attempts++;
+
+        pthread_mutex_lock(&slot->lock);
+        slot->refreshing = false;
+        pthread_cond_broadcast(&slot->cond);
+        pthread_mutex_unlock(&slot->lock);
+    }
+}
+
+/**
+ * @brief 读取未过期的状态记录，不刷新
+ *
+ * @param key 状态键
+ * @param max_age_us 记录的最大允许年龄(微秒)
+ * @return const state_record* 未过期的当前记录，否则NULL
+ */
+const state_record *state_store_peek(state_key_t key, int64_t max_age_us)
+{
+    if (key < 0 || key >= STATE_KEY_COUNT)
+    {
+        return NULL;
+    }
+    state_slot *slot = &g_slots[key];
+    state_node *node = __atomic_load_n(&slot->current, __ATOMIC_SEQ_CST);
+    int64_t refreshed_us = __atomic_load_n(&slot->refreshed_us, __ATOMIC_ACQUIRE);
+    bool fresh = refreshed_us > 0 && qos_now_us() - refreshed_us < max_age_us;
+    return (node && fresh) ? &node->record : NULL;
+}
+
+/**
+ * @brief 发布新读到的状态
+ *
+ * @param key 状态键
+ * @param error 模块错误码
+ * @param data 与响应data相同结构的对象，NULL按空对象处理
+ * @return uint64_t 发布后的版本号，失败返回0
+ */
+uint64_t state_store_publish(state_key_t key, int error, const cJSON *data)
+{
+    if (key < 0 || key >= STATE_KEY_COUNT)
+    {
+        return 0;
+    }
+    return state_publish(key, NULL, error, data);
+}
+
+/**
+ * @brief 标记状态失效
+ *
+ * @param key 状态键
+ */
+void state_store_invalidate(state_key_t key)
+{
+    if (key < 0 || key >= STATE_KEY_COUNT)
+    {
+        return;
+    }
+    state_slot *slot = &g_slots[key];
+    pthread_mutex_lock(&slot->lock);
+    slot->generation++;
+    __atomic_store_n(&slot->refreshed_us, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&slot->lock);
+}
+
+/**
+ * @brief 获取状态的当前版本号
+ *
+ * @param key 状态键
+ * @return uint64_t 版本号，从未发布过返回0
+ */
+uint64_t state_store_version(state_key_t key)
+{
+    state_store_enter();
+    const state_record *record = state_store_fetch(key, 0, NULL, 0);
+    uint64_t version = record ? record->version : 0;
+    state_store_leave();
+    return version;
+}
+
+/**
+ * @brief 注册版本变化回调
+ *
+ * @param key 状态键
+ * @param watch 回调，NULL表示取消
+ */
+void state_store_watch(state_key_t key, state_watch_fn watch)
+{
+    if (key < 0 || key >= STATE_KEY_COUNT)
+    {
+        return;
+    }
+    state_slot *slot = &g_slots[key];
+    pthread_mutex_lock(&slot->notify_lock);
+    slot->watch = watch;
+    pthread_mutex_unlock(&slot->notify_lock);
+}
+
+/**
+ * @brief 释放所有记录
+ */
+void state_store_deinit(void)
+{
+    for (int i = 0; i < STATE_KEY_COUNT; i++)
+    {
+        state_slot *slot = &g_slots[i];
+        pthread_mutex_lock(&slot->lock);
+        metrics_free(slot->current);
+        slot->current = NULL;
+        slot->refreshed_us = 0;
+        pthread_mutex_unlock(&slot->lock);
+        pthread_mutex_lock(&slot->notify_lock);
+        slot->watch = NULL;
+        slot->notified = 0;
+        pthread_mutex_unlock(&slot->notify_lock);
+    }
+    pthread_mutex_lock(&g_retired_lock);
+    while (g_retired)
+    {
+        state_node *node = g_retired;
+        g_retired = node->next;
+        metrics_free(node);
+    }
+    pthread_mutex_unlock(&g_retired_lock);
+}
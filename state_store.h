@@ -0,0 +1,168 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file state_store.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 设备状态存储声明
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 各模块最近一次读到的设备状态以不可变的带版本记录保存，记录内容是响应data的JSON文本。
+ * 读者在state_store_enter/state_store_leave之间只读取当前记录指针，不加锁；
+ * 写者逐键串行发布新记录，旧记录在所有可能引用它的读者离开后才释放（基于纪元的回收）。
+ * 记录过期或被写操作标记失效时，同一时刻只有一个读者负责刷新，其余读者等待刷新结果。
+ */
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include "cJSON.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 状态键
+ */
+typedef enum
+{
+    STATE_WIFI_STATUS = 0, ///< WiFi连接状态
+    STATE_WIFI_SCAN,       ///< WiFi扫描结果
+    STATE_KEY_COUNT
+} state_key_t;
+
+/**
+ * @brief 不可变状态记录
+ *
+ * 只能在读区间内访问，离开读区间后不得再引用。
+ */
+typedef struct
+{
+    uint64_t version; ///< 版本号，内容或错误码变化时递增，首个记录为1
+    int error;        ///< 读取状态时模块返回的错误码，0表示成功
+    const char *text; ///< 响应data的JSON文本
+    size_t len;       ///< 文本长度
+} state_record;
+
+/**
+ * @brief 读取后端并生成状态
+ *
+ * 在刷新者线程内调用，调用期间不持有任何存储内部的锁。
+ *
+ * @param key 状态键
+ * @param data 输出与响应data相同结构的对象（调用者释放），失败时也可输出
+ * @return int 模块错误码，0表示成功
+ */
+typedef int (*state_refresh_fn)(state_key_t key, cJSON **data);
+
+/**
+ * @brief 版本变化回调
+ *
+ * 在发布者线程内、释放该键写者锁之后调用，回调期间读者与写者不受阻塞。
+ * 同一键的回调串行执行且版本单调递增；并发发布时中间版本可能被合并，只回调最新版本。
+ * 回调中不得再发布或刷新同一键。
+ *
+ * @param key 状态键
+ * @param record 新记录
+ */
+typedef void (*state_watch_fn)(state_key_t key, const state_record *record);
+
+/**
+ * @brief 进入读区间
+ *
+ * 可嵌套；读区间内取得的记录在对应的state_store_leave之前一直有效。
+ */
+void state_store_enter(void);
+
+/**
+ * @brief 离开读区间
+ */
+void state_store_leave(void);
+
+/**
+ * @brief 读取状态记录，过期或已失效时刷新
+ *
+ * 必须在读区间内调用。记录距上次刷新不超过max_age_us时直接返回，不加锁；
+ * 否则同一时刻只有一个调用者执行refresh并发布结果，其余调用者等待。
+ * 刷新结果供所有读者共享，期限只限制本调用者的等待：到期时不再等待他人的刷新，
+ * 直接返回当前记录，由调用者判断是否超时；已开始的刷新照常完成并发布。
+ *
+ * @param key 状态键
+ * @param max_age_us 记录的最大允许年龄(微秒)
+ * @param refresh 刷新函数，NULL表示只读取当前记录
+ * @param deadline_us 等待期限（qos_now_us()时间），0表示不限
+ * @return const state_record* 当前记录，从未发布过时返回NULL
+ */
+const state_record *state_store_fetch(state_key_t key, int64_t max_age_us,
+                                      state_refresh_fn refresh, int64_t deadline_us);
+
+/**
+ * @brief 读取未过期的状态记录，不刷新
+ *
+ * 必须在读区间内调用。记录距上次刷新不超过max_age_us时返回，否则（过期、已失效或
+ * 从未发布）返回NULL，由调用者决定在哪个线程刷新。
+ *
+ * @param key 状态键
+ * @param max_age_us 记录的最大允许年龄(微秒)
+ * @return const state_record* 未过期的当前记录，否则NULL
+ */
+const state_record *state_store_peek(state_key_t key, int64_t max_age_us);
+
+/**
+ * @brief 发布新读到的状态
+ *
+ * 内容与错误码都与当前记录相同时只更新刷新时间，不产生新版本。
+ *
+ * @param key 状态键
+ * @param error 模块错误码
+ * @param data 与响应data相同结构的对象，NULL按空对象处理
+ * @return uint64_t 发布后的版本号，失败返回0
+ */
+uint64_t state_store_publish(state_key_t key, int error, const cJSON *data);
+
+/**
+ * @brief 标记状态失效
+ *
+ * 写操作完成后调用：下次读取会重新刷新，正在进行的刷新结果照常发布但不再视为最新。
+ *
+ * @param key 状态键
+ */
+void state_store_invalidate(state_key_t key);
+
+/**
+ * @brief 获取状态的当前版本号
+ *
+ * @param key 状态键
+ * @return uint64_t 版本号，从未发布过返回0
+ */
+uint64_t state_store_version(state_key_t key);
+
+/**
+ * @brief 注册版本变化回调
+ *
+ * @param key 状态键
+ * @param watch 回调，NULL表示取消
+ */
+void state_store_watch(state_key_t key, state_watch_fn watch);
+
+/**
+ * @brief 释放所有记录
+ *
+ * 须在所有读者与写者停止之后调用。
+ */
+void state_store_deinit(void);
+
+#endif
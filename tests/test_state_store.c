@@ -0,0 +1,295 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file test_state_store.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 状态存储行为测试：记录回收、单飞刷新、等待期限与版本回调
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * metrics_malloc/metrics_free由本文件提供，统计存活的记录节点数，用于观察回收时机。
+ */
+#include "cJSON.h"
+#include "metrics.h"
+#include "qos.h"
+#include "state_store.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_WAITERS 8 ///< 并发读取同一过期记录的线程数
+
+// ------------------------ 替身 ------------------------
+
+static int g_live_nodes = 0; ///< 存活的记录节点数（__atomic访问）
+
+void *metrics_malloc(metrics_module_t module, size_t size)
+{
+    (void)module;
+    __atomic_add_fetch(&g_live_nodes, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void metrics_free(void *ptr)
+{
+    if (ptr)
+    {
+        __atomic_sub_fetch(&g_live_nodes, 1, __ATOMIC_RELAXED);
+    }
+    free(ptr);
+}
+
+void metrics_observe_request(const char *type, int64_t latency_us)
+{
+    (void)type;
+    (void)latency_us;
+}
+
+// ------------------------ 辅助 ------------------------
+
+/**
+ * @brief 发布{"n":n}
+ *
+ * @param key 状态键
+ * @param n 内容
+ * @return uint64_t 发布后的版本号
+ */
+static uint64_t publish_n(state_key_t key, int n)
+{
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data, "n", n);
+    uint64_t version = state_store_publish(key, 0, data);
+    cJSON_Delete(data);
+    return version;
+}
+
+static int g_refresh_calls = 0;    ///< refresh被调用的次数（__atomic访问）
+static int g_refresh_delay_ms = 0; ///< 每次刷新的耗时
+
+static int slow_refresh(state_key_t key, cJSON **data)
+{
+    (void)key;
+    int n = __atomic_add_fetch(&g_refresh_calls, 1, __ATOMIC_SEQ_CST);
+    usleep((useconds_t)g_refresh_delay_ms * 1000);
+    *data = cJSON_CreateObject();
+    cJSON_AddNumberToObject(*data, "refresh", n);
+    return 0;
+}
+
+// ------------------------ 回收 ------------------------
+
+typedef struct
+{
+    volatile bool holding; ///< 已取得记录并停留在读区间内
+    volatile bool release; ///< 允许离开读区间
+    bool intact;           ///< 停留期间记录内容未变
+} reader_ctx;
+
+static void *hold_reader(void *arg)
+{
+    reader_ctx *ctx = (reader_ctx *)arg;
+    state_store_enter();
+    const state_record *record = state_store_fetch(STATE_WIFI_STATUS, 0, NULL, 0);
+    char before[64];
+    snprintf(before, sizeof(before), "%s", record ? record->text : "");
+    ctx->holding = true;
+    while (!ctx->release)
+    {
+        usleep(1000);
+    }
+    ctx->intact = record && strcmp(record->text, before) == 0 && strcmp(before, "{\"n\":1}") == 0;
+    state_store_leave();
+    return NULL;
+}
+
+static void test_reclaim_waits_for_readers(void)
+{
+    publish_n(STATE_WIFI_STATUS, 1);
+    TEST_CHECK(g_live_nodes == 1);
+
+    reader_ctx ctx = {0};
+    pthread_t reader;
+    pthread_create(&reader, NULL, hold_reader, &ctx);
+    TEST_CHECK(TEST_WAIT_UNTIL(ctx.holding, 2000));
+
+    // 读者仍在读区间内：被替换的记录全部保留
+    for (int i = 2; i <= 10; i++)
+    {
+        publish_n(STATE_WIFI_STATUS, i);
+    }
+    TEST_CHECK(g_live_nodes == 10);
+
+    ctx.release = true;
+    pthread_join(reader, NULL);
+    TEST_CHECK(ctx.intact);
+
+    // 读者离开后下一次替换回收全部旧记录
+    publish_n(STATE_WIFI_STATUS, 11);
+    TEST_CHECK(g_live_nodes == 1);
+
+    // 内容不变时不产生新版本也不分配
+    uint64_t version = state_store_version(STATE_WIFI_STATUS);
+    TEST_CHECK(publish_n(STATE_WIFI_STATUS, 11) == version);
+    TEST_CHECK(g_live_nodes == 1);
+}
+
+// ------------------------ 单飞刷新 ------------------------
+
+static void *fetch_status(void *arg)
+{
+    uint64_t *version = (uint64_t *)arg;
+    state_store_enter();
+    const state_record *record = state_store_fetch(STATE_WIFI_STATUS, 1000000, slow_refresh, 0);
+    *version = record ? record->version : 0;
+    state_store_leave();
+    return NULL;
+}
+
+static void test_refresh_single_flight(void)
+{
+    state_store_invalidate(STATE_WIFI_STATUS);
+    g_refresh_calls = 0;
+    g_refresh_delay_ms = 50;
+
+    pthread_t threads[TEST_WAITERS];
+    uint64_t versions[TEST_WAITERS];
+    for (int i = 0; i < TEST_WAITERS; i++)
+    {
+        pthread_create(&threads[i], NULL, fetch_status, &versions[i]);
+    }
+    for (int i = 0; i < TEST_WAITERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_CHECK(g_refresh_calls == 1);
+    for (int i = 0; i < TEST_WAITERS; i++)
+    {
+        TEST_CHECK(versions[i] == state_store_version(STATE_WIFI_STATUS));
+    }
+}
+
+// ------------------------ 等待期限 ------------------------
+
+static void *refresh_scan(void *arg)
+{
+    (void)arg;
+    state_store_enter();
+    // 刷新者自己的期限很短，刷新仍须完成并发布
+    state_store_fetch(STATE_WIFI_SCAN, 1000000, slow_refresh, qos_now_us() + 10000);
+    state_store_leave();
+    return NULL;
+}
+
+static void test_deadline_limits_only_waiter(void)
+{
+    state_store_invalidate(STATE_WIFI_SCAN);
+    g_refresh_calls = 0;
+    g_refresh_delay_ms = 300;
+    uint64_t version = state_store_version(STATE_WIFI_SCAN);
+
+    pthread_t refresher;
+    pthread_create(&refresher, NULL, refresh_scan, NULL);
+    TEST_CHECK(TEST_WAIT_UNTIL(__atomic_load_n(&g_refresh_calls, __ATOMIC_SEQ_CST) == 1, 2000));
+
+    int64_t start_ms = test_now_ms();
+    state_store_enter();
+    state_store_fetch(STATE_WIFI_SCAN, 1000000, slow_refresh, qos_now_us() + 50000);
+    state_store_leave();
+    int64_t waited_ms = test_now_ms() - start_ms;
+    TEST_CHECK(waited_ms >= 40 && waited_ms < 250);
+
+    pthread_join(refresher, NULL);
+    TEST_CHECK(g_refresh_calls == 1);
+    TEST_CHECK(state_store_version(STATE_WIFI_SCAN) == version + 1);
+}
+
+// ------------------------ 版本回调 ------------------------
+
+static uint64_t g_last_notified = 0; ///< 最近一次回调的版本
+static int g_out_of_order = 0;       ///< 版本未递增的回调次数
+
+static void watch_status(state_key_t key, const state_record *record)
+{
+    if (record->version <= g_last_notified)
+    {
+        g_out_of_order++;
+    }
+    g_last_notified = record->version;
+    // 回调不持有写者锁，可以再使同一键失效
+    state_store_invalidate(key);
+}
+
+static void *publish_many(void *arg)
+{
+    int base = *(int *)arg;
+    for (int i = 0; i < 200; i++)
+    {
+        publish_n(STATE_WIFI_STATUS, base + i);
+    }
+    return NULL;
+}
+
+static void test_watch_ordered_outside_lock(void)
+{
+    state_store_watch(STATE_WIFI_STATUS, watch_status);
+    int bases[2] = {1000, 2000};
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_create(&threads[i], NULL, publish_many, &bases[i]);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    state_store_watch(STATE_WIFI_STATUS, NULL);
+    TEST_CHECK(g_out_of_order == 0);
+    TEST_CHECK(g_last_notified == state_store_version(STATE_WIFI_STATUS));
+}
+
+static void test_peek_only_fresh(void)
+{
+    publish_n(STATE_WIFI_SCAN, 7);
+    state_store_enter();
+    const state_record *record = state_store_peek(STATE_WIFI_SCAN, 1000000);
+    TEST_CHECK(record && strstr(record->text, "7") != NULL);
+    TEST_CHECK(state_store_peek(STATE_WIFI_SCAN, 0) == NULL);
+    state_store_leave();
+
+    // 失效后peek不再返回记录，也不触发刷新
+    int calls = __atomic_load_n(&g_refresh_calls, __ATOMIC_SEQ_CST);
+    state_store_invalidate(STATE_WIFI_SCAN);
+    state_store_enter();
+    TEST_CHECK(state_store_peek(STATE_WIFI_SCAN, 1000000) == NULL);
+    state_store_leave();
+    TEST_CHECK(__atomic_load_n(&g_refresh_calls, __ATOMIC_SEQ_CST) == calls);
+}
+
+int main(void)
+{
+    TEST_RUN(test_reclaim_waits_for_readers);
+    TEST_RUN(test_refresh_single_flight);
+    TEST_RUN(test_deadline_limits_only_waiter);
+    TEST_RUN(test_watch_ordered_outside_lock);
+    TEST_RUN(test_peek_only_fresh);
+    state_store_deinit();
+    TEST_CHECK(g_live_nodes == 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,98 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file test_util.h
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 行为测试的检查与运行宏
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 每个测试程序包含本文件，用TEST_RUN逐个运行用例，main返回TEST_RESULT()；
+ * 检查失败时打印位置与表达式并继续运行，退出码非0即为ctest失败。
+ */
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+static int g_test_failures = 0; ///< 失败的检查数
+
+/**
+ * @brief 检查条件，失败时记录并继续
+ */
+#define TEST_CHECK(cond)                                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(cond))                                                                               \
+        {                                                                                          \
+            fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #cond);                   \
+            g_test_failures++;                                                                     \
+        }                                                                                          \
+    } while (0)
+
+/**
+ * @brief 运行一个用例并打印结果
+ */
+#define TEST_RUN(fn)                                                                               \
+    do                                                                                             \
+    {                                                                                              \
+        int failures_before = g_test_failures;                                                     \
+        printf("[ RUN  ] %s\n", #fn);                                                              \
+        fn();                                                                                      \
+        printf("[ %s ] %s\n", g_test_failures == failures_before ? " OK " : "FAIL", #fn);          \
+        fflush(stdout);                                                                            \
+    } while (0)
+
+/**
+ * @brief 测试程序的退出码
+ */
+#define TEST_RESULT() (g_test_failures == 0 ? 0 : 1)
+
+/**
+ * @brief 单调时钟(毫秒)
+ *
+ * @return int64_t 当前时间
+ */
+static inline int64_t test_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 轮询等待条件成立
+ *
+ * @param cond 条件表达式
+ * @param timeout_ms 最长等待时间
+ * @return 条件在期限内成立为真
+ */
+#define TEST_WAIT_UNTIL(cond, timeout_ms)                                                          \
+    ({                                                                                             \
+        int64_t wait_end_ms = test_now_ms() + (timeout_ms);                                        \
+        while (!(cond) && test_now_ms() < wait_end_ms)                                             \
+        {                                                                                          \
+            usleep(1000);                                                                          \
+        }                                                                                          \
+        (cond);                                                                                    \
+    })
+
+#endif
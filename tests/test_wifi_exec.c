@@ -0,0 +1,174 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file test_wifi_exec.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 命令执行器行为测试：输出捕获与上限、期限、取消与子进程回收
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 以sleep/printf/false等系统命令代替wpa_cli。
+ */
+#include "modules/wifi/impl/wifi_exec.h"
+#include "qos.h"
+#include "test_util.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#define TEST_SLOW_KILL_MS 1000 ///< 被终止的命令必须在此时间内返回
+
+/**
+ * @brief 当前进程没有未回收的子进程
+ *
+ * @return bool 没有子进程返回true
+ */
+static bool no_children(void)
+{
+    return waitpid(-1, NULL, WNOHANG) == -1 && errno == ECHILD;
+}
+
+static void test_captures_output(void)
+{
+    const char *argv[] = {"printf", "a=1\\nb=2\\n", NULL};
+    wifi_exec_buf out = {0};
+    TEST_CHECK(wifi_exec_run(argv, 0, &out) == WIFI_ERR_OK);
+    TEST_CHECK(out.data && strcmp(out.data, "a=1\nb=2\n") == 0);
+    TEST_CHECK(out.len == strlen("a=1\nb=2\n"));
+
+    // 复用缓冲区时先清空
+    const char *empty[] = {"true", NULL};
+    TEST_CHECK(wifi_exec_run(empty, 0, &out) == WIFI_ERR_OK);
+    TEST_CHECK(out.len == 0 && out.data[0] == '\0');
+    wifi_exec_buf_free(&out);
+    TEST_CHECK(no_children());
+}
+
+static void test_tool_errors(void)
+{
+    const char *failing[] = {"false", NULL};
+    TEST_CHECK(wifi_exec_run(failing, 0, NULL) == WIFI_ERR_TOOL_ERROR);
+    const char *missing[] = {"wifi-exec-test-no-such-command", NULL};
+    TEST_CHECK(wifi_exec_run(missing, 0, NULL) == WIFI_ERR_TOOL_ERROR);
+    TEST_CHECK(no_children());
+}
+
+static void test_output_overflow(void)
+{
+    char count[32];
+    snprintf(count, sizeof(count), "%d", WIFI_EXEC_OUTPUT_MAX + 1);
+    const char *argv[] = {"head", "-c", count, "/dev/zero", NULL};
+    wifi_exec_buf out = {0};
+    TEST_CHECK(wifi_exec_run(argv, 0, &out) == WIFI_ERR_TOOL_ERROR);
+    TEST_CHECK(out.len == WIFI_EXEC_OUTPUT_MAX);
+
+    // 恰好达到上限的输出完整保留
+    snprintf(count, sizeof(count), "%d", WIFI_EXEC_OUTPUT_MAX);
+    TEST_CHECK(wifi_exec_run(argv, 0, &out) == WIFI_ERR_OK);
+    TEST_CHECK(out.len == WIFI_EXEC_OUTPUT_MAX);
+    wifi_exec_buf_free(&out);
+    TEST_CHECK(no_children());
+}
+
+static void test_timeout_kills_child(void)
+{
+    const char *argv[] = {"sleep", "5", NULL};
+    int64_t start_ms = test_now_ms();
+    TEST_CHECK(wifi_exec_run(argv, 100, NULL) == WIFI_ERR_TIMEOUT);
+    TEST_CHECK(test_now_ms() - start_ms < TEST_SLOW_KILL_MS);
+    TEST_CHECK(no_children());
+}
+
+static void test_bound_deadline(void)
+{
+    const char *argv[] = {"sleep", "5", NULL};
+
+    // 请求期限早于命令期限
+    wifi_exec_bind_deadline(qos_now_us() + 100000);
+    TEST_CHECK(wifi_exec_deadline() > 0);
+    int64_t start_ms = test_now_ms();
+    TEST_CHECK(wifi_exec_run(argv, 0, NULL) == WIFI_ERR_TIMEOUT);
+    TEST_CHECK(test_now_ms() - start_ms < TEST_SLOW_KILL_MS);
+
+    // 期限已过：不启动子进程
+    wifi_exec_bind_deadline(qos_now_us() - 1);
+    start_ms = test_now_ms();
+    TEST_CHECK(wifi_exec_run(argv, 0, NULL) == WIFI_ERR_TIMEOUT);
+    TEST_CHECK(!wifi_exec_sleep_ms(1000));
+    TEST_CHECK(test_now_ms() - start_ms < 100);
+
+    TEST_CHECK(wifi_exec_bind_deadline(0) > 0);
+    TEST_CHECK(wifi_exec_deadline() == 0);
+    TEST_CHECK(wifi_exec_sleep_ms(10));
+    TEST_CHECK(no_children());
+}
+
+static void *set_flag_later(void *arg)
+{
+    usleep(100000);
+    __atomic_store_n((bool *)arg, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void test_cancel_kills_child(void)
+{
+    const char *argv[] = {"sleep", "5", NULL};
+    bool cancelled = false;
+    pthread_t thread;
+
+    wifi_exec_bind_cancel(&cancelled);
+    pthread_create(&thread, NULL, set_flag_later, &cancelled);
+    int64_t start_ms = test_now_ms();
+    TEST_CHECK(wifi_exec_run(argv, 0, NULL) == WIFI_ERR_CANCELLED);
+    TEST_CHECK(test_now_ms() - start_ms < TEST_SLOW_KILL_MS);
+    pthread_join(thread, NULL);
+    TEST_CHECK(wifi_exec_cancelled());
+
+    // 已取消的操作中等待立即返回，解除绑定后恢复
+    TEST_CHECK(!wifi_exec_sleep_ms(1000));
+    TEST_CHECK(wifi_exec_bind_cancel(NULL) == &cancelled);
+    TEST_CHECK(!wifi_exec_cancelled());
+    TEST_CHECK(no_children());
+}
+
+static void test_cancel_interrupts_sleep(void)
+{
+    bool cancelled = false;
+    pthread_t thread;
+    wifi_exec_bind_cancel(&cancelled);
+    pthread_create(&thread, NULL, set_flag_later, &cancelled);
+    int64_t start_ms = test_now_ms();
+    TEST_CHECK(!wifi_exec_sleep_ms(5000));
+    TEST_CHECK(test_now_ms() - start_ms < TEST_SLOW_KILL_MS);
+    pthread_join(thread, NULL);
+    wifi_exec_bind_cancel(NULL);
+}
+
+int main(void)
+{
+    TEST_RUN(test_captures_output);
+    TEST_RUN(test_tool_errors);
+    TEST_RUN(test_output_overflow);
+    TEST_RUN(test_timeout_kills_child);
+    TEST_RUN(test_bound_deadline);
+    TEST_RUN(test_cancel_kills_child);
+    TEST_RUN(test_cancel_interrupts_sleep);
+    return TEST_RESULT();
+}
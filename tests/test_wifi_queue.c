@@ -0,0 +1,442 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file test_wifi_queue.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WiFi命令队列行为测试：优先级、容量、取消、排队超时、连接关闭、事件顺序与读通道
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * ws_send_text由本文件提供，记录发给各连接的响应；任务执行函数由测试控制何时完成。
+ */
+#include "cJSON.h"
+#include "modules/wifi/impl/wifi_exec.h"
+#include "modules/wifi/impl/wifi_impl.h"
+#include "modules/wifi/wifi_queue.h"
+#include "protocol/protocol_utils.h"
+#include "qos.h"
+#include "test_util.h"
+#include "ws_utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TEST_MAX_RECORDS 64           ///< 记录的响应与执行顺序上限
+#define TEST_RESPONSE "test_response" ///< 测试任务的响应类型
+#define TEST_WAIT_MS 2000             ///< 等待队列动作的最长时间
+
+/**
+ * @brief 一条发出的响应
+ */
+typedef struct
+{
+    const struct mg_connection *conn; ///< 目标连接
+    char request_id[32];              ///< 请求ID
+    int error;                        ///< 错误码
+    int order;                        ///< 发送顺序（响应与排队事件共用）
+} sent_response;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static sent_response g_sent[TEST_MAX_RECORDS]; ///< 发出的响应（g_lock保护）
+static int g_sent_count = 0;
+static sent_response g_events[TEST_MAX_RECORDS]; ///< 发出的排队事件（g_lock保护）
+static int g_event_count = 0;
+static int g_order = 0;          ///< 下一条发送的顺序号（g_lock保护）
+static int g_event_delay_ms = 0; ///< 发送排队事件的耗时，模拟慢连接（g_lock保护）
+static char g_executed[TEST_MAX_RECORDS][32]; ///< 执行顺序（g_lock保护）
+static int g_executed_count = 0;
+static bool g_gate_open = false;    ///< 阻塞任务是否可以完成（g_lock保护）
+static bool g_gate_running = false; ///< 阻塞任务是否已开始执行（g_lock保护）
+static pthread_cond_t g_gate_cond = PTHREAD_COND_INITIALIZER;
+
+static char g_conn_a; ///< 连接A（只用地址）
+static char g_conn_b; ///< 连接B（只用地址）
+#define CONN_A ((struct mg_connection *)&g_conn_a)
+#define CONN_B ((struct mg_connection *)&g_conn_b)
+
+// ------------------------ 替身 ------------------------
+
+/**
+ * @brief 记录一条发出的消息
+ *
+ * @param list 记录数组
+ * @param count 记录数
+ * @param conn 目标连接
+ * @param root 消息
+ * @param data 携带request_id的对象
+ */
+static void record_sent(sent_response *list, int *count, const struct mg_connection *conn,
+                        cJSON *root, cJSON *data)
+{
+    cJSON *request_id = data ? cJSON_GetObjectItem(data, "request_id") : NULL;
+    cJSON *error = cJSON_GetObjectItem(root, "error");
+    pthread_mutex_lock(&g_lock);
+    if (*count < TEST_MAX_RECORDS)
+    {
+        sent_response *r = &list[(*count)++];
+        r->conn = conn;
+        snprintf(r->request_id, sizeof(r->request_id), "%s",
+                 cJSON_IsString(request_id) ? request_id->valuestring : "");
+        r->error = cJSON_IsNumber(error) ? error->valueint : -1;
+        r->order = g_order++;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+int ws_send_text(struct mg_connection *conn, const char *text)
+{
+    cJSON *root = cJSON_Parse(text);
+    cJSON *type = root ? cJSON_GetObjectItem(root, "type") : NULL;
+    if (cJSON_IsString(type) && strcmp(type->valuestring, TEST_RESPONSE) == 0)
+    {
+        record_sent(g_sent, &g_sent_count, conn, root, root);
+    }
+    else if (cJSON_IsString(type) && strcmp(type->valuestring, "wifi_queue_event") == 0)
+    {
+        pthread_mutex_lock(&g_lock);
+        int delay_ms = g_event_delay_ms;
+        pthread_mutex_unlock(&g_lock);
+        usleep((useconds_t)delay_ms * 1000);
+        record_sent(g_events, &g_event_count, conn, root, cJSON_GetObjectItem(root, "data"));
+    }
+    cJSON_Delete(root);
+    return 0;
+}
+
+void ws_resume_connection(struct mg_connection *conn, const char *path, bool has_position,
+                          uint64_t epoch, uint64_t last_seq, ws_resume_result *result)
+{
+    (void)conn;
+    (void)path;
+    (void)has_position;
+    (void)epoch;
+    (void)last_seq;
+    memset(result, 0, sizeof(*result));
+}
+
+// ------------------------ 任务 ------------------------
+
+static void record_executed(const char *request_id)
+{
+    pthread_mutex_lock(&g_lock);
+    if (g_executed_count < TEST_MAX_RECORDS)
+    {
+        snprintf(g_executed[g_executed_count++], sizeof(g_executed[0]), "%s", request_id);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static cJSON *exec_record(const char *response_type, const char *request_id, cJSON *data)
+{
+    (void)data;
+    record_executed(request_id);
+    return protocol_create_response(response_type, request_id, true, WIFI_ERR_OK);
+}
+
+static cJSON *exec_gate(const char *response_type, const char *request_id, cJSON *data)
+{
+    (void)data;
+    record_executed(request_id);
+    pthread_mutex_lock(&g_lock);
+    g_gate_running = true;
+    while (!g_gate_open)
+    {
+        pthread_cond_wait(&g_gate_cond, &g_lock);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return protocol_create_response(response_type, request_id, true, WIFI_ERR_OK);
+}
+
+static cJSON *exec_until_cancelled(const char *response_type, const char *request_id,
+                                   cJSON *data)
+{
+    (void)data;
+    record_executed(request_id);
+    bool finished = wifi_exec_sleep_ms(5000);
+    wifi_error_t err = finished ? WIFI_ERR_OK : WIFI_ERR_CANCELLED;
+    return protocol_create_response(response_type, request_id, finished, err);
+}
+
+// ------------------------ 辅助 ------------------------
+
+static void reset(void)
+{
+    pthread_mutex_lock(&g_lock);
+    g_sent_count = 0;
+    g_event_count = 0;
+    g_event_delay_ms = 0;
+    g_executed_count = 0;
+    g_gate_open = false;
+    g_gate_running = false;
+    pthread_mutex_unlock(&g_lock);
+}
+
+static int sent_count(void)
+{
+    pthread_mutex_lock(&g_lock);
+    int n = g_sent_count;
+    pthread_mutex_unlock(&g_lock);
+    return n;
+}
+
+static bool gate_running(void)
+{
+    pthread_mutex_lock(&g_lock);
+    bool running = g_gate_running;
+    pthread_mutex_unlock(&g_lock);
+    return running;
+}
+
+static void open_gate(void)
+{
+    pthread_mutex_lock(&g_lock);
+    g_gate_open = true;
+    pthread_cond_broadcast(&g_gate_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * @brief 查找发给请求的响应
+ *
+ * @param request_id 请求ID
+ * @return const sent_response* 未找到返回NULL
+ */
+static const sent_response *find_sent(const char *request_id)
+{
+    const sent_response *found = NULL;
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < g_sent_count; i++)
+    {
+        if (strcmp(g_sent[i].request_id, request_id) == 0)
+        {
+            found = &g_sent[i];
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return found;
+}
+
+static bool was_executed(const char *request_id)
+{
+    bool found = false;
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < g_executed_count; i++)
+    {
+        found = found || strcmp(g_executed[i], request_id) == 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return found;
+}
+
+static wifi_error_t submit(struct mg_connection *conn, wifi_queue_prio_t prio,
+                           const char *request_id, wifi_queue_exec_fn exec, int64_t deadline_us)
+{
+    return wifi_queue_submit(WIFI_DEVICE, prio, conn, "test_request", TEST_RESPONSE, request_id,
+                             NULL, exec, qos_now_us(), deadline_us);
+}
+
+/**
+ * @brief 提交阻塞任务并等待它开始执行，之后提交的任务都在排队
+ */
+static void hold_worker(struct mg_connection *conn)
+{
+    TEST_CHECK(submit(conn, WIFI_QUEUE_PRIO_LOW, "gate", exec_gate, 0) == WIFI_ERR_OK);
+    TEST_CHECK(TEST_WAIT_UNTIL(gate_running(), TEST_WAIT_MS));
+}
+
+// ------------------------ 用例 ------------------------
+
+static void test_priority_order(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_LOW, "low1", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, "normal", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_HIGH, "high1", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_LOW, "low2", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_HIGH, "high2", exec_record, 0) == WIFI_ERR_OK);
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(sent_count() == 6, TEST_WAIT_MS));
+
+    const char *expected[] = {"gate", "high1", "high2", "normal", "low1", "low2"};
+    pthread_mutex_lock(&g_lock);
+    TEST_CHECK(g_executed_count == 6);
+    for (int i = 0; i < 6 && i < g_executed_count; i++)
+    {
+        TEST_CHECK(strcmp(g_executed[i], expected[i]) == 0);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void test_full_queue_is_busy(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    for (int i = 0; i < WIFI_QUEUE_MAX_PENDING; i++)
+    {
+        char request_id[16];
+        snprintf(request_id, sizeof(request_id), "job%d", i);
+        TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, request_id, exec_record, 0) ==
+                   WIFI_ERR_OK);
+    }
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_HIGH, "overflow", exec_record, 0) ==
+               WIFI_ERR_BUSY);
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(sent_count() == WIFI_QUEUE_MAX_PENDING + 1, TEST_WAIT_MS));
+    TEST_CHECK(!was_executed("overflow"));
+}
+
+static void test_cancel_queued(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, "victim", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(!wifi_queue_cancel(CONN_B, "victim")); // 只能取消自己的请求
+    TEST_CHECK(wifi_queue_cancel(CONN_A, "victim"));
+    const sent_response *r = find_sent("victim");
+    TEST_CHECK(r && r->error == WIFI_ERR_CANCELLED && r->conn == CONN_A);
+    TEST_CHECK(!wifi_queue_cancel(CONN_A, "victim"));
+
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("gate") != NULL, TEST_WAIT_MS));
+    TEST_CHECK(!was_executed("victim"));
+}
+
+static void test_cancel_running(void)
+{
+    reset();
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, "long", exec_until_cancelled, 0) ==
+               WIFI_ERR_OK);
+    TEST_CHECK(TEST_WAIT_UNTIL(was_executed("long"), TEST_WAIT_MS));
+    int64_t start_ms = test_now_ms();
+    TEST_CHECK(wifi_queue_cancel(CONN_A, "long"));
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("long") != NULL, TEST_WAIT_MS));
+    TEST_CHECK(test_now_ms() - start_ms < 1000);
+    const sent_response *r = find_sent("long");
+    TEST_CHECK(r && r->error == WIFI_ERR_CANCELLED);
+}
+
+static void test_expired_in_queue(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_HIGH, "late", exec_record,
+                      qos_now_us() + 10000) == WIFI_ERR_OK);
+    usleep(30000);
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("late") != NULL, TEST_WAIT_MS));
+    const sent_response *r = find_sent("late");
+    TEST_CHECK(r && r->error == WIFI_ERR_TIMEOUT);
+    TEST_CHECK(!was_executed("late"));
+}
+
+static void test_connection_closed(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    TEST_CHECK(submit(CONN_B, WIFI_QUEUE_PRIO_HIGH, "orphan", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_LOW, "after", exec_record, 0) == WIFI_ERR_OK);
+    wifi_queue_cancel_connection(CONN_B);
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("after") != NULL, TEST_WAIT_MS));
+    TEST_CHECK(!was_executed("orphan"));
+    TEST_CHECK(find_sent("orphan") == NULL);
+
+    // 正在执行的任务被取消，完成后不再向已关闭的连接发送响应
+    reset();
+    TEST_CHECK(submit(CONN_B, WIFI_QUEUE_PRIO_NORMAL, "running", exec_until_cancelled, 0) ==
+               WIFI_ERR_OK);
+    TEST_CHECK(TEST_WAIT_UNTIL(was_executed("running"), TEST_WAIT_MS));
+    wifi_queue_cancel_connection(CONN_B);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, "next", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("next") != NULL, TEST_WAIT_MS));
+    TEST_CHECK(find_sent("running") == NULL);
+}
+
+/**
+ * @brief 提交任务，用于在独立线程中执行（发送排队事件期间阻塞）
+ */
+static void *submit_announced(void *arg)
+{
+    (void)arg;
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_HIGH, "announced", exec_record, 0) ==
+               WIFI_ERR_OK);
+    return NULL;
+}
+
+static void test_position_before_response(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    pthread_mutex_lock(&g_lock);
+    g_event_delay_ms = 100;
+    pthread_mutex_unlock(&g_lock);
+
+    // 排队事件发送期间任务已可被取出，放行工作线程后响应仍须排在事件之后
+    pthread_t thread;
+    pthread_create(&thread, NULL, submit_announced, NULL);
+    usleep(20000);
+    open_gate();
+    pthread_join(thread, NULL);
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("announced") != NULL, TEST_WAIT_MS));
+
+    pthread_mutex_lock(&g_lock);
+    TEST_CHECK(g_event_count == 1);
+    TEST_CHECK(strcmp(g_events[0].request_id, "announced") == 0);
+    int event_order = g_events[0].order;
+    pthread_mutex_unlock(&g_lock);
+    const sent_response *r = find_sent("announced");
+    TEST_CHECK(r && r->order > event_order);
+}
+
+static void test_reads_bypass_commands(void)
+{
+    reset();
+    hold_worker(CONN_A);
+    TEST_CHECK(submit(CONN_A, WIFI_QUEUE_PRIO_NORMAL, "queued", exec_record, 0) == WIFI_ERR_OK);
+    TEST_CHECK(wifi_queue_submit_read(WIFI_DEVICE, CONN_B, "test_request", TEST_RESPONSE,
+                                      "read", NULL, exec_record, qos_now_us(),
+                                      0) == WIFI_ERR_OK);
+    // 命令通道被阻塞时只读请求照常完成
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("read") != NULL, TEST_WAIT_MS));
+    TEST_CHECK(!was_executed("queued"));
+    const sent_response *r = find_sent("read");
+    TEST_CHECK(r && r->error == WIFI_ERR_OK && r->conn == CONN_B);
+
+    open_gate();
+    TEST_CHECK(TEST_WAIT_UNTIL(find_sent("queued") != NULL, TEST_WAIT_MS));
+}
+
+int main(void)
+{
+    if (wifi_queue_init() != 0)
+    {
+        fprintf(stderr, "wifi_queue_init失败\n");
+        return 1;
+    }
+    TEST_RUN(test_priority_order);
+    TEST_RUN(test_full_queue_is_busy);
+    TEST_RUN(test_cancel_queued);
+    TEST_RUN(test_cancel_running);
+    TEST_RUN(test_expired_in_queue);
+    TEST_RUN(test_connection_closed);
+    TEST_RUN(test_position_before_response);
+    TEST_RUN(test_reads_bypass_commands);
+    wifi_queue_deinit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,339 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file test_ws_journal.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 推送事件日志行为测试：序号、会话恢复补发与发送线程
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * mg_websocket_write与mg_get_request_info由本文件提供：每个连接记录收到的文本帧，
+ * 可以让写入阻塞，模拟不读取的慢客户端。
+ */
+#include "cJSON.h"
+#include "civetweb.h"
+#include "test_util.h"
+#include "ws_utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TEST_MAX_FRAMES 128 ///< 每个连接记录的帧数上限
+#define TEST_WAIT_MS 2000   ///< 等待线程动作的最长时间
+
+/**
+ * @brief 模拟连接：记录收到的事件序号
+ */
+typedef struct
+{
+    uint64_t seqs[TEST_MAX_FRAMES]; ///< 收到的事件的seq字段，没有时为0
+    int ns[TEST_MAX_FRAMES];        ///< 收到的事件的n字段
+    int count;                      ///< 收到的帧数
+    bool block;                     ///< 写入是否阻塞
+    bool blocked;                   ///< 是否有写入正阻塞在该连接上
+} fake_conn;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER; ///< 保护所有模拟连接
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+
+#define CONN(fake) ((struct mg_connection *)(fake))
+
+// ------------------------ 替身 ------------------------
+
+int mg_websocket_write(struct mg_connection *conn, int opcode, const char *data, size_t data_len)
+{
+    fake_conn *fake = (fake_conn *)conn;
+    cJSON *root = opcode == MG_WEBSOCKET_OPCODE_TEXT ? cJSON_ParseWithLength(data, data_len)
+                                                     : NULL;
+    cJSON *seq = root ? cJSON_GetObjectItem(root, "seq") : NULL;
+    cJSON *n = root ? cJSON_GetObjectItem(root, "n") : NULL;
+
+    pthread_mutex_lock(&g_lock);
+    while (fake->block)
+    {
+        fake->blocked = true;
+        pthread_cond_wait(&g_cond, &g_lock);
+    }
+    fake->blocked = false;
+    if (fake->count < TEST_MAX_FRAMES)
+    {
+        fake->seqs[fake->count] = cJSON_IsNumber(seq) ? (uint64_t)seq->valuedouble : 0;
+        fake->ns[fake->count] = cJSON_IsNumber(n) ? n->valueint : -1;
+        fake->count++;
+    }
+    pthread_mutex_unlock(&g_lock);
+    cJSON_Delete(root);
+    return (int)data_len;
+}
+
+const struct mg_request_info *mg_get_request_info(const struct mg_connection *conn)
+{
+    (void)conn;
+    static struct mg_request_info info;
+    return &info;
+}
+
+// ------------------------ 辅助 ------------------------
+
+static int frame_count(fake_conn *fake)
+{
+    pthread_mutex_lock(&g_lock);
+    int n = fake->count;
+    pthread_mutex_unlock(&g_lock);
+    return n;
+}
+
+static bool write_blocked(fake_conn *fake)
+{
+    pthread_mutex_lock(&g_lock);
+    bool blocked = fake->blocked;
+    pthread_mutex_unlock(&g_lock);
+    return blocked;
+}
+
+static void set_block(fake_conn *fake, bool block)
+{
+    pthread_mutex_lock(&g_lock);
+    fake->block = block;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * @brief 推送{"type":"test_event","n":n}
+ *
+ * @param path 连接路径
+ * @param n 内容
+ * @return int 成功发送的连接数
+ */
+static int broadcast_n(const char *path, int n)
+{
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "type", "test_event");
+    cJSON_AddNumberToObject(event, "n", n);
+    int sent = ws_broadcast_event(path, event);
+    TEST_CHECK(cJSON_GetObjectItem(event, "seq") == NULL); // 不修改调用者的事件
+    cJSON_Delete(event);
+    return sent;
+}
+
+// ------------------------ 用例 ------------------------
+
+static void test_broadcast_assigns_seq(void)
+{
+    fake_conn a = {0};
+    ws_register_connection(CONN(&a), "/seq");
+    for (int i = 1; i <= 3; i++)
+    {
+        TEST_CHECK(broadcast_n("/seq", 10 * i) == 1);
+    }
+    TEST_CHECK(TEST_WAIT_UNTIL(frame_count(&a) == 3, TEST_WAIT_MS));
+    for (int i = 0; i < 3 && i < a.count; i++)
+    {
+        TEST_CHECK(a.seqs[i] == (uint64_t)i + 1);
+        TEST_CHECK(a.ns[i] == 10 * (i + 1));
+    }
+
+    // 其他路径的序号独立
+    TEST_CHECK(broadcast_n("/seq-other", 1) == 0);
+    ws_unregister_connection(CONN(&a));
+    TEST_CHECK(broadcast_n("/seq", 40) == 0);
+    TEST_CHECK(frame_count(&a) == 3);
+}
+
+static void test_resume_replays_missed(void)
+{
+    fake_conn a = {0};
+    ws_register_connection(CONN(&a), "/resume");
+    for (int i = 1; i <= 5; i++)
+    {
+        broadcast_n("/resume", i);
+    }
+
+    // 没有位置：只返回当前纪元与序号，不补发
+    fake_conn b = {0};
+    ws_register_connection(CONN(&b), "/resume");
+    ws_resume_result result;
+    ws_resume_connection(CONN(&b), "/resume", false, 0, 0, &result);
+    TEST_CHECK(!result.resumed && result.replayed == 0 && result.seq == 5 && result.epoch > 0);
+    uint64_t epoch = result.epoch;
+
+    // 从序号2恢复：按顺序补发3~5
+    ws_resume_connection(CONN(&b), "/resume", true, epoch, 2, &result);
+    TEST_CHECK(result.resumed && result.replayed == 3);
+    TEST_CHECK(b.count == 3);
+    for (int i = 0; i < 3 && i < b.count; i++)
+    {
+        TEST_CHECK(b.seqs[i] == (uint64_t)i + 3);
+        TEST_CHECK(b.ns[i] == i + 3);
+    }
+
+    // 已是最新：恢复成功但无需补发
+    ws_resume_connection(CONN(&b), "/resume", true, epoch, 5, &result);
+    TEST_CHECK(result.resumed && result.replayed == 0);
+
+    // 纪元不符或序号超前：无法判断错过了什么
+    ws_resume_connection(CONN(&b), "/resume", true, epoch + 1, 2, &result);
+    TEST_CHECK(!result.resumed && result.replayed == 0);
+    ws_resume_connection(CONN(&b), "/resume", true, epoch, 6, &result);
+    TEST_CHECK(!result.resumed && result.replayed == 0);
+    TEST_CHECK(b.count == 3);
+
+    ws_unregister_connection(CONN(&a));
+    ws_unregister_connection(CONN(&b));
+}
+
+static void test_resume_skips_live_events(void)
+{
+    fake_conn a = {0};
+    ws_register_connection(CONN(&a), "/live");
+    broadcast_n("/live", 1);
+    broadcast_n("/live", 2);
+
+    // 重连后先收到了实时推送的3，再请求从1恢复：只补发2
+    fake_conn b = {0};
+    ws_register_connection(CONN(&b), "/live");
+    broadcast_n("/live", 3);
+    TEST_CHECK(TEST_WAIT_UNTIL(frame_count(&b) == 1, TEST_WAIT_MS));
+    ws_resume_result result;
+    ws_resume_connection(CONN(&b), "/live", false, 0, 0, &result);
+    ws_resume_connection(CONN(&b), "/live", true, result.epoch, 1, &result);
+    TEST_CHECK(result.resumed && result.replayed == 1);
+    TEST_CHECK(frame_count(&b) == 2);
+    TEST_CHECK(b.seqs[0] == 3 && b.seqs[1] == 2);
+
+    ws_unregister_connection(CONN(&a));
+    ws_unregister_connection(CONN(&b));
+}
+
+static void test_resume_after_eviction(void)
+{
+    for (int i = 1; i <= WS_JOURNAL_CAPACITY + 5; i++)
+    {
+        broadcast_n("/evict", i);
+    }
+    fake_conn b = {0};
+    ws_register_connection(CONN(&b), "/evict");
+    ws_resume_result result;
+    ws_resume_connection(CONN(&b), "/evict", false, 0, 0, &result);
+    uint64_t epoch = result.epoch;
+
+    // 序号1~5已被挤出日志
+    ws_resume_connection(CONN(&b), "/evict", true, epoch, 1, &result);
+    TEST_CHECK(!result.resumed && result.replayed == 0);
+    TEST_CHECK(frame_count(&b) == 0);
+
+    // 日志中最旧的事件之前的位置仍可恢复
+    ws_resume_connection(CONN(&b), "/evict", true, epoch, 5, &result);
+    TEST_CHECK(result.resumed && result.replayed == WS_JOURNAL_CAPACITY);
+    ws_unregister_connection(CONN(&b));
+}
+
+typedef struct
+{
+    fake_conn *conn;    ///< 要注销的连接
+    volatile bool done; ///< 注销已返回
+} unregister_ctx;
+
+static void *unregister_thread(void *arg)
+{
+    unregister_ctx *ctx = (unregister_ctx *)arg;
+    ws_unregister_connection(CONN(ctx->conn));
+    ctx->done = true;
+    return NULL;
+}
+
+static void test_slow_connection_blocks_only_itself(void)
+{
+    fake_conn slow = {0};
+    fake_conn other = {0};
+    ws_register_connection(CONN(&slow), "/slow");
+    ws_register_connection(CONN(&other), "/slow");
+    set_block(&slow, true);
+
+    // 推送只入队：慢连接的写入阻塞时调用者立即返回，同路径的其他连接照常收到
+    int64_t start_ms = test_now_ms();
+    for (int i = 1; i <= 5; i++)
+    {
+        TEST_CHECK(broadcast_n("/slow", i) == 2);
+    }
+    TEST_CHECK(test_now_ms() - start_ms < 100);
+    TEST_CHECK(TEST_WAIT_UNTIL(write_blocked(&slow), TEST_WAIT_MS));
+    TEST_CHECK(TEST_WAIT_UNTIL(frame_count(&other) == 5, TEST_WAIT_MS));
+    for (int i = 0; i < 5; i++)
+    {
+        TEST_CHECK(other.seqs[i] == (uint64_t)i + 1);
+    }
+
+    // 注销正在被写入的连接：等写入结束才返回，未写出的事件丢弃
+    unregister_ctx unregister = {.conn = &slow};
+    pthread_t unregistering;
+    pthread_create(&unregistering, NULL, unregister_thread, &unregister);
+    usleep(50000);
+    TEST_CHECK(!unregister.done);
+    set_block(&slow, false);
+    pthread_join(unregistering, NULL);
+    TEST_CHECK(unregister.done);
+    TEST_CHECK(frame_count(&slow) == 1);
+
+    // 注销后不再写入
+    TEST_CHECK(broadcast_n("/slow", 6) == 1);
+    TEST_CHECK(TEST_WAIT_UNTIL(frame_count(&other) == 6, TEST_WAIT_MS));
+    TEST_CHECK(frame_count(&slow) == 1);
+    ws_unregister_connection(CONN(&other));
+}
+
+static void test_backlog_overflow_reaps(void)
+{
+    fake_conn slow = {0};
+    ws_subscriber *sub = ws_register_connection(CONN(&slow), "/overflow");
+    set_block(&slow, true);
+    broadcast_n("/overflow", 0);
+    TEST_CHECK(TEST_WAIT_UNTIL(write_blocked(&slow), TEST_WAIT_MS));
+
+    // 第一个事件正阻塞在写入中，发送队列再装满后下一个事件使连接被回收
+    for (int i = 1; i <= WS_PUSH_QUEUE_DEPTH; i++)
+    {
+        TEST_CHECK(broadcast_n("/overflow", i) == 1);
+    }
+    TEST_CHECK(broadcast_n("/overflow", WS_PUSH_QUEUE_DEPTH + 1) == 0);
+    TEST_CHECK(broadcast_n("/overflow", WS_PUSH_QUEUE_DEPTH + 2) == 0);
+
+    // 被回收的连接在收到下一帧时被告知关闭，积压的事件不再写出
+    set_block(&slow, false);
+    TEST_CHECK(!ws_connection_touch(sub, true));
+    usleep(20000);
+    TEST_CHECK(frame_count(&slow) == 2); // 阻塞的事件与关闭帧
+    ws_unregister_connection(CONN(&slow));
+}
+
+int main(void)
+{
+    if (ws_push_init() != 0)
+    {
+        return 1;
+    }
+    TEST_RUN(test_broadcast_assigns_seq);
+    TEST_RUN(test_resume_replays_missed);
+    TEST_RUN(test_resume_skips_live_events);
+    TEST_RUN(test_resume_after_eviction);
+    TEST_RUN(test_slow_connection_blocks_only_itself);
+    TEST_RUN(test_backlog_overflow_reaps);
+    ws_push_deinit();
+    return TEST_RESULT();
+}
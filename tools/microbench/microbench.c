@@ -0,0 +1,675 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file microbench.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief 协议与解析热点路径的微基准
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 在真实负载大小下测量单条消息的CPU开销，输出ns/op、allocs/op与bytes/op：
+ * - cJSON_ParseWithLength（ws_data_handler中的请求解析）
+ * - protocol_create_response + protocol_send_response（响应构造与序列化）
+ * - wifi_parse_scan_line（scan_results行解析）
+ * - wifi_parse_decode_utf8_escape（SSID转义解码）
+ *
+ * --stack模式改为在与civetweb工作线程同样大小（SERVER_THREAD_STACK_SIZE）的线程栈上各执行一次
+ * 用例，报告栈的最高水位，另外覆盖/metrics渲染、CJSON_NESTING_LIMIT层嵌套的请求解析与
+ * 输出达到WIFI_EXEC_OUTPUT_MAX的wifi_exec_run。
+ *
+ * 通过替换glibc的malloc系列符号统计分配次数与字节数（包括libc内部的strdup）；
+ * ws_send_text由本文件提供空实现，只统计发送字节数，不需要真实连接；protocol_utils.c引用的
+ * ws_resume_connection同样由本文件提供空实现，因此不链接ws_utils.c。
+ *
+ * 用法：microbench [--filter 子串] [--min-time 毫秒] [--json] [--stack]
+ */
+#include "cJSON.h"
+#include "metrics.h"
+#include "modules/wifi/impl/wifi_exec.h"
+#include "modules/wifi/impl/wifi_parse.h"
+#include "protocol/protocol_utils.h"
+#include "ws_utils.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define MB_DEFAULT_MIN_TIME_MS 500 ///< 每个用例的默认最短运行时间
+#define MB_SCAN_LINES 1000         ///< 整段scan_results用例的行数
+#define MB_STACK_PAINT 0xa5        ///< 测量栈水位时预先填充的字节
+
+#ifndef MB_STACK_SIZE
+#define MB_STACK_SIZE 131072 ///< --stack模式的线程栈大小，CMake传入SERVER_THREAD_STACK_SIZE
+#endif
+
+// ------------------------ 分配统计 ------------------------
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t g_alloc_count = 0; ///< 分配次数
+static uint64_t g_alloc_bytes = 0; ///< 分配字节数
+static size_t g_sent_bytes = 0;    ///< ws_send_text累计字节数
+
+void *malloc(size_t size)
+{
+    g_alloc_count++;
+    g_alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    g_alloc_count++;
+    g_alloc_bytes += nmemb * size;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    g_alloc_count++;
+    g_alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+/**
+ * @brief 替代ws_utils.c中的实现：丢弃数据，只统计字节数
+ */
+int ws_send_text(struct mg_connection *conn, const char *text)
+{
+    (void)conn;
+    size_t len = strlen(text);
+    g_sent_bytes += len;
+    return (int)len;
+}
+
+/**
+ * @brief 替代ws_utils.c中的实现：没有推送日志，总是需要快照
+ */
+void ws_resume_connection(struct mg_connection *conn, const char *path, bool has_position,
+                          uint64_t epoch, uint64_t last_seq, ws_resume_result *result)
+{
+    (void)conn;
+    (void)path;
+    (void)has_position;
+    (void)epoch;
+    (void)last_seq;
+    memset(result, 0, sizeof(*result));
+}
+
+// ------------------------ 用例 ------------------------
+
+/**
+ * @brief 基准用例
+ */
+typedef struct
+{
+    const char *name;    ///< 用例名
+    void (*setup)(void); ///< 准备数据（可为NULL，不计入测量）
+    void (*run)(void);   ///< 单次操作
+    bool stack_only;     ///< 只在--stack模式下运行（单次开销大，不适合计时）
+} mb_case;
+
+static char g_dummy_conn;
+#define MB_CONN ((struct mg_connection *)&g_dummy_conn)
+
+static const char g_brightness_set_req[] =
+    "{\"type\":\"brightness_set_request\",\"request_id\":\"b3-184467\","
+    "\"data\":{\"brightness\":80,\"transition_ms\":300,\"device\":\"intel_backlight\"}}";
+
+static const char g_wifi_connect_req[] =
+    "{\"type\":\"wifi_connect_request\",\"request_id\":\"req-6-1a2b3c4d\","
+    "\"data\":{\"ssid\":\"星巴克咖啡馆访客网络07\",\"password\":\"correct horse battery staple\","
+    "\"timeout_ms\":20000}}";
+
+static const char g_scan_line_ascii[] =
+    "02:aa:00:00:00:01\t2437\t-41\t[WPA2-PSK-CCMP][ESS]\tVenue-Guest-0042\n";
+
+static const char g_scan_line_utf8[] =
+    "02:00:00:00:05:23\t5280\t-83\t[WPA-PSK-TKIP][WPA2-PSK-CCMP+TKIP][ESS][WPS]\t"
+    "\\xe6\\x98\\x9f\\xe5\\xb7\\xb4\\xe5\\x85\\x8b\\xe5\\x92\\x96\\xe5\\x95\\xa1\\xe9\\xa6\\x86"
+    "\\xe8\\xae\\xbf\\xe5\\xae\\xa2\\xe7\\xbd\\x91\\xe7\\xbb\\x9c07\n";
+
+static const char g_escaped_ssid[] =
+    "\\xe6\\x98\\x9f\\xe5\\xb7\\xb4\\xe5\\x85\\x8b\\xe5\\x92\\x96\\xe5\\x95\\xa1\\xe9\\xa6\\x86"
+    "\\xe8\\xae\\xbf\\xe5\\xae\\xa2\\xe7\\xbd\\x91\\xe7\\xbb\\x9c07";
+
+static char *g_scan_text = NULL;       ///< 整段scan_results文本
+static size_t g_scan_text_len = 0;     ///< 文本长度
+static char *g_scan_work = NULL;       ///< 解析用的可写副本
+static wifi_network_info *g_scan_nets; ///< 解析结果
+
+static volatile size_t g_sink; ///< 防止结果被优化掉
+
+static void run_parse_brightness_set(void)
+{
+    cJSON *root = cJSON_ParseWithLength(g_brightness_set_req, sizeof(g_brightness_set_req) - 1);
+    g_sink += root != NULL;
+    cJSON_Delete(root);
+}
+
+static void run_parse_wifi_connect(void)
+{
+    cJSON *root = cJSON_ParseWithLength(g_wifi_connect_req, sizeof(g_wifi_connect_req) - 1);
+    g_sink += root != NULL;
+    cJSON_Delete(root);
+}
+
+static void run_response_brightness_status(void)
+{
+    cJSON *resp = protocol_create_response("brightness_status_response", "b3-184467", true, 0);
+    cJSON *data = cJSON_GetObjectItem(resp, "data");
+    cJSON_AddStringToObject(data, "device", "intel_backlight");
+    cJSON_AddNumberToObject(data, "brightness", 75);
+    cJSON_AddBoolToObject(data, "auto_brightness", false);
+    protocol_send_response(MB_CONN, resp);
+    cJSON_Delete(resp);
+}
+
+/**
+ * @brief 构造并发送含n个网络的wifi_scan_response
+ */
+static void run_response_wifi_scan(int n)
+{
+    cJSON *resp = protocol_create_response("wifi_scan_response", "req-4", true, 0);
+    cJSON *data = cJSON_GetObjectItem(resp, "data");
+    cJSON *networks = cJSON_AddArrayToObject(data, "networks");
+    for (int i = 0; i < n; i++)
+    {
+        char ssid[64];
+        char bssid[18];
+        snprintf(ssid, sizeof(ssid), i % 2 ? "星巴克咖啡馆访客网络%02d" : "Venue-Guest-%04d", i);
+        snprintf(bssid, sizeof(bssid), "02:00:00:00:%02x:%02x", (i >> 8) & 0xff, i & 0xff);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "ssid", ssid);
+        cJSON_AddStringToObject(item, "bssid", bssid);
+        cJSON_AddNumberToObject(item, "signal", -40 - i % 50);
+        cJSON_AddStringToObject(item, "security", "[WPA2-PSK-CCMP][ESS]");
+        cJSON_AddNumberToObject(item, "channel", 1 + i % 11);
+        cJSON_AddNumberToObject(item, "frequency_mhz", 2412 + 5 * (i % 11));
+        cJSON_AddBoolToObject(item, "recorded", i == 0);
+        cJSON_AddItemToArray(networks, item);
+    }
+    protocol_send_response(MB_CONN, resp);
+    cJSON_Delete(resp);
+}
+
+static void run_response_wifi_scan_64(void)
+{
+    run_response_wifi_scan(64);
+}
+
+static void run_response_wifi_scan_1000(void)
+{
+    run_response_wifi_scan(1000);
+}
+
+/**
+ * @brief 解析一行并释放结果
+ */
+static void parse_line_once(const char *line, size_t len)
+{
+    char buffer[512];
+    memcpy(buffer, line, len + 1);
+    wifi_network_info net;
+    if (wifi_parse_scan_line(buffer, &net) == 0)
+    {
+        g_sink += (size_t)net.channel;
+        metrics_free(net.ssid);
+        metrics_free(net.bssid);
+        metrics_free(net.security);
+    }
+}
+
+static void run_scan_line_ascii(void)
+{
+    parse_line_once(g_scan_line_ascii, sizeof(g_scan_line_ascii) - 1);
+}
+
+static void run_scan_line_utf8(void)
+{
+    parse_line_once(g_scan_line_utf8, sizeof(g_scan_line_utf8) - 1);
+}
+
+static void setup_scan_results(void)
+{
+    if (g_scan_text)
+    {
+        return;
+    }
+    size_t cap = MB_SCAN_LINES * sizeof(g_scan_line_utf8) + 64;
+    g_scan_text = __libc_malloc(cap);
+    g_scan_work = __libc_malloc(cap);
+    g_scan_nets = __libc_malloc(MB_SCAN_LINES * sizeof(wifi_network_info));
+    g_scan_text_len = 0;
+    for (int i = 0; i < MB_SCAN_LINES; i++)
+    {
+        const char *line = (i % 3 == 0) ? g_scan_line_utf8 : g_scan_line_ascii;
+        size_t len = strlen(line);
+        memcpy(g_scan_text + g_scan_text_len, line, len);
+        g_scan_text_len += len;
+    }
+    g_scan_text[g_scan_text_len] = '\0';
+}
+
+/**
+ * @brief 与wifi_impl_scan相同的逐行解析方式处理整段scan_results
+ */
+static void run_scan_results_1000(void)
+{
+    memcpy(g_scan_work, g_scan_text, g_scan_text_len + 1);
+    size_t count = 0;
+    char *save = NULL;
+    for (char *line = strtok_r(g_scan_work, "\n", &save); line && count < MB_SCAN_LINES;
+         line = strtok_r(NULL, "\n", &save))
+    {
+        if (wifi_parse_scan_line(line, &g_scan_nets[count]) == 0)
+        {
+            count++;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        metrics_free(g_scan_nets[i].ssid);
+        metrics_free(g_scan_nets[i].bssid);
+        metrics_free(g_scan_nets[i].security);
+    }
+    g_sink += count;
+}
+
+static void run_decode_utf8(void)
+{
+    char out[128];
+    wifi_parse_decode_utf8_escape(g_escaped_ssid, out, sizeof(out));
+    g_sink += (size_t)out[0];
+}
+
+static void run_decode_ascii(void)
+{
+    char out[128];
+    wifi_parse_decode_utf8_escape("Venue-Guest-0042", out, sizeof(out));
+    g_sink += (size_t)out[0];
+}
+
+static const char g_wpa_status[] = "bssid=aa:bb:cc:dd:ee:ff\n"
+                                   "freq=2437\n"
+                                   "ssid=Caf\\xc3\\xa9-5G\n"
+                                   "id=0\n"
+                                   "mode=station\n"
+                                   "pairwise_cipher=CCMP\n"
+                                   "group_cipher=CCMP\n"
+                                   "key_mgmt=WPA2-PSK\n"
+                                   "wpa_state=COMPLETED\n"
+                                   "ip_address=192.168.1.23\n"
+                                   "address=11:22:33:44:55:66\n";
+
+/**
+ * @brief 一次解析完整的wpa_cli status输出
+ */
+static void run_wpa_status(void)
+{
+    char buffer[sizeof(g_wpa_status)];
+    memcpy(buffer, g_wpa_status, sizeof(g_wpa_status));
+    wifi_status_info status = {0};
+    wifi_parse_status(buffer, &status);
+    g_sink += (size_t)status.channel;
+    metrics_free(status.ssid);
+    metrics_free(status.bssid);
+    metrics_free(status.security);
+}
+
+static char *g_nested_req = NULL; ///< CJSON_NESTING_LIMIT层嵌套对象的请求
+static size_t g_nested_len = 0;   ///< 请求长度
+
+static void setup_nested(void)
+{
+    if (g_nested_req)
+    {
+        return;
+    }
+    // {"type":"x","data":{"a":{"a":...{"a":1}...}}}，连同外层共CJSON_NESTING_LIMIT层
+    size_t cap = (size_t)CJSON_NESTING_LIMIT * 8 + 64;
+    g_nested_req = (char *)__libc_malloc(cap);
+    size_t n = (size_t)snprintf(g_nested_req, cap, "{\"type\":\"x\",\"data\":");
+    for (int i = 2; i < CJSON_NESTING_LIMIT; i++)
+    {
+        n += (size_t)snprintf(g_nested_req + n, cap - n, "{\"a\":");
+    }
+    n += (size_t)snprintf(g_nested_req + n, cap - n, "{\"a\":1}");
+    for (int i = 1; i < CJSON_NESTING_LIMIT; i++)
+    {
+        g_nested_req[n++] = '}';
+    }
+    g_nested_req[n] = '\0';
+    g_nested_len = n;
+}
+
+static void run_parse_nested(void)
+{
+    cJSON *root = cJSON_ParseWithLength(g_nested_req, g_nested_len);
+    g_sink += root != NULL;
+    cJSON_Delete(root);
+}
+
+static void setup_metrics(void)
+{
+    // 让各标签维度都有数据，渲染走完所有分支
+    metrics_connection_opened("/brightness");
+    metrics_connection_opened("/wifi");
+    metrics_count_message("brightness_set_request");
+    metrics_count_message("wifi_scan_request");
+    metrics_observe_request("brightness_set_request", 1200);
+    metrics_observe_request("wifi_scan_request", 250000);
+    metrics_observe_backend(METRICS_BACKEND_BRIGHTNESS_WRITE, 80, true);
+    metrics_observe_exec(METRICS_EXEC_OK, 15000);
+}
+
+static void run_metrics_render(void)
+{
+    size_t len = 0;
+    char *text = metrics_render(&len);
+    g_sink += len;
+    free(text);
+}
+
+static void run_exec_output_max(void)
+{
+    char count[32];
+    snprintf(count, sizeof(count), "%d", WIFI_EXEC_OUTPUT_MAX);
+    const char *argv[] = {"head", "-c", count, "/dev/zero", NULL};
+    wifi_exec_buf out = {0};
+    g_sink += wifi_exec_run(argv, 0, &out) == WIFI_ERR_OK ? out.len : 0;
+    wifi_exec_buf_free(&out);
+}
+
+static const mb_case g_cases[] = {
+    {"json_parse/brightness_set_request", NULL, run_parse_brightness_set, false},
+    {"json_parse/wifi_connect_request", NULL, run_parse_wifi_connect, false},
+    {"json_parse/nesting_limit", setup_nested, run_parse_nested, false},
+    {"response/brightness_status", NULL, run_response_brightness_status, false},
+    {"response/wifi_scan_64", NULL, run_response_wifi_scan_64, false},
+    {"response/wifi_scan_1000", NULL, run_response_wifi_scan_1000, false},
+    {"scan_line/ascii", NULL, run_scan_line_ascii, false},
+    {"scan_line/utf8_escaped", NULL, run_scan_line_utf8, false},
+    {"scan_results/1000_lines", setup_scan_results, run_scan_results_1000, false},
+    {"wpa_status/parse", NULL, run_wpa_status, false},
+    {"decode_utf8/escaped_30_bytes", NULL, run_decode_utf8, false},
+    {"decode_utf8/ascii", NULL, run_decode_ascii, false},
+    {"metrics/render", setup_metrics, run_metrics_render, false},
+    {"exec/output_max", NULL, run_exec_output_max, true},
+};
+#define MB_CASE_COUNT (sizeof(g_cases) / sizeof(g_cases[0]))
+
+// ------------------------ 运行 ------------------------
+
+/**
+ * @brief 单个用例的测量结果
+ */
+typedef struct
+{
+    uint64_t iterations;  ///< 迭代次数
+    double ns_per_op;     ///< 每次操作耗时(纳秒)
+    double allocs_per_op; ///< 每次操作分配次数
+    double bytes_per_op;  ///< 每次操作分配字节数
+    double sent_per_op;   ///< 每次操作发送字节数
+} mb_result;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief 运行用例：迭代次数倍增直到单轮耗时达到min_time_ms
+ */
+static mb_result run_case(const mb_case *c, int min_time_ms)
+{
+    if (c->setup)
+    {
+        c->setup();
+    }
+    // 预热
+    for (int i = 0; i < 16; i++)
+    {
+        c->run();
+    }
+
+    mb_result r = {0};
+    int64_t min_ns = (int64_t)min_time_ms * 1000000LL;
+    for (uint64_t n = 1;; n *= 2)
+    {
+        uint64_t allocs0 = g_alloc_count;
+        uint64_t bytes0 = g_alloc_bytes;
+        size_t sent0 = g_sent_bytes;
+        int64_t t0 = now_ns();
+        for (uint64_t i = 0; i < n; i++)
+        {
+            c->run();
+        }
+        int64_t elapsed = now_ns() - t0;
+        if (elapsed >= min_ns || n >= (1ULL << 40))
+        {
+            r.iterations = n;
+            r.ns_per_op = (double)elapsed / (double)n;
+            r.allocs_per_op = (double)(g_alloc_count - allocs0) / (double)n;
+            r.bytes_per_op = (double)(g_alloc_bytes - bytes0) / (double)n;
+            r.sent_per_op = (double)(g_sent_bytes - sent0) / (double)n;
+            return r;
+        }
+    }
+}
+
+static void *stack_probe(void *arg)
+{
+    const mb_case *c = (const mb_case *)arg;
+    if (c->run)
+    {
+        c->run();
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在预先填充的MB_STACK_SIZE线程栈上执行一次用例，返回栈的最高水位
+ *
+ * 与pthread_attr_setstacksize一样，glibc把线程描述符与静态TLS放在栈区顶端，
+ * 水位包含这部分固定开销（见baseline用例）。
+ *
+ * @param c 用例
+ * @return long 使用的字节数，无法创建线程返回-1
+ */
+static long stack_high_water(const mb_case *c)
+{
+    unsigned char *stack = (unsigned char *)mmap(NULL, MB_STACK_SIZE, PROT_READ | PROT_WRITE,
+                                                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED)
+    {
+        return -1;
+    }
+    memset(stack, MB_STACK_PAINT, MB_STACK_SIZE);
+
+    long used = -1;
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstack(&attr, stack, MB_STACK_SIZE) == 0 &&
+        pthread_create(&thread, &attr, stack_probe, (void *)c) == 0)
+    {
+        pthread_join(thread, NULL);
+        size_t untouched = 0;
+        while (untouched < MB_STACK_SIZE && stack[untouched] == MB_STACK_PAINT)
+        {
+            untouched++;
+        }
+        used = (long)(MB_STACK_SIZE - untouched);
+    }
+    pthread_attr_destroy(&attr);
+    munmap(stack, MB_STACK_SIZE);
+    return used;
+}
+
+/**
+ * @brief --stack模式：逐个用例测量栈水位
+ *
+ * @param filter 用例名子串，NULL表示全部
+ * @return int 0成功，1测量失败
+ */
+static int run_stack(const char *filter)
+{
+    static const mb_case baseline = {"baseline", NULL, NULL, true};
+    printf("%-36s %12s  (stack %d B)\n", "benchmark", "stack B", MB_STACK_SIZE);
+    for (size_t i = 0; i <= MB_CASE_COUNT; i++)
+    {
+        const mb_case *c = i == 0 ? &baseline : &g_cases[i - 1];
+        if (filter && !strstr(c->name, filter))
+        {
+            continue;
+        }
+        if (c->setup)
+        {
+            c->setup();
+        }
+        long used = stack_high_water(c);
+        if (used < 0)
+        {
+            fprintf(stderr, "%s: 无法在 %d 字节的栈上创建线程\n", c->name, MB_STACK_SIZE);
+            return 1;
+        }
+        printf("%-36s %12ld\n", c->name, used);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "用法: %s [--filter 子串] [--min-time 毫秒] [--json] [--stack]\n", prog);
+}
+
+/**
+ * @brief 主函数
+ *
+ * @return int 0成功，1参数错误
+ */
+int main(int argc, char **argv)
+{
+    // 与服务器一致：cJSON经由计数分配器分配
+    metrics_alloc_init();
+
+    const char *filter = NULL;
+    int min_time_ms = MB_DEFAULT_MIN_TIME_MS;
+    bool json = false;
+    bool stack = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            min_time_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else if (strcmp(argv[i], "--stack") == 0)
+        {
+            stack = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (min_time_ms <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (stack)
+    {
+        return run_stack(filter);
+    }
+
+    cJSON *report = json ? cJSON_CreateArray() : NULL;
+    if (!json)
+    {
+        printf("%-36s %12s %10s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes/op",
+               "sent B/op");
+    }
+    for (size_t i = 0; i < MB_CASE_COUNT; i++)
+    {
+        const mb_case *c = &g_cases[i];
+        if (c->stack_only || (filter && !strstr(c->name, filter)))
+        {
+            continue;
+        }
+        mb_result r = run_case(c, min_time_ms);
+        if (json)
+        {
+            cJSON *item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "name", c->name);
+            cJSON_AddNumberToObject(item, "iterations", (double)r.iterations);
+            cJSON_AddNumberToObject(item, "ns_per_op", r.ns_per_op);
+            cJSON_AddNumberToObject(item, "allocs_per_op", r.allocs_per_op);
+            cJSON_AddNumberToObject(item, "bytes_per_op", r.bytes_per_op);
+            cJSON_AddNumberToObject(item, "sent_bytes_per_op", r.sent_per_op);
+            cJSON_AddItemToArray(report, item);
+        }
+        else
+        {
+            printf("%-36s %12.1f %10.2f %12.1f %12.1f\n", c->name, r.ns_per_op, r.allocs_per_op,
+                   r.bytes_per_op, r.sent_per_op);
+            fflush(stdout);
+        }
+    }
+    if (json)
+    {
+        char *text = cJSON_Print(report);
+        if (text)
+        {
+            printf("%s\n", text);
+            cJSON_free(text);
+        }
+        cJSON_Delete(report);
+    }
+
+    __libc_free(g_scan_text);
+    __libc_free(g_scan_work);
+    __libc_free(g_scan_nets);
+    return 0;
+}
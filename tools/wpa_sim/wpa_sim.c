@@ -0,0 +1,1404 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file wpa_sim.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief wpa_supplicant控制接口模拟器（无无线网卡环境下的WiFi端到端压测）
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 在<ctrl_dir>/<ifname>上监听与wpa_supplicant相同的UNIX数据报控制接口，wpa_cli可通过
+ * `wpa_cli -p <ctrl_dir> -i <ifname>`直接连接。支持：
+ * - 数千个BSS的scan_results（含按wpa_supplicant规则转义的长UTF-8 SSID）
+ * - 按命令配置的回复延迟（延迟回复排队发送，不阻塞其他客户端）
+ * - 连接流程与认证失败、关联拒绝、超时、网络未找到等结果
+ * - ATTACH客户端的主动事件（一次性或周期性）
+ *
+ * 场景通过夹具文件(-f)描述，语法见tools/wpa_sim/fixtures/dense_venue.conf。
+ */
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_DEFAULT_CTRL_DIR "/tmp/wpa_sim" ///< 默认控制接口目录
+#define SIM_DEFAULT_IFNAME "wlan0"          ///< 默认接口名
+#define SIM_DEFAULT_REPLY_LIMIT 4096        ///< 与wpa_supplicant一致的默认回复上限
+#define SIM_DEFAULT_SCAN_MS 2000            ///< 默认扫描耗时
+#define SIM_DEFAULT_CONNECT_MS 1500         ///< 默认连接耗时
+#define SIM_DEFAULT_PSK "password"          ///< 未配置密码的加密网络的默认密码
+#define SIM_MAX_MONITORS 16                 ///< 最多ATTACH客户端数量
+#define SIM_MAX_NETWORKS 64                 ///< 最多网络配置数量
+#define SIM_MAX_RULES 64                    ///< 每类夹具规则的最大数量
+#define SIM_SSID_MAX 32                     ///< SSID最大字节数
+#define SIM_PATH_MAX 108                    ///< 控制接口路径最大长度(sun_path)
+#define SIM_REQUEST_MAX 4096                ///< 单条命令最大长度
+#define SIM_ADDRESS "02:00:00:00:01:00"     ///< 模拟接口MAC地址
+#define SIM_IP_ADDRESS "192.168.100.2"      ///< 连接后报告的IP地址
+
+/**
+ * @brief BSS条目
+ */
+typedef struct
+{
+    char bssid[18];             ///< BSSID
+    int freq;                   ///< 频率(MHz)
+    int signal;                 ///< 信号强度(dBm)
+    char flags[96];             ///< 安全标志
+    uint8_t ssid[SIM_SSID_MAX]; ///< SSID原始字节
+    size_t ssid_len;            ///< SSID长度
+} sim_bss;
+
+/**
+ * @brief 网络配置（ADD_NETWORK/SET_NETWORK）
+ */
+typedef struct
+{
+    bool used;                  ///< 槽位是否使用
+    bool disabled;              ///< 是否禁用
+    uint8_t ssid[SIM_SSID_MAX]; ///< SSID原始字节
+    size_t ssid_len;            ///< SSID长度
+    char psk[64];               ///< 密码
+    bool key_mgmt_none;         ///< 是否为开放网络配置
+} sim_network;
+
+/**
+ * @brief 连接结果
+ */
+typedef enum
+{
+    SIM_RESULT_AUTO = 0,     ///< 按密码自动判断
+    SIM_RESULT_OK,           ///< 连接成功
+    SIM_RESULT_AUTH_FAIL,    ///< 认证失败（密码错误）
+    SIM_RESULT_ASSOC_REJECT, ///< 关联被拒绝
+    SIM_RESULT_TIMEOUT,      ///< 停留在ASSOCIATING
+} sim_result;
+
+/**
+ * @brief 夹具中按SSID匹配的规则（密码或连接结果）
+ */
+typedef struct
+{
+    uint8_t ssid[SIM_SSID_MAX]; ///< SSID原始字节
+    size_t ssid_len;            ///< SSID长度
+    char psk[64];               ///< 密码（psk规则）
+    sim_result result;          ///< 连接结果（connect_result规则）
+} sim_ssid_rule;
+
+/**
+ * @brief 命令回复延迟规则
+ */
+typedef struct
+{
+    char command[32]; ///< 命令名（大写），"*"匹配所有命令
+    int delay_ms;     ///< 延迟毫秒数
+} sim_delay_rule;
+
+/**
+ * @brief 定时动作类型
+ */
+typedef enum
+{
+    SIM_ACT_REPLY,        ///< 延迟回复
+    SIM_ACT_EVENT,        ///< 广播事件（可周期）
+    SIM_ACT_SCAN_DONE,    ///< 扫描完成
+    SIM_ACT_CONNECT_STEP, ///< 连接流程下一步
+} sim_action_kind;
+
+/**
+ * @brief 定时动作
+ */
+typedef struct sim_action
+{
+    int64_t due_ms;          ///< 到期时刻
+    sim_action_kind kind;    ///< 类型
+    char *text;              ///< 回复或事件文本
+    size_t text_len;         ///< 文本长度
+    struct sockaddr_un addr; ///< 回复目标
+    socklen_t addr_len;      ///< 目标地址长度
+    int period_ms;           ///< 周期事件的周期，0表示一次性
+    int step;                ///< 连接步骤
+    unsigned attempt;        ///< 连接尝试编号（过期步骤被忽略）
+    struct sim_action *next; ///< 按到期时刻排序的链表
+} sim_action;
+
+/**
+ * @brief 模拟器状态
+ */
+typedef struct
+{
+    int sock;                                      ///< 控制接口套接字
+    char sock_path[SIM_PATH_MAX];                  ///< 套接字路径
+    size_t reply_limit;                            ///< SCAN_RESULTS回复上限，0表示不限
+    int scan_ms;                                   ///< 扫描耗时
+    int connect_ms;                                ///< 连接耗时
+    sim_bss *bss;                                  ///< BSS表
+    size_t bss_count;                              ///< BSS数量
+    size_t bss_cap;                                ///< BSS表容量
+    sim_network networks[SIM_MAX_NETWORKS];        ///< 网络配置
+    sim_ssid_rule psk_rules[SIM_MAX_RULES];        ///< 密码规则
+    size_t psk_rule_count;                         ///< 密码规则数量
+    sim_ssid_rule result_rules[SIM_MAX_RULES];     ///< 连接结果规则
+    size_t result_rule_count;                      ///< 连接结果规则数量
+    sim_delay_rule delays[SIM_MAX_RULES];          ///< 回复延迟规则
+    size_t delay_count;                            ///< 回复延迟规则数量
+    struct sockaddr_un monitors[SIM_MAX_MONITORS]; ///< ATTACH客户端
+    socklen_t monitor_lens[SIM_MAX_MONITORS];      ///< ATTACH客户端地址长度
+    size_t monitor_count;                          ///< ATTACH客户端数量
+    const char *wpa_state;                         ///< 当前wpa_state
+    int current_id;                                ///< 当前网络id，-1表示无
+    int current_bss;                               ///< 当前BSS下标，-1表示无
+    unsigned attempt;                              ///< 连接尝试编号
+    bool scanning;                                 ///< 是否正在扫描
+    sim_action *actions;                           ///< 定时动作
+} sim_state;
+
+static sim_state g_sim;
+static volatile sig_atomic_t g_exit = 0;
+
+static void signal_handler(int sig)
+{
+    (void)sig;
+    g_exit = 1;
+}
+
+/**
+ * @brief 获取单调时钟(毫秒)
+ */
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ------------------------ 文本缓冲 ------------------------
+
+/**
+ * @brief 可增长的文本缓冲
+ */
+typedef struct
+{
+    char *data; ///< 数据
+    size_t len; ///< 长度
+    size_t cap; ///< 容量
+} sim_buf;
+
+static void buf_append(sim_buf *b, const char *s, size_t n)
+{
+    if (b->len + n + 1 > b->cap)
+    {
+        size_t cap = b->cap ? b->cap : 256;
+        while (b->len + n + 1 > cap)
+        {
+            cap *= 2;
+        }
+        char *p = realloc(b->data, cap);
+        if (!p)
+        {
+            return;
+        }
+        b->data = p;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static void buf_printf(sim_buf *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void buf_printf(sim_buf *b, const char *fmt, ...)
+{
+    char tmp[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0)
+    {
+        buf_append(b, tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+    }
+}
+
+/**
+ * @brief 按wpa_supplicant的printf_encode规则转义SSID
+ */
+static void buf_append_ssid(sim_buf *b, const uint8_t *ssid, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = ssid[i];
+        char esc[5];
+        switch (c)
+        {
+        case '"':
+            buf_append(b, "\\\"", 2);
+            break;
+        case '\\':
+            buf_append(b, "\\\\", 2);
+            break;
+        case '\033':
+            buf_append(b, "\\e", 2);
+            break;
+        case '\n':
+            buf_append(b, "\\n", 2);
+            break;
+        case '\r':
+            buf_append(b, "\\r", 2);
+            break;
+        case '\t':
+            buf_append(b, "\\t", 2);
+            break;
+        default:
+            if (c >= 32 && c <= 126)
+            {
+                buf_append(b, (const char *)&c, 1);
+            }
+            else
+            {
+                snprintf(esc, sizeof(esc), "\\x%02x", c);
+                buf_append(b, esc, 4);
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 解析带\xNN、\\、\"转义的SSID文本
+ *
+ * @return size_t SSID字节数
+ */
+static size_t parse_escaped_ssid(const char *text, uint8_t *out)
+{
+    size_t n = 0;
+    while (*text && n < SIM_SSID_MAX)
+    {
+        if (text[0] == '\\' && text[1] == 'x' && text[2] && text[3])
+        {
+            char hex[3] = {text[2], text[3], '\0'};
+            out[n++] = (uint8_t)strtoul(hex, NULL, 16);
+            text += 4;
+        }
+        else if (text[0] == '\\' && text[1])
+        {
+            out[n++] = (uint8_t)text[1];
+            text += 2;
+        }
+        else
+        {
+            out[n++] = (uint8_t)*text++;
+        }
+    }
+    return n;
+}
+
+// ------------------------ 定时动作 ------------------------
+
+/**
+ * @brief 按到期时刻插入定时动作
+ */
+static sim_action *schedule(sim_action_kind kind, int delay_ms)
+{
+    sim_action *a = calloc(1, sizeof(*a));
+    if (!a)
+    {
+        return NULL;
+    }
+    a->kind = kind;
+    a->due_ms = now_ms() + delay_ms;
+    sim_action **pp = &g_sim.actions;
+    while (*pp && (*pp)->due_ms <= a->due_ms)
+    {
+        pp = &(*pp)->next;
+    }
+    a->next = *pp;
+    *pp = a;
+    return a;
+}
+
+static void schedule_event(const char *text, int delay_ms, int period_ms)
+{
+    sim_action *a = schedule(SIM_ACT_EVENT, delay_ms);
+    if (a)
+    {
+        a->text = strdup(text);
+        a->text_len = a->text ? strlen(a->text) : 0;
+        a->period_ms = period_ms;
+    }
+}
+
+static void schedule_connect_step(int step, int delay_ms)
+{
+    sim_action *a = schedule(SIM_ACT_CONNECT_STEP, delay_ms);
+    if (a)
+    {
+        a->step = step;
+        a->attempt = g_sim.attempt;
+    }
+}
+
+/**
+ * @brief 向所有ATTACH客户端广播事件（自动补充"<3>"级别前缀）
+ */
+static void broadcast_event(const char *text)
+{
+    char msg[1024];
+    int n = snprintf(msg, sizeof(msg), "%s%s", text[0] == '<' ? "" : "<3>", text);
+    if (n <= 0)
+    {
+        return;
+    }
+    for (size_t i = 0; i < g_sim.monitor_count; i++)
+    {
+        sendto(g_sim.sock, msg, strlen(msg), MSG_DONTWAIT, (struct sockaddr *)&g_sim.monitors[i],
+               g_sim.monitor_lens[i]);
+    }
+}
+
+// ------------------------ 连接状态机 ------------------------
+
+static bool ssid_equal(const uint8_t *a, size_t alen, const uint8_t *b, size_t blen)
+{
+    return alen == blen && memcmp(a, b, alen) == 0;
+}
+
+static const sim_ssid_rule *find_rule(const sim_ssid_rule *rules, size_t count,
+                                      const uint8_t *ssid, size_t len)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ssid_equal(rules[i].ssid, rules[i].ssid_len, ssid, len))
+        {
+            return &rules[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 查找SSID匹配且信号最强的BSS
+ */
+static int find_best_bss(const uint8_t *ssid, size_t len)
+{
+    int best = -1;
+    for (size_t i = 0; i < g_sim.bss_count; i++)
+    {
+        if (ssid_equal(g_sim.bss[i].ssid, g_sim.bss[i].ssid_len, ssid, len) &&
+            (best < 0 || g_sim.bss[i].signal > g_sim.bss[best].signal))
+        {
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 根据夹具规则与密码决定连接结果
+ */
+static sim_result decide_result(const sim_network *net, const sim_bss *bss)
+{
+    const sim_ssid_rule *rule =
+        find_rule(g_sim.result_rules, g_sim.result_rule_count, net->ssid, net->ssid_len);
+    if (rule && rule->result != SIM_RESULT_AUTO)
+    {
+        return rule->result;
+    }
+    bool secured = strstr(bss->flags, "PSK") != NULL || strstr(bss->flags, "SAE") != NULL;
+    if (!secured)
+    {
+        return SIM_RESULT_OK;
+    }
+    if (net->key_mgmt_none)
+    {
+        return SIM_RESULT_ASSOC_REJECT;
+    }
+    const sim_ssid_rule *psk =
+        find_rule(g_sim.psk_rules, g_sim.psk_rule_count, net->ssid, net->ssid_len);
+    return strcmp(net->psk, psk ? psk->psk : SIM_DEFAULT_PSK) == 0 ? SIM_RESULT_OK
+                                                                   : SIM_RESULT_AUTH_FAIL;
+}
+
+/**
+ * @brief 断开当前连接
+ *
+ * @param reason 断开原因码
+ * @param notify 是否广播CTRL-EVENT-DISCONNECTED
+ */
+static void disconnect_current(int reason, bool notify)
+{
+    if (notify && g_sim.current_bss >= 0 && strcmp(g_sim.wpa_state, "COMPLETED") == 0)
+    {
+        char ev[128];
+        snprintf(ev, sizeof(ev), "CTRL-EVENT-DISCONNECTED bssid=%s reason=%d locally_generated=1",
+                 g_sim.bss[g_sim.current_bss].bssid, reason);
+        broadcast_event(ev);
+    }
+    g_sim.attempt++;
+    g_sim.current_id = -1;
+    g_sim.current_bss = -1;
+    g_sim.wpa_state = "DISCONNECTED";
+}
+
+/**
+ * @brief 开始连接网络
+ */
+static void start_connect(int id)
+{
+    disconnect_current(3, true);
+    g_sim.current_id = id;
+    g_sim.wpa_state = "SCANNING";
+    schedule_connect_step(0, g_sim.connect_ms / 4);
+}
+
+/**
+ * @brief 执行连接流程的一步
+ */
+static void connect_step(int step)
+{
+    int id = g_sim.current_id;
+    if (id < 0 || !g_sim.networks[id].used)
+    {
+        return;
+    }
+    sim_network *net = &g_sim.networks[id];
+    char ev[512];
+    sim_buf ssid_txt = {0};
+    buf_append_ssid(&ssid_txt, net->ssid, net->ssid_len);
+    const char *ssid = ssid_txt.data ? ssid_txt.data : "";
+
+    if (step == 0)
+    {
+        int b = find_best_bss(net->ssid, net->ssid_len);
+        if (b < 0)
+        {
+            // 与wpa_supplicant一致：未找到网络时继续扫描
+            broadcast_event("CTRL-EVENT-NETWORK-NOT-FOUND");
+            schedule_connect_step(0, g_sim.connect_ms);
+        }
+        else
+        {
+            g_sim.current_bss = b;
+            g_sim.wpa_state = "ASSOCIATING";
+            snprintf(ev, sizeof(ev), "Trying to associate with %s (SSID='%s' freq=%d MHz)",
+                     g_sim.bss[b].bssid, ssid, g_sim.bss[b].freq);
+            broadcast_event(ev);
+            schedule_connect_step(1, g_sim.connect_ms / 4);
+        }
+        free(ssid_txt.data);
+        return;
+    }
+
+    const sim_bss *bss = &g_sim.bss[g_sim.current_bss];
+    sim_result result = decide_result(net, bss);
+    if (step == 1)
+    {
+        if (result == SIM_RESULT_TIMEOUT)
+        {
+            // 停留在ASSOCIATING，直到新的连接请求或断开
+        }
+        else if (result == SIM_RESULT_ASSOC_REJECT)
+        {
+            snprintf(ev, sizeof(ev), "CTRL-EVENT-ASSOC-REJECT bssid=%s status_code=17",
+                     bss->bssid);
+            broadcast_event(ev);
+            g_sim.current_bss = -1;
+            g_sim.wpa_state = "SCANNING";
+            schedule_connect_step(0, g_sim.connect_ms);
+        }
+        else
+        {
+            g_sim.wpa_state = "4WAY_HANDSHAKE";
+            schedule_connect_step(2, g_sim.connect_ms / 2);
+        }
+    }
+    else if (result == SIM_RESULT_AUTH_FAIL)
+    {
+        snprintf(ev, sizeof(ev), "CTRL-EVENT-DISCONNECTED bssid=%s reason=15", bss->bssid);
+        broadcast_event(ev);
+        snprintf(ev, sizeof(ev),
+                 "CTRL-EVENT-SSID-TEMP-DISABLED id=%d ssid=\"%s\" auth_failures=1 duration=10 "
+                 "reason=WRONG_KEY",
+                 id, ssid);
+        broadcast_event(ev);
+        g_sim.current_id = -1;
+        g_sim.current_bss = -1;
+        g_sim.wpa_state = "DISCONNECTED";
+    }
+    else
+    {
+        g_sim.wpa_state = "COMPLETED";
+        snprintf(ev, sizeof(ev),
+                 "CTRL-EVENT-CONNECTED - Connection to %s completed [id=%d id_str=]", bss->bssid,
+                 id);
+        broadcast_event(ev);
+    }
+    free(ssid_txt.data);
+}
+
+// ------------------------ 命令处理 ------------------------
+
+/**
+ * @brief 解析网络id参数
+ *
+ * @return int 网络id，无效时返回-1
+ */
+static int parse_network_id(const char *arg)
+{
+    if (!arg)
+    {
+        return -1;
+    }
+    char *end = NULL;
+    long id = strtol(arg, &end, 10);
+    if (end == arg || id < 0 || id >= SIM_MAX_NETWORKS || !g_sim.networks[id].used)
+    {
+        return -1;
+    }
+    return (int)id;
+}
+
+/**
+ * @brief 处理SET_NETWORK参数：<id> <field> <value>
+ */
+static bool cmd_set_network(char *args)
+{
+    char *save = NULL;
+    int id = parse_network_id(strtok_r(args, " ", &save));
+    char *field = strtok_r(NULL, " ", &save);
+    char *value = save;
+    if (id < 0 || !field || !value || !*value)
+    {
+        return false;
+    }
+    sim_network *net = &g_sim.networks[id];
+    size_t vlen = strlen(value);
+    bool quoted = vlen >= 2 && value[0] == '"' && value[vlen - 1] == '"';
+
+    if (strcmp(field, "ssid") == 0)
+    {
+        if (quoted)
+        {
+            net->ssid_len = vlen - 2 > SIM_SSID_MAX ? SIM_SSID_MAX : vlen - 2;
+            memcpy(net->ssid, value + 1, net->ssid_len);
+        }
+        else
+        {
+            // 十六进制形式
+            net->ssid_len = 0;
+            for (size_t i = 0; i + 1 < vlen && net->ssid_len < SIM_SSID_MAX; i += 2)
+            {
+                char hex[3] = {value[i], value[i + 1], '\0'};
+                net->ssid[net->ssid_len++] = (uint8_t)strtoul(hex, NULL, 16);
+            }
+        }
+        return true;
+    }
+    if (strcmp(field, "psk") == 0)
+    {
+        if (!quoted || vlen - 2 < 8 || vlen - 2 > 63)
+        {
+            return false;
+        }
+        snprintf(net->psk, sizeof(net->psk), "%.*s", (int)(vlen - 2), value + 1);
+        net->key_mgmt_none = false;
+        return true;
+    }
+    if (strcmp(field, "key_mgmt") == 0)
+    {
+        net->key_mgmt_none = (strcmp(value, "NONE") == 0);
+        return true;
+    }
+    // 其他字段接受但忽略
+    return true;
+}
+
+/**
+ * @brief 设置单个或全部网络的启用状态
+ */
+static bool set_networks_disabled(const char *arg, bool disabled)
+{
+    if (arg && strcmp(arg, "all") == 0)
+    {
+        for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+        {
+            g_sim.networks[i].disabled = disabled;
+        }
+        if (disabled && g_sim.current_id >= 0)
+        {
+            disconnect_current(3, true);
+        }
+        return true;
+    }
+    int id = parse_network_id(arg);
+    if (id < 0)
+    {
+        return false;
+    }
+    g_sim.networks[id].disabled = disabled;
+    if (disabled && id == g_sim.current_id)
+    {
+        disconnect_current(3, true);
+    }
+    return true;
+}
+
+static void reply_status(sim_buf *out)
+{
+    if (g_sim.current_bss >= 0 && strcmp(g_sim.wpa_state, "SCANNING") != 0)
+    {
+        const sim_bss *bss = &g_sim.bss[g_sim.current_bss];
+        const sim_network *net = &g_sim.networks[g_sim.current_id];
+        buf_printf(out, "bssid=%s\nfreq=%d\nssid=", bss->bssid, bss->freq);
+        buf_append_ssid(out, net->ssid, net->ssid_len);
+        buf_printf(out, "\nid=%d\nmode=station\n", g_sim.current_id);
+        if (strcmp(g_sim.wpa_state, "COMPLETED") == 0)
+        {
+            bool secured = !net->key_mgmt_none && strstr(bss->flags, "PSK") != NULL;
+            buf_printf(out, "pairwise_cipher=%s\ngroup_cipher=%s\nkey_mgmt=%s\n",
+                       secured ? "CCMP" : "NONE", secured ? "CCMP" : "NONE",
+                       secured ? "WPA2-PSK" : "NONE");
+        }
+    }
+    buf_printf(out, "wpa_state=%s\n", g_sim.wpa_state);
+    if (strcmp(g_sim.wpa_state, "COMPLETED") == 0)
+    {
+        buf_printf(out, "ip_address=%s\n", SIM_IP_ADDRESS);
+    }
+    buf_printf(out, "address=%s\nuuid=00000000-0000-0000-0000-000000000000\n", SIM_ADDRESS);
+}
+
+static void reply_scan_results(sim_buf *out)
+{
+    buf_printf(out, "bssid / frequency / signal level / flags / ssid\n");
+    sim_buf line = {0};
+    for (size_t i = 0; i < g_sim.bss_count; i++)
+    {
+        const sim_bss *bss = &g_sim.bss[i];
+        line.len = 0;
+        buf_printf(&line, "%s\t%d\t%d\t%s\t", bss->bssid, bss->freq, bss->signal, bss->flags);
+        buf_append_ssid(&line, bss->ssid, bss->ssid_len);
+        buf_append(&line, "\n", 1);
+        // 与wpa_supplicant一致：放不下的条目整条丢弃
+        if (g_sim.reply_limit && out->len + line.len > g_sim.reply_limit)
+        {
+            break;
+        }
+        buf_append(out, line.data, line.len);
+    }
+    free(line.data);
+}
+
+static void reply_list_networks(sim_buf *out)
+{
+    buf_printf(out, "network id / ssid / bssid / flags\n");
+    for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+    {
+        const sim_network *net = &g_sim.networks[i];
+        if (!net->used)
+        {
+            continue;
+        }
+        buf_printf(out, "%d\t", i);
+        buf_append_ssid(out, net->ssid, net->ssid_len);
+        buf_printf(out, "\tany\t%s\n",
+                   i == g_sim.current_id ? "[CURRENT]" : (net->disabled ? "[DISABLED]" : ""));
+    }
+}
+
+/**
+ * @brief 处理一条控制命令
+ *
+ * @param cmd 命令文本（会被修改）
+ * @param out 回复
+ */
+static void handle_command(char *cmd, sim_buf *out)
+{
+    char *args = strchr(cmd, ' ');
+    if (args)
+    {
+        *args++ = '\0';
+    }
+
+    if (strcmp(cmd, "PING") == 0)
+    {
+        buf_printf(out, "PONG\n");
+    }
+    else if (strcmp(cmd, "STATUS") == 0)
+    {
+        reply_status(out);
+    }
+    else if (strcmp(cmd, "SCAN") == 0)
+    {
+        if (g_sim.scanning)
+        {
+            buf_printf(out, "FAIL-BUSY\n");
+            return;
+        }
+        g_sim.scanning = true;
+        broadcast_event("CTRL-EVENT-SCAN-STARTED ");
+        schedule(SIM_ACT_SCAN_DONE, g_sim.scan_ms);
+        buf_printf(out, "OK\n");
+    }
+    else if (strcmp(cmd, "SCAN_RESULTS") == 0)
+    {
+        reply_scan_results(out);
+    }
+    else if (strcmp(cmd, "LIST_NETWORKS") == 0)
+    {
+        reply_list_networks(out);
+    }
+    else if (strcmp(cmd, "ADD_NETWORK") == 0)
+    {
+        for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+        {
+            if (!g_sim.networks[i].used)
+            {
+                memset(&g_sim.networks[i], 0, sizeof(g_sim.networks[i]));
+                g_sim.networks[i].used = true;
+                g_sim.networks[i].disabled = true;
+                buf_printf(out, "%d\n", i);
+                return;
+            }
+        }
+        buf_printf(out, "FAIL\n");
+    }
+    else if (strcmp(cmd, "REMOVE_NETWORK") == 0)
+    {
+        bool all = args && strcmp(args, "all") == 0;
+        int id = all ? -1 : parse_network_id(args);
+        if (!all && id < 0)
+        {
+            buf_printf(out, "FAIL\n");
+            return;
+        }
+        for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+        {
+            if (all || i == id)
+            {
+                if (i == g_sim.current_id)
+                {
+                    disconnect_current(3, true);
+                }
+                g_sim.networks[i].used = false;
+            }
+        }
+        buf_printf(out, "OK\n");
+    }
+    else if (strcmp(cmd, "SET_NETWORK") == 0)
+    {
+        buf_printf(out, "%s\n", args && cmd_set_network(args) ? "OK" : "FAIL");
+    }
+    else if (strcmp(cmd, "ENABLE_NETWORK") == 0)
+    {
+        buf_printf(out, "%s\n", set_networks_disabled(args, false) ? "OK" : "FAIL");
+    }
+    else if (strcmp(cmd, "DISABLE_NETWORK") == 0)
+    {
+        buf_printf(out, "%s\n", set_networks_disabled(args, true) ? "OK" : "FAIL");
+    }
+    else if (strcmp(cmd, "SELECT_NETWORK") == 0)
+    {
+        int id = parse_network_id(args);
+        if (id < 0)
+        {
+            buf_printf(out, "FAIL\n");
+            return;
+        }
+        for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+        {
+            g_sim.networks[i].disabled = (i != id);
+        }
+        start_connect(id);
+        buf_printf(out, "OK\n");
+    }
+    else if (strcmp(cmd, "RECONNECT") == 0)
+    {
+        if (g_sim.current_id < 0)
+        {
+            for (int i = 0; i < SIM_MAX_NETWORKS; i++)
+            {
+                if (g_sim.networks[i].used && !g_sim.networks[i].disabled)
+                {
+                    start_connect(i);
+                    break;
+                }
+            }
+        }
+        buf_printf(out, "OK\n");
+    }
+    else if (strcmp(cmd, "DISCONNECT") == 0)
+    {
+        disconnect_current(3, true);
+        buf_printf(out, "OK\n");
+    }
+    else if (strcmp(cmd, "SIGNAL_POLL") == 0)
+    {
+        if (strcmp(g_sim.wpa_state, "COMPLETED") != 0)
+        {
+            buf_printf(out, "FAIL\n");
+            return;
+        }
+        const sim_bss *bss = &g_sim.bss[g_sim.current_bss];
+        buf_printf(out, "RSSI=%d\nLINKSPEED=300\nNOISE=9999\nFREQUENCY=%d\n", bss->signal,
+                   bss->freq);
+    }
+    else if (strcmp(cmd, "ATTACH") == 0 || strcmp(cmd, "DETACH") == 0 ||
+             strcmp(cmd, "SAVE_CONFIG") == 0 || strcmp(cmd, "LEVEL") == 0)
+    {
+        // ATTACH/DETACH在handle_datagram中处理地址登记
+        buf_printf(out, "OK\n");
+    }
+    else
+    {
+        buf_printf(out, "UNKNOWN COMMAND\n");
+    }
+}
+
+/**
+ * @brief 查询命令的回复延迟
+ */
+static int command_delay(const char *cmd)
+{
+    int wildcard = 0;
+    size_t n = strcspn(cmd, " ");
+    for (size_t i = 0; i < g_sim.delay_count; i++)
+    {
+        if (strcmp(g_sim.delays[i].command, "*") == 0)
+        {
+            wildcard = g_sim.delays[i].delay_ms;
+        }
+        else if (strlen(g_sim.delays[i].command) == n &&
+                 strncmp(g_sim.delays[i].command, cmd, n) == 0)
+        {
+            return g_sim.delays[i].delay_ms;
+        }
+    }
+    return wildcard;
+}
+
+/**
+ * @brief 登记或注销ATTACH客户端
+ */
+static void update_monitor(const struct sockaddr_un *addr, socklen_t len, bool attach)
+{
+    for (size_t i = 0; i < g_sim.monitor_count; i++)
+    {
+        if (g_sim.monitor_lens[i] == len && memcmp(&g_sim.monitors[i], addr, len) == 0)
+        {
+            if (!attach)
+            {
+                g_sim.monitor_count--;
+                g_sim.monitors[i] = g_sim.monitors[g_sim.monitor_count];
+                g_sim.monitor_lens[i] = g_sim.monitor_lens[g_sim.monitor_count];
+            }
+            return;
+        }
+    }
+    if (attach && g_sim.monitor_count < SIM_MAX_MONITORS)
+    {
+        g_sim.monitors[g_sim.monitor_count] = *addr;
+        g_sim.monitor_lens[g_sim.monitor_count] = len;
+        g_sim.monitor_count++;
+    }
+}
+
+/**
+ * @brief 接收并处理一个控制数据报
+ */
+static void handle_datagram(void)
+{
+    char req[SIM_REQUEST_MAX];
+    struct sockaddr_un from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n = recvfrom(g_sim.sock, req, sizeof(req) - 1, 0, (struct sockaddr *)&from, &from_len);
+    if (n <= 0)
+    {
+        return;
+    }
+    req[n] = '\0';
+    req[strcspn(req, "\n")] = '\0';
+
+    if (strcmp(req, "ATTACH") == 0 || strcmp(req, "DETACH") == 0)
+    {
+        update_monitor(&from, from_len, req[0] == 'A');
+    }
+    int delay = command_delay(req);
+
+    sim_buf out = {0};
+    handle_command(req, &out);
+    if (!out.data)
+    {
+        return;
+    }
+    if (delay <= 0)
+    {
+        sendto(g_sim.sock, out.data, out.len, 0, (struct sockaddr *)&from, from_len);
+        free(out.data);
+        return;
+    }
+    sim_action *a = schedule(SIM_ACT_REPLY, delay);
+    if (!a)
+    {
+        free(out.data);
+        return;
+    }
+    a->text = out.data;
+    a->text_len = out.len;
+    a->addr = from;
+    a->addr_len = from_len;
+}
+
+/**
+ * @brief 执行所有到期的定时动作
+ *
+ * @return int 距下一个动作的毫秒数，无动作时返回-1
+ */
+static int run_due_actions(void)
+{
+    for (;;)
+    {
+        sim_action *a = g_sim.actions;
+        if (!a)
+        {
+            return -1;
+        }
+        int64_t now = now_ms();
+        if (a->due_ms > now)
+        {
+            return (int)(a->due_ms - now);
+        }
+        g_sim.actions = a->next;
+
+        switch (a->kind)
+        {
+        case SIM_ACT_REPLY:
+            sendto(g_sim.sock, a->text, a->text_len, 0, (struct sockaddr *)&a->addr, a->addr_len);
+            break;
+        case SIM_ACT_EVENT:
+            broadcast_event(a->text);
+            if (a->period_ms > 0)
+            {
+                schedule_event(a->text, a->period_ms, a->period_ms);
+            }
+            break;
+        case SIM_ACT_SCAN_DONE:
+            g_sim.scanning = false;
+            broadcast_event("CTRL-EVENT-SCAN-RESULTS ");
+            break;
+        case SIM_ACT_CONNECT_STEP:
+            if (a->attempt == g_sim.attempt)
+            {
+                connect_step(a->step);
+            }
+            break;
+        }
+        free(a->text);
+        free(a);
+    }
+}
+
+// ------------------------ 场景 ------------------------
+
+static sim_bss *add_bss(void)
+{
+    if (g_sim.bss_count == g_sim.bss_cap)
+    {
+        size_t cap = g_sim.bss_cap ? g_sim.bss_cap * 2 : 256;
+        sim_bss *p = realloc(g_sim.bss, cap * sizeof(sim_bss));
+        if (!p)
+        {
+            return NULL;
+        }
+        g_sim.bss = p;
+        g_sim.bss_cap = cap;
+    }
+    sim_bss *bss = &g_sim.bss[g_sim.bss_count++];
+    memset(bss, 0, sizeof(*bss));
+    return bss;
+}
+
+/**
+ * @brief 生成密集场景的BSS
+ *
+ * 同一SSID由多个AP广播；SSID混合长中文（30字节以上）、4字节emoji、ASCII、
+ * 需要转义的引号/反斜杠以及隐藏网络。
+ *
+ * @param count 生成数量
+ */
+static void generate_bss(size_t count)
+{
+    static const char *flags[] = {
+        "[WPA2-PSK-CCMP][ESS]",
+        "[WPA2-PSK-CCMP][WPA2-SAE-CCMP][ESS]",
+        "[ESS]",
+        "[WPA-PSK-TKIP][WPA2-PSK-CCMP+TKIP][ESS][WPS]",
+        "[WPA2-EAP-CCMP][ESS]",
+    };
+    size_t base = g_sim.bss_count;
+    for (size_t i = 0; i < count; i++)
+    {
+        sim_bss *bss = add_bss();
+        if (!bss)
+        {
+            return;
+        }
+        size_t k = base + i;
+        snprintf(bss->bssid, sizeof(bss->bssid), "02:%02x:%02x:%02x:%02x:%02x",
+                 (unsigned)((k >> 24) & 0xff), (unsigned)((k >> 16) & 0xff),
+                 (unsigned)((k >> 8) & 0xff), (unsigned)(k & 0xff), (unsigned)(k * 7 & 0xff));
+        bss->freq = (k % 3 == 0) ? 2412 + 5 * (int)(k % 13) : 5180 + 20 * (int)(k % 8);
+        bss->signal = -30 - (int)(k * 37 % 66);
+        snprintf(bss->flags, sizeof(bss->flags), "%s", flags[k % 5]);
+
+        char ssid[64];
+        switch (k % 5)
+        {
+        case 0:
+            snprintf(ssid, sizeof(ssid), "星巴克咖啡馆访客网络%02u", (unsigned)(k / 5 % 100));
+            break;
+        case 1:
+            snprintf(ssid, sizeof(ssid), "\xf0\x9f\x93\xb6大堂-Lobby-%03u", (unsigned)(k / 5 % 1000));
+            break;
+        case 2:
+            snprintf(ssid, sizeof(ssid), "Venue-Guest-%04u", (unsigned)(k / 5 % 10000));
+            break;
+        case 3:
+            snprintf(ssid, sizeof(ssid), "Bob's \"Cafe\" \\%u", (unsigned)(k / 5 % 100));
+            break;
+        default:
+            // 每50个BSS中有一个隐藏网络
+            snprintf(ssid, sizeof(ssid), "%s%zu", k % 50 == 4 ? "" : "AP-", k);
+            if (k % 50 == 4)
+            {
+                ssid[0] = '\0';
+            }
+            break;
+        }
+        bss->ssid_len = strlen(ssid) > SIM_SSID_MAX ? SIM_SSID_MAX : strlen(ssid);
+        memcpy(bss->ssid, ssid, bss->ssid_len);
+    }
+}
+
+/**
+ * @brief 解析SSID规则的SSID字段（取行的剩余部分）
+ */
+static void parse_rule_ssid(sim_ssid_rule *rule, const char *text)
+{
+    rule->ssid_len = parse_escaped_ssid(text, rule->ssid);
+}
+
+/**
+ * @brief 加载夹具文件
+ *
+ * @param path 文件路径
+ * @return int 0成功，-1失败
+ */
+static int load_fixture(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        fprintf(stderr, "无法打开夹具 %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[1024];
+    int lineno = 0;
+    int ret = 0;
+    while (ret == 0 && fgets(line, sizeof(line), fp))
+    {
+        lineno++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char *p = line + strspn(line, " \t");
+        if (*p == '\0' || *p == '#')
+        {
+            continue;
+        }
+        char key[32];
+        int off = 0;
+        if (sscanf(p, "%31s %n", key, &off) != 1)
+        {
+            continue;
+        }
+        char *rest = p + off;
+
+        if (strcmp(key, "generate") == 0)
+        {
+            generate_bss((size_t)strtoul(rest, NULL, 10));
+        }
+        else if (strcmp(key, "bss") == 0)
+        {
+            // bss <bssid> <freq> <signal> <flags> <ssid...>
+            sim_bss *bss = add_bss();
+            int n = 0;
+            if (!bss || sscanf(rest, "%17s %d %d %95s %n", bss->bssid, &bss->freq, &bss->signal,
+                               bss->flags, &n) < 4)
+            {
+                ret = -1;
+                break;
+            }
+            bss->ssid_len = parse_escaped_ssid(rest + n, bss->ssid);
+        }
+        else if (strcmp(key, "psk") == 0 && g_sim.psk_rule_count < SIM_MAX_RULES)
+        {
+            // psk <password> <ssid...>
+            sim_ssid_rule *rule = &g_sim.psk_rules[g_sim.psk_rule_count];
+            int n = 0;
+            if (sscanf(rest, "%63s %n", rule->psk, &n) < 1)
+            {
+                ret = -1;
+                break;
+            }
+            parse_rule_ssid(rule, rest + n);
+            g_sim.psk_rule_count++;
+        }
+        else if (strcmp(key, "connect_result") == 0 && g_sim.result_rule_count < SIM_MAX_RULES)
+        {
+            // connect_result ok|auth_fail|assoc_reject|timeout <ssid...>
+            static const char *names[] = {"auto", "ok", "auth_fail", "assoc_reject", "timeout"};
+            sim_ssid_rule *rule = &g_sim.result_rules[g_sim.result_rule_count];
+            char name[32];
+            int n = 0;
+            if (sscanf(rest, "%31s %n", name, &n) < 1)
+            {
+                ret = -1;
+                break;
+            }
+            rule->result = SIM_RESULT_AUTO;
+            for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+            {
+                if (strcmp(name, names[i]) == 0)
+                {
+                    rule->result = (sim_result)i;
+                }
+            }
+            parse_rule_ssid(rule, rest + n);
+            g_sim.result_rule_count++;
+        }
+        else if (strcmp(key, "delay") == 0 && g_sim.delay_count < SIM_MAX_RULES)
+        {
+            // delay <COMMAND|*> <ms>
+            sim_delay_rule *rule = &g_sim.delays[g_sim.delay_count];
+            if (sscanf(rest, "%31s %d", rule->command, &rule->delay_ms) != 2)
+            {
+                ret = -1;
+                break;
+            }
+            g_sim.delay_count++;
+        }
+        else if (strcmp(key, "event") == 0 || strcmp(key, "event_every") == 0)
+        {
+            // event <at_ms> <text> / event_every <period_ms> <text>
+            int ms = 0;
+            int n = 0;
+            if (sscanf(rest, "%d %n", &ms, &n) < 1 || rest[n] == '\0')
+            {
+                ret = -1;
+                break;
+            }
+            schedule_event(rest + n, ms, key[5] == '_' ? ms : 0);
+        }
+        else if (strcmp(key, "scan_ms") == 0)
+        {
+            g_sim.scan_ms = atoi(rest);
+        }
+        else if (strcmp(key, "connect_ms") == 0)
+        {
+            g_sim.connect_ms = atoi(rest);
+        }
+        else if (strcmp(key, "reply_limit") == 0)
+        {
+            g_sim.reply_limit = (size_t)strtoul(rest, NULL, 10);
+        }
+        else
+        {
+            ret = -1;
+        }
+    }
+    if (ret != 0)
+    {
+        fprintf(stderr, "%s:%d: 无法解析: %s\n", path, lineno, line);
+    }
+    fclose(fp);
+    return ret;
+}
+
+// ------------------------ 主程序 ------------------------
+
+/**
+ * @brief 创建控制接口套接字
+ *
+ * @return int 0成功，-1失败
+ */
+static int open_ctrl_socket(const char *dir, const char *ifname)
+{
+    if (mkdir(dir, 0770) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "无法创建目录 %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    int n = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s", dir, ifname);
+    if (n < 0 || (size_t)n >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "控制接口路径过长\n");
+        return -1;
+    }
+    snprintf(g_sim.sock_path, sizeof(g_sim.sock_path), "%s", addr.sun_path);
+
+    g_sim.sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (g_sim.sock < 0)
+    {
+        return -1;
+    }
+    // 允许较大的scan_results回复
+    int sndbuf = 4 * 1024 * 1024;
+    setsockopt(g_sim.sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    unlink(addr.sun_path);
+    if (bind(g_sim.sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        fprintf(stderr, "无法绑定 %s: %s\n", addr.sun_path, strerror(errno));
+        close(g_sim.sock);
+        return -1;
+    }
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "用法: %s [-p ctrl_dir] [-i ifname] [-f fixture] [-n bss_count] [-d delay_ms]\n"
+            "          [-r reply_limit]\n"
+            "  -p  控制接口目录（默认%s），wpa_cli -p使用相同目录\n"
+            "  -i  接口名（默认%s）\n"
+            "  -f  场景夹具文件\n"
+            "  -n  额外生成的BSS数量\n"
+            "  -d  所有命令的默认回复延迟(毫秒)\n"
+            "  -r  SCAN_RESULTS回复上限(字节，默认%d，0不限)\n",
+            prog, SIM_DEFAULT_CTRL_DIR, SIM_DEFAULT_IFNAME, SIM_DEFAULT_REPLY_LIMIT);
+}
+
+/**
+ * @brief 主函数
+ *
+ * @return int 0正常退出，1参数或初始化错误
+ */
+int main(int argc, char **argv)
+{
+    const char *ctrl_dir = SIM_DEFAULT_CTRL_DIR;
+    const char *ifname = SIM_DEFAULT_IFNAME;
+    const char *fixture = NULL;
+    size_t generate = 0;
+    int default_delay = 0;
+
+    g_sim.reply_limit = SIM_DEFAULT_REPLY_LIMIT;
+    g_sim.scan_ms = SIM_DEFAULT_SCAN_MS;
+    g_sim.connect_ms = SIM_DEFAULT_CONNECT_MS;
+    g_sim.wpa_state = "DISCONNECTED";
+    g_sim.current_id = -1;
+    g_sim.current_bss = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:i:f:n:d:r:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            ctrl_dir = optarg;
+            break;
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'f':
+            fixture = optarg;
+            break;
+        case 'n':
+            generate = (size_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            default_delay = atoi(optarg);
+            break;
+        case 'r':
+            g_sim.reply_limit = (size_t)strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (fixture && load_fixture(fixture) != 0)
+    {
+        return 1;
+    }
+    generate_bss(generate);
+    if (default_delay > 0 && g_sim.delay_count < SIM_MAX_RULES)
+    {
+        snprintf(g_sim.delays[g_sim.delay_count].command, sizeof(g_sim.delays[0].command), "*");
+        g_sim.delays[g_sim.delay_count].delay_ms = default_delay;
+        g_sim.delay_count++;
+    }
+    if (open_ctrl_socket(ctrl_dir, ifname) != 0)
+    {
+        return 1;
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+    printf("wpa_sim: %s，%zu 个BSS\n", g_sim.sock_path, g_sim.bss_count);
+    fflush(stdout);
+
+    while (!g_exit)
+    {
+        int timeout = run_due_actions();
+        struct pollfd pfd = {.fd = g_sim.sock, .events = POLLIN};
+        int rc = poll(&pfd, 1, timeout);
+        if (rc > 0 && (pfd.revents & POLLIN))
+        {
+            handle_datagram();
+        }
+        else if (rc < 0 && errno != EINTR)
+        {
+            break;
+        }
+    }
+
+    unlink(g_sim.sock_path);
+    close(g_sim.sock);
+    while (g_sim.actions)
+    {
+        sim_action *a = g_sim.actions;
+        g_sim.actions = a->next;
+        free(a->text);
+        free(a);
+    }
+    free(g_sim.bss);
+    return 0;
+}
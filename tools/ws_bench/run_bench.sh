@@ -0,0 +1,77 @@
+#!/bin/bash
+# 在模拟后端上运行WebSocket基准测试
+#
+# 用法: tools/ws_bench/run_bench.sh <build_dir> [输出文件] [ws_bench参数...]
+# 需要以 -DBUILD_BENCHMARKS=ON 配置构建目录。
+# 脚本在临时目录中创建模拟背光sysfs树，启动模拟服务器，运行ws_bench并写出JSON结果。
+# BENCH_TRANSPORT=unix 时经UNIX域套接字连接（默认tcp，走回环），结束时输出服务器消耗的CPU时间。
+# 自动传入 --server-pid，配合 --idle N 可得到每个空闲连接的服务器内存开销。
+
+set -euo pipefail
+
+TRANSPORT=${BENCH_TRANSPORT:-tcp}
+
+BUILD_DIR=${1:?"用法: $0 <build_dir> [输出文件] [ws_bench参数...]"}
+OUTPUT=${2:-bench_output.json}
+shift $(($# >= 2 ? 2 : 1))
+
+SERVER="$BUILD_DIR/CWebSocketServerForFlutterPanel_sim"
+BENCH="$BUILD_DIR/ws_bench"
+for bin in "$SERVER" "$BENCH"; do
+    if [ ! -x "$bin" ]; then
+        echo "未找到 $bin，请使用 -DBUILD_BENCHMARKS=ON 构建" >&2
+        exit 1
+    fi
+done
+
+SIM_DIR=$(mktemp -d)
+SERVER_PID=""
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$SIM_DIR"
+}
+trap cleanup EXIT
+
+# 模拟背光设备
+mkdir -p "$SIM_DIR/backlight/sim_backlight"
+echo 255 > "$SIM_DIR/backlight/sim_backlight/max_brightness"
+echo 128 > "$SIM_DIR/backlight/sim_backlight/brightness"
+echo 128 > "$SIM_DIR/backlight/sim_backlight/actual_brightness"
+echo raw > "$SIM_DIR/backlight/sim_backlight/type"
+
+SOCKET="$SIM_DIR/panel.sock"
+SERVER_UNIX_SOCKET="$SOCKET" \
+BRIGHTNESS_SYSFS_ROOT="$SIM_DIR/backlight" \
+BRIGHTNESS_PERSIST_PATH="" \
+WIFI_SNAPSHOT_PATH="" \
+BRIGHTNESS_IIO_DIR="$SIM_DIR/iio" \
+    "$SERVER" > "$SIM_DIR/server.log" 2>&1 &
+SERVER_PID=$!
+
+# 等待服务器开始监听
+for _ in $(seq 50); do
+    if [ -S "$SOCKET" ] && (exec 3<>/dev/tcp/127.0.0.1/8080) 2>/dev/null; then
+        break
+    fi
+    sleep 0.1
+done
+
+# 服务器累计CPU时间（/proc/<pid>/stat 的 utime + stime，单位为时钟滴答）
+server_cpu_ticks() {
+    awk '{print $14 + $15}' "/proc/$SERVER_PID/stat"
+}
+
+TRANSPORT_ARGS=()
+if [ "$TRANSPORT" = "unix" ]; then
+    TRANSPORT_ARGS=(--unix "$SOCKET")
+fi
+
+CPU_BEFORE=$(server_cpu_ticks)
+"$BENCH" --output "$OUTPUT" --server-pid "$SERVER_PID" ${TRANSPORT_ARGS[@]+"${TRANSPORT_ARGS[@]}"} "$@"
+CPU_AFTER=$(server_cpu_ticks)
+echo "传输: $TRANSPORT，服务器CPU时间: $(awk -v d=$((CPU_AFTER - CPU_BEFORE)) \
+    -v hz="$(getconf CLK_TCK)" 'BEGIN {printf "%.2f", d / hz}') s"
+echo "结果已写入 $OUTPUT"
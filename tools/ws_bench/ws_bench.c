@@ -0,0 +1,839 @@
+/*
+Copyright 2025 kozakemi
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ * @file ws_bench.c
+ * @author kozakemi (kozakemi@gmail.com)
+ * @brief WebSocket负载生成与延迟基准工具
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 kozakemi
+ *
+ * 对/wifi与/brightness路径各建立N个连接，按设定的总速率与请求类型权重开环发送请求，
+ * 统计每种请求的吞吐与p50/p95/p99/max延迟，结果以JSON输出便于跟踪性能回归。
+ *
+ * 请求按固定节拍发送，延迟从计划发送时刻开始计算，服务端变慢时积压的等待时间
+ * 同样计入延迟，避免闭环压测低估尾延迟。
+ *
+ * 用法：
+ *   ws_bench [--host H] [--port P] [--unix PATH] [--connections N] [--duration S] [--rate R]
+ *            [--mix type=weight,...] [--seed N] [--idle N] [--server-pid PID] [--output FILE]
+ *
+ * 指定--unix时经UNIX域套接字连接（忽略--host/--port），用于与TCP回环对比延迟与CPU占用；
+ * 报告中的client_cpu_s为压测进程自身消耗的CPU时间。
+ *
+ * --idle在压测期间额外保持N个不发送请求的空闲连接（两个路径交替），验证连接数上限；
+ * 同时指定--server-pid（同机运行）时报告建立空闲连接前后服务器的驻留内存，
+ * 得到每个空闲连接的内存开销。
+ */
+#include "cJSON.h"
+#include "civetweb.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_HOST "127.0.0.1" ///< 默认服务器地址
+#define BENCH_UNIX_PORT (-99)          ///< civetweb客户端以该端口值表示host为UNIX域套接字路径
+#define BENCH_DEFAULT_PORT 8080        ///< 默认服务器端口
+#define BENCH_DEFAULT_CONNECTIONS 4    ///< 默认每个路径的连接数
+#define BENCH_DEFAULT_DURATION_S 10    ///< 默认压测时长(秒)
+#define BENCH_DEFAULT_RATE 200         ///< 默认总请求速率(次/秒)
+#define BENCH_DEFAULT_MIX                                                                          \
+    "brightness_status_request=4,brightness_set_request=4,wifi_status_request=2"
+#define BENCH_MAX_CONNECTIONS 256 ///< 每个路径的最大连接数
+#define BENCH_PENDING_SLOTS 4096  ///< 每个连接的在途请求槽位数
+#define BENCH_DRAIN_MS 5000       ///< 发送结束后等待剩余响应的最长时间(毫秒)
+#define BENCH_MAX_IDLE 4096       ///< 最大空闲连接数
+#define BENCH_IDLE_SETTLE_MS 500  ///< 空闲连接建立后等待服务器稳定再采样内存的时间(毫秒)
+
+/**
+ * @brief 请求类型描述
+ */
+typedef struct
+{
+    const char *type;                        ///< 请求类型
+    const char *path;                        ///< WebSocket路径
+    void (*fill)(cJSON *data, uint64_t seq); ///< 填充data字段（可为NULL）
+} bench_request_def;
+
+/**
+ * @brief 单个请求类型的统计
+ */
+typedef struct
+{
+    const bench_request_def *def; ///< 请求类型描述
+    unsigned weight;              ///< 在混合中的权重
+    uint64_t sent;                ///< 已发送数量
+    uint64_t received;            ///< 已收到响应数量
+    uint64_t errors;              ///< success为false的响应数量
+    uint64_t timeouts;            ///< 未收到响应数量
+    uint64_t send_failures;       ///< 发送失败数量
+    uint32_t *latency_us;         ///< 延迟样本(微秒)
+    size_t latency_count;         ///< 样本数量
+    size_t latency_cap;           ///< 样本数组容量
+} bench_type_stats;
+
+/**
+ * @brief 在途请求
+ */
+typedef struct
+{
+    bool used;           ///< 槽位是否占用
+    uint64_t seq;        ///< 请求序号
+    int type_index;      ///< 请求类型下标
+    int64_t intended_ns; ///< 计划发送时刻
+} bench_pending;
+
+/**
+ * @brief 客户端连接
+ */
+typedef struct
+{
+    struct mg_connection *conn;                 ///< civetweb客户端连接
+    const char *path;                           ///< 连接路径
+    int index;                                  ///< 连接编号（用于request_id）
+    bool closed;                                ///< 服务端是否已关闭连接
+    uint64_t next_seq;                          ///< 下一个请求序号
+    size_t inflight;                            ///< 在途请求数
+    bench_pending pending[BENCH_PENDING_SLOTS]; ///< 在途请求表（按seq取模）
+} bench_conn;
+
+static void fill_brightness_set(cJSON *data, uint64_t seq)
+{
+    cJSON_AddNumberToObject(data, "brightness", (double)(10 + seq % 91));
+}
+
+static void fill_wifi_scan(cJSON *data, uint64_t seq)
+{
+    (void)seq;
+    cJSON_AddBoolToObject(data, "rescan", false);
+}
+
+static const bench_request_def g_request_defs[] = {
+    {"brightness_status_request", "/brightness", NULL},
+    {"brightness_set_request", "/brightness", fill_brightness_set},
+    {"brightness_devices_request", "/brightness", NULL},
+    {"wifi_status_request", "/wifi", NULL},
+    {"wifi_scan_request", "/wifi", fill_wifi_scan},
+};
+#define BENCH_REQUEST_DEF_COUNT (sizeof(g_request_defs) / sizeof(g_request_defs[0]))
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER; ///< 保护统计与在途表
+static bench_type_stats g_types[BENCH_REQUEST_DEF_COUNT];
+static size_t g_type_count = 0;
+static unsigned g_weight_total = 0;
+static bench_conn *g_conns = NULL;
+static size_t g_conn_count = 0;
+
+/**
+ * @brief 获取单调时钟(纳秒)
+ */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief 睡眠到指定的单调时钟时刻
+ */
+static void sleep_until_ns(int64_t deadline)
+{
+    struct timespec ts = {.tv_sec = deadline / 1000000000LL, .tv_nsec = deadline % 1000000000LL};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+/**
+ * @brief xorshift64伪随机数（固定种子保证结果可复现）
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief 记录一个延迟样本（调用者持有g_lock）
+ */
+static void record_latency_locked(bench_type_stats *st, int64_t latency_ns)
+{
+    if (st->latency_count == st->latency_cap)
+    {
+        size_t cap = st->latency_cap ? st->latency_cap * 2 : 1024;
+        uint32_t *p = realloc(st->latency_us, cap * sizeof(uint32_t));
+        if (!p)
+        {
+            return;
+        }
+        st->latency_us = p;
+        st->latency_cap = cap;
+    }
+    int64_t us = latency_ns / 1000;
+    st->latency_us[st->latency_count++] = (uint32_t)(us > UINT32_MAX ? UINT32_MAX : us);
+}
+
+/**
+ * @brief 客户端数据回调：按request_id匹配在途请求并记录延迟，事件消息忽略
+ */
+static int bench_data_handler(struct mg_connection *conn, int opcode, char *data, size_t datasize,
+                              void *user_data)
+{
+    (void)conn;
+    int64_t now = now_ns();
+    bench_conn *bc = (bench_conn *)user_data;
+    if ((opcode & 0xf) != MG_WEBSOCKET_OPCODE_TEXT)
+    {
+        return 1;
+    }
+
+    cJSON *root = cJSON_ParseWithLength(data, datasize);
+    if (!root)
+    {
+        return 1;
+    }
+    const cJSON *rid = cJSON_GetObjectItemCaseSensitive(root, "request_id");
+    const cJSON *success = cJSON_GetObjectItemCaseSensitive(root, "success");
+    int conn_index = -1;
+    uint64_t seq = 0;
+    if (cJSON_IsString(rid) && sscanf(rid->valuestring, "c%d-%" SCNu64, &conn_index, &seq) == 2 &&
+        conn_index == bc->index)
+    {
+        pthread_mutex_lock(&g_lock);
+        bench_pending *p = &bc->pending[seq % BENCH_PENDING_SLOTS];
+        if (p->used && p->seq == seq)
+        {
+            bench_type_stats *st = &g_types[p->type_index];
+            st->received++;
+            if (!cJSON_IsTrue(success))
+            {
+                st->errors++;
+            }
+            record_latency_locked(st, now - p->intended_ns);
+            p->used = false;
+            bc->inflight--;
+        }
+        pthread_mutex_unlock(&g_lock);
+    }
+    cJSON_Delete(root);
+    return 1;
+}
+
+/**
+ * @brief 空闲连接的数据回调：忽略推送的事件
+ */
+static int bench_idle_data_handler(struct mg_connection *conn, int opcode, char *data,
+                                   size_t datasize, void *user_data)
+{
+    (void)conn;
+    (void)opcode;
+    (void)data;
+    (void)datasize;
+    (void)user_data;
+    return 1;
+}
+
+/**
+ * @brief 读取进程的驻留内存
+ *
+ * @param pid 进程号
+ * @return long long 驻留内存(字节)，读取失败返回-1
+ */
+static long long read_rss_bytes(int pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        return -1;
+    }
+    char line[256];
+    long long kb = -1;
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (sscanf(line, "VmRSS: %lld kB", &kb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(fp);
+    return kb >= 0 ? kb * 1024 : -1;
+}
+
+/**
+ * @brief 客户端关闭回调
+ */
+static void bench_close_handler(const struct mg_connection *conn, void *user_data)
+{
+    (void)conn;
+    bench_conn *bc = (bench_conn *)user_data;
+    pthread_mutex_lock(&g_lock);
+    bc->closed = true;
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * @brief 解析请求混合配置，格式为"type=weight,type=weight"
+ *
+ * @return int 0成功，-1失败
+ */
+static int parse_mix(const char *mix)
+{
+    char *copy = strdup(mix);
+    if (!copy)
+    {
+        return -1;
+    }
+    int ret = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
+    {
+        char *eq = strchr(tok, '=');
+        unsigned weight = 1;
+        if (eq)
+        {
+            *eq = '\0';
+            weight = (unsigned)strtoul(eq + 1, NULL, 10);
+        }
+        const bench_request_def *def = NULL;
+        for (size_t i = 0; i < BENCH_REQUEST_DEF_COUNT; i++)
+        {
+            if (strcmp(tok, g_request_defs[i].type) == 0)
+            {
+                def = &g_request_defs[i];
+                break;
+            }
+        }
+        if (!def)
+        {
+            fprintf(stderr, "未知请求类型: %s\n", tok);
+            ret = -1;
+            break;
+        }
+        if (weight == 0)
+        {
+            continue;
+        }
+        g_types[g_type_count].def = def;
+        g_types[g_type_count].weight = weight;
+        g_type_count++;
+        g_weight_total += weight;
+        if (g_type_count == BENCH_REQUEST_DEF_COUNT)
+        {
+            break;
+        }
+    }
+    free(copy);
+    if (ret == 0 && g_type_count == 0)
+    {
+        fprintf(stderr, "请求混合为空\n");
+        ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief 判断混合中是否有请求使用该路径
+ */
+static bool mix_uses_path(const char *path)
+{
+    for (size_t i = 0; i < g_type_count; i++)
+    {
+        if (strcmp(g_types[i].def->path, path) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 按权重选择请求类型
+ */
+static int pick_type(uint64_t *rng)
+{
+    unsigned r = (unsigned)(next_random(rng) % g_weight_total);
+    for (size_t i = 0; i < g_type_count; i++)
+    {
+        if (r < g_types[i].weight)
+        {
+            return (int)i;
+        }
+        r -= g_types[i].weight;
+    }
+    return (int)g_type_count - 1;
+}
+
+/**
+ * @brief 在指定路径的连接中轮询选择下一个可用连接
+ *
+ * @param path 路径
+ * @param cursor 轮询游标
+ * @return bench_conn* 连接，全部关闭时返回NULL
+ */
+static bench_conn *pick_conn(const char *path, size_t *cursor)
+{
+    for (size_t n = 0; n < g_conn_count; n++)
+    {
+        bench_conn *bc = &g_conns[(*cursor)++ % g_conn_count];
+        if (strcmp(bc->path, path) == 0 && !bc->closed)
+        {
+            return bc;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 发送一个请求
+ *
+ * @param type_index 请求类型下标
+ * @param intended_ns 计划发送时刻
+ * @param cursor 连接轮询游标
+ */
+static void send_one(int type_index, int64_t intended_ns, size_t *cursor)
+{
+    bench_type_stats *st = &g_types[type_index];
+
+    pthread_mutex_lock(&g_lock);
+    bench_conn *bc = pick_conn(st->def->path, cursor);
+    if (!bc)
+    {
+        st->send_failures++;
+        pthread_mutex_unlock(&g_lock);
+        return;
+    }
+    uint64_t seq = bc->next_seq++;
+    bench_pending *p = &bc->pending[seq % BENCH_PENDING_SLOTS];
+    if (p->used)
+    {
+        // 槽位被更早的未响应请求占用，视为超时
+        g_types[p->type_index].timeouts++;
+        bc->inflight--;
+    }
+    p->used = true;
+    p->seq = seq;
+    p->type_index = type_index;
+    p->intended_ns = intended_ns;
+    bc->inflight++;
+    st->sent++;
+    pthread_mutex_unlock(&g_lock);
+
+    char request_id[48];
+    snprintf(request_id, sizeof(request_id), "c%d-%" PRIu64, bc->index, seq);
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", st->def->type);
+    cJSON_AddStringToObject(root, "request_id", request_id);
+    cJSON *data = cJSON_AddObjectToObject(root, "data");
+    if (st->def->fill)
+    {
+        st->def->fill(data, seq);
+    }
+    char *text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    int rc = text ? mg_websocket_client_write(bc->conn, MG_WEBSOCKET_OPCODE_TEXT, text,
+                                              strlen(text))
+                  : -1;
+    free(text);
+    if (rc <= 0)
+    {
+        pthread_mutex_lock(&g_lock);
+        if (p->used && p->seq == seq)
+        {
+            p->used = false;
+            bc->inflight--;
+            st->sent--;
+            st->send_failures++;
+        }
+        pthread_mutex_unlock(&g_lock);
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 取排序后样本的百分位数
+ */
+static uint32_t percentile(const uint32_t *sorted, size_t count, double p)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    size_t rank = (size_t)(p * (double)count + 0.999999);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+/**
+ * @brief 生成单个请求类型的统计对象
+ */
+static cJSON *type_stats_to_json(bench_type_stats *st, double elapsed_s)
+{
+    qsort(st->latency_us, st->latency_count, sizeof(uint32_t), compare_u32);
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "sent", (double)st->sent);
+    cJSON_AddNumberToObject(obj, "received", (double)st->received);
+    cJSON_AddNumberToObject(obj, "errors", (double)st->errors);
+    cJSON_AddNumberToObject(obj, "timeouts", (double)st->timeouts);
+    cJSON_AddNumberToObject(obj, "send_failures", (double)st->send_failures);
+    cJSON_AddNumberToObject(obj, "throughput_rps",
+                            elapsed_s > 0 ? (double)st->received / elapsed_s : 0);
+    cJSON *lat = cJSON_AddObjectToObject(obj, "latency_us");
+    cJSON_AddNumberToObject(lat, "p50", percentile(st->latency_us, st->latency_count, 0.50));
+    cJSON_AddNumberToObject(lat, "p95", percentile(st->latency_us, st->latency_count, 0.95));
+    cJSON_AddNumberToObject(lat, "p99", percentile(st->latency_us, st->latency_count, 0.99));
+    cJSON_AddNumberToObject(
+        lat, "max", st->latency_count ? st->latency_us[st->latency_count - 1] : 0);
+    return obj;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "用法: %s [--host H] [--port P] [--unix PATH] [--connections N] [--duration S]\n"
+            "          [--rate R] [--mix type=weight,...] [--seed N] [--idle N]\n"
+            "          [--server-pid PID] [--output FILE]\n"
+            "默认: --host %s --port %d --connections %d --duration %d --rate %d\n"
+            "      --mix %s\n",
+            prog, BENCH_DEFAULT_HOST, BENCH_DEFAULT_PORT, BENCH_DEFAULT_CONNECTIONS,
+            BENCH_DEFAULT_DURATION_S, BENCH_DEFAULT_RATE, BENCH_DEFAULT_MIX);
+}
+
+/**
+ * @brief 主函数
+ *
+ * @return int 0成功，1参数或连接错误
+ */
+int main(int argc, char **argv)
+{
+    const char *host = BENCH_DEFAULT_HOST;
+    int port = BENCH_DEFAULT_PORT;
+    const char *unix_path = NULL;
+    int idle = 0;
+    int server_pid = 0;
+    int connections = BENCH_DEFAULT_CONNECTIONS;
+    int duration_s = BENCH_DEFAULT_DURATION_S;
+    int rate = BENCH_DEFAULT_RATE;
+    const char *mix = BENCH_DEFAULT_MIX;
+    const char *output = NULL;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 || !val)
+        {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 ? 0 : 1;
+        }
+        i++;
+        if (strcmp(arg, "--host") == 0)
+        {
+            host = val;
+        }
+        else if (strcmp(arg, "--port") == 0)
+        {
+            port = atoi(val);
+        }
+        else if (strcmp(arg, "--unix") == 0)
+        {
+            unix_path = val;
+        }
+        else if (strcmp(arg, "--connections") == 0)
+        {
+            connections = atoi(val);
+        }
+        else if (strcmp(arg, "--duration") == 0)
+        {
+            duration_s = atoi(val);
+        }
+        else if (strcmp(arg, "--rate") == 0)
+        {
+            rate = atoi(val);
+        }
+        else if (strcmp(arg, "--mix") == 0)
+        {
+            mix = val;
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            rng = strtoull(val, NULL, 0);
+            rng = rng ? rng : 1;
+        }
+        else if (strcmp(arg, "--idle") == 0)
+        {
+            idle = atoi(val);
+        }
+        else if (strcmp(arg, "--server-pid") == 0)
+        {
+            server_pid = atoi(val);
+        }
+        else if (strcmp(arg, "--output") == 0)
+        {
+            output = val;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (port <= 0 || connections <= 0 || connections > BENCH_MAX_CONNECTIONS || duration_s <= 0 ||
+        rate <= 0 || idle < 0 || idle > BENCH_MAX_IDLE)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (parse_mix(mix) != 0)
+    {
+        return 1;
+    }
+    if (unix_path)
+    {
+        host = unix_path;
+        port = BENCH_UNIX_PORT;
+    }
+
+    mg_init_library(MG_FEATURES_WEBSOCKET);
+
+    // 为混合中用到的每个路径建立连接
+    static const char *paths[] = {"/brightness", "/wifi"};
+    g_conns = calloc(2 * (size_t)connections, sizeof(bench_conn));
+    if (!g_conns)
+    {
+        mg_exit_library();
+        return 1;
+    }
+    int ret = 0;
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]) && ret == 0; p++)
+    {
+        if (!mix_uses_path(paths[p]))
+        {
+            continue;
+        }
+        for (int i = 0; i < connections; i++)
+        {
+            bench_conn *bc = &g_conns[g_conn_count];
+            char err[256] = {0};
+            bc->path = paths[p];
+            bc->index = (int)g_conn_count;
+            bc->conn = mg_connect_websocket_client(host, port, 0, err, sizeof(err), paths[p],
+                                                   NULL, bench_data_handler, bench_close_handler,
+                                                   bc);
+            if (!bc->conn)
+            {
+                if (unix_path)
+                {
+                    fprintf(stderr, "连接 unix:%s%s 失败: %s\n", unix_path, paths[p], err);
+                }
+                else
+                {
+                    fprintf(stderr, "连接 %s:%d%s 失败: %s\n", host, port, paths[p], err);
+                }
+                ret = 1;
+                break;
+            }
+            g_conn_count++;
+        }
+    }
+
+    // 空闲连接：只建立不发送，服务端达到上限时握手被拒绝
+    struct mg_connection **idle_conns = calloc((size_t)idle + 1, sizeof(*idle_conns));
+    int idle_opened = 0;
+    long long rss_before = server_pid > 0 ? read_rss_bytes(server_pid) : -1;
+    for (int i = 0; i < idle && ret == 0 && idle_conns; i++)
+    {
+        char err[256] = {0};
+        idle_conns[idle_opened] =
+            mg_connect_websocket_client(host, port, 0, err, sizeof(err), paths[i % 2], NULL,
+                                        bench_idle_data_handler, NULL, NULL);
+        if (idle_conns[idle_opened])
+        {
+            idle_opened++;
+        }
+    }
+    long long rss_after = -1;
+    if (idle > 0 && ret == 0)
+    {
+        sleep_until_ns(now_ns() + BENCH_IDLE_SETTLE_MS * 1000000LL);
+        rss_after = server_pid > 0 ? read_rss_bytes(server_pid) : -1;
+    }
+
+    int64_t start = now_ns();
+    int64_t end = start + (int64_t)duration_s * 1000000000LL;
+    int64_t interval = 1000000000LL / rate;
+    size_t cursor = 0;
+    if (ret == 0)
+    {
+        // 开环发送：第k个请求的计划时刻固定为start + k * interval
+        for (int64_t next = start; next < end; next += interval)
+        {
+            sleep_until_ns(next);
+            send_one(pick_type(&rng), next, &cursor);
+        }
+
+        // 等待在途请求完成
+        int64_t drain_end = now_ns() + BENCH_DRAIN_MS * 1000000LL;
+        while (now_ns() < drain_end)
+        {
+            size_t inflight = 0;
+            pthread_mutex_lock(&g_lock);
+            for (size_t i = 0; i < g_conn_count; i++)
+            {
+                inflight += g_conns[i].closed ? 0 : g_conns[i].inflight;
+            }
+            pthread_mutex_unlock(&g_lock);
+            if (inflight == 0)
+            {
+                break;
+            }
+            sleep_until_ns(now_ns() + 10000000LL);
+        }
+    }
+    double elapsed_s = (double)(now_ns() - start) / 1e9;
+
+    for (size_t i = 0; i < g_conn_count; i++)
+    {
+        mg_close_connection(g_conns[i].conn);
+    }
+    for (int i = 0; i < idle_opened; i++)
+    {
+        mg_close_connection(idle_conns[i]);
+    }
+    free(idle_conns);
+
+    // 剩余未响应的请求计为超时
+    for (size_t i = 0; i < g_conn_count; i++)
+    {
+        for (size_t s = 0; s < BENCH_PENDING_SLOTS; s++)
+        {
+            bench_pending *p = &g_conns[i].pending[s];
+            if (p->used)
+            {
+                g_types[p->type_index].timeouts++;
+                p->used = false;
+            }
+        }
+    }
+
+    if (ret == 0)
+    {
+        cJSON *report = cJSON_CreateObject();
+        cJSON *config = cJSON_AddObjectToObject(report, "config");
+        cJSON_AddStringToObject(config, "transport", unix_path ? "unix" : "tcp");
+        cJSON_AddStringToObject(config, "host", host);
+        cJSON_AddNumberToObject(config, "port", port);
+        cJSON_AddNumberToObject(config, "connections_per_path", connections);
+        cJSON_AddNumberToObject(config, "duration_s", duration_s);
+        cJSON_AddNumberToObject(config, "rate", rate);
+        cJSON_AddStringToObject(config, "mix", mix);
+        cJSON_AddNumberToObject(report, "elapsed_s", elapsed_s);
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru) == 0)
+        {
+            double cpu_s = (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+                           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+            cJSON_AddNumberToObject(report, "client_cpu_s", cpu_s);
+        }
+
+        bench_type_stats total = {0};
+        cJSON *types = cJSON_AddObjectToObject(report, "types");
+        for (size_t i = 0; i < g_type_count; i++)
+        {
+            bench_type_stats *st = &g_types[i];
+            total.sent += st->sent;
+            total.received += st->received;
+            total.errors += st->errors;
+            total.timeouts += st->timeouts;
+            total.send_failures += st->send_failures;
+            for (size_t k = 0; k < st->latency_count; k++)
+            {
+                record_latency_locked(&total, (int64_t)st->latency_us[k] * 1000);
+            }
+            cJSON_AddItemToObject(types, st->def->type, type_stats_to_json(st, elapsed_s));
+        }
+        cJSON_AddItemToObject(report, "total", type_stats_to_json(&total, elapsed_s));
+        if (idle > 0)
+        {
+            cJSON *idle_obj = cJSON_AddObjectToObject(report, "idle");
+            cJSON_AddNumberToObject(idle_obj, "requested", idle);
+            cJSON_AddNumberToObject(idle_obj, "opened", idle_opened);
+            if (rss_before >= 0 && rss_after >= 0)
+            {
+                cJSON_AddNumberToObject(idle_obj, "server_rss_before_bytes", (double)rss_before);
+                cJSON_AddNumberToObject(idle_obj, "server_rss_after_bytes", (double)rss_after);
+                if (idle_opened > 0)
+                {
+                    cJSON_AddNumberToObject(idle_obj, "server_bytes_per_connection",
+                                            (double)(rss_after - rss_before) / idle_opened);
+                }
+            }
+        }
+        free(total.latency_us);
+
+        char *text = cJSON_Print(report);
+        cJSON_Delete(report);
+        FILE *fp = output ? fopen(output, "w") : stdout;
+        if (!fp || !text)
+        {
+            fprintf(stderr, "无法写入结果 %s\n", output ? output : "stdout");
+            ret = 1;
+        }
+        else
+        {
+            fprintf(fp, "%s\n", text);
+            if (fp != stdout)
+            {
+                fclose(fp);
+            }
+        }
+        free(text);
+    }
+
+    for (size_t i = 0; i < g_type_count; i++)
+    {
+        free(g_types[i].latency_us);
+    }
+    free(g_conns);
+    mg_exit_library();
+    return ret;
+}
@@ -24,9 +24,86 @@ limitations under the License.
  *
  */
 #include "ws_utils.h"
+#include "metrics.h"
+#include "qos.h"
+#include "reactor.h"
 
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/**
+ * @brief 已序列化的推送事件，由事件日志与各连接的发送队列共享
+ */
+typedef struct
+{
+    int refs;    ///< 引用数（__atomic访问）
+    size_t len;  ///< 文本长度
+    char data[]; ///< 文本
+} ws_text;
+
+/**
+ * @brief 已登记的推送连接
+ */
+struct ws_subscriber
+{
+    struct ws_subscriber *next;           ///< 下一个连接
+    struct ws_subscriber *ready_next;     ///< 待发送队列中的下一个连接
+    struct mg_connection *conn;           ///< 连接指针
+    char path[64];                        ///< 连接路径
+    int64_t last_rx_us;                   ///< 最近收到任意帧的时间（__atomic访问）
+    int64_t last_message_us;              ///< 最近收到业务消息的时间（__atomic访问）
+    const char *reaped;                   ///< 回收原因（关闭帧中的说明），NULL表示未回收（__atomic访问）
+    uint64_t first_live_seq;              ///< 实时推送给该连接的第一个事件序号，0表示尚未推送
+    ws_text *outbox[WS_PUSH_QUEUE_DEPTH]; ///< 待发送的事件（环形缓冲）
+    size_t out_head;                      ///< 最旧事件的下标
+    size_t out_count;                     ///< 待发送的事件数
+    bool ready;                           ///< 已在待发送队列中
+    bool sending;                         ///< 发送线程正在不持锁地向该连接写入
+};
+
+/**
+ * @brief 事件日志中的一条事件
+ */
+typedef struct
+{
+    uint64_t seq;  ///< 序号
+    ws_text *text; ///< 已序列化的事件（持有一个引用）
+} ws_journal_entry;
+
+/**
+ * @brief 单个路径的事件日志（环形缓冲）
+ */
+typedef struct
+{
+    char path[64];                                 ///< 连接路径，空串表示未使用
+    uint64_t last_seq;                             ///< 最近分配的序号
+    ws_journal_entry entries[WS_JOURNAL_CAPACITY]; ///< 事件
+    size_t head;                                   ///< 最旧事件的下标
+    size_t count;                                  ///< 事件数
+    size_t bytes;                                  ///< 事件文本总字节数
+} ws_journal;
+
+// 登记表、事件日志与发送队列由g_subscribers_lock保护，锁内只做登记、分配序号与入队，不写连接；
+// 推送由发送线程在锁外写出，每个连接同一时刻至多一个发送线程，事件按入队顺序到达。
+// 注销时等待正在写该连接的发送线程写完，返回后保证不会再向该连接写入
+static pthread_mutex_t g_subscribers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_subscribers_released = PTHREAD_COND_INITIALIZER; ///< 发送线程写完一帧
+static pthread_cond_t g_push_ready = PTHREAD_COND_INITIALIZER;           ///< 有待发送的连接
+static ws_subscriber *g_subscribers = NULL;
+static ws_subscriber *g_ready_head = NULL; ///< 待发送队列（有事件待写出的连接）
+static ws_subscriber *g_ready_tail = NULL;
+static ws_journal g_journals[WS_JOURNAL_MAX_PATHS];
+static uint64_t g_epoch = 0;
+
+static pthread_t g_push_threads[WS_PUSH_THREADS]; ///< 发送线程
+static int g_push_started = 0;                    ///< 已启动的发送线程数
+static bool g_push_stop = false;                  ///< 要求发送线程退出
+
+static ws_keepalive_config g_keepalive; ///< 保活参数
+static int g_keepalive_timer = -1;      ///< 回收检查定时器
 
 /**
  * @brief 通过WebSocket发送UTF-8文本消息
@@ -48,3 +125,637 @@ int ws_send_text(struct mg_connection *conn, const char *text)
     const int n = mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_TEXT, text, len);
     return n;
 }
+
+/**
+ * @brief 登记可接收推送事件的连接，并开始跟踪其存活状态
+ *
+ * @param conn WebSocket连接指针
+ * @param path 连接路径（如/brightness）
+ * @return ws_subscriber* 连接句柄，失败返回NULL
+ */
+ws_subscriber *ws_register_connection(struct mg_connection *conn, const char *path)
+{
+    if (!conn || !path)
+    {
+        return NULL;
+    }
+
+    ws_subscriber *sub =
+        (ws_subscriber *)metrics_calloc(METRICS_MODULE_CORE, 1, sizeof(ws_subscriber));
+    if (!sub)
+    {
+        return NULL;
+    }
+    sub->conn = conn;
+    strncpy(sub->path, path, sizeof(sub->path) - 1);
+    sub->path[sizeof(sub->path) - 1] = '\0';
+    sub->last_rx_us = qos_now_us();
+    sub->last_message_us = sub->last_rx_us;
+
+    pthread_mutex_lock(&g_subscribers_lock);
+    sub->next = g_subscribers;
+    g_subscribers = sub;
+    pthread_mutex_unlock(&g_subscribers_lock);
+    return sub;
+}
+
+/**
+ * @brief 向连接发送关闭帧（状态码1001，附带原因）
+ *
+ * @param conn WebSocket连接指针
+ * @param reason 关闭原因
+ */
+static void ws_send_close(struct mg_connection *conn, const char *reason)
+{
+    char frame[2 + 64];
+    size_t len = strlen(reason);
+    if (len > sizeof(frame) - 2)
+    {
+        len = sizeof(frame) - 2;
+    }
+    frame[0] = (char)(1001 >> 8);
+    frame[1] = (char)(1001 & 0xff);
+    memcpy(frame + 2, reason, len);
+    mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_CONNECTION_CLOSE, frame, len + 2);
+}
+
+/**
+ * @brief 记录从连接收到一帧
+ *
+ * 在连接自己的处理线程上调用：已被回收的连接在这里收到关闭帧，
+ * 写入即使阻塞也只占用该连接的线程。
+ *
+ * @param sub 连接句柄
+ * @param message 是否为业务消息
+ * @return true 连接仍有效
+ * @return false 连接已被回收
+ */
+bool ws_connection_touch(ws_subscriber *sub, bool message)
+{
+    if (!sub)
+    {
+        return true;
+    }
+    int64_t now = qos_now_us();
+    __atomic_store_n(&sub->last_rx_us, now, __ATOMIC_RELAXED);
+    if (message)
+    {
+        __atomic_store_n(&sub->last_message_us, now, __ATOMIC_RELAXED);
+    }
+    const char *reason = __atomic_load_n(&sub->reaped, __ATOMIC_RELAXED);
+    if (reason)
+    {
+        ws_send_close(sub->conn, reason);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 释放事件文本的一个引用
+ *
+ * @param text 事件文本（可为NULL）
+ */
+static void ws_text_release(ws_text *text)
+{
+    if (text && __atomic_sub_fetch(&text->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        metrics_free(text);
+    }
+}
+
+/**
+ * @brief 从待发送队列摘除连接（调用者持有g_subscribers_lock）
+ *
+ * @param sub 连接
+ */
+static void ws_ready_remove(ws_subscriber *sub)
+{
+    ws_subscriber *prev = NULL;
+    for (ws_subscriber *it = g_ready_head; it; prev = it, it = it->ready_next)
+    {
+        if (it != sub)
+        {
+            continue;
+        }
+        if (prev)
+        {
+            prev->ready_next = it->ready_next;
+        }
+        else
+        {
+            g_ready_head = it->ready_next;
+        }
+        if (g_ready_tail == it)
+        {
+            g_ready_tail = prev;
+        }
+        break;
+    }
+    sub->ready_next = NULL;
+    sub->ready = false;
+}
+
+/**
+ * @brief 把有事件待写出的连接排入待发送队列（调用者持有g_subscribers_lock）
+ *
+ * @param sub 连接
+ */
+static void ws_ready_push(ws_subscriber *sub)
+{
+    if (sub->ready || sub->sending || sub->out_count == 0)
+    {
+        return; // 正在发送的连接由发送线程写完当前帧后重新排队
+    }
+    sub->ready = true;
+    sub->ready_next = NULL;
+    if (g_ready_tail)
+    {
+        g_ready_tail->ready_next = sub;
+    }
+    else
+    {
+        g_ready_head = sub;
+    }
+    g_ready_tail = sub;
+    pthread_cond_signal(&g_push_ready);
+}
+
+/**
+ * @brief 丢弃连接发送队列中的全部事件（调用者持有g_subscribers_lock）
+ *
+ * @param sub 连接
+ */
+static void ws_outbox_clear(ws_subscriber *sub)
+{
+    while (sub->out_count > 0)
+    {
+        ws_text_release(sub->outbox[sub->out_head]);
+        sub->out_head = (sub->out_head + 1) % WS_PUSH_QUEUE_DEPTH;
+        sub->out_count--;
+    }
+}
+
+/**
+ * @brief 注销连接
+ *
+ * 先从登记表与待发送队列摘除，再等待正在向该连接写入的发送线程写完。
+ *
+ * @param conn WebSocket连接指针
+ */
+void ws_unregister_connection(const struct mg_connection *conn)
+{
+    ws_subscriber *dead = NULL;
+    pthread_mutex_lock(&g_subscribers_lock);
+    ws_subscriber **pp = &g_subscribers;
+    while (*pp)
+    {
+        if ((*pp)->conn == conn)
+        {
+            ws_subscriber *sub = *pp;
+            *pp = sub->next;
+            ws_ready_remove(sub);
+            ws_outbox_clear(sub); // 清空后发送线程写完当前帧也不会再把它排回队列
+            sub->next = dead;
+            dead = sub;
+            continue;
+        }
+        pp = &(*pp)->next;
+    }
+    while (dead)
+    {
+        while (dead->sending)
+        {
+            pthread_cond_wait(&g_subscribers_released, &g_subscribers_lock);
+        }
+        ws_subscriber *next = dead->next;
+        metrics_free(dead);
+        dead = next;
+    }
+    pthread_mutex_unlock(&g_subscribers_lock);
+}
+
+/**
+ * @brief 获取本次运行的纪元（调用者持有g_subscribers_lock）
+ *
+ * @return uint64_t 首次调用时的Unix毫秒时间
+ */
+static uint64_t ws_epoch(void)
+{
+    if (g_epoch == 0)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        g_epoch = (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+    }
+    return g_epoch;
+}
+
+/**
+ * @brief 查找路径的事件日志（调用者持有g_subscribers_lock）
+ *
+ * @param path 连接路径
+ * @param create 不存在时是否创建
+ * @return ws_journal* 未找到且未创建（或表已满）时返回NULL
+ */
+static ws_journal *ws_journal_find(const char *path, bool create)
+{
+    ws_journal *unused = NULL;
+    for (size_t i = 0; i < WS_JOURNAL_MAX_PATHS; i++)
+    {
+        if (g_journals[i].path[0] == '\0')
+        {
+            if (!unused)
+            {
+                unused = &g_journals[i];
+            }
+        }
+        else if (strcmp(g_journals[i].path, path) == 0)
+        {
+            return &g_journals[i];
+        }
+    }
+    if (!create || !unused)
+    {
+        return NULL;
+    }
+    strncpy(unused->path, path, sizeof(unused->path) - 1);
+    unused->path[sizeof(unused->path) - 1] = '\0';
+    return unused;
+}
+
+/**
+ * @brief 生成带seq字段的事件文本（在已序列化的事件末尾加上seq字段）
+ *
+ * @param body 已序列化的事件对象
+ * @param journaled 是否加上seq字段
+ * @param seq 序号
+ * @return ws_text* 新文本（引用数为1），失败返回NULL
+ */
+static ws_text *ws_text_create(const char *body, bool journaled, uint64_t seq)
+{
+    size_t len = strlen(body);
+    if (journaled && (len < 2 || body[len - 1] != '}'))
+    {
+        return NULL;
+    }
+    char suffix[40] = "";
+    int n = 0;
+    if (journaled)
+    {
+        n = snprintf(suffix, sizeof(suffix), "%s\"seq\":%llu}", len > 2 ? "," : "",
+                     (unsigned long long)seq);
+        len--; // 去掉结尾的'}'，由suffix补上
+    }
+    ws_text *text =
+        (ws_text *)metrics_malloc(METRICS_MODULE_CORE, sizeof(ws_text) + len + (size_t)n + 1);
+    if (!text)
+    {
+        return NULL;
+    }
+    text->refs = 1;
+    text->len = len + (size_t)n;
+    memcpy(text->data, body, len);
+    memcpy(text->data + len, suffix, (size_t)n + 1);
+    return text;
+}
+
+/**
+ * @brief 向事件日志追加一条事件，超出条数或字节上限时挤出最旧的事件
+ *
+ * @param journal 事件日志
+ * @param seq 序号
+ * @param text 已序列化的事件，日志持有调用者的一个引用
+ */
+static void ws_journal_append(ws_journal *journal, uint64_t seq, ws_text *text)
+{
+    while (journal->count > 0 && (journal->count == WS_JOURNAL_CAPACITY ||
+                                  journal->bytes + text->len > WS_JOURNAL_MAX_BYTES))
+    {
+        ws_journal_entry *oldest = &journal->entries[journal->head];
+        journal->bytes -= oldest->text->len;
+        ws_text_release(oldest->text);
+        oldest->text = NULL;
+        journal->head = (journal->head + 1) % WS_JOURNAL_CAPACITY;
+        journal->count--;
+    }
+    ws_journal_entry *entry =
+        &journal->entries[(journal->head + journal->count) % WS_JOURNAL_CAPACITY];
+    entry->seq = seq;
+    entry->text = text;
+    journal->count++;
+    journal->bytes += text->len;
+}
+
+/**
+ * @brief 向指定路径的所有已登记连接推送事件
+ *
+ * 只在锁内分配序号、写日志并放入各连接的发送队列，由发送线程写出，调用者不等待写入。
+ * 发送队列已满的连接读得太慢，按回收处理，重连后通过会话恢复补齐。
+ *
+ * @param path 连接路径
+ * @param event 事件对象
+ * @return int 放入发送队列的连接数
+ */
+int ws_broadcast_event(const char *path, cJSON *event)
+{
+    if (!path || !event)
+    {
+        return 0;
+    }
+    char *body = cJSON_PrintUnformatted(event);
+    if (!body)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_subscribers_lock);
+    ws_epoch();
+    ws_journal *journal = ws_journal_find(path, true);
+    uint64_t seq = journal ? journal->last_seq + 1 : 0;
+    ws_text *text = ws_text_create(body, journal != NULL, seq);
+    if (!text)
+    {
+        pthread_mutex_unlock(&g_subscribers_lock);
+        cJSON_free(body);
+        return 0;
+    }
+
+    int queued = 0;
+    for (ws_subscriber *sub = g_subscribers; sub; sub = sub->next)
+    {
+        if (strcmp(sub->path, path) != 0 || __atomic_load_n(&sub->reaped, __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+        if (sub->out_count == WS_PUSH_QUEUE_DEPTH)
+        {
+            __atomic_store_n(&sub->reaped, "push overflow", __ATOMIC_RELAXED);
+            metrics_connection_reaped(METRICS_REAP_OVERFLOW);
+            ws_outbox_clear(sub);
+            continue;
+        }
+        if (sub->first_live_seq == 0)
+        {
+            sub->first_live_seq = seq;
+        }
+        __atomic_add_fetch(&text->refs, 1, __ATOMIC_RELAXED);
+        sub->outbox[(sub->out_head + sub->out_count) % WS_PUSH_QUEUE_DEPTH] = text;
+        sub->out_count++;
+        ws_ready_push(sub);
+        queued++;
+    }
+    if (journal)
+    {
+        journal->last_seq = seq;
+        ws_journal_append(journal, seq, text);
+    }
+    else
+    {
+        ws_text_release(text);
+    }
+    pthread_mutex_unlock(&g_subscribers_lock);
+
+    cJSON_free(body);
+    return queued;
+}
+
+/**
+ * @brief 向重连的客户端补发错过的事件
+ *
+ * @param conn WebSocket连接指针
+ * @param path 连接路径
+ * @param has_position 客户端是否给出了epoch与last_seq
+ * @param epoch 客户端记录的纪元
+ * @param last_seq 客户端收到的最后一个序号
+ * @param result 输出恢复结果
+ */
+void ws_resume_connection(struct mg_connection *conn, const char *path, bool has_position,
+                          uint64_t epoch, uint64_t last_seq, ws_resume_result *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (!conn || !path)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_subscribers_lock);
+    ws_journal *journal = ws_journal_find(path, false);
+    result->epoch = ws_epoch();
+    result->seq = journal ? journal->last_seq : 0;
+
+    // 纪元不同（服务器已重启）或序号超前时无从判断错过了哪些事件
+    bool resumable = has_position && epoch == result->epoch && last_seq <= result->seq;
+    uint64_t oldest = (journal && journal->count > 0) ? journal->entries[journal->head].seq
+                                                      : result->seq + 1;
+    if (last_seq + 1 < oldest)
+    {
+        resumable = false; // 错过的事件已被挤出日志
+    }
+
+    // 登记之后已放入发送队列的事件不再补发
+    uint64_t live_from = UINT64_MAX;
+    for (ws_subscriber *sub = g_subscribers; sub; sub = sub->next)
+    {
+        if (sub->conn == conn && sub->first_live_seq != 0)
+        {
+            live_from = sub->first_live_seq;
+            break;
+        }
+    }
+
+    // 锁内只对要补发的事件加引用，锁外在本连接的处理线程上写出
+    size_t count = (resumable && journal) ? journal->count : 0;
+    ws_text **replay =
+        count ? (ws_text **)metrics_malloc(METRICS_MODULE_CORE, count * sizeof(ws_text *)) : NULL;
+    size_t n = 0;
+    for (size_t i = 0; replay && i < count; i++)
+    {
+        const ws_journal_entry *entry =
+            &journal->entries[(journal->head + i) % WS_JOURNAL_CAPACITY];
+        if (entry->seq > last_seq && entry->seq < live_from)
+        {
+            __atomic_add_fetch(&entry->text->refs, 1, __ATOMIC_RELAXED);
+            replay[n++] = entry->text;
+        }
+    }
+    pthread_mutex_unlock(&g_subscribers_lock);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_TEXT, replay[i]->data, replay[i]->len) >=
+            0)
+        {
+            result->replayed++;
+        }
+        ws_text_release(replay[i]);
+    }
+    metrics_free(replay);
+    result->resumed = resumable && (count == 0 || replay);
+}
+
+/**
+ * @brief 发送线程：轮流从待发送队列取连接，每次写出一个事件
+ *
+ * 每次只写一帧后把连接排回队尾，一个写入阻塞的连接只占住一个发送线程，
+ * 其余连接由其他发送线程继续写出。
+ *
+ * @param arg 未使用
+ * @return void* NULL
+ */
+static void *ws_push_worker(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_subscribers_lock);
+    while (!g_push_stop)
+    {
+        ws_subscriber *sub = g_ready_head;
+        if (!sub)
+        {
+            pthread_cond_wait(&g_push_ready, &g_subscribers_lock);
+            continue;
+        }
+        ws_ready_remove(sub);
+        if (__atomic_load_n(&sub->reaped, __ATOMIC_RELAXED))
+        {
+            ws_outbox_clear(sub);
+            continue;
+        }
+        ws_text *text = sub->outbox[sub->out_head];
+        sub->out_head = (sub->out_head + 1) % WS_PUSH_QUEUE_DEPTH;
+        sub->out_count--;
+        sub->sending = true;
+        pthread_mutex_unlock(&g_subscribers_lock);
+
+        mg_websocket_write(sub->conn, MG_WEBSOCKET_OPCODE_TEXT, text->data, text->len);
+        ws_text_release(text);
+
+        pthread_mutex_lock(&g_subscribers_lock);
+        sub->sending = false;
+        pthread_cond_broadcast(&g_subscribers_released);
+        ws_ready_push(sub); // 注销中的连接发送队列已清空，不会再排回
+    }
+    pthread_mutex_unlock(&g_subscribers_lock);
+    return NULL;
+}
+
+/**
+ * @brief 启动推送发送线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int ws_push_init(void)
+{
+    pthread_mutex_lock(&g_subscribers_lock);
+    g_push_stop = false;
+    pthread_mutex_unlock(&g_subscribers_lock);
+    while (g_push_started < WS_PUSH_THREADS)
+    {
+        if (pthread_create(&g_push_threads[g_push_started], NULL, ws_push_worker, NULL) != 0)
+        {
+            fprintf(stderr, "ws_push_init: 无法创建发送线程\n");
+            ws_push_deinit();
+            return -1;
+        }
+        g_push_started++;
+    }
+    return 0;
+}
+
+/**
+ * @brief 停止推送发送线程，尚未写出的事件随连接注销丢弃
+ */
+void ws_push_deinit(void)
+{
+    pthread_mutex_lock(&g_subscribers_lock);
+    g_push_stop = true;
+    pthread_cond_broadcast(&g_push_ready);
+    pthread_mutex_unlock(&g_subscribers_lock);
+    while (g_push_started > 0)
+    {
+        pthread_join(g_push_threads[--g_push_started], NULL);
+    }
+}
+
+/**
+ * @brief 回收检查：找出失联或空闲的连接并标记回收
+ *
+ * civetweb只在连接静默ping_interval_ms后发送PING，因此应答期限从最后一帧起算
+ * ping_interval_ms + pong_timeout_ms。在后端事件线程上运行，只标记、不写连接：
+ * 被回收的连接不再接收推送，空闲连接在其处理线程收到下一帧（含PONG）时收到关闭帧并关闭，
+ * 失联的连接由civetweb在多次PING无应答后关闭。
+ *
+ * @param arg 未使用
+ */
+static void ws_keepalive_tick(void *arg)
+{
+    (void)arg;
+
+    int64_t now = qos_now_us();
+    int64_t rx_limit_us = 0;
+    if (g_keepalive.pong_timeout_ms > 0)
+    {
+        rx_limit_us = (int64_t)(g_keepalive.ping_interval_ms + g_keepalive.pong_timeout_ms) * 1000;
+    }
+    int64_t idle_limit_us = (int64_t)g_keepalive.idle_timeout_ms * 1000;
+
+    pthread_mutex_lock(&g_subscribers_lock);
+    for (ws_subscriber *sub = g_subscribers; sub; sub = sub->next)
+    {
+        if (__atomic_load_n(&sub->reaped, __ATOMIC_RELAXED))
+        {
+            continue;
+        }
+        int64_t rx_age_us = now - __atomic_load_n(&sub->last_rx_us, __ATOMIC_RELAXED);
+        int64_t idle_us = now - __atomic_load_n(&sub->last_message_us, __ATOMIC_RELAXED);
+        if (rx_limit_us > 0 && rx_age_us > rx_limit_us)
+        {
+            __atomic_store_n(&sub->reaped, "pong timeout", __ATOMIC_RELAXED);
+            metrics_connection_reaped(METRICS_REAP_PONG_TIMEOUT);
+        }
+        else if (idle_limit_us > 0 && idle_us > idle_limit_us)
+        {
+            __atomic_store_n(&sub->reaped, "idle timeout", __ATOMIC_RELAXED);
+            metrics_connection_reaped(METRICS_REAP_IDLE);
+        }
+    }
+    pthread_mutex_unlock(&g_subscribers_lock);
+}
+
+/**
+ * @brief 启动连接回收检查
+ *
+ * @param config 保活参数
+ * @return int 成功返回0，失败返回-1
+ */
+int ws_keepalive_start(const ws_keepalive_config *config)
+{
+    if (!config || g_keepalive_timer >= 0)
+    {
+        return -1;
+    }
+    g_keepalive = *config;
+    if (g_keepalive.pong_timeout_ms <= 0 && g_keepalive.idle_timeout_ms <= 0)
+    {
+        return 0; // 不需要回收检查
+    }
+    g_keepalive_timer = reactor_timer_create(ws_keepalive_tick, NULL);
+    if (g_keepalive_timer < 0)
+    {
+        return -1;
+    }
+    reactor_timer_arm(g_keepalive_timer, WS_KEEPALIVE_TICK_MS, WS_KEEPALIVE_TICK_MS);
+    return 0;
+}
+
+/**
+ * @brief 停止连接回收检查
+ */
+void ws_keepalive_stop(void)
+{
+    if (g_keepalive_timer >= 0)
+    {
+        reactor_timer_destroy(g_keepalive_timer);
+        g_keepalive_timer = -1;
+    }
+}
@@ -26,8 +26,50 @@ limitations under the License.
 #ifndef WS_UTILS_H
 #define WS_UTILS_H
 
+#include "cJSON.h"
 #include "civetweb.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WS_KEEPALIVE_TICK_MS 1000 ///< 回收检查周期(毫秒)
+
+#ifndef WS_JOURNAL_CAPACITY
+#define WS_JOURNAL_CAPACITY 64 ///< 每个路径保留的推送事件数
+#endif
+
+#ifndef WS_JOURNAL_MAX_BYTES
+#define WS_JOURNAL_MAX_BYTES (64 * 1024) ///< 每个路径保留的推送事件总字节数
+#endif
+
+#define WS_JOURNAL_MAX_PATHS 8 ///< 最多记录推送事件的路径数
+
+#ifndef WS_PUSH_THREADS
+#define WS_PUSH_THREADS 2 ///< 推送发送线程数，写入阻塞的连接各占住一个
+#endif
+
+#ifndef WS_PUSH_QUEUE_DEPTH
+#define WS_PUSH_QUEUE_DEPTH 64 ///< 每个连接待发送的推送事件上限，超过时回收该连接
+#endif
+
+/**
+ * @brief 已登记连接的句柄（不透明）
+ */
+typedef struct ws_subscriber ws_subscriber;
+
+/**
+ * @brief 连接保活与回收参数
+ *
+ * PING由civetweb在连接静默ping_interval_ms后发出（enable_websocket_ping_pong），
+ * 这里只根据收到的帧判断连接是否存活。
+ */
+typedef struct
+{
+    int ping_interval_ms; ///< 连接静默多久后发送PING
+    int pong_timeout_ms;  ///< PING后等待应答的期限，0表示不检查
+    int idle_timeout_ms;  ///< 多久未收到业务消息视为空闲，0表示不检查
+} ws_keepalive_config;
+
 /**
  * @brief 通过WebSocket发送UTF-8文本消息
  *
@@ -39,4 +81,105 @@ limitations under the License.
  */
 int ws_send_text(struct mg_connection *conn, const char *text);
 
+/**
+ * @brief 登记可接收推送事件的连接，并开始跟踪其存活状态
+ *
+ * @param conn WebSocket连接指针
+ * @param path 连接路径（如/brightness）
+ * @return ws_subscriber* 连接句柄，在ws_unregister_connection之前有效；失败返回NULL
+ */
+ws_subscriber *ws_register_connection(struct mg_connection *conn, const char *path);
+
+/**
+ * @brief 记录从连接收到一帧
+ *
+ * 只应在该连接的处理线程中调用（与ws_unregister_connection同线程，句柄不会被并发释放）。
+ * 连接已被回收时先向其发送附带回收原因的关闭帧。
+ *
+ * @param sub 连接句柄
+ * @param message 是否为业务消息（文本帧），控制帧只刷新存活时间
+ * @return true 连接仍有效
+ * @return false 连接已被回收，调用方应关闭连接
+ */
+bool ws_connection_touch(ws_subscriber *sub, bool message);
+
+/**
+ * @brief 注销连接，返回后不会再向该连接推送事件
+ *
+ * 若有线程正在向该连接写入，等待其写完后返回。
+ *
+ * @param conn WebSocket连接指针
+ */
+void ws_unregister_connection(const struct mg_connection *conn);
+
+/**
+ * @brief 会话恢复结果
+ */
+typedef struct
+{
+    uint64_t epoch; ///< 本次运行的纪元（启动时的Unix毫秒时间），序号只在同一纪元内有效
+    uint64_t seq;   ///< 该路径最近推送的事件序号
+    int replayed;   ///< 补发的事件数
+    bool resumed;   ///< true表示错过的事件已全部补发，false表示无法补发，需要快照
+} ws_resume_result;
+
+/**
+ * @brief 向指定路径的所有已登记连接推送事件
+ *
+ * 事件序列化后在末尾加上该路径单调递增的序号（"seq"字段），写入有界的事件日志，
+ * 并按序号顺序放入各连接的发送队列后立即返回，由推送发送线程写出，可在后端事件线程上调用。
+ * 发送队列已满的连接被回收（METRICS_REAP_OVERFLOW），不再接收推送。
+ *
+ * @param path 连接路径
+ * @param event 事件对象（不修改，所有权仍属调用者）
+ * @return int 放入发送队列的连接数
+ */
+int ws_broadcast_event(const char *path, cJSON *event);
+
+/**
+ * @brief 向重连的客户端补发错过的事件
+ *
+ * 客户端给出上次收到的纪元与序号，日志中仍保留其后的全部事件时按顺序补发，
+ * 已放入该连接发送队列的事件不再重复发送；纪元不符或部分事件已被挤出日志时不补发。
+ * 补发在调用线程上写出，可能与发送线程写出的实时事件交错，客户端按seq去重排序。
+ *
+ * @param conn WebSocket连接指针（须已登记）
+ * @param path 连接路径
+ * @param has_position 客户端是否给出了epoch与last_seq
+ * @param epoch 客户端记录的纪元
+ * @param last_seq 客户端收到的最后一个序号
+ * @param result 输出恢复结果
+ */
+void ws_resume_connection(struct mg_connection *conn, const char *path, bool has_position,
+                          uint64_t epoch, uint64_t last_seq, ws_resume_result *result);
+
+/**
+ * @brief 启动推送发送线程
+ *
+ * @return int 成功返回0，失败返回-1
+ */
+int ws_push_init(void);
+
+/**
+ * @brief 停止推送发送线程（在所有连接注销之后调用）
+ */
+void ws_push_deinit(void);
+
+/**
+ * @brief 启动连接回收检查（在后端事件线程上周期运行）
+ *
+ * 超过PING应答期限或空闲超时的连接被回收：立即不再接收推送；检查本身不写连接，
+ * 关闭帧由ws_connection_touch在该连接的处理线程上发送，调用方随后关闭连接。
+ * 失联的连接不会再收到帧，由civetweb在多次PING无应答后关闭。
+ *
+ * @param config 保活参数
+ * @return int 成功返回0，失败返回-1
+ */
+int ws_keepalive_start(const ws_keepalive_config *config);
+
+/**
+ * @brief 停止连接回收检查
+ */
+void ws_keepalive_stop(void);
+
 #endif